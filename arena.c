@@ -0,0 +1,174 @@
+/****************************
+ * Author: Blake A. Molina
+ * Created on: 10/17/26
+ * License: GPL
+ ****************************/
+
+#include <pthread.h>
+#include "matrix_internal.h"
+
+// Smallest block an arena grows by
+#define ARENA_MIN_BLOCK (64 * 1024)
+
+/*******************************************************
+ *          Arena State
+ *******************************************************/
+// An arena is a chain of aligned blocks filled front to back. Blocks are
+// never returned to the system before FreeMatrixArena: a reset just starts
+// filling from the first block again, so once an arena has grown to the
+// size of one iteration's temporaries it never calls malloc again.
+typedef struct arena_block{
+    struct arena_block *next;
+    size_t capacity;  // usable bytes after the header
+    size_t used;
+}arena_block;
+
+struct arena_struct{
+    arena_block *first;
+    arena_block *current;
+};
+
+// Header rounded up so the first allocation in a block is aligned
+#define BLOCK_HEADER ((sizeof(arena_block) + MATRIX_ALIGNMENT - 1) / MATRIX_ALIGNMENT * MATRIX_ALIGNMENT)
+
+static _Thread_local MatrixArena active_arena = NULL;
+
+static arena_block *NewBlock(size_t capacity){
+    arena_block *block = (arena_block*)AllocateAligned(BLOCK_HEADER + capacity);
+    if(!block)
+        return NULL;
+    block->next = NULL;
+    block->capacity = capacity;
+    block->used = 0;
+    return block;
+}
+
+
+/*******************************************************
+ *          Arena Creation & Deletion
+ *******************************************************/
+MatrixArena NewMatrixArena(size_t capacity){
+    MatrixArena arena = (MatrixArena)malloc(sizeof(struct arena_struct));
+    if(!arena){
+        fprintf(stderr, "%s", "Error - Could not allocate arena");
+        return NULL;
+    }
+    arena->first = NewBlock(capacity > ARENA_MIN_BLOCK ? capacity : ARENA_MIN_BLOCK);
+    if(!arena->first){
+        fprintf(stderr, "%s", "Error - Could not allocate arena");
+        free(arena);
+        return NULL;
+    }
+    arena->current = arena->first;
+    return arena;
+}
+
+void FreeMatrixArena(MatrixArena *arena){
+    if(arena && *arena){
+        if(active_arena == *arena)
+            active_arena = NULL;
+        arena_block *block = (*arena)->first;
+        while(block){
+            arena_block *next = block->next;
+            FreeAligned(block);
+            block = next;
+        }
+        free(*arena);
+        *arena = NULL;
+    }
+}
+
+void ResetMatrixArena(MatrixArena arena){
+    if(!arena)
+        return;
+    // later blocks are marked empty as the fill pointer reaches them
+    arena->current = arena->first;
+    arena->first->used = 0;
+}
+
+MatrixArena UseMatrixArena(MatrixArena arena){
+    MatrixArena previous = active_arena;
+    active_arena = arena;
+    return previous;
+}
+
+
+/*******************************************************
+ *          Allocation
+ *******************************************************/
+MatrixArena ActiveArena(void){
+    return active_arena;
+}
+
+void *ArenaAllocate(MatrixArena arena, size_t size){
+    size = (size + MATRIX_ALIGNMENT - 1) / MATRIX_ALIGNMENT * MATRIX_ALIGNMENT;
+    arena_block *block = arena->current;
+    while(block->capacity - block->used < size){
+        // move on to the next block, adding one when the chain runs out
+        if(!block->next){
+            size_t capacity = block->capacity * 2 > size ? block->capacity * 2 : size;
+            block->next = NewBlock(capacity);
+            if(!block->next)
+                return NULL;
+        }
+        block = block->next;
+        block->used = 0;
+    }
+    arena->current = block;
+    void *memory = (char*)block + BLOCK_HEADER + block->used;
+    block->used += size;
+    return memory;
+}
+
+
+/*******************************************************
+ *          Per-thread Scratch
+ *******************************************************/
+// Thread-local buffer pointers to free when their thread exits. The key's
+// value only has to be non-NULL for its destructor to run; the destructor
+// then walks the exiting thread's own list.
+#define THREAD_BUFFER_SLOTS 8
+
+static pthread_key_t thread_buffer_key;
+static pthread_once_t thread_buffer_once = PTHREAD_ONCE_INIT;
+static int thread_buffer_key_created = 0;
+static _Thread_local void **thread_buffers[THREAD_BUFFER_SLOTS];
+static _Thread_local size_t num_thread_buffers = 0;
+
+static void FreeThreadBuffers(void *unused){
+    (void)unused;
+    for(size_t i = 0; i < num_thread_buffers; i++){
+        FreeAligned(*thread_buffers[i]);
+        *thread_buffers[i] = NULL;
+    }
+    num_thread_buffers = 0;
+}
+
+static void CreateThreadBufferKey(void){
+    thread_buffer_key_created = pthread_key_create(&thread_buffer_key, FreeThreadBuffers) == 0;
+}
+
+void FreeAtThreadExit(void **buffer){
+    pthread_once(&thread_buffer_once, CreateThreadBufferKey);
+    if(!thread_buffer_key_created || num_thread_buffers == THREAD_BUFFER_SLOTS)
+        return;
+    thread_buffers[num_thread_buffers++] = buffer;
+    pthread_setspecific(thread_buffer_key, thread_buffers);
+}
+
+static _Thread_local void *scratch = NULL;
+static _Thread_local size_t scratch_size = 0;
+
+void *ThreadScratch(size_t size){
+    if(size > scratch_size){
+        void *larger = AllocateAligned(size);
+        if(!larger)
+            return NULL;
+        if(!scratch)
+            FreeAtThreadExit(&scratch);
+        FreeAligned(scratch);
+        scratch = larger;
+        scratch_size = size;
+    }
+    return scratch;
+}
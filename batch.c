@@ -0,0 +1,226 @@
+/****************************
+ * Author: Blake A. Molina
+ * Created on: 10/17/26
+ * License: GPL
+ ****************************/
+
+#include <stdatomic.h>
+#include "matrix_internal.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define MATRIX_X86_DISPATCH 1
+#endif
+
+// Matrices handed to a task at a time, and the granularity the lane stride
+// is padded to: one AVX-512 vector of doubles (two AVX2, four SSE2 ones), so
+// every lane vector of every kernel is aligned.
+#define BATCH_LANES 8
+
+
+/*******************************************************
+ *          Batch Creation & Deletion
+ *******************************************************/
+MatrixBatch NewMatrixBatch(size_t count, size_t num_rows, size_t num_cols){
+    if(count == 0 || num_rows == 0 || num_cols == 0){
+        fprintf(stderr, "%s", "Error - A matrix batch needs a positive count and shape");
+        return NULL;
+    }
+    MatrixBatch batch = (MatrixBatch)malloc(sizeof(batch_struct));
+    if(!batch)
+        return NULL;
+    batch->count = count;
+    batch->num_rows = num_rows;
+    batch->num_cols = num_cols;
+    batch->stride = (count + BATCH_LANES - 1) / BATCH_LANES * BATCH_LANES;
+    size_t bytes = num_rows * num_cols * batch->stride * sizeof(double);
+    batch->data = (double*)AllocateAligned(bytes);
+    if(!batch->data){
+        free(batch);
+        return NULL;
+    }
+    memset(batch->data, 0, bytes);
+    return batch;
+}
+
+void FreeMatrixBatch(MatrixBatch *batch){
+    if(batch && *batch){
+        FreeAligned((*batch)->data);
+        free(*batch);
+        *batch = NULL;
+    }
+}
+
+int BatchSetMatrix(MatrixBatch batch, size_t index, Matrix matrix){
+    if(!batch || index >= batch->count || isEmpty(matrix) ||
+       matrix->num_rows != batch->num_rows || matrix->num_cols != batch->num_cols){
+        fprintf(stderr, "%s", "Error - Matrix does not fit in the batch");
+        return -1;
+    }
+    for(size_t i = 0; i < batch->num_rows; i++)
+        for(size_t j = 0; j < batch->num_cols; j++)
+            BATCH_AT(batch, index, i, j) = MATRIX_AT(matrix, i, j);
+    return 0;
+}
+
+int BatchGetMatrix(MatrixBatch batch, size_t index, Matrix matrix){
+    if(!batch || index >= batch->count || isEmpty(matrix) ||
+       matrix->num_rows != batch->num_rows || matrix->num_cols != batch->num_cols){
+        fprintf(stderr, "%s", "Error - Matrix does not fit in the batch");
+        return -1;
+    }
+    for(size_t i = 0; i < batch->num_rows; i++)
+        for(size_t j = 0; j < batch->num_cols; j++)
+            MATRIX_AT(matrix, i, j) = BATCH_AT(batch, index, i, j);
+    return 0;
+}
+
+
+/*******************************************************
+ *          Per-ISA Kernels
+ *******************************************************/
+typedef struct{
+    MatrixBatch a, b, c;     // operands; c is the output where there is one
+    double *determinants;
+    atomic_size_t failed;    // matrices found singular / not positive definite
+}BatchJob;
+
+typedef struct{
+    ParallelTask multiply, determinant, solve, cholesky;
+}BatchTasks;
+
+// Matrices of the batch from offset on, capped at one chunk (0 past the end;
+// the remaining lanes are padding)
+static size_t LiveLanes(const MatrixBatch batch, size_t offset){
+    if(offset >= batch->count)
+        return 0;
+    return batch->count - offset < BATCH_LANES ? batch->count - offset : BATCH_LANES;
+}
+
+// The scalar and sse2 sets share the baseline build (SSE2 is part of x86-64;
+// elsewhere the lane vectors map to whatever the target offers)
+#define BATCH_ISA Baseline
+#define LANE_WIDTH 2
+#include "batch_kernels.h"
+
+#ifdef MATRIX_X86_DISPATCH
+#pragma GCC push_options
+#pragma GCC target("avx2,fma")
+#define BATCH_ISA AVX2
+#define LANE_WIDTH 4
+#include "batch_kernels.h"
+#pragma GCC pop_options
+
+#pragma GCC push_options
+#pragma GCC target("avx512f")
+#define BATCH_ISA AVX512
+#define LANE_WIDTH 8
+#include "batch_kernels.h"
+#pragma GCC pop_options
+#endif //MATRIX_X86_DISPATCH
+
+// Follows the row kernel selection (and so SMLC_ISA)
+static const BatchTasks *CurrentBatchTasks(void){
+#ifdef MATRIX_X86_DISPATCH
+    if(strcmp(matrix_kernels->name, "avx512") == 0)
+        return &batch_tasksAVX512;
+    if(strcmp(matrix_kernels->name, "avx2") == 0)
+        return &batch_tasksAVX2;
+#endif
+    return &batch_tasksBaseline;
+}
+
+// Chunks per task: enough that a share of the pool does real work
+static size_t BatchChunk(size_t work_per_matrix){
+    size_t per_chunk = work_per_matrix * BATCH_LANES;
+    return per_chunk >= 16384 ? 1 : 16384 / per_chunk + 1;
+}
+
+static size_t NumChunks(const MatrixBatch batch){
+    return batch->stride / BATCH_LANES;
+}
+
+
+/*******************************************************
+ *          Public Entry Points
+ *******************************************************/
+static int CheckSquareBatch(MatrixBatch batch){
+    if(!batch || batch->num_rows != batch->num_cols || batch->num_rows > BATCH_MAX_DIM){
+        fprintf(stderr, "%s", "Error - Need a batch of NxN matrices with N <= BATCH_MAX_DIM");
+        return -1;
+    }
+    return 0;
+}
+
+int BatchMultiply(MatrixBatch batch_A, MatrixBatch batch_B, MatrixBatch batch_C){
+    if(!batch_A || !batch_B || !batch_C || batch_A->count != batch_B->count || batch_A->count != batch_C->count ||
+       batch_A->num_cols != batch_B->num_rows || batch_C->num_rows != batch_A->num_rows ||
+       batch_C->num_cols != batch_B->num_cols || batch_C == batch_A || batch_C == batch_B){
+        fprintf(stderr, "%s", "Error - Batches must hold the same number of MxN, NxP and MxP matrices");
+        return -1;
+    }
+    STATS_BEGIN();
+    BatchJob job = {batch_A, batch_B, batch_C, NULL, 0};
+    size_t work = batch_A->num_rows * batch_A->num_cols * batch_B->num_cols;
+    ParallelFor(NumChunks(batch_A), BatchChunk(work), CurrentBatchTasks()->multiply, &job);
+    STATS_END(MATRIX_STAT_BATCH, 2.0 * work * batch_A->count);
+    return 0;
+}
+
+int BatchDeterminant(MatrixBatch batch, double *determinants){
+    if(CheckSquareBatch(batch) != 0 || !determinants)
+        return -1;
+    STATS_BEGIN();
+    BatchJob job = {batch, NULL, NULL, determinants, 0};
+    size_t n = batch->num_rows;
+    ParallelFor(NumChunks(batch), BatchChunk(n*n*n), CurrentBatchTasks()->determinant, &job);
+    STATS_END(MATRIX_STAT_BATCH, 2.0 * n * n * n / 3 * batch->count);
+    return 0;
+}
+
+int BatchSolve(MatrixBatch batch_A, MatrixBatch batch_B){
+    if(CheckSquareBatch(batch_A) != 0)
+        return -1;
+    if(!batch_B || batch_B->count != batch_A->count || batch_B->num_rows != batch_A->num_rows){
+        fprintf(stderr, "%s", "Error - Right-hand side batch must match the matrix batch");
+        return -1;
+    }
+    STATS_BEGIN();
+    BatchJob job = {batch_A, NULL, batch_B, NULL, 0};
+    size_t n = batch_A->num_rows;
+    ParallelFor(NumChunks(batch_A), BatchChunk(n*n*(n + batch_B->num_cols)), CurrentBatchTasks()->solve, &job);
+    STATS_END(MATRIX_STAT_BATCH, (2.0 * n * n * n / 3 + 2.0 * n * n * batch_B->num_cols) * batch_A->count);
+    return (int)atomic_load(&job.failed);
+}
+
+int BatchInverse(MatrixBatch batch, MatrixBatch inverse){
+    if(CheckSquareBatch(batch) != 0)
+        return -1;
+    if(!inverse || inverse == batch || inverse->count != batch->count ||
+       inverse->num_rows != batch->num_rows || inverse->num_cols != batch->num_cols){
+        fprintf(stderr, "%s", "Error - Inverse batch must match the matrix batch");
+        return -1;
+    }
+    // solve against the identity
+    size_t n = batch->num_rows;
+    memset(inverse->data, 0, n * n * inverse->stride * sizeof(double));
+    for(size_t i = 0; i < n; i++)
+        for(size_t b = 0; b < inverse->stride; b++)
+            inverse->data[(i*n + i)*inverse->stride + b] = 1.0;
+    return BatchSolve(batch, inverse);
+}
+
+int BatchCholesky(MatrixBatch batch, MatrixBatch factor){
+    if(CheckSquareBatch(batch) != 0)
+        return -1;
+    if(!factor || factor == batch || factor->count != batch->count ||
+       factor->num_rows != batch->num_rows || factor->num_cols != batch->num_cols){
+        fprintf(stderr, "%s", "Error - Factor batch must match the matrix batch");
+        return -1;
+    }
+    STATS_BEGIN();
+    BatchJob job = {batch, NULL, factor, NULL, 0};
+    size_t n = batch->num_rows;
+    ParallelFor(NumChunks(batch), BatchChunk(n*n*n), CurrentBatchTasks()->cholesky, &job);
+    STATS_END(MATRIX_STAT_BATCH, (double)n * n * n / 3 * batch->count);
+    return (int)atomic_load(&job.failed);
+}
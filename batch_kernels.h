@@ -0,0 +1,211 @@
+/****************************
+ * Author: Blake A. Molina
+ * Created on: 10/17/26
+ * License: GPL
+ ****************************/
+
+/*************************************************************************
+ * Batch lane kernels, included by batch.c once per instruction set.
+ *
+ *  Before each inclusion batch.c defines BATCH_ISA (a name suffix) and
+ *  LANE_WIDTH (doubles per native vector), and selects the target with
+ *  #pragma GCC target. Lanes is a GCC vector of LANE_WIDTH doubles, each
+ *  lane a different matrix of the batch, so every Lanes operation below
+ *  compiles to a single SSE2, AVX2 or AVX-512 instruction. The inclusion
+ *  defines the tasks MultiplyTask, DeterminantTask, SolveTask and
+ *  CholeskyTask (suffixed with BATCH_ISA) and their table batch_tasks.
+ *
+ *  There is deliberately no include guard.
+ ************************************************************************/
+
+#define BATCH_CONCAT_(name, isa) name##isa
+#define BATCH_CONCAT(name, isa)  BATCH_CONCAT_(name, isa)
+#define BATCH_NAME(name)         BATCH_CONCAT(name, BATCH_ISA)
+
+#define Lanes             BATCH_NAME(Lanes)
+#define LaneMask          BATCH_NAME(LaneMask)
+#define EliminateLanes    BATCH_NAME(EliminateLanes)
+#define CountLanes        BATCH_NAME(CountLanes)
+
+typedef double Lanes __attribute__((vector_size(LANE_WIDTH * sizeof(double))));
+typedef long long LaneMask __attribute__((vector_size(LANE_WIDTH * sizeof(long long))));
+
+// The lane vector holding entry e (row-major index) of the group at base
+#define LANES(base, e, stride) (*(Lanes*)((base) + (size_t)(e) * (stride)))
+
+// Lane-wise mask ? a : b (masks come from vector comparisons: all ones or zero)
+#define SELECT(mask, a, b) ((Lanes)(((LaneMask)(a) & (mask)) | ((LaneMask)(b) & ~(mask))))
+#define ABS(a) SELECT((a) < 0.0, -(a), (a))
+
+
+// Gaussian elimination with partial pivoting of the n x n lane matrices in a
+// (lane stride LANE_WIDTH), applying the same row operations to the n x k
+// right-hand sides in rhs (may be NULL). Pivots are chosen per lane and rows
+// are exchanged with lane-wise selects rather than branches. Leaves U in a,
+// the reciprocal of each pivot (0 for a zero pivot) in reciprocal, the
+// determinant in determinant and an all-ones singular mask per singular lane.
+static inline void EliminateLanes(size_t n, double *a, size_t k, double *rhs, size_t rhs_stride,
+                                  Lanes *reciprocal, Lanes *determinant, LaneMask *singular){
+    const Lanes zero = {0};
+    *determinant = zero + 1.0;
+    *singular = (LaneMask){0};
+    for(size_t j = 0; j < n; j++){
+        Lanes largest = ABS(LANES(a, j*n + j, LANE_WIDTH));
+        Lanes pivot_row = zero + (double)j;
+        for(size_t r = j + 1; r < n; r++){
+            Lanes magnitude = ABS(LANES(a, r*n + j, LANE_WIDTH));
+            LaneMask larger = magnitude > largest;
+            pivot_row = SELECT(larger, zero + (double)r, pivot_row);
+            largest   = SELECT(larger, magnitude, largest);
+        }
+        for(size_t r = j + 1; r < n; r++){
+            LaneMask take = pivot_row == (double)r;
+            for(size_t c = j; c < n; c++){
+                Lanes x = LANES(a, j*n + c, LANE_WIDTH), y = LANES(a, r*n + c, LANE_WIDTH);
+                LANES(a, j*n + c, LANE_WIDTH) = SELECT(take, y, x);
+                LANES(a, r*n + c, LANE_WIDTH) = SELECT(take, x, y);
+            }
+            for(size_t c = 0; c < k; c++){
+                Lanes x = LANES(rhs, j*k + c, rhs_stride), y = LANES(rhs, r*k + c, rhs_stride);
+                LANES(rhs, j*k + c, rhs_stride) = SELECT(take, y, x);
+                LANES(rhs, r*k + c, rhs_stride) = SELECT(take, x, y);
+            }
+        }
+
+        Lanes pivot = LANES(a, j*n + j, LANE_WIDTH);
+        LaneMask zero_pivot = pivot == 0.0;
+        *determinant *= SELECT(pivot_row != (double)j, -pivot, pivot);
+        *singular |= zero_pivot;
+        reciprocal[j] = SELECT(zero_pivot, zero, 1.0 / pivot);
+        for(size_t r = j + 1; r < n; r++){
+            Lanes factor = LANES(a, r*n + j, LANE_WIDTH) * reciprocal[j];
+            for(size_t c = j + 1; c < n; c++)
+                LANES(a, r*n + c, LANE_WIDTH) -= factor * LANES(a, j*n + c, LANE_WIDTH);
+            for(size_t c = 0; c < k; c++)
+                LANES(rhs, r*k + c, rhs_stride) -= factor * LANES(rhs, j*k + c, rhs_stride);
+        }
+    }
+}
+
+// Number of the first live lanes whose mask is set
+static size_t CountLanes(const LaneMask *mask, size_t live){
+    size_t count = 0;
+    for(size_t l = 0; l < live && l < LANE_WIDTH; l++)
+        count += (*mask)[l] != 0;
+    return count;
+}
+
+
+/*******************************************************
+ *          Tasks (chunks of BATCH_LANES matrices)
+ *******************************************************/
+static void BATCH_NAME(MultiplyTask)(void *context, size_t begin, size_t end){
+    BatchJob *job = (BatchJob*)context;
+    const size_t m = job->a->num_rows, inner = job->a->num_cols, n = job->b->num_cols;
+    for(size_t offset = begin * BATCH_LANES; offset < end * BATCH_LANES; offset += LANE_WIDTH){
+        double *a = job->a->data + offset, *b = job->b->data + offset, *c = job->c->data + offset;
+        for(size_t i = 0; i < m; i++){
+            for(size_t j = 0; j < n; j++){
+                Lanes sum = {0};
+                for(size_t q = 0; q < inner; q++)
+                    sum += LANES(a, i*inner + q, job->a->stride) * LANES(b, q*n + j, job->b->stride);
+                LANES(c, i*n + j, job->c->stride) = sum;
+            }
+        }
+    }
+}
+
+static void BATCH_NAME(DeterminantTask)(void *context, size_t begin, size_t end){
+    BatchJob *job = (BatchJob*)context;
+    const size_t n = job->a->num_rows;
+    Lanes scratch[BATCH_MAX_DIM * BATCH_MAX_DIM], reciprocal[BATCH_MAX_DIM], determinant;
+    LaneMask singular;
+    for(size_t offset = begin * BATCH_LANES; offset < end * BATCH_LANES; offset += LANE_WIDTH){
+        if(offset >= job->a->count)
+            break;
+        for(size_t e = 0; e < n*n; e++)
+            scratch[e] = LANES(job->a->data + offset, e, job->a->stride);
+        EliminateLanes(n, (double*)scratch, 0, NULL, 0, reciprocal, &determinant, &singular);
+        size_t live = LiveLanes(job->a, offset);
+        memcpy(job->determinants + offset, &determinant, (live < LANE_WIDTH ? live : LANE_WIDTH) * sizeof(double));
+    }
+}
+
+// Solves a X = c for every lane, overwriting c (the right-hand sides)
+static void BATCH_NAME(SolveTask)(void *context, size_t begin, size_t end){
+    BatchJob *job = (BatchJob*)context;
+    const size_t n = job->a->num_rows, k = job->c->num_cols, stride = job->c->stride;
+    Lanes scratch[BATCH_MAX_DIM * BATCH_MAX_DIM], reciprocal[BATCH_MAX_DIM], determinant;
+    LaneMask singular;
+    size_t failed = 0;
+    for(size_t offset = begin * BATCH_LANES; offset < end * BATCH_LANES; offset += LANE_WIDTH){
+        double *u = (double*)scratch, *x = job->c->data + offset;
+        for(size_t e = 0; e < n*n; e++)
+            scratch[e] = LANES(job->a->data + offset, e, job->a->stride);
+        EliminateLanes(n, u, k, x, stride, reciprocal, &determinant, &singular);
+        // back substitution through U
+        for(size_t i = n; i-- > 0;){
+            for(size_t c = 0; c < k; c++){
+                Lanes value = LANES(x, i*k + c, stride);
+                for(size_t q = i + 1; q < n; q++)
+                    value -= LANES(u, i*n + q, LANE_WIDTH) * LANES(x, q*k + c, stride);
+                LANES(x, i*k + c, stride) = SELECT(singular, (Lanes){0} + NAN, value * reciprocal[i]);
+            }
+        }
+        failed += CountLanes(&singular, LiveLanes(job->a, offset));
+    }
+    atomic_fetch_add(&job->failed, failed);
+}
+
+// c = L with a = L * L^T for every lane (only the lower triangle of a is read)
+static void BATCH_NAME(CholeskyTask)(void *context, size_t begin, size_t end){
+    BatchJob *job = (BatchJob*)context;
+    const size_t n = job->a->num_rows, lda = job->a->stride, ldl = job->c->stride;
+    size_t failed = 0;
+    for(size_t offset = begin * BATCH_LANES; offset < end * BATCH_LANES; offset += LANE_WIDTH){
+        double *a = job->a->data + offset, *l = job->c->data + offset;
+        LaneMask bad = {0};
+        for(size_t j = 0; j < n; j++){
+            Lanes diagonal = LANES(a, j*n + j, lda);
+            for(size_t q = 0; q < j; q++)
+                diagonal -= LANES(l, j*n + q, ldl) * LANES(l, j*n + q, ldl);
+            LaneMask positive = diagonal > 0.0; // also rejects NaN
+            bad |= ~positive;
+            diagonal = SELECT(positive, diagonal, (Lanes){0} + 1.0);
+            for(size_t lane = 0; lane < LANE_WIDTH; lane++)
+                diagonal[lane] = sqrt(diagonal[lane]);
+            LANES(l, j*n + j, ldl) = diagonal;
+            for(size_t c = j + 1; c < n; c++)
+                LANES(l, j*n + c, ldl) = (Lanes){0};
+
+            Lanes reciprocal = 1.0 / diagonal;
+            for(size_t i = j + 1; i < n; i++){
+                Lanes value = LANES(a, i*n + j, lda);
+                for(size_t q = 0; q < j; q++)
+                    value -= LANES(l, i*n + q, ldl) * LANES(l, j*n + q, ldl);
+                LANES(l, i*n + j, ldl) = value * reciprocal;
+            }
+        }
+        for(size_t e = 0; e < n*n; e++)
+            LANES(l, e, ldl) = SELECT(bad, (Lanes){0} + NAN, LANES(l, e, ldl));
+        failed += CountLanes(&bad, LiveLanes(job->a, offset));
+    }
+    atomic_fetch_add(&job->failed, failed);
+}
+
+static const BatchTasks BATCH_NAME(batch_tasks) = {
+    BATCH_NAME(MultiplyTask), BATCH_NAME(DeterminantTask), BATCH_NAME(SolveTask), BATCH_NAME(CholeskyTask)
+};
+
+#undef Lanes
+#undef LaneMask
+#undef EliminateLanes
+#undef CountLanes
+#undef LANES
+#undef SELECT
+#undef ABS
+#undef BATCH_NAME
+#undef BATCH_CONCAT
+#undef BATCH_CONCAT_
+#undef BATCH_ISA
+#undef LANE_WIDTH
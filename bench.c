@@ -0,0 +1,540 @@
+/****************************
+ * Author: Blake A. Molina
+ * Created on: 10/17/26
+ * License: GPL
+ ****************************/
+
+/*************************************************************************
+ * smlc benchmark driver
+ *
+ *  Sweeps square sizes 8, 16, ... 8192 (and a few rectangular shapes) over
+ *  the main operations, and reports for each case the median and 99th
+ *  percentile time, GFLOP/s and GB/s, both also as a percentage of the
+ *  machine's peak. Results can be written as JSON so two runs can be
+ *  diffed. Run ./bench --help for the options.
+ *
+ *  Operations that have an ...Into variant are timed through it, so the
+ *  page faults of a freshly allocated result are not counted. Destructive
+ *  operations get a fresh copy of their input before every (untimed) run.
+ *
+ *  Peaks are measured at startup unless given on the command line: FLOP/s
+ *  with the GEMM micro-kernel on L1-resident panels on every thread, and
+ *  bandwidth with a parallel z = x + b*y sweep over arrays far larger than
+ *  the last-level cache (a STREAM triad). Cases small enough to stay in
+ *  cache can therefore report more than 100% of the bandwidth peak.
+ ************************************************************************/
+
+#include <time.h>
+#include "matrix_internal.h"
+
+#define MAX_SHAPES 3
+#define MAX_SIZES 32
+
+/*******************************************************
+ *          Timing
+ *******************************************************/
+static double Now(void){
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)now.tv_sec + (double)now.tv_nsec * 1e-9;
+}
+
+static int CompareDoubles(const void *a, const void *b){
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+// Nearest-rank percentile of sorted samples
+static double Percentile(const double *sorted, size_t count, double fraction){
+    size_t rank = (size_t)ceil(fraction * (double)count);
+    return sorted[rank > 0 ? rank - 1 : 0];
+}
+
+
+/*******************************************************
+ *          Peak Estimates
+ *******************************************************/
+#define PEAK_KC 256
+#define PEAK_CALLS 20000
+#define STREAM_LENGTH (8u << 20)  // doubles per array: 64 MB each
+
+static void PeakFlopsTask(void *context, size_t begin, size_t end){
+    (void)context;
+    double *a = (double*)AllocateAligned(GEMM_MR * PEAK_KC * sizeof(double));
+    double *b = (double*)AllocateAligned(GEMM_NR * PEAK_KC * sizeof(double));
+    double *tile = (double*)AllocateAligned(GEMM_MR * GEMM_NR * sizeof(double));
+    if(!a || !b || !tile)
+        goto done;
+    for(size_t i = 0; i < GEMM_MR * PEAK_KC; i++)
+        a[i] = 1e-3 * (double)(i % 7);
+    for(size_t i = 0; i < GEMM_NR * PEAK_KC; i++)
+        b[i] = 1e-3 * (double)(i % 5);
+    for(size_t worker = begin; worker < end; worker++)
+        for(size_t call = 0; call < PEAK_CALLS; call++)
+            matrix_kernels->gemm_micro(PEAK_KC, a, b, tile);
+done:
+    FreeAligned(a);
+    FreeAligned(b);
+    FreeAligned(tile);
+}
+
+static double MeasurePeakGflops(void){
+    size_t threads = GetMatrixThreads();
+    double best = 0.0;
+    for(int attempt = 0; attempt < 3; attempt++){
+        double start = Now();
+        ParallelFor(threads, 1, PeakFlopsTask, NULL);
+        double seconds = Now() - start;
+        double flops = 2.0 * GEMM_MR * GEMM_NR * PEAK_KC * PEAK_CALLS * (double)threads;
+        if(flops / seconds > best)
+            best = flops / seconds;
+    }
+    return best * 1e-9;
+}
+
+typedef struct{
+    double *x, *y, *z;
+}StreamJob;
+
+static void StreamTask(void *context, size_t begin, size_t end){
+    const StreamJob *job = (const StreamJob*)context;
+    matrix_kernels->add(end - begin, job->x + begin, 3.0, job->y + begin, job->z + begin);
+}
+
+static double MeasurePeakBandwidth(void){
+    StreamJob job;
+    job.x = (double*)AllocateAligned(STREAM_LENGTH * sizeof(double));
+    job.y = (double*)AllocateAligned(STREAM_LENGTH * sizeof(double));
+    job.z = (double*)AllocateAligned(STREAM_LENGTH * sizeof(double));
+    double best = 0.0;
+    if(job.x && job.y && job.z){
+        for(size_t i = 0; i < STREAM_LENGTH; i++){
+            job.x[i] = 1.0;
+            job.y[i] = 2.0;
+            job.z[i] = 0.0;
+        }
+        for(int attempt = 0; attempt < 5; attempt++){
+            double start = Now();
+            ParallelFor(STREAM_LENGTH, 65536, StreamTask, &job);
+            double seconds = Now() - start;
+            double bytes = 3.0 * STREAM_LENGTH * sizeof(double);
+            if(bytes / seconds > best)
+                best = bytes / seconds;
+        }
+    }
+    FreeAligned(job.x);
+    FreeAligned(job.y);
+    FreeAligned(job.z);
+    return best * 1e-9;
+}
+
+
+/*******************************************************
+ *          Operations
+ *******************************************************/
+typedef struct{
+    const char *name;
+    size_t rows, cols, inner;  // inner: shared dimension of a product
+}Shape;
+
+typedef struct{
+    Matrix a, b, c;   // operands / result
+    Matrix source;    // pristine input copied into a before destructive runs
+}BenchCase;
+
+typedef struct{
+    const char *name;
+    // Shapes run at sweep size n; returns how many were written to shapes
+    size_t (*shapes)(size_t n, Shape *shapes);
+    int (*setup)(BenchCase *bench, const Shape *shape);
+    void (*reset)(BenchCase *bench);  // untimed, before every run (may be NULL)
+    void (*run)(BenchCase *bench);
+    double (*flops)(const Shape *shape);
+    double (*bytes)(const Shape *shape);  // minimum traffic: inputs read once, outputs written once
+}BenchOp;
+
+static void FillRandom(Matrix matrix, unsigned seed){
+    for(size_t i = 0; i < matrix->num_rows; i++)
+        for(size_t j = 0; j < matrix->num_cols; j++){
+            seed = seed * 1103515245u + 12345u;
+            MATRIX_AT(matrix, i, j) = (double)(seed >> 8) / (double)(1u << 24) - 0.5;
+        }
+}
+
+// A well conditioned matrix: random with a dominant diagonal (n x n, plus
+// any extra columns the caller asked for)
+static void FillDominant(Matrix matrix, unsigned seed){
+    FillRandom(matrix, seed);
+    for(size_t i = 0; i < matrix->num_rows && i < matrix->num_cols; i++)
+        MATRIX_AT(matrix, i, i) += (double)matrix->num_rows;
+}
+
+static void CopyInto(Matrix dst, Matrix src){
+    for(size_t i = 0; i < src->num_rows; i++)
+        memcpy(MATRIX_ROW(dst, i), MATRIX_ROW(src, i), src->num_cols * sizeof(double));
+}
+
+static void ResetFromSource(BenchCase *bench){
+    CopyInto(bench->a, bench->source);
+}
+
+// ---- shapes ----
+static size_t SquareShapes(size_t n, Shape *shapes){
+    shapes[0] = (Shape){"square", n, n, n};
+    return 1;
+}
+
+static size_t AugmentedShapes(size_t n, Shape *shapes){
+    shapes[0] = (Shape){"augmented", n, n + 1, n};
+    return 1;
+}
+
+// square plus a tall one holding as many values
+static size_t SquareTallShapes(size_t n, Shape *shapes){
+    shapes[0] = (Shape){"square", n, n, n};
+    if(n < 4)
+        return 1;
+    shapes[1] = (Shape){"tall", 4 * n, n / 4, n};
+    return 2;
+}
+
+// square, a rank-64 update (n x 64 times 64 x n) and a thin product (n x n
+// times n x 16)
+static size_t MultiplyShapes(size_t n, Shape *shapes){
+    shapes[0] = (Shape){"square", n, n, n};
+    shapes[1] = (Shape){"rank64", n, n, 64};
+    shapes[2] = (Shape){"thin16", n, 16, n};
+    return 3;
+}
+
+// ---- setup ----
+static int SetupMultiply(BenchCase *bench, const Shape *shape){
+    bench->a = NewMatrix(shape->rows, shape->inner);
+    bench->b = NewMatrix(shape->inner, shape->cols);
+    bench->c = NewMatrix(shape->rows, shape->cols);
+    if(!bench->a || !bench->b || !bench->c)
+        return -1;
+    FillRandom(bench->a, 1);
+    FillRandom(bench->b, 2);
+    FillRandom(bench->c, 3);
+    return 0;
+}
+
+static int SetupAdd(BenchCase *bench, const Shape *shape){
+    bench->a = NewMatrix(shape->rows, shape->cols);
+    bench->b = NewMatrix(shape->rows, shape->cols);
+    bench->c = NewMatrix(shape->rows, shape->cols);
+    if(!bench->a || !bench->b || !bench->c)
+        return -1;
+    FillRandom(bench->a, 1);
+    FillRandom(bench->b, 2);
+    return 0;
+}
+
+static int SetupTranspose(BenchCase *bench, const Shape *shape){
+    bench->a = NewMatrix(shape->rows, shape->cols);
+    // a rectangular matrix is transposed into a second one
+    if(shape->rows != shape->cols)
+        bench->b = NewMatrix(shape->cols, shape->rows);
+    if(!bench->a || (shape->rows != shape->cols && !bench->b))
+        return -1;
+    FillRandom(bench->a, 1);
+    return 0;
+}
+
+// Input a (restored from source before each run) and an N x 1 result
+static int SetupSystem(BenchCase *bench, const Shape *shape){
+    bench->a = NewMatrix(shape->rows, shape->cols);
+    bench->source = NewMatrix(shape->rows, shape->cols);
+    bench->c = NewMatrix(shape->rows, shape->rows == shape->cols ? shape->cols : 1);
+    if(!bench->a || !bench->source || !bench->c)
+        return -1;
+    FillDominant(bench->source, 4);
+    // a symmetric positive-definite source for Cholesky
+    if(shape->rows == shape->cols)
+        for(size_t i = 0; i < shape->rows; i++)
+            for(size_t j = 0; j < i; j++)
+                MATRIX_AT(bench->source, j, i) = MATRIX_AT(bench->source, i, j);
+    CopyInto(bench->a, bench->source);
+    return 0;
+}
+
+// ---- runs ----
+static void RunMultiply(BenchCase *bench){ MultiplyMatricesInto(bench->c, bench->a, bench->b); }
+static void RunAdd(BenchCase *bench){ AddMatricesInto(bench->c, bench->a, bench->b, 0); }
+static void RunRotateClockwise(BenchCase *bench){ RotateMatrixClockwise(bench->a); }
+static void RunRotateCounterClockwise(BenchCase *bench){ RotateMatrixCounterClockwise(bench->a); }
+static void RunRotate180(BenchCase *bench){ Rotate180(bench->a); }
+static void RunReducedRowEchelonForm(BenchCase *bench){ ReducedRowEchelonForm(bench->a); }
+static void RunDeterminant(BenchCase *bench){ Determinant(bench->a); }
+static void RunCholesky(BenchCase *bench){ CholeskyInto(bench->c, bench->a); }
+static void RunSolveSystem(BenchCase *bench){ SolveSystemInto(bench->c, bench->a); }
+
+static void RunTranspose(BenchCase *bench){
+    if(bench->b)
+        TransposeInto(bench->a, bench->b);
+    else
+        Transpose(bench->a);
+}
+
+// ---- models ----
+static double Values(const Shape *shape){ return (double)shape->rows * (double)shape->cols; }
+static double Cube(const Shape *shape){ return (double)shape->rows * (double)shape->rows * (double)shape->rows; }
+
+static double NoFlops(const Shape *shape){ (void)shape; return 0.0; }
+static double MultiplyFlops(const Shape *shape){ return 2.0 * Values(shape) * (double)shape->inner; }
+static double AddFlops(const Shape *shape){ return Values(shape); }
+static double EliminationFlops(const Shape *shape){ return 2.0 / 3.0 * Cube(shape) + 2.0 * Values(shape); }
+static double GaussJordanFlops(const Shape *shape){ return Cube(shape) + Values(shape); }
+static double CholeskyFlops(const Shape *shape){ return Cube(shape) / 3.0; }
+
+static double MultiplyBytes(const Shape *shape){
+    double m = (double)shape->rows, n = (double)shape->cols, k = (double)shape->inner;
+    return 8.0 * (m * k + k * n + m * n);
+}
+static double ReadWriteBytes(const Shape *shape){ return 16.0 * Values(shape); }
+static double AddBytes(const Shape *shape){ return 24.0 * Values(shape); }
+static double ReadBytes(const Shape *shape){ return 8.0 * Values(shape) + 8.0 * (double)shape->rows; }
+
+static const BenchOp bench_ops[] = {
+    {"multiply",      MultiplyShapes,   SetupMultiply,  NULL,            RunMultiply,               MultiplyFlops,    MultiplyBytes},
+    {"add",           SquareTallShapes, SetupAdd,       NULL,            RunAdd,                    AddFlops,         AddBytes},
+    {"transpose",     SquareTallShapes, SetupTranspose, NULL,            RunTranspose,              NoFlops,          ReadWriteBytes},
+    {"rotate_cw",     SquareShapes,     SetupTranspose, NULL,            RunRotateClockwise,        NoFlops,          ReadWriteBytes},
+    {"rotate_ccw",    SquareShapes,     SetupTranspose, NULL,            RunRotateCounterClockwise, NoFlops,          ReadWriteBytes},
+    {"rotate_180",    SquareShapes,     SetupTranspose, NULL,            RunRotate180,              NoFlops,          ReadWriteBytes},
+    {"rref",          AugmentedShapes,  SetupSystem,    ResetFromSource, RunReducedRowEchelonForm,  GaussJordanFlops, ReadWriteBytes},
+    {"determinant",   SquareShapes,     SetupSystem,    NULL,            RunDeterminant,            EliminationFlops, ReadBytes},
+    {"cholesky",      SquareShapes,     SetupSystem,    NULL,            RunCholesky,               CholeskyFlops,    ReadWriteBytes},
+    {"solve",         AugmentedShapes,  SetupSystem,    NULL,            RunSolveSystem,            EliminationFlops, ReadBytes},
+};
+#define NUM_OPS (sizeof(bench_ops) / sizeof(bench_ops[0]))
+
+static void ReleaseCase(BenchCase *bench){
+    FreeMatrix(&bench->a);
+    FreeMatrix(&bench->b);
+    FreeMatrix(&bench->c);
+    FreeMatrix(&bench->source);
+}
+
+
+/*******************************************************
+ *          Measurement & Reporting
+ *******************************************************/
+typedef struct{
+    size_t sizes[MAX_SIZES];
+    size_t num_sizes;
+    const char *ops;          // comma separated filter, NULL for all
+    const char *json_path;    // NULL for no JSON, "-" for stdout
+    double max_seconds;       // stop growing an op once a run takes longer
+    double min_time;          // keep repeating a case for at least this long
+    size_t min_reps, max_reps;
+    double peak_gflops, peak_gbs;
+}Settings;
+
+typedef struct{
+    size_t reps;
+    double median, p99;
+}Timing;
+
+static int MeasureCase(const BenchOp *op, const Shape *shape, const Settings *settings, Timing *timing){
+    BenchCase bench = {NULL, NULL, NULL, NULL};
+    if(op->setup(&bench, shape) != 0){
+        ReleaseCase(&bench);
+        return -1;
+    }
+    double *samples = (double*)malloc(settings->max_reps * sizeof(double));
+    if(!samples){
+        ReleaseCase(&bench);
+        return -1;
+    }
+    // one untimed warm-up run faults in the pages and the thread pool
+    if(op->reset)
+        op->reset(&bench);
+    op->run(&bench);
+
+    double total = 0.0;
+    size_t reps = 0;
+    while(reps < settings->max_reps && (reps < settings->min_reps || total < settings->min_time)){
+        if(op->reset)
+            op->reset(&bench);
+        double start = Now();
+        op->run(&bench);
+        samples[reps] = Now() - start;
+        total += samples[reps++];
+        // a single run over the budget is enough of a sample
+        if(samples[reps - 1] > settings->max_seconds)
+            break;
+    }
+    qsort(samples, reps, sizeof(double), CompareDoubles);
+    timing->reps = reps;
+    timing->median = reps % 2 ? samples[reps / 2] : 0.5 * (samples[reps / 2 - 1] + samples[reps / 2]);
+    timing->p99 = Percentile(samples, reps, 0.99);
+    free(samples);
+    ReleaseCase(&bench);
+    return 0;
+}
+
+static int Selected(const char *filter, const char *name){
+    if(!filter)
+        return 1;
+    size_t length = strlen(name);
+    for(const char *at = filter; (at = strstr(at, name)) != NULL; at += length){
+        int starts = at == filter || at[-1] == ',';
+        int ends = at[length] == '\0' || at[length] == ',';
+        if(starts && ends)
+            return 1;
+    }
+    return 0;
+}
+
+static void PrintUsage(const char *program){
+    printf("Usage: %s [options]\n"
+           "  --ops LIST          comma separated operations (default: all of\n"
+           "                      multiply,add,transpose,rotate_cw,rotate_ccw,rotate_180,\n"
+           "                      rref,determinant,cholesky,solve)\n"
+           "  --sizes LIST        comma separated sizes (default: 8,16,...,8192)\n"
+           "  --max-size N        largest size of the default sweep\n"
+           "  --max-seconds S     skip larger sizes of an op once a run takes S (default 2)\n"
+           "  --min-time S        repeat each case for at least S seconds (default 0.25)\n"
+           "  --min-reps N        at least N timed runs per case (default 5)\n"
+           "  --max-reps N        at most N timed runs per case (default 1000)\n"
+           "  --threads N         threads per operation (default: SMLC_NUM_THREADS or cores)\n"
+           "  --peak-gflops X     peak FLOP/s to compare against (default: measured)\n"
+           "  --peak-gbs X        peak bandwidth to compare against (default: measured)\n"
+           "  --json FILE         also write the results as JSON (- for stdout)\n", program);
+}
+
+static int ParseArguments(int argc, char **argv, Settings *settings){
+    size_t max_size = 8192;
+    settings->num_sizes = 0;
+    for(int i = 1; i < argc; i++){
+        const char *flag = argv[i];
+        if(strcmp(flag, "--help") == 0 || strcmp(flag, "-h") == 0){
+            PrintUsage(argv[0]);
+            exit(0);
+        }
+        if(i + 1 >= argc){
+            fprintf(stderr, "Error - Unknown option or missing value: %s\n", flag);
+            return -1;
+        }
+        const char *value = argv[++i];
+        if(strcmp(flag, "--ops") == 0)
+            settings->ops = value;
+        else if(strcmp(flag, "--json") == 0)
+            settings->json_path = value;
+        else if(strcmp(flag, "--sizes") == 0){
+            for(char *end; *value && settings->num_sizes < MAX_SIZES; value = *end ? end + 1 : end){
+                size_t size = strtoul(value, &end, 10);
+                if(size == 0 || (*end && *end != ',')){
+                    fprintf(stderr, "Error - Bad size list: %s\n", argv[i]);
+                    return -1;
+                }
+                settings->sizes[settings->num_sizes++] = size;
+            }
+        }
+        else if(strcmp(flag, "--max-size") == 0)
+            max_size = strtoul(value, NULL, 10);
+        else if(strcmp(flag, "--max-seconds") == 0)
+            settings->max_seconds = strtod(value, NULL);
+        else if(strcmp(flag, "--min-time") == 0)
+            settings->min_time = strtod(value, NULL);
+        else if(strcmp(flag, "--min-reps") == 0)
+            settings->min_reps = strtoul(value, NULL, 10);
+        else if(strcmp(flag, "--max-reps") == 0)
+            settings->max_reps = strtoul(value, NULL, 10);
+        else if(strcmp(flag, "--threads") == 0)
+            SetMatrixThreads(strtoul(value, NULL, 10));
+        else if(strcmp(flag, "--peak-gflops") == 0)
+            settings->peak_gflops = strtod(value, NULL);
+        else if(strcmp(flag, "--peak-gbs") == 0)
+            settings->peak_gbs = strtod(value, NULL);
+        else{
+            fprintf(stderr, "Error - Unknown option: %s\n", flag);
+            return -1;
+        }
+    }
+    if(settings->num_sizes == 0)
+        for(size_t size = 8; size <= max_size && settings->num_sizes < MAX_SIZES; size *= 2)
+            settings->sizes[settings->num_sizes++] = size;
+    if(settings->max_reps == 0)
+        settings->max_reps = 1;
+    if(settings->min_reps > settings->max_reps)
+        settings->min_reps = settings->max_reps;
+    return 0;
+}
+
+int main(int argc, char **argv){
+    Settings settings = {{0}, 0, NULL, NULL, 2.0, 0.25, 5, 1000, 0.0, 0.0};
+    if(ParseArguments(argc, argv, &settings) != 0){
+        PrintUsage(argv[0]);
+        return 1;
+    }
+    if(settings.peak_gflops <= 0.0)
+        settings.peak_gflops = MeasurePeakGflops();
+    if(settings.peak_gbs <= 0.0)
+        settings.peak_gbs = MeasurePeakBandwidth();
+
+    FILE *json = NULL;
+    if(settings.json_path){
+        json = strcmp(settings.json_path, "-") == 0 ? stdout : fopen(settings.json_path, "w");
+        if(!json){
+            fprintf(stderr, "Error - Could not open %s for writing\n", settings.json_path);
+            return 1;
+        }
+        fprintf(json, "{\n  \"isa\": \"%s\",\n  \"threads\": %zu,\n  \"peak_gflops\": %.3f,\n"
+                      "  \"peak_gbs\": %.3f,\n  \"results\": [",
+                MatrixKernelName(), GetMatrixThreads(), settings.peak_gflops, settings.peak_gbs);
+    }
+    // with JSON on stdout the table goes to stderr
+    FILE *table = json == stdout ? stderr : stdout;
+    fprintf(table, "kernels %s, %zu thread(s), peak %.1f GFLOP/s, %.1f GB/s\n",
+            MatrixKernelName(), GetMatrixThreads(), settings.peak_gflops, settings.peak_gbs);
+    fprintf(table, "%-12s %-9s %7s %7s %7s %6s %12s %12s %9s %6s %9s %6s\n", "op", "shape", "rows", "cols",
+            "inner", "reps", "median(s)", "p99(s)", "GFLOP/s", "%peak", "GB/s", "%peak");
+
+    size_t written = 0;
+    for(size_t o = 0; o < NUM_OPS; o++){
+        const BenchOp *op = &bench_ops[o];
+        if(!Selected(settings.ops, op->name))
+            continue;
+        int over_budget[MAX_SHAPES] = {0};
+        for(size_t s = 0; s < settings.num_sizes; s++){
+            Shape shapes[MAX_SHAPES];
+            size_t num_shapes = op->shapes(settings.sizes[s], shapes);
+            for(size_t k = 0; k < num_shapes; k++){
+                if(over_budget[k])
+                    continue;
+                Timing timing;
+                if(MeasureCase(op, &shapes[k], &settings, &timing) != 0){
+                    fprintf(stderr, "Error - Could not set up %s %s at size %zu\n", op->name, shapes[k].name,
+                            settings.sizes[s]);
+                    over_budget[k] = 1;
+                    continue;
+                }
+                over_budget[k] = timing.median > settings.max_seconds;
+                double gflops = op->flops(&shapes[k]) / timing.median * 1e-9;
+                double gbs = op->bytes(&shapes[k]) / timing.median * 1e-9;
+                double flops_peak = 100.0 * gflops / settings.peak_gflops;
+                double bandwidth_peak = 100.0 * gbs / settings.peak_gbs;
+                fprintf(table, "%-12s %-9s %7zu %7zu %7zu %6zu %12.6g %12.6g %9.2f %6.1f %9.2f %6.1f\n",
+                        op->name, shapes[k].name, shapes[k].rows, shapes[k].cols, shapes[k].inner, timing.reps,
+                        timing.median, timing.p99, gflops, flops_peak, gbs, bandwidth_peak);
+                fflush(table);
+                if(json)
+                    fprintf(json, "%s\n    {\"op\": \"%s\", \"shape\": \"%s\", \"rows\": %zu, \"cols\": %zu, "
+                                  "\"inner\": %zu, \"reps\": %zu, \"median_s\": %.9g, \"p99_s\": %.9g, "
+                                  "\"gflops\": %.4f, \"gflops_pct_peak\": %.2f, \"gbs\": %.4f, \"gbs_pct_peak\": %.2f}",
+                            written++ ? "," : "", op->name, shapes[k].name, shapes[k].rows, shapes[k].cols,
+                            shapes[k].inner, timing.reps, timing.median, timing.p99, gflops, flops_peak, gbs,
+                            bandwidth_peak);
+            }
+        }
+    }
+    if(json){
+        fprintf(json, "\n  ]\n}\n");
+        if(json != stdout)
+            fclose(json);
+    }
+    return 0;
+}
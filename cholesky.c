@@ -0,0 +1,396 @@
+/****************************
+ * Author: Blake A. Molina
+ * Created on: 10/17/26
+ * License: GPL
+ ****************************/
+
+#include "matrix_internal.h"
+
+// Columns factored per step before the trailing matrix is updated with GEMM
+#define CHOLESKY_BLOCK 96
+
+// Rows of L rotated together by the rank-1 update (see UpdateRowGroup)
+#define UPDATE_GROUP 4
+
+// Index of L[row][col] (col <= row) in packed lower-triangular storage
+#define PACKED_INDEX(row, col) ((size_t)(row) * ((row) + 1) / 2 + (col))
+
+
+/*******************************************************
+ *          Factorization Kernels
+ *******************************************************/
+// Unblocked Cholesky of the width x width diagonal block at a (lower part only)
+static size_t FactorDiagonalBlock(size_t width, double *a, size_t lda, size_t offset){
+    for(size_t j = 0; j < width; j++){
+        double *row_j = a + j*lda;
+        double diagonal = row_j[j] - matrix_kernels->dot(j, row_j, row_j);
+        if(!(diagonal > 0.0)) // also catches NaN
+            return offset + j + 1;
+        row_j[j] = sqrt(diagonal);
+        const double reciprocal = 1.0 / row_j[j];
+        for(size_t i = j + 1; i < width; i++){
+            double *row_i = a + i*lda;
+            row_i[j] = (row_i[j] - matrix_kernels->dot(j, row_i, row_j)) * reciprocal;
+        }
+    }
+    return 0;
+}
+
+typedef struct{
+    double *a;
+    size_t lda, col, width;
+}PanelSolveJob;
+
+// L21 = A21 * L11^-T, one independent row of the panel at a time (task i is
+// the i-th row below the diagonal block)
+static void PanelSolveTask(void *context, size_t begin, size_t end){
+    const PanelSolveJob *job = (const PanelSolveJob*)context;
+    const double *diagonal_block = job->a + job->col*job->lda + job->col;
+    for(size_t i = job->col + job->width + begin; i < job->col + job->width + end; i++){
+        double *row = job->a + i*job->lda + job->col;
+        for(size_t c = 0; c < job->width; c++){
+            const double *l_row = diagonal_block + c*job->lda;
+            row[c] = (row[c] - matrix_kernels->dot(c, row, l_row)) / l_row[c];
+        }
+    }
+}
+
+size_t CholeskyDense(size_t n, double *a, size_t lda){
+    for(size_t k = 0; k < n; k += CHOLESKY_BLOCK){
+        size_t width = n - k < CHOLESKY_BLOCK ? n - k : CHOLESKY_BLOCK;
+        size_t failed = FactorDiagonalBlock(width, a + k*lda + k, lda, k);
+        if(failed)
+            return failed;
+
+        size_t next = k + width;
+        if(next >= n)
+            break;
+        PanelSolveJob job = {a, lda, k, width};
+        ParallelFor(n - next, 64, PanelSolveTask, &job);
+        // Trailing update A22 -= L21 * L21^T, lower triangle only: one GEMM per
+        // block column, each starting at its diagonal block
+        for(size_t j = next; j < n; j += CHOLESKY_BLOCK){
+            size_t cols = n - j < CHOLESKY_BLOCK ? n - j : CHOLESKY_BLOCK;
+            DenseGemm(0, 1, n - j, cols, width,
+                      -1.0, a + j*lda + k, lda, a + j*lda + k, lda,
+                      1.0, a + j*lda + j, lda);
+        }
+    }
+    // The updates above also touched the upper half of the diagonal blocks
+    for(size_t i = 0; i < n; i++)
+        memset(a + i*lda + i + 1, 0, (n - i - 1) * sizeof(double));
+    return 0;
+}
+
+typedef struct{
+    const double *source;
+    size_t lds;
+    double *packed;
+    size_t column;
+}PackedColumnJob;
+
+// Entries [begin, end) of the current packed column below the diagonal
+static void PackedColumnTask(void *context, size_t begin, size_t end){
+    const PackedColumnJob *job = (const PackedColumnJob*)context;
+    size_t j = job->column;
+    const double *row_j = job->packed + PACKED_INDEX(j, 0);
+    for(size_t i = j + 1 + begin; i < j + 1 + end; i++){
+        double *row_i = job->packed + PACKED_INDEX(i, 0);
+        row_i[j] = (job->source[i*job->lds + j] - matrix_kernels->dot(j, row_i, row_j)) / row_j[j];
+    }
+}
+
+// Column-by-column Cholesky straight into packed rows: every row of L is
+// contiguous, so each entry is one dot product, and the entries below a
+// diagonal depend only on earlier columns and are computed in parallel.
+static size_t CholeskyPackedDense(size_t n, const double *source, size_t lds, double *packed){
+    for(size_t j = 0; j < n; j++){
+        double *row_j = packed + PACKED_INDEX(j, 0);
+        double diagonal = source[j*lds + j] - matrix_kernels->dot(j, row_j, row_j);
+        if(!(diagonal > 0.0))
+            return j + 1;
+        row_j[j] = sqrt(diagonal);
+
+        PackedColumnJob job = {source, lds, packed, j};
+        ParallelFor(n - j - 1, 16384 / (j + 1) + 1, PackedColumnTask, &job);
+    }
+    return 0;
+}
+
+
+/*******************************************************
+ *          Triangular Solves
+ *******************************************************/
+void CholeskySolveDense(size_t n, const double *l, size_t ldl, size_t k, double *b, size_t ldb){
+    // L * Y = B: block rows, with everything left of the diagonal block folded
+    // in by one GEMM and the diagonal block done row by row
+    for(size_t i0 = 0; i0 < n; i0 += CHOLESKY_BLOCK){
+        size_t i1 = n - i0 < CHOLESKY_BLOCK ? n : i0 + CHOLESKY_BLOCK;
+        DenseGemm(0, 0, i1 - i0, k, i0, -1.0, l + i0*ldl, ldl, b, ldb, 1.0, b + i0*ldb, ldb);
+        for(size_t i = i0; i < i1; i++){
+            for(size_t q = i0; q < i; q++)
+                matrix_kernels->axpy(k, -l[i*ldl + q], b + q*ldb, b + i*ldb);
+            matrix_kernels->scale(k, 1.0 / l[i*ldl + i], b + i*ldb);
+        }
+    }
+    // L^T * X = Y: row i of L is column i of L^T, so once x_i is known it is
+    // pushed into the rows above it
+    size_t blocks = (n + CHOLESKY_BLOCK - 1) / CHOLESKY_BLOCK;
+    for(size_t block = blocks; block-- > 0;){
+        size_t i0 = block * CHOLESKY_BLOCK;
+        size_t i1 = n - i0 < CHOLESKY_BLOCK ? n : i0 + CHOLESKY_BLOCK;
+        for(size_t i = i1; i-- > i0;){
+            matrix_kernels->scale(k, 1.0 / l[i*ldl + i], b + i*ldb);
+            for(size_t q = i0; q < i; q++)
+                matrix_kernels->axpy(k, -l[i*ldl + q], b + i*ldb, b + q*ldb);
+        }
+        DenseGemm(1, 0, i0, k, i1 - i0, -1.0, l + i0*ldl, ldl, b + i0*ldb, ldb, 1.0, b, ldb);
+    }
+}
+
+
+/*******************************************************
+ *          Rank-1 Updates & Downdates
+ *******************************************************/
+// With p = L^-1 * x, the k-th rotation of the rank-1 update (LINPACK's
+// dchud/dchdd) depends only on p[0..k], so every rotation is known before L
+// is touched. Each row of L then takes all of them independently:
+//   L[i][k] = shrink[k] * L[i][k] + mix[k] * t,   t -= p[k] * L[i][k] (old)
+// with t starting at x[i], and the diagonal grows (or shrinks) by scale[i].
+typedef struct{
+    double *l;
+    size_t ldl, n;
+    const double *x, *p, *mix, *shrink, *scale;
+}UpdateRowsJob;
+
+// Rotates one row, from column start (with the running t) through its diagonal
+static void UpdateRowTail(const UpdateRowsJob *job, size_t i, size_t start, double t){
+    double *row = job->l + i*job->ldl;
+    for(size_t k = start; k < i; k++){
+        double old = row[k];
+        row[k] = job->shrink[k] * old + job->mix[k] * t;
+        t -= job->p[k] * old;
+    }
+    row[i] *= job->scale[i];
+}
+
+// Rows first..first+3 together: across their shared columns [0, first) the
+// four chains of t are independent, so they overlap instead of each waiting
+// on its own previous step
+static void UpdateRowGroup(const UpdateRowsJob *job, size_t first){
+    double *row0 = job->l + first*job->ldl, *row1 = row0 + job->ldl;
+    double *row2 = row1 + job->ldl, *row3 = row2 + job->ldl;
+    double t0 = job->x[first], t1 = job->x[first + 1], t2 = job->x[first + 2], t3 = job->x[first + 3];
+    for(size_t k = 0; k < first; k++){
+        const double shrink = job->shrink[k], mix = job->mix[k], p = job->p[k];
+        double old0 = row0[k], old1 = row1[k], old2 = row2[k], old3 = row3[k];
+        row0[k] = shrink * old0 + mix * t0;
+        row1[k] = shrink * old1 + mix * t1;
+        row2[k] = shrink * old2 + mix * t2;
+        row3[k] = shrink * old3 + mix * t3;
+        t0 -= p * old0;
+        t1 -= p * old1;
+        t2 -= p * old2;
+        t3 -= p * old3;
+    }
+    UpdateRowTail(job, first, first, t0);
+    UpdateRowTail(job, first + 1, first, t1);
+    UpdateRowTail(job, first + 2, first, t2);
+    UpdateRowTail(job, first + 3, first, t3);
+}
+
+// Group q costs O(q), so task q takes group q and the group mirrored from
+// the end to even out the work; the last n % UPDATE_GROUP rows go one by one
+static void UpdateRowsTask(void *context, size_t begin, size_t end){
+    const UpdateRowsJob *job = (const UpdateRowsJob*)context;
+    size_t groups = job->n / UPDATE_GROUP;
+    for(size_t q = begin; q < end; q++){
+        UpdateRowGroup(job, q * UPDATE_GROUP);
+        if(groups - 1 - q != q)
+            UpdateRowGroup(job, (groups - 1 - q) * UPDATE_GROUP);
+    }
+}
+
+// L * L^T +/- x * x^T in place, using 5n doubles of scratch (x is copied to
+// scratch[0..n) by the caller). Returns 0, or 1 without touching L when a
+// downdate would leave a matrix that is not positive definite.
+static int CholeskyRankOneDense(size_t n, double *l, size_t ldl, double sigma, double *scratch){
+    double *x = scratch, *p = x + n, *mix = p + n, *shrink = mix + n, *scale = shrink + n;
+    for(size_t i = 0; i < n; i++){
+        const double *row = l + i*ldl;
+        p[i] = (x[i] - matrix_kernels->dot(i, row, p)) / row[i];
+    }
+    // g = product of the previous c_k, so that x^(k)[k] / L[k][k] = p[k] / g
+    double g = 1.0;
+    for(size_t k = 0; k < n; k++){
+        double s = p[k] / g;
+        double c2 = 1.0 + sigma * s * s;
+        if(!(c2 > 0.0)) // also catches NaN
+            return 1;
+        double c = sqrt(c2);
+        mix[k] = sigma * s / (g * c);
+        shrink[k] = 1.0 / c;
+        scale[k] = c;
+        g *= c;
+    }
+    UpdateRowsJob job = {l, ldl, n, x, p, mix, shrink, scale};
+    size_t groups = n / UPDATE_GROUP;
+    ParallelFor((groups + 1) / 2, 4096 / n + 1, UpdateRowsTask, &job);
+    for(size_t i = groups * UPDATE_GROUP; i < n; i++)
+        UpdateRowTail(&job, i, 0, x[i]);
+    return 0;
+}
+
+
+/*******************************************************
+ *          Public Entry Points
+ *******************************************************/
+int CholeskyInPlace(Matrix matrix){
+    if(isEmpty(matrix) || !isSquare(matrix)){
+        fprintf(stderr, "%s", "Error - Need an NxN matrix to compute a Cholesky factorization");
+        return -1;
+    }
+    size_t n = matrix->num_rows;
+    STATS_BEGIN();
+    int failed = (int)CholeskyDense(n, matrix->data, matrix->ld);
+    STATS_END(MATRIX_STAT_CHOLESKY, (double)n * n * n / 3);
+    return failed;
+}
+
+Matrix Cholesky(Matrix matrix){
+    if(isEmpty(matrix) || !isSquare(matrix)){
+        fprintf(stderr, "%s", "Error - Need an NxN matrix to compute a Cholesky factorization");
+        return NULL;
+    }
+    size_t n = matrix->num_rows;
+    Matrix new_matrix = NewMatrix(n, n);
+    if(!new_matrix)
+        return NULL;
+    int failed = CholeskyInto(new_matrix, matrix);
+    if(failed){
+        fprintf(stderr, "Error - Matrix is not positive definite (pivot %d)", failed - 1);
+        FreeMatrix(&new_matrix);
+    }
+    return new_matrix;
+}
+
+int CholeskyInto(Matrix factor, Matrix matrix){
+    if(isEmpty(matrix) || !isSquare(matrix) || isEmpty(factor) ||
+       factor->num_rows != matrix->num_rows || factor->num_cols != matrix->num_cols){
+        fprintf(stderr, "%s", "Error - Need two NxN matrices to compute a Cholesky factorization");
+        return -1;
+    }
+    size_t n = matrix->num_rows;
+    STATS_BEGIN();
+    if(factor->data != matrix->data){
+        // only the lower triangle of the input is read
+        for(size_t i = 0; i < n; i++){
+            memcpy(MATRIX_ROW(factor, i), MATRIX_ROW(matrix, i), (i + 1) * sizeof(double));
+            memset(MATRIX_ROW(factor, i) + i + 1, 0, (n - i - 1) * sizeof(double));
+        }
+    }
+    int failed = (int)CholeskyDense(n, factor->data, factor->ld);
+    STATS_END(MATRIX_STAT_CHOLESKY, (double)n * n * n / 3);
+    return failed;
+}
+
+int CholeskyPacked(Matrix matrix, double *packed){
+    if(isEmpty(matrix) || !isSquare(matrix) || !packed){
+        fprintf(stderr, "%s", "Error - Need an NxN matrix to compute a Cholesky factorization");
+        return -1;
+    }
+    size_t n = matrix->num_rows;
+    STATS_BEGIN();
+    int failed = (int)CholeskyPackedDense(n, matrix->data, matrix->ld, packed);
+    STATS_END(MATRIX_STAT_CHOLESKY, (double)n * n * n / 3);
+    return failed;
+}
+
+int CholeskySolveInPlace(Matrix factor, Matrix rhs){
+    if(isEmpty(factor) || !isSquare(factor) || isEmpty(rhs) || rhs->num_rows != factor->num_rows){
+        fprintf(stderr, "%s", "Error - Right-hand side must have as many rows as the factor");
+        return -1;
+    }
+    size_t n = factor->num_rows;
+    STATS_BEGIN();
+    CholeskySolveDense(n, factor->data, factor->ld, rhs->num_cols, rhs->data, rhs->ld);
+    STATS_END(MATRIX_STAT_CHOLESKY_SOLVE, 2.0 * n * n * rhs->num_cols);
+    return 0;
+}
+
+Matrix CholeskySolve(Matrix factor, Matrix rhs){
+    if(isEmpty(rhs))
+        return NULL;
+    Matrix solution = NewMatrix(rhs->num_rows, rhs->num_cols);
+    if(!solution)
+        return NULL;
+    for(size_t i = 0; i < rhs->num_rows; i++)
+        memcpy(MATRIX_ROW(solution, i), MATRIX_ROW(rhs, i), rhs->num_cols * sizeof(double));
+    if(CholeskySolveInPlace(factor, solution) != 0)
+        FreeMatrix(&solution);
+    return solution;
+}
+
+int CholeskySolvePacked(const double *packed, Matrix rhs){
+    if(!packed || isEmpty(rhs))
+        return -1;
+    size_t n = rhs->num_rows, k = rhs->num_cols;
+    STATS_BEGIN();
+    // L * Y = B
+    for(size_t i = 0; i < n; i++){
+        const double *row = packed + PACKED_INDEX(i, 0);
+        double *b_i = MATRIX_ROW(rhs, i);
+        for(size_t q = 0; q < i; q++)
+            if(row[q] != 0.0)
+                matrix_kernels->axpy(k, -row[q], MATRIX_ROW(rhs, q), b_i);
+        matrix_kernels->scale(k, 1.0 / row[i], b_i);
+    }
+    // L^T * X = Y
+    for(size_t i = n; i-- > 0;){
+        const double *row = packed + PACKED_INDEX(i, 0);
+        double *x_i = MATRIX_ROW(rhs, i);
+        matrix_kernels->scale(k, 1.0 / row[i], x_i);
+        for(size_t q = 0; q < i; q++)
+            if(row[q] != 0.0)
+                matrix_kernels->axpy(k, -row[q], x_i, MATRIX_ROW(rhs, q));
+    }
+    STATS_END(MATRIX_STAT_CHOLESKY_SOLVE, 2.0 * n * n * k);
+    return 0;
+}
+
+int CholeskyUpdate(Matrix factor, Matrix vectors, int downdate_flag){
+    if(isEmpty(factor) || !isSquare(factor) || isEmpty(vectors) || vectors->num_rows != factor->num_rows){
+        fprintf(stderr, "%s", "Error - Update vectors must have as many rows as the NxN factor");
+        return -1;
+    }
+    size_t n = factor->num_rows, k = vectors->num_cols;
+    double *scratch = (double*)ThreadScratch(5 * n * sizeof(double));
+    if(!scratch)
+        return -1;
+    STATS_BEGIN();
+    int status = 0;
+    for(size_t j = 0; j < k && status == 0; j++){
+        for(size_t i = 0; i < n; i++)
+            scratch[i] = MATRIX_AT(vectors, i, j);
+        if(CholeskyRankOneDense(n, factor->data, factor->ld, downdate_flag ? -1.0 : 1.0, scratch) != 0)
+            status = (int)j + 1;
+    }
+    STATS_END(MATRIX_STAT_FACTOR_UPDATE, 3.0 * n * n * k);
+    return status;
+}
+
+int CholeskyUpdateVector(Matrix factor, const double *vector, int downdate_flag){
+    if(isEmpty(factor) || !isSquare(factor) || !vector){
+        fprintf(stderr, "%s", "Error - Need an NxN factor and an update vector");
+        return -1;
+    }
+    size_t n = factor->num_rows;
+    double *scratch = (double*)ThreadScratch(5 * n * sizeof(double));
+    if(!scratch)
+        return -1;
+    STATS_BEGIN();
+    memcpy(scratch, vector, n * sizeof(double));
+    int status = CholeskyRankOneDense(n, factor->data, factor->ld, downdate_flag ? -1.0 : 1.0, scratch);
+    STATS_END(MATRIX_STAT_FACTOR_UPDATE, 3.0 * n * n);
+    return status;
+}
@@ -0,0 +1,573 @@
+/****************************
+ * Author: Blake A. Molina
+ * Created on: 10/17/26
+ * License: GPL
+ ****************************/
+
+#include <float.h>
+#include <stdatomic.h>
+#include "matrix_internal.h"
+
+// Columns reduced per panel before the trailing matrix gets its rank-2k
+// GEMM update; also the reflectors per block of the back-transformation
+#define EIGEN_BLOCK 32
+// QL sweeps allowed per eigenvalue before the iteration is declared stuck
+#define EIGEN_MAX_SWEEPS 60
+// Columns of the eigenvector rows rotated per task in a QL sweep
+#define ROTATION_COLUMNS 256
+
+#define DEFAULT_TOLERANCE 1e-8
+// Smallest Lanczos basis used when SolverOptions.restart is not given
+#define DEFAULT_BASIS 20
+// Vector entries handled per task by the Lanczos orthogonalization
+#define LANCZOS_CHUNK 2048
+
+/*************************************************************************
+ *  The dense solver follows LAPACK's xSYTRD + xSTEQR + xORMTR:
+ *
+ *   1. Q^T A Q = T (tridiagonal) by Householder reflectors, a panel of
+ *      EIGEN_BLOCK at a time (xLATRD): each column is brought up to date
+ *      with the panel's earlier reflectors just before it is reduced, and
+ *      the trailing matrix is updated once per panel by two GEMMs
+ *      (A22 -= V * W^T + W * V^T). A is stored whole, so column j is the
+ *      contiguous row j.
+ *   2. T = S * diag(d) * S^T by implicit QL with Wilkinson shifts. The
+ *      rotations act on rows of Z = S^T, each sweep's rotations applied
+ *      together to blocks of columns in parallel.
+ *   3. Eigenvectors Q * S, i.e. rows of Z * Q^T, applying the reflectors
+ *      in blocks through the compact WY form I - Y * T * Y^T (GEMMs).
+ ************************************************************************/
+
+/*******************************************************
+ *          Tridiagonal Reduction
+ *******************************************************/
+typedef struct{
+    const double *a, *v;
+    size_t lda, first, length;
+    double *y;
+}SymvJob;
+
+// y[i] = A[i][first:] . v[first:] for rows [first + begin, first + end)
+static void SymvTask(void *context, size_t begin, size_t end){
+    const SymvJob *job = (const SymvJob*)context;
+    for(size_t i = job->first + begin; i < job->first + end; i++)
+        job->y[i] = matrix_kernels->dot(job->length, job->a + i*job->lda + job->first, job->v + job->first);
+}
+
+// Reduces the symmetric n x n matrix at a (both triangles stored, destroyed)
+// to T: diagonal d, off-diagonal e[0..n-2] (e[n-1] = 0). Reflector j acts on
+// rows j+1..n-1; its vector is row j of v (zero up to column j, v[j][j+1] =
+// 1) and its scale tau[j]. w holds EIGEN_BLOCK rows of n doubles.
+static void Tridiagonalize(size_t n, double *a, size_t lda, double *d, double *e,
+                           double *v, size_t ldv, double *tau, double *w, size_t ldw){
+    for(size_t j0 = 0; j0 + 1 < n; j0 += EIGEN_BLOCK){
+        size_t width = n - 1 - j0 < EIGEN_BLOCK ? n - 1 - j0 : EIGEN_BLOCK;
+        for(size_t c = 0; c < width; c++){
+            size_t j = j0 + c, length = n - j - 1;
+            double *row = a + j*lda, *v_j = v + j*ldv, *w_j = w + c*ldw;
+            // column j (= row j) with the panel's pending updates applied
+            for(size_t q = 0; q < c; q++){
+                const double *v_q = v + (j0 + q)*ldv, *w_q = w + q*ldw;
+                matrix_kernels->axpy(n - j, -v_q[j], w_q + j, row + j);
+                matrix_kernels->axpy(n - j, -w_q[j], v_q + j, row + j);
+            }
+            d[j] = row[j];
+            memset(v_j, 0, (j + 1) * sizeof(double));
+            memcpy(v_j + j + 1, row + j + 1, length * sizeof(double));
+            tau[j] = HouseholderReflector(length, v_j + j + 1);
+            e[j] = v_j[j + 1];
+            v_j[j + 1] = 1.0;
+            memset(w_j, 0, (j + 1) * sizeof(double));
+            if(tau[j] == 0.0){
+                memset(w_j + j + 1, 0, length * sizeof(double));
+                continue;
+            }
+            // y = A22 * v with A22 as it was when the panel started...
+            SymvJob job = {a, v_j, lda, j + 1, length, w_j};
+            ParallelFor(length, 16384 / length + 1, SymvTask, &job);
+            // ...less the panel's pending V * W^T + W * V^T
+            for(size_t q = 0; q < c; q++){
+                const double *v_q = v + (j0 + q)*ldv, *w_q = w + q*ldw;
+                double wv = matrix_kernels->dot(length, w_q + j + 1, v_j + j + 1);
+                double vv = matrix_kernels->dot(length, v_q + j + 1, v_j + j + 1);
+                matrix_kernels->axpy(length, -wv, v_q + j + 1, w_j + j + 1);
+                matrix_kernels->axpy(length, -vv, w_q + j + 1, w_j + j + 1);
+            }
+            // w = tau * y - (tau^2 / 2) * (y . v) * v, so H A H = A - v w^T - w v^T
+            matrix_kernels->scale(length, tau[j], w_j + j + 1);
+            double alpha = -0.5 * tau[j] * matrix_kernels->dot(length, w_j + j + 1, v_j + j + 1);
+            matrix_kernels->axpy(length, alpha, v_j + j + 1, w_j + j + 1);
+        }
+        size_t s = j0 + width;
+        DenseGemm(1, 0, n - s, n - s, width, -1.0, v + j0*ldv + s, ldv, w + s, ldw, 1.0, a + s*lda + s, lda);
+        DenseGemm(1, 0, n - s, n - s, width, -1.0, w + s, ldw, v + j0*ldv + s, ldv, 1.0, a + s*lda + s, lda);
+    }
+    d[n - 1] = a[(n - 1)*lda + n - 1];
+    e[n - 1] = 0.0;
+}
+
+
+/*******************************************************
+ *          Tridiagonal QL Iteration
+ *******************************************************/
+typedef struct{
+    double *z;
+    size_t ldz, n, low, high;  // rotation i (low <= i < high) mixes rows i and i+1
+    const double *cosine, *sine;
+}RotationJob;
+
+// Applies the sweep's rotations, last to first, to columns [begin, end) blocks
+static void RotationTask(void *context, size_t begin, size_t end){
+    const RotationJob *job = (const RotationJob*)context;
+    size_t from = begin * ROTATION_COLUMNS;
+    size_t to = end * ROTATION_COLUMNS < job->n ? end * ROTATION_COLUMNS : job->n;
+    for(size_t i = job->high; i-- > job->low;){
+        double *restrict upper = job->z + i*job->ldz;
+        double *restrict lower = upper + job->ldz;
+        const double c = job->cosine[i], s = job->sine[i];
+        for(size_t k = from; k < to; k++){
+            double f = lower[k];
+            lower[k] = s * upper[k] + c * f;
+            upper[k] = c * upper[k] - s * f;
+        }
+    }
+}
+
+// Eigenvalues of the symmetric tridiagonal (d, e) into d, by implicit QL with
+// Wilkinson shifts (EISPACK tql2). When z is given, its rows 0..n-1 (Z = S^T)
+// take the rotations; cosine and sine hold n values each. Returns 0, or -1
+// when an eigenvalue does not converge.
+static int TridiagonalQL(size_t n, double *d, double *e, double *z, size_t ldz,
+                         double *cosine, double *sine){
+    for(size_t l = 0; l < n; l++){
+        size_t sweeps = 0, m;
+        for(;;){
+            for(m = l; m + 1 < n; m++){
+                double scale = fabs(d[m]) + fabs(d[m + 1]);
+                if(fabs(e[m]) <= DBL_EPSILON * scale)
+                    break;
+            }
+            if(m == l)
+                break;
+            if(sweeps++ == EIGEN_MAX_SWEEPS)
+                return -1;
+            double g = (d[l + 1] - d[l]) / (2.0 * e[l]);
+            double r = hypot(g, 1.0);
+            g = d[m] - d[l] + e[l] / (g + copysign(r, g));
+            double s = 1.0, c = 1.0, p = 0.0;
+            size_t i = m, low = l;
+            int deflated = 0;
+            while(i-- > l){
+                double f = s * e[i], b = c * e[i];
+                e[i + 1] = r = hypot(f, g);
+                if(r == 0.0){
+                    // underflow: the matrix splits here, restart the sweep
+                    d[i + 1] -= p;
+                    e[m] = 0.0;
+                    deflated = 1;
+                    low = i + 1;
+                    break;
+                }
+                s = f / r;
+                c = g / r;
+                g = d[i + 1] - p;
+                r = (d[i] - g) * s + 2.0 * c * b;
+                p = s * r;
+                d[i + 1] = g + p;
+                g = c * r - b;
+                cosine[i] = c;
+                sine[i] = s;
+            }
+            if(z && low < m){
+                RotationJob job = {z, ldz, n, low, m, cosine, sine};
+                ParallelFor((n + ROTATION_COLUMNS - 1) / ROTATION_COLUMNS, 1, RotationTask, &job);
+            }
+            if(deflated)
+                continue;
+            d[l] -= p;
+            e[l] = g;
+            e[m] = 0.0;
+        }
+    }
+    return 0;
+}
+
+
+/*******************************************************
+ *          Back-Transformation & Driver
+ *******************************************************/
+// Rows of z (count x n) = z * Q^T, Q = H_0 * H_1 * ... * H_{n-2}. Blocks of
+// reflectors, last block first: z -= ((z * Y) * T^T) * Y^T with the block
+// written I - Y * T * Y^T (xLARFT, forward). zy is count x EIGEN_BLOCK.
+static void BackTransform(size_t n, size_t count, const double *v, size_t ldv, const double *tau,
+                          double *z, size_t ldz, double *zy, double *zyt){
+    double t[EIGEN_BLOCK * EIGEN_BLOCK];
+    size_t reflectors = n - 1;
+    size_t blocks = (reflectors + EIGEN_BLOCK - 1) / EIGEN_BLOCK;
+    for(size_t block = blocks; block-- > 0;){
+        size_t j0 = block * EIGEN_BLOCK;
+        size_t width = reflectors - j0 < EIGEN_BLOCK ? reflectors - j0 : EIGEN_BLOCK;
+        size_t s = j0 + 1;
+        const double *y = v + j0*ldv;
+        // T upper triangular: T[i][i] = tau_i, T[0:i][i] = -tau_i T[0:i][0:i] Y^T y_i
+        for(size_t i = 0; i < width; i++){
+            const double *y_i = y + i*ldv;
+            double overlap[EIGEN_BLOCK];
+            for(size_t q = 0; q < i; q++)
+                overlap[q] = matrix_kernels->dot(n - s - i, y + q*ldv + s + i, y_i + s + i);
+            for(size_t q = 0; q < i; q++){
+                double sum = 0.0;
+                for(size_t r = q; r < i; r++)
+                    sum += t[q*EIGEN_BLOCK + r] * overlap[r];
+                t[q*EIGEN_BLOCK + i] = -tau[j0 + i] * sum;
+            }
+            t[i*EIGEN_BLOCK + i] = tau[j0 + i];
+            for(size_t q = i + 1; q < width; q++)
+                t[q*EIGEN_BLOCK + i] = 0.0;
+        }
+        DenseGemm(0, 1, count, width, n - s, 1.0, z + s, ldz, y + s, ldv, 0.0, zy, EIGEN_BLOCK);
+        DenseGemm(0, 1, count, width, width, 1.0, zy, EIGEN_BLOCK, t, EIGEN_BLOCK, 0.0, zyt, EIGEN_BLOCK);
+        DenseGemm(0, 0, count, n - s, width, -1.0, zyt, EIGEN_BLOCK, y + s, ldv, 1.0, z + s, ldz);
+    }
+}
+
+// Eigenvalues (ascending) of the symmetric n x n matrix at a, whose lower
+// triangle is read and which is destroyed. When z is given its row i
+// receives the unit eigenvector of values[i]. Returns 0, -1 on a memory
+// failure or when the QL iteration does not converge.
+static int SymmetricEigenDense(size_t n, double *a, size_t lda, double *values, double *z, size_t ldz){
+    for(size_t i = 0; i < n; i++)
+        for(size_t j = i + 1; j < n; j++)
+            a[i*lda + j] = a[j*lda + i];
+    size_t ldv = (n + 7) / 8 * 8;
+    size_t doubles = n * ldv + EIGEN_BLOCK * ldv + 5 * n + 2 * n * EIGEN_BLOCK;
+    double *work = (double*)AllocateAligned(doubles * sizeof(double));
+    if(!work)
+        return -1;
+    double *v = work, *w = v + n * ldv, *e = w + EIGEN_BLOCK * ldv;
+    double *tau = e + n, *cosine = tau + n, *sine = cosine + n, *scratch = sine + n;
+    double *zy = scratch + n, *zyt = zy + n * EIGEN_BLOCK;
+
+    Tridiagonalize(n, a, lda, values, e, v, ldv, tau, w, ldv);
+    if(z){
+        for(size_t i = 0; i < n; i++){
+            memset(z + i*ldz, 0, n * sizeof(double));
+            z[i*ldz + i] = 1.0;
+        }
+    }
+    int status = TridiagonalQL(n, values, e, z, ldz, cosine, sine);
+    if(status == 0){
+        // ascending order, moving the eigenvector rows along
+        for(size_t i = 0; i + 1 < n; i++){
+            size_t smallest = i;
+            for(size_t j = i + 1; j < n; j++)
+                if(values[j] < values[smallest])
+                    smallest = j;
+            if(smallest != i){
+                double temp = values[i];
+                values[i] = values[smallest];
+                values[smallest] = temp;
+                if(z)
+                    matrix_kernels->swap(n, z + i*ldz, z + smallest*ldz);
+            }
+        }
+        if(z && n > 1)
+            BackTransform(n, n, v, ldv, tau, z, ldz, zy, zyt);
+    }
+    FreeAligned(work);
+    return status;
+}
+
+int SymmetricEigen(Matrix matrix, double *eigenvalues, Matrix eigenvectors){
+    if(isEmpty(matrix) || !isSquare(matrix) || !eigenvalues ||
+       (eigenvectors && (isEmpty(eigenvectors) || eigenvectors->num_rows != matrix->num_rows ||
+                         eigenvectors->num_cols != matrix->num_cols))){
+        fprintf(stderr, "%s", "Error - Need an NxN symmetric matrix, N eigenvalues and an NxN eigenvector matrix");
+        return -1;
+    }
+    if(eigenvectors && MatricesOverlap(eigenvectors, matrix)){
+        fprintf(stderr, "%s", "Error - Eigenvectors cannot overwrite the matrix");
+        return -1;
+    }
+    size_t n = matrix->num_rows;
+    Matrix copy = NewMatrix(n, n);
+    if(!copy)
+        return -1;
+    STATS_BEGIN();
+    for(size_t i = 0; i < n; i++)
+        memcpy(MATRIX_ROW(copy, i), MATRIX_ROW(matrix, i), (i + 1) * sizeof(double));
+    int status = SymmetricEigenDense(n, copy->data, copy->ld, eigenvalues,
+                                     eigenvectors ? eigenvectors->data : NULL, eigenvectors ? eigenvectors->ld : 0);
+    // the rows hold the eigenvectors; the columns should
+    if(status == 0 && eigenvectors)
+        TransposeSquareDense(n, eigenvectors->data, eigenvectors->ld);
+    if(status != 0)
+        fprintf(stderr, "%s", "Error - Eigenvalue iteration did not converge");
+    FreeMatrix(&copy);
+    STATS_END(MATRIX_STAT_EIGEN, eigenvectors ? 9.0 * n * n * n : 4.0 * n * n * n / 3);
+    return status;
+}
+
+
+/*******************************************************
+ *          Thick-Restart Lanczos
+ *******************************************************/
+/*************************************************************************
+ *  Lanczos with full reorthogonalization (classical Gram-Schmidt, twice)
+ *  and thick restarts (Wu & Simon). The basis is kept as rows of V, and H
+ *  = V^T A V is filled in from the Gram-Schmidt coefficients. Once the
+ *  basis is full, the Ritz pairs of H come from the dense solver above;
+ *  the `keep` of largest magnitude become the start of the next basis (V
+ *  <- Y^T V) followed by the last residual vector, which keeps
+ *  A V = V H + beta * v * e^T exact across restarts. All vector work runs
+ *  over column chunks of V in parallel, so only A touches the whole
+ *  vectors at once.
+ ************************************************************************/
+typedef struct{
+    size_t n, stride, chunks;
+    double *v;           // (basis + 1) rows of stride doubles
+    double *partial;     // chunks x (basis + 1) partial dot products
+    double *projection;  // basis + 1 coefficients
+    double *w;
+    size_t count;
+    const double *selected;  // rows of Y^T being combined (count x basis)
+    size_t basis, residual;  // (Recombine) basis size; row to move into row count
+    atomic_int failed;       // (Recombine) a thread found no scratch space
+}LanczosJob;
+
+static void ProjectTask(void *context, size_t begin, size_t end){
+    const LanczosJob *job = (const LanczosJob*)context;
+    for(size_t chunk = begin; chunk < end; chunk++){
+        size_t from = chunk * LANCZOS_CHUNK;
+        size_t length = job->n - from < LANCZOS_CHUNK ? job->n - from : LANCZOS_CHUNK;
+        for(size_t i = 0; i < job->count; i++)
+            job->partial[chunk * job->count + i] =
+                matrix_kernels->dot(length, job->v + i*job->stride + from, job->w + from);
+    }
+}
+
+static void SubtractTask(void *context, size_t begin, size_t end){
+    const LanczosJob *job = (const LanczosJob*)context;
+    for(size_t chunk = begin; chunk < end; chunk++){
+        size_t from = chunk * LANCZOS_CHUNK;
+        size_t length = job->n - from < LANCZOS_CHUNK ? job->n - from : LANCZOS_CHUNK;
+        for(size_t i = 0; i < job->count; i++)
+            matrix_kernels->axpy(length, -job->projection[i], job->v + i*job->stride + from, job->w + from);
+    }
+}
+
+// Rows [0, count) of V <- selected * V[0..basis) and row count <- row
+// residual, chunk by chunk through per-thread scratch
+static void RecombineTask(void *context, size_t begin, size_t end){
+    LanczosJob *job = (LanczosJob*)context;
+    double *temp = (double*)ThreadScratch(job->count * LANCZOS_CHUNK * sizeof(double));
+    if(!temp){
+        atomic_store(&job->failed, 1);
+        return;
+    }
+    for(size_t chunk = begin; chunk < end; chunk++){
+        size_t from = chunk * LANCZOS_CHUNK;
+        size_t length = job->n - from < LANCZOS_CHUNK ? job->n - from : LANCZOS_CHUNK;
+        DenseGemm(0, 0, job->count, length, job->basis, 1.0, job->selected, job->basis,
+                  job->v + from, job->stride, 0.0, temp, LANCZOS_CHUNK);
+        for(size_t i = 0; i < job->count; i++)
+            memcpy(job->v + i*job->stride + from, temp + i*LANCZOS_CHUNK, length * sizeof(double));
+        if(job->residual != job->count)
+            memcpy(job->v + job->count*job->stride + from, job->v + job->residual*job->stride + from,
+                   length * sizeof(double));
+    }
+}
+
+// w -= V[0..count) projections, twice; the coefficients go to h
+static void Orthogonalize(LanczosJob *job, size_t count, double *w, double *h){
+    job->count = count;
+    job->w = w;
+    for(size_t i = 0; i < count; i++)
+        h[i] = 0.0;
+    for(int pass = 0; pass < 2; pass++){
+        ParallelFor(job->chunks, 1, ProjectTask, job);
+        for(size_t i = 0; i < count; i++){
+            double sum = 0.0;
+            for(size_t chunk = 0; chunk < job->chunks; chunk++)
+                sum += job->partial[chunk * count + i];
+            job->projection[i] = sum;
+            h[i] += sum;
+        }
+        ParallelFor(job->chunks, 1, SubtractTask, job);
+    }
+}
+
+// Fills w with a pseudo-random unit vector orthogonal to V[0..count).
+// Returns 0, or -1 when V already spans the whole space.
+static int RandomVector(LanczosJob *job, size_t count, double *w, uint64_t *seed, double *h){
+    for(int attempt = 0; attempt < 3; attempt++){
+        for(size_t i = 0; i < job->n; i++){
+            *seed = *seed * 6364136223846793005ULL + 1442695040888963407ULL;
+            w[i] = (double)(*seed >> 11) / 9007199254740992.0 - 0.5;
+        }
+        double norm_before = sqrt(matrix_kernels->dot(job->n, w, w));
+        if(count)
+            Orthogonalize(job, count, w, h);
+        double norm = sqrt(matrix_kernels->dot(job->n, w, w));
+        if(norm > 1e-8 * norm_before){
+            matrix_kernels->scale(job->n, 1.0 / norm, w);
+            return 0;
+        }
+    }
+    return -1;
+}
+
+int DominantEigenpairs(const LinearOperator *op, size_t k, double *eigenvalues, Matrix eigenvectors,
+                       const SolverOptions *options, SolverReport *report){
+    if(!op || !op->apply || op->size == 0 || k == 0 || k > op->size || !eigenvalues ||
+       (op->dense && op->dense->num_cols != op->size) || (op->sparse && op->sparse->num_cols != op->size) ||
+       (eigenvectors && (isEmpty(eigenvectors) || eigenvectors->num_rows != op->size || eigenvectors->num_cols != k))){
+        fprintf(stderr, "%s", "Error - Need a square operator, 1 <= k <= N eigenvalues and an Nxk eigenvector matrix");
+        return -1;
+    }
+    const size_t n = op->size;
+    double tolerance = options && options->tolerance > 0.0 ? options->tolerance : DEFAULT_TOLERANCE;
+    size_t max_iterations = options && options->max_iterations ? options->max_iterations : (n > 1000 ? n : 1000);
+    size_t basis = options && options->restart ? options->restart : 2 * k + 10;
+    if(basis < DEFAULT_BASIS)
+        basis = DEFAULT_BASIS;
+    if(basis <= k)
+        basis = k + 1;
+    if(basis > n)
+        basis = n;
+    const size_t keep = k + (basis - k) / 2;
+
+    STATS_BEGIN();
+    LanczosJob job;
+    atomic_init(&job.failed, 0);
+    job.n = n;
+    job.stride = (n + 7) / 8 * 8;
+    job.chunks = (n + LANCZOS_CHUNK - 1) / LANCZOS_CHUNK;
+    size_t h_size = (basis + 1) * (basis + 1);
+    size_t doubles = (basis + 1) * job.stride + job.chunks * (basis + 1) + 3 * (basis + 1) + h_size + 2 * basis * basis + basis;
+    double *work = (double*)AllocateAligned(doubles * sizeof(double));
+    size_t *order = (size_t*)malloc(basis * sizeof(size_t));
+    if(!work || !order){
+        fprintf(stderr, "%s", "Error - Could not allocate solver workspace");
+        FreeAligned(work);
+        free(order);
+        return -1;
+    }
+    job.v = work;
+    job.partial = job.v + (basis + 1) * job.stride;
+    job.projection = job.partial + job.chunks * (basis + 1);
+    double *column = job.projection + basis + 1, *discard = column + basis + 1;
+    double *h = discard + basis + 1, *h_copy = h + h_size;
+    double *ritz_vectors = h_copy + basis * basis, *ritz_values = ritz_vectors + basis * basis;
+    double *selected = h_copy;  // free once the Ritz pairs are known
+    const size_t ldh = basis + 1;
+    memset(h, 0, h_size * sizeof(double));
+
+    uint64_t seed = 0x9E3779B97F4A7C15ULL;
+    RandomVector(&job, 0, job.v, &seed, discard);
+    size_t active = 0, iterations = 0, m = basis;
+    double beta = 0.0, worst = INFINITY;
+    int status = 1;
+    for(;;){
+        // extend the basis to m vectors, v_m (row m) holding the residual direction
+        for(size_t j = active; j < m; j++){
+            double *w = job.v + (j + 1)*job.stride;
+            op->apply(op->context, job.v + j*job.stride, w);
+            iterations++;
+            double applied = sqrt(matrix_kernels->dot(n, w, w));
+            Orthogonalize(&job, j + 1, w, column);
+            for(size_t i = 0; i <= j; i++)
+                h[i*ldh + j] = h[j*ldh + i] = column[i];
+            beta = sqrt(matrix_kernels->dot(n, w, w));
+            if(beta <= 8.0 * DBL_EPSILON * applied){
+                // invariant subspace: go on in a fresh direction, uncoupled
+                beta = 0.0;
+                if(RandomVector(&job, j + 1, w, &seed, discard) != 0){
+                    m = j + 1;  // the basis spans everything
+                    break;
+                }
+            }
+            else
+                matrix_kernels->scale(n, 1.0 / beta, w);
+            h[(j + 1)*ldh + j] = h[j*ldh + j + 1] = beta;
+        }
+
+        // Ritz pairs, by decreasing magnitude
+        for(size_t i = 0; i < m; i++)
+            memcpy(h_copy + i*m, h + i*ldh, m * sizeof(double));
+        if(SymmetricEigenDense(m, h_copy, m, ritz_values, ritz_vectors, m) != 0){
+            fprintf(stderr, "%s", "Error - Eigenvalue iteration on the Lanczos basis did not converge");
+            status = -1;
+            break;
+        }
+        for(size_t i = 0; i < m; i++)
+            order[i] = i;
+        for(size_t i = 1; i < m; i++)
+            for(size_t j = i; j > 0 && fabs(ritz_values[order[j]]) > fabs(ritz_values[order[j - 1]]); j--){
+                size_t temp = order[j];
+                order[j] = order[j - 1];
+                order[j - 1] = temp;
+            }
+        double scale = fabs(ritz_values[order[0]]) > 0.0 ? fabs(ritz_values[order[0]]) : 1.0;
+        worst = 0.0;
+        for(size_t i = 0; i < k; i++){
+            double residual = fabs(beta * ritz_vectors[order[i]*m + m - 1]) / scale;
+            worst = residual > worst ? residual : worst;
+        }
+        if(report){
+            report->iterations = iterations;
+            report->residual = worst;
+            report->converged = worst <= tolerance;
+        }
+        if(options && options->monitor)
+            options->monitor(iterations, worst, options->monitor_context);
+        int done = worst <= tolerance || m < basis;
+        if(done || iterations >= max_iterations){
+            status = done ? 0 : 1;
+            if(report)
+                report->converged = status == 0;
+            for(size_t i = 0; i < k; i++)
+                memcpy(selected + i*m, ritz_vectors + order[i]*m, m * sizeof(double));
+            if(eigenvectors){
+                job.count = k;
+                job.selected = selected;
+                job.basis = m;
+                job.residual = k;
+                ParallelFor(job.chunks, 1, RecombineTask, &job);
+                if(atomic_load(&job.failed)){
+                    fprintf(stderr, "%s", "Error - Could not allocate solver workspace");
+                    status = -1;
+                    break;
+                }
+                TransposeDense(k, n, job.v, job.stride, eigenvectors->data, eigenvectors->ld);
+            }
+            for(size_t i = 0; i < k; i++)
+                eigenvalues[i] = ritz_values[order[i]];
+            break;
+        }
+
+        // thick restart: the kept Ritz vectors, then the residual direction
+        for(size_t i = 0; i < keep; i++)
+            memcpy(selected + i*m, ritz_vectors + order[i]*m, m * sizeof(double));
+        job.count = keep;
+        job.selected = selected;
+        job.basis = m;
+        job.residual = m;
+        ParallelFor(job.chunks, 1, RecombineTask, &job);
+        if(atomic_load(&job.failed)){
+            fprintf(stderr, "%s", "Error - Could not allocate solver workspace");
+            status = -1;
+            break;
+        }
+        memset(h, 0, h_size * sizeof(double));
+        for(size_t i = 0; i < keep; i++){
+            h[i*ldh + i] = ritz_values[order[i]];
+            h[keep*ldh + i] = h[i*ldh + keep] = beta * ritz_vectors[order[i]*m + m - 1];
+        }
+        active = keep;
+    }
+    FreeAligned(work);
+    free(order);
+    STATS_END(MATRIX_STAT_EIGEN, 0);
+    return status;
+}
@@ -0,0 +1,363 @@
+/****************************
+ * Author: Blake A. Molina
+ * Created on: 10/17/26
+ * License: GPL
+ ****************************/
+
+#include "matrix_internal.h"
+
+// Node kinds
+#define EXPR_LEAF      0
+#define EXPR_ADD       1
+#define EXPR_SUBTRACT  2
+#define EXPR_SCALE     3
+#define EXPR_MULTIPLY  4
+#define EXPR_TRANSPOSE 5
+
+// Tile of the fused elementwise pass: rows x columns of the result
+#define EXPR_TILE_ROWS 32
+#define EXPR_TILE_COLS 256
+
+struct expr_node_struct{
+    int kind;
+    size_t num_rows, num_cols;  // shape of the node's value
+    MatrixExpr left, right;     // operands (right only for binary kinds)
+    double alpha;               // EXPR_SCALE factor
+    Matrix matrix;              // EXPR_LEAF matrix (borrowed)
+    MatrixExprGraph graph;
+};
+
+struct expr_graph_struct{
+    MatrixExpr *nodes;
+    size_t count, capacity;
+};
+
+/*******************************************************
+ *          Graph & Node Construction
+ *******************************************************/
+MatrixExprGraph NewMatrixExprGraph(void){
+    MatrixExprGraph graph = (MatrixExprGraph)calloc(1, sizeof(struct expr_graph_struct));
+    if(!graph)
+        fprintf(stderr, "%s", "Error - Could not allocate expression graph");
+    return graph;
+}
+
+void FreeMatrixExprGraph(MatrixExprGraph *graph){
+    if(graph && *graph){
+        for(size_t i = 0; i < (*graph)->count; i++)
+            free((*graph)->nodes[i]);
+        free((*graph)->nodes);
+        free(*graph);
+        *graph = NULL;
+    }
+}
+
+static MatrixExpr NewNode(MatrixExprGraph graph, int kind, size_t num_rows, size_t num_cols,
+                          MatrixExpr left, MatrixExpr right){
+    if(graph->count == graph->capacity){
+        size_t capacity = graph->capacity ? graph->capacity * 2 : 16;
+        MatrixExpr *grown = (MatrixExpr*)realloc(graph->nodes, capacity * sizeof(MatrixExpr));
+        if(!grown){
+            fprintf(stderr, "%s", "Error - Could not allocate expression node");
+            return NULL;
+        }
+        graph->nodes = grown;
+        graph->capacity = capacity;
+    }
+    MatrixExpr node = (MatrixExpr)calloc(1, sizeof(struct expr_node_struct));
+    if(!node){
+        fprintf(stderr, "%s", "Error - Could not allocate expression node");
+        return NULL;
+    }
+    node->kind = kind;
+    node->num_rows = num_rows;
+    node->num_cols = num_cols;
+    node->left = left;
+    node->right = right;
+    node->graph = graph;
+    graph->nodes[graph->count++] = node;
+    return node;
+}
+
+MatrixExpr ExprMatrix(MatrixExprGraph graph, Matrix matrix){
+    if(!graph || isEmpty(matrix))
+        return NULL;
+    MatrixExpr node = NewNode(graph, EXPR_LEAF, matrix->num_rows, matrix->num_cols, NULL, NULL);
+    if(node)
+        node->matrix = matrix;
+    return node;
+}
+
+// Sum or difference of two expressions of one shape from one graph
+static MatrixExpr Elementwise(int kind, MatrixExpr left, MatrixExpr right){
+    if(!left || !right)
+        return NULL;
+    if(left->graph != right->graph || left->num_rows != right->num_rows || left->num_cols != right->num_cols){
+        fprintf(stderr, "%s", "Error - Need expressions of the same size (and graph) to add or subtract");
+        return NULL;
+    }
+    return NewNode(left->graph, kind, left->num_rows, left->num_cols, left, right);
+}
+
+MatrixExpr ExprAdd(MatrixExpr left, MatrixExpr right){
+    return Elementwise(EXPR_ADD, left, right);
+}
+
+MatrixExpr ExprSubtract(MatrixExpr left, MatrixExpr right){
+    return Elementwise(EXPR_SUBTRACT, left, right);
+}
+
+MatrixExpr ExprScale(MatrixExpr expr, double alpha){
+    if(!expr)
+        return NULL;
+    MatrixExpr node = NewNode(expr->graph, EXPR_SCALE, expr->num_rows, expr->num_cols, expr, NULL);
+    if(node)
+        node->alpha = alpha;
+    return node;
+}
+
+MatrixExpr ExprMultiply(MatrixExpr left, MatrixExpr right){
+    if(!left || !right)
+        return NULL;
+    if(left->graph != right->graph || left->num_cols != right->num_rows){
+        fprintf(stderr, "%s", "Error - Expression A's column count must equal expression B's row count to multiply");
+        return NULL;
+    }
+    return NewNode(left->graph, EXPR_MULTIPLY, left->num_rows, right->num_cols, left, right);
+}
+
+MatrixExpr ExprTranspose(MatrixExpr expr){
+    if(!expr)
+        return NULL;
+    return NewNode(expr->graph, EXPR_TRANSPOSE, expr->num_cols, expr->num_rows, expr, NULL);
+}
+
+
+/*******************************************************
+ *          Normalization
+ *******************************************************/
+// An expression is evaluated as a linear combination of terms:
+//   coef * op(leaf)                   (fused into one elementwise pass)
+//   coef * op(left) * op(right)       (one GEMM each, accumulating)
+// Scales become coefficients and transposes are pushed down to the leaves
+// and GEMM operands, where they cost nothing.
+typedef struct{
+    double coef;
+    int trans;
+    Matrix matrix;
+}LeafTerm;
+
+typedef struct{
+    double coef;
+    MatrixExpr left, right;
+    int trans_left, trans_right;
+}ProductTerm;
+
+typedef struct{
+    LeafTerm *leaves;
+    size_t num_leaves, leaf_capacity;
+    ProductTerm *products;
+    size_t num_products, product_capacity;
+}TermList;
+
+static int Grow(void **array, size_t *capacity, size_t count, size_t size){
+    if(count < *capacity)
+        return 0;
+    size_t grown_capacity = *capacity ? *capacity * 2 : 8;
+    void *grown = realloc(*array, grown_capacity * size);
+    if(!grown)
+        return -1;
+    *array = grown;
+    *capacity = grown_capacity;
+    return 0;
+}
+
+static int Normalize(MatrixExpr node, double coef, int trans, TermList *terms){
+    switch(node->kind){
+    case EXPR_LEAF:
+        if(Grow((void**)&terms->leaves, &terms->leaf_capacity, terms->num_leaves, sizeof(LeafTerm)) != 0)
+            return -1;
+        terms->leaves[terms->num_leaves++] = (LeafTerm){coef, trans, node->matrix};
+        return 0;
+    case EXPR_ADD:
+    case EXPR_SUBTRACT:
+        if(Normalize(node->left, coef, trans, terms) != 0)
+            return -1;
+        return Normalize(node->right, node->kind == EXPR_ADD ? coef : -coef, trans, terms);
+    case EXPR_SCALE:
+        return Normalize(node->left, coef * node->alpha, trans, terms);
+    case EXPR_TRANSPOSE:
+        return Normalize(node->left, coef, !trans, terms);
+    default: // EXPR_MULTIPLY; (L*R)^T = R^T * L^T
+        if(Grow((void**)&terms->products, &terms->product_capacity, terms->num_products, sizeof(ProductTerm)) != 0)
+            return -1;
+        terms->products[terms->num_products++] = trans ? (ProductTerm){coef, node->right, node->left, 1, 1}
+                                                       : (ProductTerm){coef, node->left, node->right, 0, 0};
+        return 0;
+    }
+}
+
+// Strips transposes and scales off a GEMM operand, folding them into its
+// transpose flag and the term's coefficient
+static MatrixExpr PeelOperand(MatrixExpr node, int *trans, double *coef){
+    for(;;){
+        if(node->kind == EXPR_TRANSPOSE)
+            *trans = !*trans;
+        else if(node->kind == EXPR_SCALE)
+            *coef *= node->alpha;
+        else
+            return node;
+        node = node->left;
+    }
+}
+
+// Whether any leaf under node shares storage with result
+static int ExprReadsMatrix(MatrixExpr node, Matrix result){
+    if(node->kind == EXPR_LEAF)
+        return MatricesOverlap(result, node->matrix);
+    return ExprReadsMatrix(node->left, result) || (node->right && ExprReadsMatrix(node->right, result));
+}
+
+// Whether writing result while reading the terms could clobber an input:
+// any leaf under a GEMM operand (nested ones are evaluated after the fused
+// pass has written result), or a transposed leaf or shifted view that
+// shares storage with the result (a plain leaf that is the result itself
+// is read element by element before that element is written)
+static int ResultAliasesInput(Matrix result, const TermList *terms){
+    for(size_t t = 0; t < terms->num_leaves; t++){
+        Matrix leaf = terms->leaves[t].matrix;
+        int same_storage = leaf->data == result->data && leaf->ld == result->ld;
+        if((terms->leaves[t].trans || !same_storage) && MatricesOverlap(result, leaf))
+            return 1;
+    }
+    for(size_t t = 0; t < terms->num_products; t++){
+        const ProductTerm *term = &terms->products[t];
+        if(ExprReadsMatrix(term->left, result) || ExprReadsMatrix(term->right, result))
+            return 1;
+    }
+    return 0;
+}
+
+
+/*******************************************************
+ *          Fused Elementwise Pass
+ *******************************************************/
+typedef struct{
+    Matrix result;
+    const LeafTerm *leaves;
+    size_t num_leaves;
+}FusedJob;
+
+// result = sum of coef * op(leaf) over row tiles [begin, end). Each tile
+// row is accumulated in a small buffer and stored once, so a leaf that is
+// also the result is read before it is overwritten, and a transposed leaf
+// is read through an EXPR_TILE_COLS x EXPR_TILE_ROWS block that stays in
+// cache.
+static void FusedTask(void *context, size_t begin, size_t end){
+    const FusedJob *job = (const FusedJob*)context;
+    Matrix result = job->result;
+    _Alignas(MATRIX_ALIGNMENT) double sum[EXPR_TILE_COLS];
+    size_t row_end = end * EXPR_TILE_ROWS < result->num_rows ? end * EXPR_TILE_ROWS : result->num_rows;
+    for(size_t j0 = 0; j0 < result->num_cols; j0 += EXPR_TILE_COLS){
+        size_t width = result->num_cols - j0 < EXPR_TILE_COLS ? result->num_cols - j0 : EXPR_TILE_COLS;
+        for(size_t i = begin * EXPR_TILE_ROWS; i < row_end; i++){
+            memset(sum, 0, width * sizeof(double));
+            for(size_t t = 0; t < job->num_leaves; t++){
+                const LeafTerm *term = &job->leaves[t];
+                if(!term->trans)
+                    matrix_kernels->add(width, sum, term->coef, MATRIX_ROW(term->matrix, i) + j0, sum);
+                else{
+                    const double *column = term->matrix->data + j0 * term->matrix->ld + i;
+                    for(size_t j = 0; j < width; j++)
+                        sum[j] += term->coef * column[j * term->matrix->ld];
+                }
+            }
+            memcpy(MATRIX_ROW(result, i) + j0, sum, width * sizeof(double));
+        }
+    }
+}
+
+
+/*******************************************************
+ *          Evaluation
+ *******************************************************/
+static int Evaluate(Matrix result, MatrixExpr expr);
+
+// Runs one product term into result (beta 0 overwrites, 1 accumulates).
+// Operands that are not plain matrices are evaluated into a temporary.
+static int EvaluateProduct(Matrix result, const ProductTerm *term, double beta){
+    int trans_left = term->trans_left, trans_right = term->trans_right;
+    double coef = term->coef;
+    MatrixExpr left = PeelOperand(term->left, &trans_left, &coef);
+    MatrixExpr right = PeelOperand(term->right, &trans_right, &coef);
+    Matrix operands[2] = {NULL, NULL}, temporaries[2] = {NULL, NULL};
+    MatrixExpr nodes[2] = {left, right};
+    int status = 0;
+    for(int side = 0; side < 2 && status == 0; side++){
+        if(nodes[side]->kind == EXPR_LEAF){
+            operands[side] = nodes[side]->matrix;
+            continue;
+        }
+        temporaries[side] = NewMatrix(nodes[side]->num_rows, nodes[side]->num_cols);
+        status = temporaries[side] ? Evaluate(temporaries[side], nodes[side]) : -1;
+        operands[side] = temporaries[side];
+    }
+    if(status == 0){
+        size_t k = trans_left ? operands[0]->num_rows : operands[0]->num_cols;
+        DenseGemm(trans_left, trans_right, result->num_rows, result->num_cols, k,
+                  coef, operands[0]->data, operands[0]->ld, operands[1]->data, operands[1]->ld,
+                  beta, result->data, result->ld);
+    }
+    FreeMatrix(&temporaries[0]);
+    FreeMatrix(&temporaries[1]);
+    return status;
+}
+
+static int Evaluate(Matrix result, MatrixExpr expr){
+    TermList terms = {NULL, 0, 0, NULL, 0, 0};
+    int status = Normalize(expr, 1.0, 0, &terms);
+    if(status == 0 && ResultAliasesInput(result, &terms)){
+        // evaluate beside the result, then copy it in
+        Matrix temporary = NewMatrix(result->num_rows, result->num_cols);
+        status = temporary ? Evaluate(temporary, expr) : -1;
+        if(status == 0)
+            for(size_t i = 0; i < result->num_rows; i++)
+                memcpy(MATRIX_ROW(result, i), MATRIX_ROW(temporary, i), result->num_cols * sizeof(double));
+        FreeMatrix(&temporary);
+    }
+    else if(status == 0){
+        // every plain matrix in one pass, then each product accumulated in
+        // place by GEMM: no temporaries for any intermediate sum or product
+        if(terms.num_leaves > 0){
+            FusedJob job = {result, terms.leaves, terms.num_leaves};
+            size_t tiles = (result->num_rows + EXPR_TILE_ROWS - 1) / EXPR_TILE_ROWS;
+            size_t tile_work = EXPR_TILE_ROWS * result->num_cols * terms.num_leaves;
+            ParallelFor(tiles, tile_work >= 16384 ? 1 : 16384 / tile_work + 1, FusedTask, &job);
+        }
+        for(size_t t = 0; t < terms.num_products && status == 0; t++)
+            status = EvaluateProduct(result, &terms.products[t], t == 0 && terms.num_leaves == 0 ? 0.0 : 1.0);
+    }
+    if(status != 0)
+        fprintf(stderr, "%s", "Error - Could not allocate memory to evaluate expression");
+    free(terms.leaves);
+    free(terms.products);
+    return status;
+}
+
+int EvaluateExprInto(Matrix result_matrix, MatrixExpr expr){
+    if(!expr || isEmpty(result_matrix) ||
+       result_matrix->num_rows != expr->num_rows || result_matrix->num_cols != expr->num_cols){
+        fprintf(stderr, "%s", "Error - Result must have the shape of the expression");
+        return -1;
+    }
+    return Evaluate(result_matrix, expr);
+}
+
+Matrix EvaluateExpr(MatrixExpr expr){
+    if(!expr)
+        return NULL;
+    Matrix result_matrix = NewMatrix(expr->num_rows, expr->num_cols);
+    if(result_matrix && Evaluate(result_matrix, expr) != 0)
+        FreeMatrix(&result_matrix);
+    return result_matrix;
+}
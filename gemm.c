@@ -0,0 +1,40 @@
+/****************************
+ * Author: Blake A. Molina
+ * Created on: 10/17/26
+ * License: GPL
+ ****************************/
+
+#include "matrix_internal.h"
+
+/*******************************************************
+ *          Blocking Parameters
+ *******************************************************/
+// The register tile (GEMM_MR x GEMM_NR, GEMMF_MR x GEMMF_NR for float32) is fixed
+// by the micro-kernels in simd.c
+// GEMM_KC x GEMM_NR panel of B stays in L1, GEMM_MC x GEMM_KC block of A in L2,
+// GEMM_KC x GEMM_NC block of B in L3
+#define GEMM_KC 256
+#define GEMM_MC 96
+#define GEMM_NC 4096
+
+// Below this many multiply-adds packing costs more than it saves
+#define GEMM_SMALL_WORK (32 * 32 * 32)
+// Below this many multiply-adds the product runs on the calling thread only
+#define GEMM_PARALLEL_WORK (128 * 128 * 128)
+
+/*******************************************************
+ *          Double & Float32 Engines
+ *******************************************************/
+#define REAL double
+#define GEMM_TYPE
+#define GEMM_KERNELS matrix_kernels
+#define TILE_MR GEMM_MR
+#define TILE_NR GEMM_NR
+#include "gemm_driver.h"
+
+#define REAL float
+#define GEMM_TYPE F
+#define GEMM_KERNELS matrix_kernels_f
+#define TILE_MR GEMMF_MR
+#define TILE_NR GEMMF_NR
+#include "gemm_driver.h"
@@ -0,0 +1,269 @@
+/****************************
+ * Author: Blake A. Molina
+ * Created on: 10/17/26
+ * License: GPL
+ ****************************/
+
+/*************************************************************************
+ * Packed GEMM engine, included by gemm.c once per element type.
+ *
+ *  Before each inclusion gemm.c defines REAL (the element type),
+ *  GEMM_TYPE (a name suffix, empty for double), GEMM_KERNELS (the kernel
+ *  table whose gemm_micro is used) and its register tile TILE_MR x
+ *  TILE_NR. The inclusion defines DenseGemm (suffixed with GEMM_TYPE) and
+ *  the packing buffers and helpers behind it; the blocking parameters in
+ *  gemm.c are shared by every type.
+ *
+ *  There is deliberately no include guard.
+ ************************************************************************/
+
+#define GEMM_CONCAT_(name, type) name##type
+#define GEMM_CONCAT(name, type)  GEMM_CONCAT_(name, type)
+#define GEMM_NAME(name)          GEMM_CONCAT(name, GEMM_TYPE)
+
+#define packed_A      GEMM_NAME(packed_A)
+#define packed_B      GEMM_NAME(packed_B)
+#define PackBuffer    GEMM_NAME(PackBuffer)
+#define PackA         GEMM_NAME(PackA)
+#define PackB         GEMM_NAME(PackB)
+#define StoreTile     GEMM_NAME(StoreTile)
+#define ScaleBlock    GEMM_NAME(ScaleBlock)
+#define SmallGemm     GEMM_NAME(SmallGemm)
+#define GemmBlockJob  GEMM_NAME(GemmBlockJob)
+#define GemmBlockTask GEMM_NAME(GemmBlockTask)
+#define DenseGemm     GEMM_NAME(DenseGemm)
+
+// Per-thread packing buffers, allocated once at full block size so repeated
+// products never touch the allocator again, and freed when the thread exits.
+static _Thread_local void *packed_A = NULL;
+static _Thread_local void *packed_B = NULL;
+
+static REAL *PackBuffer(void **buffer, size_t count){
+    if(!*buffer){
+        *buffer = AllocateAligned(count * sizeof(REAL));
+        if(*buffer)
+            FreeAtThreadExit(buffer);
+    }
+    return (REAL*)*buffer;
+}
+
+
+/*******************************************************
+ *          Packing
+ *******************************************************/
+// Copies an mc x kc block of op(A) into TILE_MR-row micro-panels. Within a
+// micro-panel the TILE_MR values of each column are adjacent, so the
+// micro-kernel reads A strictly sequentially. Short panels are zero-padded.
+static void PackA(int trans_a, size_t mc, size_t kc, const REAL *A, size_t lda, REAL *packed){
+    for(size_t i = 0; i < mc; i += TILE_MR){
+        size_t rows = mc - i < TILE_MR ? mc - i : TILE_MR;
+        for(size_t p = 0; p < kc; p++){
+            for(size_t r = 0; r < rows; r++)
+                packed[r] = trans_a ? A[p*lda + i + r] : A[(i + r)*lda + p];
+            for(size_t r = rows; r < TILE_MR; r++)
+                packed[r] = 0.0;
+            packed += TILE_MR;
+        }
+    }
+}
+
+// Copies a kc x nc block of op(B) into TILE_NR-column micro-panels laid out
+// row by row, zero-padding the last panel.
+static void PackB(int trans_b, size_t kc, size_t nc, const REAL *B, size_t ldb, REAL *packed){
+    for(size_t j = 0; j < nc; j += TILE_NR){
+        size_t cols = nc - j < TILE_NR ? nc - j : TILE_NR;
+        for(size_t p = 0; p < kc; p++){
+            if(!trans_b && cols == TILE_NR){
+                memcpy(packed, B + p*ldb + j, TILE_NR * sizeof(REAL));
+            }
+            else{
+                for(size_t c = 0; c < cols; c++)
+                    packed[c] = trans_b ? B[(j + c)*ldb + p] : B[p*ldb + j + c];
+                for(size_t c = cols; c < TILE_NR; c++)
+                    packed[c] = 0.0;
+            }
+            packed += TILE_NR;
+        }
+    }
+}
+
+
+/*******************************************************
+ *          Tile Store
+ *******************************************************/
+// C[0:rows, 0:cols] = alpha * tile + beta * C, never reading C when beta is 0
+static void StoreTile(size_t rows, size_t cols, REAL alpha, const REAL *tile,
+                      REAL beta, REAL *C, size_t ldc){
+    for(size_t i = 0; i < rows; i++){
+        REAL *row = C + i*ldc;
+        const REAL *values = tile + i*TILE_NR;
+        if(beta == 0.0){
+            for(size_t j = 0; j < cols; j++)
+                row[j] = alpha * values[j];
+        }
+        else if(beta == 1.0){
+            for(size_t j = 0; j < cols; j++)
+                row[j] += alpha * values[j];
+        }
+        else{
+            for(size_t j = 0; j < cols; j++)
+                row[j] = alpha * values[j] + beta * row[j];
+        }
+    }
+}
+
+
+/*******************************************************
+ *          Driver
+ *******************************************************/
+// C = beta * C (C write-only when beta is 0)
+static void ScaleBlock(size_t m, size_t n, REAL beta, REAL *C, size_t ldc){
+    for(size_t i = 0; i < m; i++){
+        REAL *row = C + i*ldc;
+        if(beta == 0.0)
+            memset(row, 0, n * sizeof(REAL));
+        else if(beta != 1.0)
+            for(size_t j = 0; j < n; j++)
+                row[j] *= beta;
+    }
+}
+
+// Straightforward i-p-j product for tiny problems: unit stride over B and C
+// when neither operand is transposed.
+static void SmallGemm(int trans_a, int trans_b, size_t m, size_t n, size_t k,
+                      REAL alpha, const REAL *A, size_t lda,
+                      const REAL *B, size_t ldb, REAL *C, size_t ldc){
+    for(size_t i = 0; i < m; i++){
+        REAL *row = C + i*ldc;
+        for(size_t p = 0; p < k; p++){
+            const REAL a_value = alpha * (trans_a ? A[p*lda + i] : A[i*lda + p]);
+            if(!trans_b){
+                const REAL *b_row = B + p*ldb;
+                for(size_t j = 0; j < n; j++)
+                    row[j] += a_value * b_row[j];
+            }
+            else{
+                for(size_t j = 0; j < n; j++)
+                    row[j] += a_value * B[j*ldb + p];
+            }
+        }
+    }
+}
+
+// Everything a worker needs to multiply its share of one packed B block
+typedef struct{
+    int trans_a;
+    size_t m, kc, nc, slices, slice_width;
+    REAL alpha, beta;
+    const REAL *A;
+    size_t lda;
+    const REAL *pack_B;
+    REAL *C;
+    size_t ldc;
+}GemmBlockJob;
+
+// Multiplies tasks [begin, end) of a packed B block. Each task is one
+// GEMM_MC row block of A crossed with one column slice of the B block;
+// every thread packs A into its own buffer.
+static void GemmBlockTask(void *context, size_t begin, size_t end){
+    const GemmBlockJob *job = (const GemmBlockJob*)context;
+    REAL *pack_A = PackBuffer(&packed_A, (size_t)GEMM_MC * GEMM_KC);
+    _Alignas(MATRIX_ALIGNMENT) REAL tile[TILE_MR * TILE_NR];
+    void (*micro_kernel)(size_t, const REAL*, const REAL*, REAL*) = GEMM_KERNELS->gemm_micro;
+    size_t kc = job->kc;
+
+    for(size_t task = begin; task < end; task++){
+        size_t ic = task / job->slices * GEMM_MC;
+        size_t j_begin = task % job->slices * job->slice_width;
+        size_t j_end = j_begin + job->slice_width < job->nc ? j_begin + job->slice_width : job->nc;
+        size_t mc = job->m - ic < GEMM_MC ? job->m - ic : GEMM_MC;
+        const REAL *A_block = job->trans_a ? job->A + ic : job->A + ic*job->lda;
+        PackA(job->trans_a, mc, kc, A_block, job->lda, pack_A);
+
+        for(size_t jr = j_begin; jr < j_end; jr += TILE_NR){
+            size_t cols = j_end - jr < TILE_NR ? j_end - jr : TILE_NR;
+            const REAL *b_panel = job->pack_B + jr*kc;
+            for(size_t ir = 0; ir < mc; ir += TILE_MR){
+                size_t rows = mc - ir < TILE_MR ? mc - ir : TILE_MR;
+                micro_kernel(kc, pack_A + ir*kc, b_panel, tile);
+                StoreTile(rows, cols, job->alpha, tile, job->beta,
+                          job->C + (ic + ir)*job->ldc + jr, job->ldc);
+            }
+        }
+    }
+}
+
+void DenseGemm(int trans_a, int trans_b, size_t m, size_t n, size_t k,
+               REAL alpha, const REAL *A, size_t lda,
+               const REAL *B, size_t ldb,
+               REAL beta, REAL *C, size_t ldc){
+    if(m == 0 || n == 0)
+        return;
+    if(k == 0 || alpha == 0.0){
+        ScaleBlock(m, n, beta, C, ldc);
+        return;
+    }
+    if(m * n * k <= GEMM_SMALL_WORK){
+        ScaleBlock(m, n, beta, C, ldc);
+        SmallGemm(trans_a, trans_b, m, n, k, alpha, A, lda, B, ldb, C, ldc);
+        return;
+    }
+
+    REAL *pack_A = PackBuffer(&packed_A, (size_t)GEMM_MC * GEMM_KC);
+    REAL *pack_B = PackBuffer(&packed_B, (size_t)GEMM_KC * GEMM_NC);
+    if(!pack_A || !pack_B){
+        // out of memory for the packing buffers: fall back to the unpacked loop
+        ScaleBlock(m, n, beta, C, ldc);
+        SmallGemm(trans_a, trans_b, m, n, k, alpha, A, lda, B, ldb, C, ldc);
+        return;
+    }
+
+    // Threads split the row blocks of A; when there are fewer row blocks than
+    // threads the columns of each B block are sliced as well.
+    size_t threads = m * n * k >= GEMM_PARALLEL_WORK ? GetMatrixThreads() : 1;
+    size_t row_blocks = (m + GEMM_MC - 1) / GEMM_MC;
+
+    for(size_t jc = 0; jc < n; jc += GEMM_NC){
+        size_t nc = n - jc < GEMM_NC ? n - jc : GEMM_NC;
+        size_t slices = threads > row_blocks ? (threads + row_blocks - 1) / row_blocks : 1;
+        size_t max_slices = (nc + 4*TILE_NR - 1) / (4*TILE_NR);
+        if(slices > max_slices)
+            slices = max_slices;
+        size_t slice_width = ((nc + slices - 1) / slices + TILE_NR - 1) / TILE_NR * TILE_NR;
+        slices = (nc + slice_width - 1) / slice_width;
+
+        for(size_t pc = 0; pc < k; pc += GEMM_KC){
+            size_t kc = k - pc < GEMM_KC ? k - pc : GEMM_KC;
+            const REAL *B_block = trans_b ? B + jc*ldb + pc : B + pc*ldb + jc;
+            PackB(trans_b, kc, nc, B_block, ldb, pack_B);
+
+            GemmBlockJob job = {
+                trans_a, m, kc, nc, slices, slice_width,
+                alpha, pc == 0 ? beta : 1.0, // the first k-block applies beta; later ones accumulate
+                trans_a ? A + pc*lda : A + pc, lda,
+                pack_B, C + jc, ldc
+            };
+            ParallelFor(row_blocks * slices, threads > 1 ? 1 : row_blocks * slices, GemmBlockTask, &job);
+        }
+    }
+}
+
+#undef packed_A
+#undef packed_B
+#undef PackBuffer
+#undef PackA
+#undef PackB
+#undef StoreTile
+#undef ScaleBlock
+#undef SmallGemm
+#undef GemmBlockJob
+#undef GemmBlockTask
+#undef DenseGemm
+#undef GEMM_NAME
+#undef GEMM_CONCAT
+#undef GEMM_CONCAT_
+#undef REAL
+#undef GEMM_TYPE
+#undef GEMM_KERNELS
+#undef TILE_MR
+#undef TILE_NR
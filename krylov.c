@@ -0,0 +1,755 @@
+/****************************
+ * Author: Blake A. Molina
+ * Created on: 10/17/26
+ * License: GPL
+ ****************************/
+
+#include "matrix_internal.h"
+
+// Vectors shorter than this are handled by a single kernel call
+#define VECTOR_PARALLEL_LENGTH 32768
+// Dot products are summed in this many fixed blocks so the result does not
+// depend on the number of threads
+#define DOT_BLOCKS 64
+
+#define DEFAULT_TOLERANCE 1e-8
+#define DEFAULT_RESTART 30
+
+/*******************************************************
+ *          Vector Kernels
+ *******************************************************/
+typedef struct{
+    size_t n;
+    const double *x, *y;
+    double *partial;
+    double alpha;
+    double *out;
+}VectorJob;
+
+static void DotBlocksTask(void *context, size_t begin, size_t end){
+    const VectorJob *job = (const VectorJob*)context;
+    for(size_t block = begin; block < end; block++){
+        size_t from = job->n * block / DOT_BLOCKS, to = job->n * (block + 1) / DOT_BLOCKS;
+        job->partial[block] = matrix_kernels->dot(to - from, job->x + from, job->y + from);
+    }
+}
+
+static double VectorDot(size_t n, const double *x, const double *y){
+    if(n < VECTOR_PARALLEL_LENGTH)
+        return matrix_kernels->dot(n, x, y);
+    double partial[DOT_BLOCKS];
+    VectorJob job = {n, x, y, partial, 0.0, NULL};
+    ParallelFor(DOT_BLOCKS, 1, DotBlocksTask, &job);
+    double sum = 0.0;
+    for(size_t block = 0; block < DOT_BLOCKS; block++)
+        sum += partial[block];
+    return sum;
+}
+
+static double VectorNorm(size_t n, const double *x){
+    return sqrt(VectorDot(n, x, x));
+}
+
+static void AxpyTask(void *context, size_t begin, size_t end){
+    const VectorJob *job = (const VectorJob*)context;
+    matrix_kernels->axpy(end - begin, job->alpha, job->x + begin, job->out + begin);
+}
+
+// out += alpha * x
+static void VectorAxpy(size_t n, double alpha, const double *x, double *out){
+    VectorJob job = {n, x, NULL, NULL, alpha, out};
+    ParallelFor(n, VECTOR_PARALLEL_LENGTH / 2, AxpyTask, &job);
+}
+
+static void ScaleAddTask(void *context, size_t begin, size_t end){
+    const VectorJob *job = (const VectorJob*)context;
+    matrix_kernels->add(end - begin, job->x + begin, job->alpha, job->out + begin, job->out + begin);
+}
+
+// out = x + alpha * out
+static void VectorScaleAdd(size_t n, const double *x, double alpha, double *out){
+    VectorJob job = {n, x, NULL, NULL, alpha, out};
+    ParallelFor(n, VECTOR_PARALLEL_LENGTH / 2, ScaleAddTask, &job);
+}
+
+
+/*******************************************************
+ *          Linear Operators
+ *******************************************************/
+typedef struct{
+    Matrix matrix;
+    const double *x;
+    double *y;
+}DenseApplyJob;
+
+static void DenseApplyTask(void *context, size_t begin, size_t end){
+    const DenseApplyJob *job = (const DenseApplyJob*)context;
+    for(size_t i = begin; i < end; i++)
+        job->y[i] = matrix_kernels->dot(job->matrix->num_cols, MATRIX_ROW(job->matrix, i), job->x);
+}
+
+static void DenseApply(void *context, const double *x, double *y){
+    Matrix matrix = (Matrix)context;
+    DenseApplyJob job = {matrix, x, y};
+    size_t chunk = matrix->num_cols >= 16384 ? 1 : 16384 / matrix->num_cols;
+    ParallelFor(matrix->num_rows, chunk, DenseApplyTask, &job);
+}
+
+static void SparseApply(void *context, const double *x, double *y){
+    SparseMultiplyVector((SparseMatrix)context, 0, x, y);
+}
+
+LinearOperator DenseOperator(Matrix matrix){
+    LinearOperator op = {isEmpty(matrix) ? 0 : matrix->num_rows, DenseApply, matrix, matrix, NULL};
+    return op;
+}
+
+LinearOperator SparseOperator(SparseMatrix sparse){
+    LinearOperator op = {sparse ? sparse->num_rows : 0, SparseApply, sparse, NULL, sparse};
+    return op;
+}
+
+LinearOperator MatrixFreeOperator(size_t size, OperatorApply apply, void *context){
+    LinearOperator op = {size, apply, context, NULL, NULL};
+    return op;
+}
+
+
+/*******************************************************
+ *          Preconditioners
+ *******************************************************/
+struct preconditioner_struct{
+    OperatorApply apply;  // z = M^-1 r
+    void *context;        // passed to apply; owned by the preconditioner unless custom
+    void (*release)(void *context);
+    size_t size;
+};
+
+static Preconditioner WrapPreconditioner(OperatorApply apply, void *context, void (*release)(void*), size_t size){
+    Preconditioner preconditioner = (Preconditioner)malloc(sizeof(struct preconditioner_struct));
+    if(!preconditioner){
+        if(release)
+            release(context);
+        return NULL;
+    }
+    preconditioner->apply = apply;
+    preconditioner->context = context;
+    preconditioner->release = release;
+    preconditioner->size = size;
+    return preconditioner;
+}
+
+Preconditioner NewCustomPreconditioner(size_t size, OperatorApply apply, void *context){
+    if(!apply)
+        return NULL;
+    return WrapPreconditioner(apply, context, NULL, size);
+}
+
+void FreePreconditioner(Preconditioner *preconditioner){
+    if(preconditioner && *preconditioner){
+        if((*preconditioner)->release)
+            (*preconditioner)->release((*preconditioner)->context);
+        free(*preconditioner);
+        *preconditioner = NULL;
+    }
+}
+
+static int CheckSquareOperator(const LinearOperator *op){
+    if(!op || op->size == 0 || (!op->dense && !op->sparse) ||
+       (op->dense && op->dense->num_cols != op->size) || (op->sparse && op->sparse->num_cols != op->size)){
+        fprintf(stderr, "%s", "Error - Preconditioners need a square dense or sparse matrix operator");
+        return -1;
+    }
+    return 0;
+}
+
+// The CSR form of a sparse operator (converted when stored as CSC)
+static SparseMatrix RowsOf(const LinearOperator *op, SparseMatrix *converted){
+    *converted = NULL;
+    if(op->sparse->format == SPARSE_CSR)
+        return op->sparse;
+    *converted = SparseConvert(op->sparse, SPARSE_CSR);
+    return *converted;
+}
+
+// ---- Jacobi: M = diag(A) ----
+typedef struct{
+    size_t n;
+    double *inverse_diagonal;
+}JacobiData;
+
+static void JacobiApply(void *context, const double *r, double *z){
+    const JacobiData *data = (const JacobiData*)context;
+    for(size_t i = 0; i < data->n; i++)
+        z[i] = r[i] * data->inverse_diagonal[i];
+}
+
+static void JacobiRelease(void *context){
+    JacobiData *data = (JacobiData*)context;
+    FreeAligned(data->inverse_diagonal);
+    free(data);
+}
+
+Preconditioner NewJacobiPreconditioner(const LinearOperator *op){
+    if(CheckSquareOperator(op) != 0)
+        return NULL;
+    size_t n = op->size;
+    JacobiData *data = (JacobiData*)malloc(sizeof(JacobiData));
+    if(!data)
+        return NULL;
+    data->n = n;
+    data->inverse_diagonal = (double*)AllocateAligned(n * sizeof(double));
+    if(!data->inverse_diagonal){
+        free(data);
+        return NULL;
+    }
+    for(size_t i = 0; i < n; i++){
+        double diagonal = 0.0;
+        if(op->dense)
+            diagonal = MATRIX_AT(op->dense, i, i);
+        else  // row i of CSR, column i of CSC
+            for(size_t p = op->sparse->offsets[i]; p < op->sparse->offsets[i + 1]; p++)
+                if(op->sparse->indices[p] == i)
+                    diagonal = op->sparse->values[p];
+        // a zero diagonal leaves that unknown unscaled
+        data->inverse_diagonal[i] = diagonal != 0.0 ? 1.0 / diagonal : 1.0;
+    }
+    return WrapPreconditioner(JacobiApply, data, JacobiRelease, n);
+}
+
+// ---- Dense factorizations (IC and ILU(0) of a full pattern are exact) ----
+typedef struct{
+    size_t n;
+    Matrix factor;
+    size_t *pivots;  // NULL for a Cholesky factor
+}DenseFactorData;
+
+static void DenseFactorApply(void *context, const double *r, double *z){
+    const DenseFactorData *data = (const DenseFactorData*)context;
+    memcpy(z, r, data->n * sizeof(double));
+    if(data->pivots)
+        LUSolveDense(data->n, data->factor->data, data->factor->ld, data->pivots, 1, z, 1);
+    else
+        CholeskySolveDense(data->n, data->factor->data, data->factor->ld, 1, z, 1);
+}
+
+static void DenseFactorRelease(void *context){
+    DenseFactorData *data = (DenseFactorData*)context;
+    FreeMatrix(&data->factor);
+    free(data->pivots);
+    free(data);
+}
+
+static Preconditioner NewDenseFactorPreconditioner(Matrix matrix, int pivoted){
+    size_t n = matrix->num_rows;
+    DenseFactorData *data = (DenseFactorData*)calloc(1, sizeof(DenseFactorData));
+    if(!data)
+        return NULL;
+    data->n = n;
+    // the factor outlives any arena scope the caller is in
+    MatrixArena previous = UseMatrixArena(NULL);
+    data->factor = NewMatrix(n, n);
+    UseMatrixArena(previous);
+    data->pivots = pivoted ? (size_t*)malloc(n * sizeof(size_t)) : NULL;
+    if(!data->factor || (pivoted && !data->pivots)){
+        DenseFactorRelease(data);
+        return NULL;
+    }
+    size_t failed;
+    if(pivoted){
+        for(size_t i = 0; i < n; i++)
+            memcpy(MATRIX_ROW(data->factor, i), MATRIX_ROW(matrix, i), n * sizeof(double));
+        int sign;
+        failed = LUFactorDense(n, data->factor->data, data->factor->ld, data->pivots, &sign);
+    }
+    else{
+        failed = (size_t)CholeskyInto(data->factor, matrix);
+    }
+    if(failed){
+        fprintf(stderr, "Error - Factorization for the preconditioner broke down at pivot %zu", failed - 1);
+        DenseFactorRelease(data);
+        return NULL;
+    }
+    return WrapPreconditioner(DenseFactorApply, data, DenseFactorRelease, n);
+}
+
+// ---- Sparse IC(0) and ILU(0): factors restricted to the pattern of A ----
+typedef struct{
+    size_t n;
+    SparseMatrix factor;  // CSR: L (IC) or unit-L and U together (ILU)
+    size_t *diagonal;     // position of each diagonal entry in factor
+    int cholesky;
+}SparseFactorData;
+
+static void SparseFactorApply(void *context, const double *r, double *z){
+    const SparseFactorData *data = (const SparseFactorData*)context;
+    const size_t *offsets = data->factor->offsets, *diagonal = data->diagonal;
+    const uint32_t *indices = data->factor->indices;
+    const double *values = data->factor->values;
+    // L y = r (rows in order; IC divides by L's diagonal, ILU's L has unit diagonal)
+    for(size_t i = 0; i < data->n; i++){
+        double sum = r[i];
+        for(size_t p = offsets[i]; p < diagonal[i]; p++)
+            sum -= values[p] * z[indices[p]];
+        z[i] = data->cholesky ? sum / values[diagonal[i]] : sum;
+    }
+    if(data->cholesky){
+        // L^T z = y: rows of L are columns of L^T, pushed upwards once solved
+        for(size_t i = data->n; i-- > 0;){
+            z[i] /= values[diagonal[i]];
+            for(size_t p = offsets[i]; p < diagonal[i]; p++)
+                z[indices[p]] -= values[p] * z[i];
+        }
+    }
+    else{
+        // U z = y
+        for(size_t i = data->n; i-- > 0;){
+            double sum = z[i];
+            for(size_t p = diagonal[i] + 1; p < offsets[i + 1]; p++)
+                sum -= values[p] * z[indices[p]];
+            z[i] = sum / values[diagonal[i]];
+        }
+    }
+}
+
+static void SparseFactorRelease(void *context){
+    SparseFactorData *data = (SparseFactorData*)context;
+    FreeSparseMatrix(&data->factor);
+    free(data->diagonal);
+    free(data);
+}
+
+static Preconditioner NewSparseFactorPreconditioner(const LinearOperator *op, int cholesky){
+    SparseMatrix converted;
+    SparseMatrix rows = RowsOf(op, &converted);
+    if(!rows)
+        return NULL;
+    size_t n = rows->num_rows;
+    SparseFactorData *data = (SparseFactorData*)calloc(1, sizeof(SparseFactorData));
+    if(!data){
+        FreeSparseMatrix(&converted);
+        return NULL;
+    }
+    data->n = n;
+    data->cholesky = cholesky;
+    data->diagonal = (size_t*)malloc(n * sizeof(size_t));
+    // IC keeps the lower triangle only; ILU the whole pattern
+    size_t kept = 0;
+    for(size_t i = 0; i < n; i++)
+        for(size_t p = rows->offsets[i]; p < rows->offsets[i + 1]; p++)
+            kept += !cholesky || rows->indices[p] <= i;
+    data->factor = NewSparseMatrix(n, n, kept + n, SPARSE_CSR); // + room for missing diagonals
+    if(!data->diagonal || !data->factor){
+        SparseFactorRelease(data);
+        FreeSparseMatrix(&converted);
+        return NULL;
+    }
+    SparseMatrix f = data->factor;
+    size_t out = 0;
+    for(size_t i = 0; i < n; i++){
+        int has_diagonal = 0;
+        for(size_t p = rows->offsets[i]; p < rows->offsets[i + 1]; p++){
+            uint32_t j = rows->indices[p];
+            if(cholesky && j > i)
+                break;
+            if(j > i && !has_diagonal){
+                data->diagonal[i] = out;
+                f->indices[out] = (uint32_t)i;
+                f->values[out++] = 0.0;
+                has_diagonal = 1;
+            }
+            if(j == i){
+                data->diagonal[i] = out;
+                has_diagonal = 1;
+            }
+            f->indices[out] = j;
+            f->values[out++] = rows->values[p];
+        }
+        if(!has_diagonal){
+            data->diagonal[i] = out;
+            f->indices[out] = (uint32_t)i;
+            f->values[out++] = 0.0;
+        }
+        f->offsets[i + 1] = out;
+    }
+    f->nnz = out;
+    FreeSparseMatrix(&converted);
+
+    if(cholesky){
+        // L[i][k] = (A[i][k] - <L[i][:k], L[k][:k]>) / L[k][k], both rows sorted
+        for(size_t i = 0; i < n; i++){
+            for(size_t p = f->offsets[i]; p <= data->diagonal[i]; p++){
+                size_t k = f->indices[p];
+                size_t a = f->offsets[i], b = f->offsets[k];
+                double sum = f->values[p];
+                while(a < p && b < data->diagonal[k]){
+                    if(f->indices[a] < f->indices[b])
+                        a++;
+                    else if(f->indices[b] < f->indices[a])
+                        b++;
+                    else
+                        sum -= f->values[a++] * f->values[b++];
+                }
+                if(k == i) // a breakdown falls back to the original diagonal
+                    f->values[p] = sum > 0.0 ? sqrt(sum) : sqrt(fabs(f->values[p]) > 0.0 ? fabs(f->values[p]) : 1.0);
+                else
+                    f->values[p] = sum / f->values[data->diagonal[k]];
+            }
+        }
+    }
+    else{
+        // IKJ elimination restricted to the pattern; position[j] locates
+        // column j of the current row
+        size_t *position = (size_t*)malloc(n * sizeof(size_t));
+        if(!position){
+            SparseFactorRelease(data);
+            return NULL;
+        }
+        for(size_t j = 0; j < n; j++)
+            position[j] = SIZE_MAX;
+        for(size_t i = 0; i < n; i++){
+            for(size_t p = f->offsets[i]; p < f->offsets[i + 1]; p++)
+                position[f->indices[p]] = p;
+            for(size_t p = f->offsets[i]; p < data->diagonal[i]; p++){
+                size_t k = f->indices[p];
+                double pivot = f->values[data->diagonal[k]];
+                f->values[p] /= pivot != 0.0 ? pivot : 1.0;
+                for(size_t q = data->diagonal[k] + 1; q < f->offsets[k + 1]; q++){
+                    size_t target = position[f->indices[q]];
+                    if(target != SIZE_MAX)
+                        f->values[target] -= f->values[p] * f->values[q];
+                }
+            }
+            if(f->values[data->diagonal[i]] == 0.0)
+                f->values[data->diagonal[i]] = 1.0;
+            for(size_t p = f->offsets[i]; p < f->offsets[i + 1]; p++)
+                position[f->indices[p]] = SIZE_MAX;
+        }
+        free(position);
+    }
+    return WrapPreconditioner(SparseFactorApply, data, SparseFactorRelease, n);
+}
+
+Preconditioner NewIncompleteCholeskyPreconditioner(const LinearOperator *op){
+    if(CheckSquareOperator(op) != 0)
+        return NULL;
+    return op->dense ? NewDenseFactorPreconditioner(op->dense, 0) : NewSparseFactorPreconditioner(op, 1);
+}
+
+Preconditioner NewILU0Preconditioner(const LinearOperator *op){
+    if(CheckSquareOperator(op) != 0)
+        return NULL;
+    return op->dense ? NewDenseFactorPreconditioner(op->dense, 1) : NewSparseFactorPreconditioner(op, 0);
+}
+
+
+/*******************************************************
+ *          Solver Plumbing
+ *******************************************************/
+typedef struct{
+    double tolerance;
+    size_t max_iterations;
+    size_t restart;
+}Settings;
+
+static Settings ReadSettings(const SolverOptions *options, size_t n){
+    Settings settings = {DEFAULT_TOLERANCE, n > 1000 ? n : 1000, DEFAULT_RESTART};
+    if(options){
+        if(options->tolerance > 0.0)
+            settings.tolerance = options->tolerance;
+        if(options->max_iterations)
+            settings.max_iterations = options->max_iterations;
+        if(options->restart)
+            settings.restart = options->restart;
+    }
+    if(settings.restart > n)
+        settings.restart = n;
+    return settings;
+}
+
+static void Precondition(Preconditioner preconditioner, size_t n, const double *r, double *z){
+    if(preconditioner)
+        preconditioner->apply(preconditioner->context, r, z);
+    else
+        memcpy(z, r, n * sizeof(double));
+}
+
+// Records progress; returns non-zero once the relative residual is small enough
+static int Report(const SolverOptions *options, SolverReport *report, size_t iteration,
+                  double residual, double tolerance){
+    if(report){
+        report->iterations = iteration;
+        report->residual = residual;
+        report->converged = residual <= tolerance;
+    }
+    if(options && options->monitor)
+        options->monitor(iteration, residual, options->monitor_context);
+    return residual <= tolerance;
+}
+
+static int CheckSolve(const LinearOperator *op, Preconditioner preconditioner, const double *b, double *x){
+    if(!op || !op->apply || op->size == 0 || !b || !x ||
+       (op->dense && op->dense->num_cols != op->size) || (op->sparse && op->sparse->num_cols != op->size) ||
+       (preconditioner && preconditioner->size && preconditioner->size != op->size)){
+        fprintf(stderr, "%s", "Error - Need a square operator, right-hand side and solution vector of one size");
+        return -1;
+    }
+    return 0;
+}
+
+// Work of one product with A: 2 per stored value of a dense or sparse
+// operator, 0 for a matrix-free one (whose cost is unknown)
+static double ProductFlops(const LinearOperator *op){
+    if(op->sparse)
+        return 2.0 * op->sparse->nnz;
+    if(op->dense)
+        return 2.0 * op->size * op->size;
+    return 0.0;
+}
+
+// r = b - A x
+static void Residual(const LinearOperator *op, const double *b, const double *x, double *r){
+    op->apply(op->context, x, r);
+    VectorScaleAdd(op->size, b, -1.0, r);
+}
+
+// Scratch for count vectors of length n, each starting on an alignment boundary
+static double *NewVectors(size_t count, size_t n, size_t *stride){
+    *stride = (n + MATRIX_ALIGNMENT / sizeof(double) - 1) / (MATRIX_ALIGNMENT / sizeof(double)) * (MATRIX_ALIGNMENT / sizeof(double));
+    double *vectors = (double*)AllocateAligned(count * *stride * sizeof(double));
+    if(!vectors)
+        fprintf(stderr, "%s", "Error - Could not allocate solver workspace");
+    return vectors;
+}
+
+
+/*******************************************************
+ *          Conjugate Gradient
+ *******************************************************/
+int SolveCG(const LinearOperator *op, Preconditioner preconditioner, const double *b, double *x,
+            const SolverOptions *options, SolverReport *report){
+    if(CheckSolve(op, preconditioner, b, x) != 0)
+        return -1;
+    const size_t n = op->size;
+    STATS_BEGIN();
+    const Settings settings = ReadSettings(options, n);
+    size_t stride;
+    double *work = NewVectors(4, n, &stride);
+    if(!work)
+        return -1;
+    double *r = work, *z = work + stride, *p = work + 2*stride, *q = work + 3*stride;
+
+    double norm_b = VectorNorm(n, b);
+    if(norm_b == 0.0)
+        norm_b = 1.0;
+    Residual(op, b, x, r);
+    int converged = Report(options, report, 0, VectorNorm(n, r) / norm_b, settings.tolerance);
+    Precondition(preconditioner, n, r, z);
+    memcpy(p, z, n * sizeof(double));
+    double rho = VectorDot(n, r, z);
+    const double product = ProductFlops(op);
+    double flops = product + 6.0 * n;  // preconditioner applications are not counted
+
+    for(size_t iteration = 1; !converged && iteration <= settings.max_iterations; iteration++){
+        op->apply(op->context, p, q);
+        double curvature = VectorDot(n, p, q);
+        if(curvature == 0.0)
+            break;  // breakdown: p is in the null space of A
+        double alpha = rho / curvature;
+        VectorAxpy(n, alpha, p, x);
+        VectorAxpy(n, -alpha, q, r);
+        flops += product + 8.0 * n;
+        converged = Report(options, report, iteration, VectorNorm(n, r) / norm_b, settings.tolerance);
+        if(converged)
+            break;
+        Precondition(preconditioner, n, r, z);
+        double rho_next = VectorDot(n, r, z);
+        VectorScaleAdd(n, z, rho_next / rho, p);   // p = z + beta p
+        rho = rho_next;
+        flops += 4.0 * n;
+    }
+    FreeAligned(work);
+    STATS_END(MATRIX_STAT_KRYLOV, product ? flops : 0);
+    return converged ? 0 : 1;
+}
+
+
+/*******************************************************
+ *          BiCGSTAB (right preconditioned)
+ *******************************************************/
+int SolveBiCGSTAB(const LinearOperator *op, Preconditioner preconditioner, const double *b, double *x,
+                  const SolverOptions *options, SolverReport *report){
+    if(CheckSolve(op, preconditioner, b, x) != 0)
+        return -1;
+    const size_t n = op->size;
+    STATS_BEGIN();
+    const Settings settings = ReadSettings(options, n);
+    size_t stride;
+    double *work = NewVectors(7, n, &stride);
+    if(!work)
+        return -1;
+    double *r = work, *r_hat = work + stride, *p = work + 2*stride, *v = work + 3*stride;
+    double *p_hat = work + 4*stride, *s_hat = work + 5*stride, *t = work + 6*stride;
+
+    double norm_b = VectorNorm(n, b);
+    if(norm_b == 0.0)
+        norm_b = 1.0;
+    Residual(op, b, x, r);
+    double rho = 1.0, alpha = 1.0, omega = 1.0;
+    int converged = Report(options, report, 0, VectorNorm(n, r) / norm_b, settings.tolerance);
+    int restart = 1;
+    const double product = ProductFlops(op);
+    double flops = product + 4.0 * n;  // preconditioner applications are not counted
+
+    for(size_t iteration = 1; !converged && iteration <= settings.max_iterations; iteration++){
+        if(restart){
+            memcpy(r_hat, r, n * sizeof(double));
+            memset(p, 0, n * sizeof(double));
+            memset(v, 0, n * sizeof(double));
+            rho = alpha = omega = 1.0;
+            restart = 0;
+        }
+        double rho_next = VectorDot(n, r_hat, r);
+        if(rho_next == 0.0 || omega == 0.0)
+            break;  // breakdown
+        double beta = (rho_next / rho) * (alpha / omega);
+        rho = rho_next;
+        VectorAxpy(n, -omega, v, p);                 // p = r + beta (p - omega v)
+        VectorScaleAdd(n, r, beta, p);
+        Precondition(preconditioner, n, p, p_hat);
+        op->apply(op->context, p_hat, v);
+        double denominator = VectorDot(n, r_hat, v);
+        if(denominator == 0.0)
+            break;
+        alpha = rho / denominator;
+        VectorAxpy(n, alpha, p_hat, x);
+        VectorAxpy(n, -alpha, v, r);                 // r is now s
+        flops += product + 14.0 * n;
+        int small_residual = Report(options, report, iteration, VectorNorm(n, r) / norm_b, settings.tolerance);
+        if(!small_residual){
+            Precondition(preconditioner, n, r, s_hat);
+            op->apply(op->context, s_hat, t);
+            double t_t = VectorDot(n, t, t);
+            omega = t_t != 0.0 ? VectorDot(n, t, r) / t_t : 0.0;
+            VectorAxpy(n, omega, s_hat, x);
+            VectorAxpy(n, -omega, t, r);
+            flops += product + 10.0 * n;
+            small_residual = Report(options, report, iteration, VectorNorm(n, r) / norm_b, settings.tolerance);
+        }
+        if(small_residual){
+            // the updated r drifts away from b - A x; confirm before stopping
+            // and start over from the true residual if it is not small yet
+            Residual(op, b, x, r);
+            flops += product + 4.0 * n;
+            converged = Report(options, report, iteration, VectorNorm(n, r) / norm_b, settings.tolerance);
+            restart = !converged;
+        }
+    }
+    FreeAligned(work);
+    STATS_END(MATRIX_STAT_KRYLOV, product ? flops : 0);
+    return converged ? 0 : 1;
+}
+
+
+/*******************************************************
+ *          Restarted GMRES (right preconditioned)
+ *******************************************************/
+int SolveGMRES(const LinearOperator *op, Preconditioner preconditioner, const double *b, double *x,
+               const SolverOptions *options, SolverReport *report){
+    if(CheckSolve(op, preconditioner, b, x) != 0)
+        return -1;
+    const size_t n = op->size;
+    STATS_BEGIN();
+    const Settings settings = ReadSettings(options, n);
+    const size_t m = settings.restart;
+    size_t stride;
+    // Krylov basis V (m+1 vectors) plus one work vector
+    double *work = NewVectors(m + 2, n, &stride);
+    // Hessenberg matrix (column-major, (m+1) x m), Givens rotations and g
+    double *small = (double*)malloc(((m + 1) * m + 3 * (m + 1)) * sizeof(double));
+    if(!work || !small){
+        FreeAligned(work);
+        free(small);
+        return -1;
+    }
+    double *hessenberg = small, *cosines = small + (m + 1) * m;
+    double *sines = cosines + (m + 1), *g = sines + (m + 1);
+    double *w = work + (m + 1) * stride;
+#define BASIS(i) (work + (size_t)(i) * stride)
+#define H(row, col) hessenberg[(size_t)(col) * (m + 1) + (row)]
+
+    double norm_b = VectorNorm(n, b);
+    if(norm_b == 0.0)
+        norm_b = 1.0;
+    size_t iteration = 0;
+    int converged = 0;
+    const double product = ProductFlops(op);
+    double flops = 0.0;  // preconditioner applications are not counted
+    while(!converged && iteration < settings.max_iterations){
+        Residual(op, b, x, BASIS(0));
+        double beta = VectorNorm(n, BASIS(0));
+        flops += product + 5.0 * n;
+        converged = Report(options, report, iteration, beta / norm_b, settings.tolerance);
+        if(converged || beta == 0.0)
+            break;
+        matrix_kernels->scale(n, 1.0 / beta, BASIS(0));
+        memset(g, 0, (m + 1) * sizeof(double));
+        g[0] = beta;
+
+        size_t k = 0;
+        int small_residual = 0;
+        while(k < m && iteration < settings.max_iterations){
+            // w = A M^-1 v_k, orthogonalized against the basis (modified Gram-Schmidt)
+            Precondition(preconditioner, n, BASIS(k), w);
+            op->apply(op->context, w, BASIS(k + 1));
+            for(size_t i = 0; i <= k; i++){
+                H(i, k) = VectorDot(n, BASIS(k + 1), BASIS(i));
+                VectorAxpy(n, -H(i, k), BASIS(i), BASIS(k + 1));
+            }
+            H(k + 1, k) = VectorNorm(n, BASIS(k + 1));
+            if(H(k + 1, k) != 0.0)
+                matrix_kernels->scale(n, 1.0 / H(k + 1, k), BASIS(k + 1));
+            flops += product + (4.0 * (k + 1) + 3.0) * n;
+
+            // apply the earlier rotations, then one that zeroes H(k+1, k)
+            for(size_t i = 0; i < k; i++){
+                double upper = H(i, k), lower = H(i + 1, k);
+                H(i, k)     =  cosines[i] * upper + sines[i] * lower;
+                H(i + 1, k) = -sines[i] * upper + cosines[i] * lower;
+            }
+            double radius = hypot(H(k, k), H(k + 1, k));
+            cosines[k] = radius != 0.0 ? H(k, k) / radius : 1.0;
+            sines[k]   = radius != 0.0 ? H(k + 1, k) / radius : 0.0;
+            H(k, k) = radius;
+            H(k + 1, k) = 0.0;
+            g[k + 1] = -sines[k] * g[k];
+            g[k]     =  cosines[k] * g[k];
+            k++;
+            iteration++;
+            // |g[k]| is the residual norm of the current least-squares solution
+            small_residual = Report(options, report, iteration, fabs(g[k]) / norm_b, settings.tolerance);
+            if(small_residual || radius == 0.0)
+                break;
+        }
+        // y = H^-1 g (upper triangular), then x += M^-1 (V y)
+        for(size_t i = k; i-- > 0;){
+            double sum = g[i];
+            for(size_t j = i + 1; j < k; j++)
+                sum -= H(i, j) * g[j];
+            g[i] = H(i, i) != 0.0 ? sum / H(i, i) : 0.0;
+        }
+        memset(BASIS(m + 1), 0, n * sizeof(double));
+        for(size_t i = 0; i < k; i++)
+            VectorAxpy(n, g[i], BASIS(i), BASIS(m + 1));
+        Precondition(preconditioner, n, BASIS(m + 1), BASIS(0));
+        VectorAxpy(n, 1.0, BASIS(0), x);
+        flops += (2.0 * k + 2.0) * n + (double)k * k;
+        converged = small_residual;
+    }
+#undef BASIS
+#undef H
+    FreeAligned(work);
+    free(small);
+    STATS_END(MATRIX_STAT_KRYLOV, product ? flops : 0);
+    return converged ? 0 : 1;
+}
@@ -0,0 +1,255 @@
+/****************************
+ * Author: Blake A. Molina
+ * Created on: 10/17/26
+ * License: GPL
+ ****************************/
+
+#include "matrix_internal.h"
+
+// Columns factored per panel before the trailing matrix is updated with GEMM
+#define LU_BLOCK 64
+// Rows of L updated together by the rank-1 update (see UpdateLowerGroup)
+#define UPDATE_GROUP 4
+
+
+/*******************************************************
+ *          Double & Float32 Kernels
+ *******************************************************/
+#define REAL double
+#define LU_TYPE
+#define LU_KERNELS matrix_kernels
+#define LU_ABS fabs
+#include "lu_kernels.h"
+
+#define REAL float
+#define LU_TYPE F
+#define LU_KERNELS matrix_kernels_f
+#define LU_ABS fabsf
+#include "lu_kernels.h"
+
+
+/*******************************************************
+ *          LU Factorization Objects
+ *******************************************************/
+LUFactorization LUFactor(Matrix matrix){
+    if(isEmpty(matrix) || !isSquare(matrix)){
+        fprintf(stderr, "%s", "Error - Need an NxN matrix to compute an LU factorization");
+        return NULL;
+    }
+    size_t n = matrix->num_rows;
+    STATS_BEGIN();
+    LUFactorization factor = (LUFactorization)malloc(sizeof(lu_struct));
+    if(!factor)
+        return NULL;
+    // the factor outlives any arena scope the caller is in
+    MatrixArena previous = UseMatrixArena(NULL);
+    factor->lu = NewMatrix(n, n);
+    UseMatrixArena(previous);
+    factor->pivots = (size_t*)malloc(n * sizeof(size_t));
+    if(!factor->lu || !factor->pivots){
+        FreeLUFactorization(&factor);
+        return NULL;
+    }
+    for(size_t i = 0; i < n; i++)
+        memcpy(MATRIX_ROW(factor->lu, i), MATRIX_ROW(matrix, i), n * sizeof(double));
+    factor->singular = LUFactorDense(n, factor->lu->data, factor->lu->ld, factor->pivots, &factor->sign);
+    STATS_END(MATRIX_STAT_LU_FACTOR, 2.0 * n * n * n / 3);
+    return factor;
+}
+
+void FreeLUFactorization(LUFactorization *factor){
+    if(factor && *factor){
+        FreeMatrix(&(*factor)->lu);
+        free((*factor)->pivots);
+        free(*factor);
+        *factor = NULL;
+    }
+}
+
+int LUSolveInPlace(LUFactorization factor, Matrix rhs){
+    if(!factor || isEmpty(rhs) || rhs->num_rows != factor->lu->num_rows){
+        fprintf(stderr, "%s", "Error - Right-hand side must have as many rows as the factored matrix");
+        return -1;
+    }
+    if(factor->singular){
+        fprintf(stderr, "%s", "Error - Matrix is singular");
+        return -1;
+    }
+    size_t n = factor->lu->num_rows;
+    STATS_BEGIN();
+    LUSolveDense(n, factor->lu->data, factor->lu->ld, factor->pivots, rhs->num_cols, rhs->data, rhs->ld);
+    STATS_END(MATRIX_STAT_LU_SOLVE, 2.0 * n * n * rhs->num_cols);
+    return 0;
+}
+
+Matrix LUSolve(LUFactorization factor, Matrix rhs){
+    if(!factor || isEmpty(rhs))
+        return NULL;
+    Matrix solution = NewMatrix(rhs->num_rows, rhs->num_cols);
+    if(!solution)
+        return NULL;
+    for(size_t i = 0; i < rhs->num_rows; i++)
+        memcpy(MATRIX_ROW(solution, i), MATRIX_ROW(rhs, i), rhs->num_cols * sizeof(double));
+    if(LUSolveInPlace(factor, solution) != 0)
+        FreeMatrix(&solution);
+    return solution;
+}
+
+int LUSolveVector(LUFactorization factor, double *vector){
+    if(!factor || !vector)
+        return -1;
+    if(factor->singular){
+        fprintf(stderr, "%s", "Error - Matrix is singular");
+        return -1;
+    }
+    size_t n = factor->lu->num_rows;
+    STATS_BEGIN();
+    LUSolveDense(n, factor->lu->data, factor->lu->ld, factor->pivots, 1, vector, 1);
+    STATS_END(MATRIX_STAT_LU_SOLVE, 2.0 * n * n);
+    return 0;
+}
+
+double LUDeterminant(LUFactorization factor){
+    if(!factor)
+        return 0;
+    if(factor->singular)
+        return 0;
+    double determinant = factor->sign;
+    for(size_t i = 0; i < factor->lu->num_rows; i++) // product of U's diagonal
+        determinant *= MATRIX_AT(factor->lu, i, i);
+    return determinant;
+}
+
+
+/*******************************************************
+ *          Rank-1 Updates
+ *******************************************************/
+// Bennett's algorithm for L*U + x*y^T, split so that only the U half is
+// sequential. Step k needs xf[k] (x with L's earlier columns eliminated,
+// i.e. xf = L^-1 * x) and produces ys[k]; row i of L then takes
+//   t -= xf[k] * L[i][k] (old),   L[i][k] += ys[k] * t
+// for every k < i with t starting at x[i], independently of other rows.
+typedef struct{
+    double *lu;
+    size_t ld, n;
+    const double *x, *xf, *ys;
+}UpdateLowerJob;
+
+// Updates one row of L from column start (with the running t) to the diagonal
+static void UpdateLowerTail(const UpdateLowerJob *job, size_t i, size_t start, double t){
+    double *row = job->lu + i*job->ld;
+    for(size_t k = start; k < i; k++){
+        t -= job->xf[k] * row[k];
+        row[k] += job->ys[k] * t;
+    }
+}
+
+// Rows first..first+3 together, so the four chains of t overlap across the
+// columns they share
+static void UpdateLowerGroup(const UpdateLowerJob *job, size_t first){
+    double *row0 = job->lu + first*job->ld, *row1 = row0 + job->ld;
+    double *row2 = row1 + job->ld, *row3 = row2 + job->ld;
+    double t0 = job->x[first], t1 = job->x[first + 1], t2 = job->x[first + 2], t3 = job->x[first + 3];
+    for(size_t k = 0; k < first; k++){
+        const double xf = job->xf[k], ys = job->ys[k];
+        t0 -= xf * row0[k];
+        t1 -= xf * row1[k];
+        t2 -= xf * row2[k];
+        t3 -= xf * row3[k];
+        row0[k] += ys * t0;
+        row1[k] += ys * t1;
+        row2[k] += ys * t2;
+        row3[k] += ys * t3;
+    }
+    UpdateLowerTail(job, first, first, t0);
+    UpdateLowerTail(job, first + 1, first, t1);
+    UpdateLowerTail(job, first + 2, first, t2);
+    UpdateLowerTail(job, first + 3, first, t3);
+}
+
+// Group q costs O(q), so task q takes group q and the group mirrored from
+// the end to even out the work
+static void UpdateLowerTask(void *context, size_t begin, size_t end){
+    const UpdateLowerJob *job = (const UpdateLowerJob*)context;
+    size_t groups = job->n / UPDATE_GROUP;
+    for(size_t q = begin; q < end; q++){
+        UpdateLowerGroup(job, q * UPDATE_GROUP);
+        if(groups - 1 - q != q)
+            UpdateLowerGroup(job, (groups - 1 - q) * UPDATE_GROUP);
+    }
+}
+
+// P*A + (P*u)*v^T in place, with u and v in scratch[0..n) and [n..2n) and n
+// more doubles of room. Returns 0, or one more than the index of a pivot the
+// update made exactly zero (the factor is then only partly updated).
+static size_t LURankOneDense(size_t n, double *lu, size_t ld, const size_t *pivots, double *scratch){
+    double *x = scratch, *y = x + n, *xf = y + n;
+    for(size_t i = 0; i < n; i++){ // the factor's row interchanges, in order
+        double temp = x[i];
+        x[i] = x[pivots[i]];
+        x[pivots[i]] = temp;
+    }
+    for(size_t i = 0; i < n; i++)
+        xf[i] = x[i] - matrix_kernels->dot(i, lu + i*ld, xf);
+    // U, one row at a time; y[k] becomes ys[k] once row k is done
+    for(size_t k = 0; k < n; k++){
+        double *row = lu + k*ld;
+        row[k] += xf[k] * y[k];
+        if(row[k] == 0.0)
+            return k + 1;
+        y[k] /= row[k];
+        matrix_kernels->axpy(n - k - 1, xf[k], y + k + 1, row + k + 1);
+        matrix_kernels->axpy(n - k - 1, -y[k], row + k + 1, y + k + 1);
+    }
+    UpdateLowerJob job = {lu, ld, n, x, xf, y};
+    size_t groups = n / UPDATE_GROUP;
+    ParallelFor((groups + 1) / 2, 4096 / n + 1, UpdateLowerTask, &job);
+    for(size_t i = groups * UPDATE_GROUP; i < n; i++)
+        UpdateLowerTail(&job, i, 0, x[i]);
+    return 0;
+}
+
+int LUUpdate(LUFactorization factor, Matrix vectors_U, Matrix vectors_V){
+    if(!factor || isEmpty(vectors_U) || isEmpty(vectors_V) || vectors_U->num_rows != factor->lu->num_rows ||
+       vectors_V->num_rows != factor->lu->num_rows || vectors_U->num_cols != vectors_V->num_cols){
+        fprintf(stderr, "%s", "Error - Update vectors must be two Nxk matrices for an NxN factorization");
+        return -1;
+    }
+    if(factor->singular){
+        fprintf(stderr, "%s", "Error - Matrix is singular");
+        return -1;
+    }
+    size_t n = factor->lu->num_rows, k = vectors_U->num_cols;
+    double *scratch = (double*)ThreadScratch(3 * n * sizeof(double));
+    if(!scratch)
+        return -1;
+    STATS_BEGIN();
+    for(size_t j = 0; j < k && !factor->singular; j++){
+        for(size_t i = 0; i < n; i++){
+            scratch[i] = MATRIX_AT(vectors_U, i, j);
+            scratch[n + i] = MATRIX_AT(vectors_V, i, j);
+        }
+        factor->singular = LURankOneDense(n, factor->lu->data, factor->lu->ld, factor->pivots, scratch);
+    }
+    STATS_END(MATRIX_STAT_FACTOR_UPDATE, 5.0 * n * n * k);
+    return factor->singular ? 1 : 0;
+}
+
+int LUUpdateVector(LUFactorization factor, const double *u, const double *v){
+    if(!factor || !u || !v)
+        return -1;
+    if(factor->singular){
+        fprintf(stderr, "%s", "Error - Matrix is singular");
+        return -1;
+    }
+    size_t n = factor->lu->num_rows;
+    double *scratch = (double*)ThreadScratch(3 * n * sizeof(double));
+    if(!scratch)
+        return -1;
+    STATS_BEGIN();
+    memcpy(scratch, u, n * sizeof(double));
+    memcpy(scratch + n, v, n * sizeof(double));
+    factor->singular = LURankOneDense(n, factor->lu->data, factor->lu->ld, factor->pivots, scratch);
+    STATS_END(MATRIX_STAT_FACTOR_UPDATE, 5.0 * n * n);
+    return factor->singular ? 1 : 0;
+}
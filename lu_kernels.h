@@ -0,0 +1,164 @@
+/****************************
+ * Author: Blake A. Molina
+ * Created on: 10/17/26
+ * License: GPL
+ ****************************/
+
+/*************************************************************************
+ * Blocked LU factorization and solve, included by lu.c once per element
+ * type.
+ *
+ *  Before each inclusion lu.c defines REAL (the element type), LU_TYPE (a
+ *  name suffix, empty for double, matching the DenseGemm it calls),
+ *  LU_KERNELS (the kernel table for the row operations) and LU_ABS (the
+ *  absolute value function for REAL). The inclusion defines LUFactorDense
+ *  and LUSolveDense suffixed with LU_TYPE.
+ *
+ *  There is deliberately no include guard.
+ ************************************************************************/
+
+#define LU_CONCAT_(name, type) name##type
+#define LU_CONCAT(name, type)  LU_CONCAT_(name, type)
+#define LU_NAME(name)          LU_CONCAT(name, LU_TYPE)
+
+#define FactorPanel   LU_NAME(FactorPanel)
+#define LUFactorDense LU_NAME(LUFactorDense)
+#define LUSolveDense  LU_NAME(LUSolveDense)
+#define DenseGemm     LU_NAME(DenseGemm)
+
+/*******************************************************
+ *          Factorization Kernels
+ *******************************************************/
+// Unblocked partial-pivoting LU of the panel made of columns [col, col+width)
+// and rows [col, n). Row interchanges are applied to entire rows of length n
+// so the left (L) and right (not yet updated) parts stay consistent.
+static size_t FactorPanel(size_t n, REAL *a, size_t lda, size_t col, size_t width,
+                          size_t *pivots, int *sign){
+    size_t singular = 0;
+    for(size_t j = col; j < col + width; j++){
+        // partial pivoting: pick the largest magnitude entry in the column
+        size_t pivot_row = j;
+        REAL largest = LU_ABS(a[j*lda + j]);
+        for(size_t i = j + 1; i < n; i++){
+            REAL value = LU_ABS(a[i*lda + j]);
+            if(value > largest){
+                largest = value;
+                pivot_row = i;
+            }
+        }
+        pivots[j] = pivot_row;
+        if(pivot_row != j){
+            LU_KERNELS->swap(n, a + j*lda, a + pivot_row*lda);
+            *sign = -*sign;
+        }
+        if(largest == 0.0){
+            // exactly singular column: nothing to eliminate, remember the first
+            if(!singular)
+                singular = j + 1;
+            continue;
+        }
+
+        const REAL *pivot = a + j*lda;
+        const REAL reciprocal = (REAL)1 / pivot[j];
+        const size_t rest = col + width - (j + 1); // panel columns right of j
+        for(size_t i = j + 1; i < n; i++){
+            REAL *row = a + i*lda;
+            row[j] *= reciprocal;
+            if(rest)
+                LU_KERNELS->axpy(rest, -row[j], pivot + j + 1, row + j + 1);
+        }
+    }
+    return singular;
+}
+
+size_t LUFactorDense(size_t n, REAL *a, size_t lda, size_t *pivots, int *sign){
+    size_t singular = 0;
+    *sign = 1;
+    for(size_t j = 0; j < n; j += LU_BLOCK){
+        size_t width = n - j < LU_BLOCK ? n - j : LU_BLOCK;
+        size_t panel_singular = FactorPanel(n, a, lda, j, width, pivots, sign);
+        if(panel_singular && !singular)
+            singular = panel_singular;
+
+        size_t next = j + width;
+        if(next >= n)
+            break;
+        // U12 = L11^-1 * A12 (forward substitution on the block row, row by row)
+        size_t right = n - next;
+        for(size_t i = j + 1; i < next; i++){
+            REAL *row = a + i*lda;
+            for(size_t q = j; q < i; q++)
+                if(row[q] != 0.0)
+                    LU_KERNELS->axpy(right, -row[q], a + q*lda + next, row + next);
+        }
+        // A22 = A22 - L21 * U12
+        DenseGemm(0, 0, n - next, right, width,
+                  -1.0, a + next*lda + j, lda, a + j*lda + next, lda,
+                  1.0, a + next*lda + next, lda);
+    }
+    return singular;
+}
+
+
+/*******************************************************
+ *          Triangular Solves
+ *******************************************************/
+void LUSolveDense(size_t n, const REAL *lu, size_t lda, const size_t *pivots,
+                  size_t k, REAL *b, size_t ldb){
+    // Apply the row interchanges in the order they were made
+    for(size_t i = 0; i < n; i++)
+        if(pivots[i] != i)
+            LU_KERNELS->swap(k, b + i*ldb, b + pivots[i]*ldb);
+
+    if(k == 1){
+        // Single right-hand side: dot products along contiguous rows of L and U
+        for(size_t i = 0; i < n; i++){
+            const REAL *row = lu + i*lda;
+            REAL sum = b[i*ldb];
+            for(size_t q = 0; q < i; q++)
+                sum -= row[q] * b[q*ldb];
+            b[i*ldb] = sum;
+        }
+        for(size_t i = n; i-- > 0;){
+            const REAL *row = lu + i*lda;
+            REAL sum = b[i*ldb];
+            for(size_t q = i + 1; q < n; q++)
+                sum -= row[q] * b[q*ldb];
+            b[i*ldb] = sum / row[i];
+        }
+        return;
+    }
+
+    // Many right-hand sides: block rows, with everything left of the diagonal
+    // block folded in by one GEMM and the diagonal block done row by row.
+    for(size_t i0 = 0; i0 < n; i0 += LU_BLOCK){
+        size_t i1 = n - i0 < LU_BLOCK ? n : i0 + LU_BLOCK;
+        DenseGemm(0, 0, i1 - i0, k, i0, -1.0, lu + i0*lda, lda, b, ldb, 1.0, b + i0*ldb, ldb);
+        for(size_t i = i0; i < i1; i++)
+            for(size_t q = i0; q < i; q++)
+                LU_KERNELS->axpy(k, -lu[i*lda + q], b + q*ldb, b + i*ldb);
+    }
+    size_t blocks = (n + LU_BLOCK - 1) / LU_BLOCK;
+    for(size_t block = blocks; block-- > 0;){
+        size_t i0 = block * LU_BLOCK;
+        size_t i1 = n - i0 < LU_BLOCK ? n : i0 + LU_BLOCK;
+        DenseGemm(0, 0, i1 - i0, k, n - i1, -1.0, lu + i0*lda + i1, lda, b + i1*ldb, ldb, 1.0, b + i0*ldb, ldb);
+        for(size_t i = i1; i-- > i0;){
+            for(size_t q = i + 1; q < i1; q++)
+                LU_KERNELS->axpy(k, -lu[i*lda + q], b + q*ldb, b + i*ldb);
+            LU_KERNELS->scale(k, (REAL)1 / lu[i*lda + i], b + i*ldb);
+        }
+    }
+}
+
+#undef FactorPanel
+#undef LUFactorDense
+#undef LUSolveDense
+#undef DenseGemm
+#undef LU_NAME
+#undef LU_CONCAT
+#undef LU_CONCAT_
+#undef REAL
+#undef LU_TYPE
+#undef LU_KERNELS
+#undef LU_ABS
@@ -0,0 +1,257 @@
+/****************************
+ * Author: Blake A. Molina
+ * Created on: 10/17/26
+ * License: GPL
+ ****************************/
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "matrix_internal.h"
+
+#define MATRIX_FILE_MAGIC "SMLCMAT"   // 7 characters + terminator
+#define MATRIX_FILE_VERSION 1
+#define MATRIX_FILE_BYTE_ORDER 0x01020304u
+#define MATRIX_DTYPE_FLOAT64 1
+
+/*******************************************************
+ *          File Header
+ *******************************************************/
+// Fixed 64-byte header, written in the byte order of the machine that wrote
+// the file (byte_order tells a reader whether that matches its own). The
+// values start at data_offset, a multiple of alignment, as num_rows rows of
+// ld values each: exactly the layout of a Matrix, so a mapping of the file
+// is usable in place.
+typedef struct{
+    char magic[8];
+    uint32_t version;
+    uint32_t dtype;
+    uint64_t num_rows;
+    uint64_t num_cols;
+    uint64_t ld;           // values per stored row (>= num_cols)
+    uint64_t alignment;    // of data_offset and of every row, in bytes
+    uint64_t data_offset;  // bytes from the start of the file to row 0
+    uint32_t byte_order;
+    uint32_t reserved;
+}MatrixFileHeader;
+
+_Static_assert(sizeof(MatrixFileHeader) == 64, "matrix file header must stay 64 bytes");
+
+// Reads the header from fd and checks it describes a matrix this build can use
+static int ReadHeader(int fd, const char *path, MatrixFileHeader *header, off_t *file_size){
+    struct stat info;
+    if(fstat(fd, &info) != 0 || pread(fd, header, sizeof(*header), 0) != (ssize_t)sizeof(*header)){
+        fprintf(stderr, "Error - Could not read a matrix header from %s", path);
+        return -1;
+    }
+    *file_size = info.st_size;
+    if(memcmp(header->magic, MATRIX_FILE_MAGIC, sizeof(header->magic)) != 0){
+        fprintf(stderr, "Error - %s is not a matrix file", path);
+        return -1;
+    }
+    if(header->byte_order != MATRIX_FILE_BYTE_ORDER){
+        fprintf(stderr, "Error - %s was written on a machine of a different byte order", path);
+        return -1;
+    }
+    if(header->version != MATRIX_FILE_VERSION || header->dtype != MATRIX_DTYPE_FLOAT64){
+        fprintf(stderr, "Error - %s uses version %u / dtype %u, which this build cannot read", path,
+                (unsigned)header->version, (unsigned)header->dtype);
+        return -1;
+    }
+    uint64_t rows = header->num_rows, ld = header->ld;
+    if(rows == 0 || header->num_cols == 0 || ld < header->num_cols ||
+       header->alignment != MATRIX_ALIGNMENT || header->data_offset % MATRIX_ALIGNMENT != 0 ||
+       (ld * sizeof(double)) % MATRIX_ALIGNMENT != 0 || ld > (UINT64_MAX - header->data_offset) / sizeof(double) / rows ||
+       header->data_offset + rows * ld * sizeof(double) > (uint64_t)info.st_size){
+        fprintf(stderr, "Error - %s has an inconsistent header or is truncated", path);
+        return -1;
+    }
+    return 0;
+}
+
+// Writes all of buffer, resuming after partial writes
+static int WriteAll(int fd, const void *buffer, size_t size){
+    const char *at = (const char*)buffer;
+    while(size > 0){
+        ssize_t written = write(fd, at, size);
+        if(written < 0){
+            if(errno == EINTR)
+                continue;
+            return -1;
+        }
+        at += written;
+        size -= (size_t)written;
+    }
+    return 0;
+}
+
+
+/*******************************************************
+ *          Writing
+ *******************************************************/
+int SaveMatrix(Matrix matrix, const char *path){
+    if(isEmpty(matrix) || !path){
+        fprintf(stderr, "%s", "Error - Need a matrix and a path to save it to");
+        return -1;
+    }
+    STATS_BEGIN();
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if(fd < 0){
+        fprintf(stderr, "Error - Could not open %s for writing", path);
+        return -1;
+    }
+    const size_t per_line = MATRIX_ALIGNMENT / sizeof(double);
+    size_t ld = (matrix->num_cols + per_line - 1) / per_line * per_line;
+    MatrixFileHeader header = {MATRIX_FILE_MAGIC, MATRIX_FILE_VERSION, MATRIX_DTYPE_FLOAT64,
+                               matrix->num_rows, matrix->num_cols, ld, MATRIX_ALIGNMENT,
+                               sizeof(MatrixFileHeader), MATRIX_FILE_BYTE_ORDER, 0};
+    int status = WriteAll(fd, &header, sizeof(header));
+    if(status == 0 && matrix->ld == ld && !(matrix->flags & MATRIX_VIEW)){
+        // the rows are already in file layout: one write for the whole region
+        status = WriteAll(fd, matrix->data, matrix->num_rows * ld * sizeof(double));
+    }
+    else if(status == 0){
+        // repack rows of another stride through a buffer of whole rows
+        size_t row_bytes = ld * sizeof(double);
+        size_t rows_per_chunk = row_bytes >= (4u << 20) ? 1 : (4u << 20) / row_bytes;
+        double *chunk = (double*)AllocateAligned(rows_per_chunk * row_bytes);
+        status = chunk ? 0 : -1;
+        for(size_t i = 0; status == 0 && i < matrix->num_rows; i += rows_per_chunk){
+            size_t rows = matrix->num_rows - i < rows_per_chunk ? matrix->num_rows - i : rows_per_chunk;
+            for(size_t r = 0; r < rows; r++){
+                memcpy(chunk + r * ld, MATRIX_ROW(matrix, i + r), matrix->num_cols * sizeof(double));
+                memset(chunk + r * ld + matrix->num_cols, 0, (ld - matrix->num_cols) * sizeof(double));
+            }
+            status = WriteAll(fd, chunk, rows * row_bytes);
+        }
+        FreeAligned(chunk);
+    }
+    if(close(fd) != 0)
+        status = -1;
+    if(status != 0)
+        fprintf(stderr, "Error - Could not write matrix to %s", path);
+    STATS_END(MATRIX_STAT_FILE_IO, 0);
+    return status;
+}
+
+
+/*******************************************************
+ *          Loading & Mapping
+ *******************************************************/
+Matrix LoadMatrix(const char *path){
+    STATS_BEGIN();
+    int fd = path ? open(path, O_RDONLY) : -1;
+    if(fd < 0){
+        fprintf(stderr, "Error - Could not open %s", path ? path : "(null)");
+        return NULL;
+    }
+    MatrixFileHeader header;
+    off_t file_size;
+    Matrix matrix = NULL;
+    if(ReadHeader(fd, path, &header, &file_size) == 0)
+        matrix = NewMatrix(header.num_rows, header.num_cols);
+    if(matrix){
+        // NewMatrix picks the same stride the writer used, so the values
+        // arrive with one large read
+        size_t size = header.num_rows * header.ld * sizeof(double);
+        int same_layout = matrix->ld == header.ld;
+        char *at = (char*)matrix->data;
+        off_t offset = (off_t)header.data_offset;
+        for(size_t i = 0; i < (same_layout ? 1 : header.num_rows); i++){
+            size_t remaining = same_layout ? size : header.num_cols * sizeof(double);
+            if(!same_layout){
+                at = (char*)MATRIX_ROW(matrix, i);
+                offset = (off_t)(header.data_offset + i * header.ld * sizeof(double));
+            }
+            while(remaining > 0){
+                ssize_t got = pread(fd, at, remaining, offset);
+                if(got < 0 && errno == EINTR)
+                    continue;
+                if(got <= 0){
+                    fprintf(stderr, "Error - Could not read the values of %s", path);
+                    FreeMatrix(&matrix);
+                    close(fd);
+                    return NULL;
+                }
+                at += got;
+                offset += got;
+                remaining -= (size_t)got;
+            }
+        }
+    }
+    close(fd);
+    STATS_END(MATRIX_STAT_FILE_IO, 0);
+    return matrix;
+}
+
+// The struct of a mapped matrix carries what FreeMatrix needs to undo it
+typedef struct{
+    matrix_struct matrix;  // first, so a Matrix points at the whole record
+    void *base;            // the mapping
+    size_t length;
+    double **index;        // row table of the mapped rows
+}MappedMatrix;
+
+Matrix MapMatrix(const char *path, int mode){
+    if(mode != MATRIX_MAP_READ_ONLY && mode != MATRIX_MAP_COPY_ON_WRITE){
+        fprintf(stderr, "%s", "Error - Map mode must be MATRIX_MAP_READ_ONLY or MATRIX_MAP_COPY_ON_WRITE");
+        return NULL;
+    }
+    STATS_BEGIN();
+    int fd = path ? open(path, O_RDONLY) : -1;
+    if(fd < 0){
+        fprintf(stderr, "Error - Could not open %s", path ? path : "(null)");
+        return NULL;
+    }
+    MatrixFileHeader header;
+    off_t file_size;
+    if(ReadHeader(fd, path, &header, &file_size) != 0){
+        close(fd);
+        return NULL;
+    }
+    // a private mapping is writable without touching the file: pages are
+    // copied the first time they are written
+    int protection = mode == MATRIX_MAP_READ_ONLY ? PROT_READ : PROT_READ | PROT_WRITE;
+    int sharing = mode == MATRIX_MAP_READ_ONLY ? MAP_SHARED : MAP_PRIVATE;
+    size_t length = (size_t)file_size;
+    void *base = mmap(NULL, length, protection, sharing, fd, 0);
+    close(fd); // the mapping keeps the file referenced
+    if(base == MAP_FAILED){
+        fprintf(stderr, "Error - Could not map %s", path);
+        return NULL;
+    }
+    posix_madvise(base, length, POSIX_MADV_SEQUENTIAL);
+
+    MappedMatrix *mapped = (MappedMatrix*)malloc(sizeof(MappedMatrix));
+    double **index = (double**)malloc(header.num_rows * sizeof(double*));
+    if(!mapped || !index){
+        fprintf(stderr, "%s", "Error - Could not allocate matrix");
+        free(mapped);
+        free(index);
+        munmap(base, length);
+        return NULL;
+    }
+    Matrix matrix = &mapped->matrix;
+    matrix->data = (double*)((char*)base + header.data_offset);
+    matrix->num_rows = header.num_rows;
+    matrix->num_cols = header.num_cols;
+    matrix->ld = header.ld;
+    matrix->flags = MATRIX_MAPPED;
+    matrix->index = index;
+    for(size_t i = 0; i < matrix->num_rows; i++)
+        index[i] = MATRIX_ROW(matrix, i);
+    mapped->base = base;
+    mapped->length = length;
+    mapped->index = index;
+    STATS_END(MATRIX_STAT_FILE_IO, 0);
+    return matrix;
+}
+
+void ReleaseMappedMatrix(Matrix matrix){
+    MappedMatrix *mapped = (MappedMatrix*)matrix;
+    munmap(mapped->base, mapped->length);
+    free(mapped->index);
+    free(mapped);
+}
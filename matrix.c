@@ -4,44 +4,137 @@
  * License: GPL
  ****************************/
 
-#include "matrix.h"
+#define _POSIX_C_SOURCE 200809L  // posix_memalign
+
+#include "matrix_internal.h"
+
+// Smallest share of elementwise work (in values touched) worth handing to a thread
+#define PARALLEL_MIN_ELEMENTS 16384
+
+// Rows per thread share for a row-wise loop over rows of num_cols values
+static size_t RowChunk(size_t num_cols){
+    return num_cols >= PARALLEL_MIN_ELEMENTS ? 1 : PARALLEL_MIN_ELEMENTS / (num_cols ? num_cols : 1);
+}
 
 /*******************************************************
  *     Matrix Instantiation, Deletion, & Printing
  *******************************************************/
-Matrix NewMatrix(size_t num_rows, size_t num_cols){
+void *AllocateAligned(size_t size){
+    void *buffer = NULL;
+    // posix_memalign wants a non-zero size that it can round; keep it a whole
+    // number of alignment units so the tail of the last row is never shared
+    size = (size + MATRIX_ALIGNMENT - 1) / MATRIX_ALIGNMENT * MATRIX_ALIGNMENT;
+    if(size == 0 || posix_memalign(&buffer, MATRIX_ALIGNMENT, size) != 0)
+        return NULL;
+    return buffer;
+}
+
+void FreeAligned(void *buffer){
+    free(buffer);
+}
+
+// Rounds a row length up so that every row starts on a MATRIX_ALIGNMENT boundary
+static size_t LeadingDimension(size_t num_cols){
+    const size_t per_line = MATRIX_ALIGNMENT / sizeof(double);
+    return (num_cols + per_line - 1) / per_line * per_line;
+}
 
-    // Allocate memory for matrix struct
-    Matrix newMatrix = (Matrix)malloc(sizeof(matrix_struct));
+Matrix NewMatrix(size_t num_rows, size_t num_cols){
+    size_t ld          = LeadingDimension(num_cols);
+    size_t value_bytes = num_rows * ld * sizeof(double);
+    size_t total_bytes = value_bytes + num_rows * sizeof(double*);
+    Matrix newMatrix;
+    STATS_BEGIN();
+
+    MatrixArena arena = ActiveArena();
+    if(arena){
+        // struct, values and row table in one arena allocation
+        size_t struct_bytes = (sizeof(matrix_struct) + MATRIX_ALIGNMENT - 1) / MATRIX_ALIGNMENT * MATRIX_ALIGNMENT;
+        char *memory = (char*)ArenaAllocate(arena, struct_bytes + total_bytes);
+        if(!memory){
+            fprintf(stderr, "%s", "Error - Could not allocate matrix");
+            return NULL;
+        }
+        newMatrix = (Matrix)memory;
+        newMatrix->data  = (double*)(memory + struct_bytes);
+        newMatrix->flags = 0;
+    }
+    else{
+        // Allocate memory for matrix struct
+        newMatrix = (Matrix)malloc(sizeof(matrix_struct));
+        if(!newMatrix){
+            fprintf(stderr, "%s", "Error - Could not allocate matrix");
+            return NULL;
+        }
+        // One aligned buffer holds the values followed by the row pointer table
+        newMatrix->data = (double*)AllocateAligned(total_bytes > 0 ? total_bytes : 1);
+        if(!newMatrix->data){
+            fprintf(stderr, "%s", "Error - Could not allocate matrix");
+            free(newMatrix);
+            return NULL;
+        }
+        newMatrix->flags = MATRIX_OWNS_DATA | MATRIX_OWNS_STRUCT;
+    }
     newMatrix->num_rows = num_rows;
     newMatrix->num_cols = num_cols;
-
-    // Allocate memory for 2d array of type double within matrix struct
-    newMatrix->index = (double**)calloc(newMatrix->num_rows, sizeof(double*));
-    for(int i = 0; i < newMatrix->num_rows; i++)
-        newMatrix->index[i] = (double*)calloc(newMatrix->num_cols, sizeof(double));
+    newMatrix->ld       = ld;
+    memset(newMatrix->data, 0, value_bytes);
+
+    newMatrix->index = (double**)((char*)newMatrix->data + value_bytes);
+    for(size_t i = 0; i < num_rows; i++)
+        newMatrix->index[i] = MATRIX_ROW(newMatrix, i);
+    STATS_ALLOCATED(total_bytes);
+    STATS_END(MATRIX_STAT_NEW_MATRIX, 0);
     return newMatrix;
 }
 
 void FreeMatrix(Matrix *matrix) {
-    if (!isEmpty(*matrix)) {
-        // free memory from 2d array within matrix struct
-        for (int i = 0; i < (*matrix)->num_rows; i++)
-            free((*matrix)->index[i]);
-        free((*matrix)->index);
+    if (matrix && *matrix) {
+        // values and row table share one buffer
+        if ((*matrix)->flags & MATRIX_OWNS_DATA)
+            FreeAligned((*matrix)->data);
         // free memory from matrix struct
-        free(*matrix);
+        if ((*matrix)->flags & MATRIX_OWNS_STRUCT)
+            free(*matrix);
+        else if ((*matrix)->flags & MATRIX_MAPPED)
+            ReleaseMappedMatrix(*matrix); // unmaps the file along with the struct
         *matrix = NULL;
     }
 }
 
+Matrix MatrixView(Matrix parent, size_t row, size_t col, size_t num_rows, size_t num_cols, size_t row_step){
+    if(isEmpty(parent))
+        return NULL;
+    if(row_step == 0)
+        row_step = 1;
+    if(num_rows == 0 || num_cols == 0 || row >= parent->num_rows || col >= parent->num_cols ||
+       num_cols > parent->num_cols - col || (num_rows - 1) * row_step >= parent->num_rows - row){
+        fprintf(stderr, "%s", "Error - View must lie inside its parent matrix");
+        return NULL;
+    }
+    // struct and row table in one allocation; the values stay the parent's
+    size_t bytes = sizeof(matrix_struct) + num_rows * sizeof(double*);
+    MatrixArena arena = ActiveArena();
+    Matrix view = arena ? (Matrix)ArenaAllocate(arena, bytes) : (Matrix)malloc(bytes);
+    if(!view){
+        fprintf(stderr, "%s", "Error - Could not allocate matrix view");
+        return NULL;
+    }
+    view->data     = MATRIX_ROW(parent, row) + col;
+    view->num_rows = num_rows;
+    view->num_cols = num_cols;
+    view->ld       = parent->ld * row_step;
+    view->flags    = arena ? MATRIX_VIEW : MATRIX_VIEW | MATRIX_OWNS_STRUCT;
+    view->index    = (double**)(view + 1);
+    for(size_t i = 0; i < num_rows; i++)
+        view->index[i] = MATRIX_ROW(view, i);
+    return view;
+}
+
 void PrintMatrix(Matrix matrix) {
     if (!isEmpty(matrix)) {
-        for (int i = 0; i < matrix->num_rows; i++) {
-            for (int j = 0; j < matrix->num_cols; j++)
-                printf("%0.3f ", matrix->index[i][j]);
-            printf("\n");
-        }
+        // "%0.3f " per value, formatted into large buffers
+        FormatMatrixText(matrix, stdout, 3, ' ', 1);
     }
 }
 
@@ -51,25 +144,74 @@ void PrintMatrix(Matrix matrix) {
 Matrix MultiplyMatrices(Matrix matrix_A, Matrix matrix_B){
     // Makes sure matrices exist and dot product can be applied to the matrices
     if(isEmpty(matrix_A) || isEmpty(matrix_B) || matrix_A->num_cols != matrix_B->num_rows) {
-        fprintf(stderr, "%s", "Error - Need an NxN matrix to perform matrix multiplication");
+        fprintf(stderr, "%s", "Error - Matrix A's column count must equal matrix B's row count to multiply");
         return NULL;
     }
 
     Matrix result_matrix = NewMatrix(matrix_A->num_rows, matrix_B->num_cols);
+    if(!result_matrix)
+        return NULL;
+    MultiplyMatricesInto(result_matrix, matrix_A, matrix_B);
+    return result_matrix;
+}
 
-    // Apply Dot Product
-    for(int row = 0; row < matrix_A->num_rows; row++){
-        for(int column = 0; column < matrix_B->num_cols; column++){
-            int sum = 0;
-            for(int i = 0; i < matrix_A->num_rows; i++)
-                sum += matrix_A->index[row][i] * matrix_B->index[i][column];
-            result_matrix->index[row][column] = sum;
-        }
+int MultiplyMatricesInto(Matrix result_matrix, Matrix matrix_A, Matrix matrix_B){
+    if(isEmpty(matrix_A) || isEmpty(matrix_B) || isEmpty(result_matrix) ||
+       matrix_A->num_cols != matrix_B->num_rows ||
+       result_matrix->num_rows != matrix_A->num_rows || result_matrix->num_cols != matrix_B->num_cols) {
+        fprintf(stderr, "%s", "Error - Result must be MxP to hold the product of an MxN and an NxP matrix");
+        return -1;
     }
-    return result_matrix;
+    if(MatricesOverlap(result_matrix, matrix_A) || MatricesOverlap(result_matrix, matrix_B)) {
+        fprintf(stderr, "%s", "Error - Result of a multiplication cannot be one of its operands");
+        return -1;
+    }
+    // Apply Dot Product (unrolled for small square shapes, otherwise
+    // blocked GEMM, see gemm.c)
+    STATS_BEGIN();
+    size_t n = matrix_A->num_rows;
+    if(matrix_A->num_cols != n || matrix_B->num_cols != n ||
+       SmallMultiplyDense(n, matrix_A->data, matrix_A->ld, matrix_B->data, matrix_B->ld,
+                          result_matrix->data, result_matrix->ld) != 0)
+        DenseGemm(0, 0, matrix_A->num_rows, matrix_B->num_cols, matrix_A->num_cols,
+                  1.0, matrix_A->data, matrix_A->ld, matrix_B->data, matrix_B->ld,
+                  0.0, result_matrix->data, result_matrix->ld);
+    STATS_END(MATRIX_STAT_MULTIPLY, 2.0 * matrix_A->num_rows * matrix_B->num_cols * matrix_A->num_cols);
+    return 0;
+}
+
+int MultiplyMatricesAccumulate(Matrix matrix_C, double alpha, Matrix matrix_A, Matrix matrix_B, double beta){
+    if(isEmpty(matrix_A) || isEmpty(matrix_B) || isEmpty(matrix_C) ||
+       matrix_A->num_cols != matrix_B->num_rows ||
+       matrix_C->num_rows != matrix_A->num_rows || matrix_C->num_cols != matrix_B->num_cols) {
+        fprintf(stderr, "%s", "Error - Matrix dimensions do not agree for C = alpha*A*B + beta*C");
+        return -1;
+    }
+    if(MatricesOverlap(matrix_C, matrix_A) || MatricesOverlap(matrix_C, matrix_B)) {
+        fprintf(stderr, "%s", "Error - Result of a multiplication cannot be one of its operands");
+        return -1;
+    }
+    STATS_BEGIN();
+    DenseGemm(0, 0, matrix_A->num_rows, matrix_B->num_cols, matrix_A->num_cols,
+              alpha, matrix_A->data, matrix_A->ld, matrix_B->data, matrix_B->ld,
+              beta, matrix_C->data, matrix_C->ld);
+    STATS_END(MATRIX_STAT_MULTIPLY, 2.0 * matrix_A->num_rows * matrix_B->num_cols * matrix_A->num_cols);
+    return 0;
 }
 
 
+typedef struct{
+    Matrix matrix_A, matrix_B, result_matrix;
+    double sign;
+}AddRowsJob;
+
+static void AddRowsTask(void *context, size_t begin, size_t end){
+    const AddRowsJob *job = (const AddRowsJob*)context;
+    for(size_t i = begin; i < end; i++)
+        matrix_kernels->add(job->matrix_A->num_cols, MATRIX_ROW(job->matrix_A, i), job->sign,
+                            MATRIX_ROW(job->matrix_B, i), MATRIX_ROW(job->result_matrix, i));
+}
+
 Matrix AddMatrices(Matrix matrix_A, Matrix matrix_B, int subtract_flag){
     // Makes sure matrices exists and are same size before performing addition
     if(isEmpty(matrix_A) || isEmpty(matrix_B) || matrix_A->num_rows != matrix_B->num_rows || matrix_A->num_cols != matrix_B->num_cols) {
@@ -77,52 +219,32 @@ Matrix AddMatrices(Matrix matrix_A, Matrix matrix_B, int subtract_flag){
         return NULL;
     }
 
-    // set subtraction flag to -1 if user passes in a 1 for the subtract parameter
-    int subtraction_flag = 1;
-    if(subtract_flag == 1)
-        subtraction_flag = -1;
-
     Matrix result_matrix = NewMatrix(matrix_A->num_rows, matrix_A->num_cols);
-
-    for(int i = 0; i < matrix_A->num_rows; i++){
-        for(int j = 0; j < matrix_A->num_cols; j++)
-            result_matrix->index[i][j] = matrix_A->index[i][j] + (subtraction_flag * matrix_B->index[i][j]);
-    }
+    if(!result_matrix)
+        return NULL;
+    AddMatricesInto(result_matrix, matrix_A, matrix_B, subtract_flag);
     return result_matrix;
 }
 
-
-/*******************************************************
- *          Matrix Transposing & Rotation
- *******************************************************/
-void RotateMatrixClockwise(Matrix matrix){
-    // make sure matrix exists and is square
-    if(isEmpty(matrix) || !isSquare(matrix))
-        fprintf(stderr, "%s", "Error - Need an Nxn matrix to rotate");
-    else{
-        Transpose(matrix);
-        SwapColumns(matrix);
+int AddMatricesInto(Matrix result_matrix, Matrix matrix_A, Matrix matrix_B, int subtract_flag){
+    if(isEmpty(matrix_A) || isEmpty(matrix_B) || isEmpty(result_matrix) ||
+       matrix_A->num_rows != matrix_B->num_rows || matrix_A->num_cols != matrix_B->num_cols ||
+       result_matrix->num_rows != matrix_A->num_rows || result_matrix->num_cols != matrix_A->num_cols) {
+        fprintf(stderr, "%s", "Error - Need matrices of the same size to perform matrix addition");
+        return -1;
     }
-}
 
-void RotateMatrixCounterClockwise(Matrix matrix){
-    // make sure matrix exists and is square
-    if(isEmpty(matrix) || !isSquare(matrix))
-        fprintf(stderr, "%s", "Error - Need an Nxn matrix to rotate");
-    else{
-        SwapColumns(matrix);
-        Transpose(matrix);
-    }
-}
+    // set subtraction flag to -1 if user passes in a 1 for the subtract parameter
+    double subtraction_flag = 1;
+    if(subtract_flag == 1)
+        subtraction_flag = -1;
 
-void Transpose(Matrix matrix){
-    if(isEmpty(matrix))
-        return;
-    // Transpose NxN matrix
-    for(int row = 0; row < matrix->num_rows; row++){
-        for(int col = row; col < matrix->num_cols; col++)
-            SwapValues(*(matrix->index+row)+col, *(matrix->index+col)+row);
-    }
+    // elementwise, so the result may be one of the operands
+    STATS_BEGIN();
+    AddRowsJob job = {matrix_A, matrix_B, result_matrix, subtraction_flag};
+    ParallelFor(matrix_A->num_rows, RowChunk(matrix_A->num_cols), AddRowsTask, &job);
+    STATS_END(MATRIX_STAT_ADD, matrix_A->num_rows * matrix_A->num_cols);
+    return 0;
 }
 
 
@@ -135,102 +257,152 @@ double Determinant(Matrix matrix){
         fprintf(stderr, "%s", "Error - Need an NxN matrix to calculate determinant");
         return -1;
     }
-    double determinant_multiplier = ReducedRowEchelonForm(matrix);
-    int determinant = 1;
-    for(int i = 0; i < matrix->num_rows; i++) // multiply diagonal
-        determinant *= matrix->index[i][i];
-    return determinant * determinant_multiplier; // scale determinant by value from performing elementary row operations
+    STATS_BEGIN();
+    double determinant;
+    if(SmallDeterminantDense(matrix->num_rows, matrix->data, matrix->ld, &determinant) == 0){
+        STATS_END(MATRIX_STAT_DETERMINANT, 2.0 * matrix->num_rows * matrix->num_rows * matrix->num_rows / 3);
+        return determinant;
+    }
+    // triangularize a copy so the caller's matrix survives
+    LUFactorization factor = LUFactor(matrix);
+    if(!factor)
+        return -1;
+    determinant = LUDeterminant(factor); // product of the diagonal, signed by row swaps
+    FreeLUFactorization(&factor);
+    STATS_END(MATRIX_STAT_DETERMINANT, 2.0 * matrix->num_rows * matrix->num_rows * matrix->num_rows / 3);
+    return determinant;
 }
 
 
 /*******************************************************
  *         Matrix Decomposition Algorithms
  *******************************************************/
+typedef struct{
+    double **rows;  // current row order
+    size_t num_cols, row, pivot;
+}EliminateJob;
+
+// Clears the pivot column from rows [begin, end), except the pivot row itself
+static void EliminateTask(void *context, size_t begin, size_t end){
+    const EliminateJob *job = (const EliminateJob*)context;
+    const double *pivot_row = job->rows[job->row];
+    for(size_t i = begin; i < end; i++) {
+        double scalar = -job->rows[i][job->pivot];
+        if (i != job->row && scalar != 0.0) // Rule 3 of Properties of Row Operations for Determinants
+            matrix_kernels->axpy(job->num_cols, scalar, pivot_row, job->rows[i]);
+    }
+}
+
+// Moves every row of matrix to the position its index table entry names
+// (row i's values are at index[i]) and resets the table. Follows each cycle
+// of the permutation with one spare row, so each row is copied at most once.
+static void ApplyRowOrder(Matrix matrix){
+    size_t n = matrix->num_rows, bytes = matrix->num_cols * sizeof(double);
+    double *spare = NULL;
+    for(size_t start = 0; start < n; start++){
+        if(matrix->index[start] == MATRIX_ROW(matrix, start))
+            continue;
+        if(!spare && !(spare = (double*)ThreadScratch(bytes))){
+            // no room for a spare row: fall back to swapping rows into place
+            for(size_t i = start; i < n; i++){
+                size_t source = (size_t)(matrix->index[i] - matrix->data) / matrix->ld;
+                if(source == i)
+                    continue;
+                matrix_kernels->swap(matrix->num_cols, MATRIX_ROW(matrix, i), matrix->index[i]);
+                for(size_t j = i + 1; j < n; j++){
+                    if(matrix->index[j] == MATRIX_ROW(matrix, i)){
+                        matrix->index[j] = MATRIX_ROW(matrix, source);
+                        break;
+                    }
+                }
+                matrix->index[i] = MATRIX_ROW(matrix, i);
+            }
+            return;
+        }
+        memcpy(spare, MATRIX_ROW(matrix, start), bytes);
+        size_t at = start;
+        for(;;){
+            double *source = matrix->index[at];
+            matrix->index[at] = MATRIX_ROW(matrix, at);
+            if(source == MATRIX_ROW(matrix, start)){
+                memcpy(MATRIX_ROW(matrix, at), spare, bytes);
+                break;
+            }
+            memcpy(MATRIX_ROW(matrix, at), source, bytes);
+            at = (size_t)(source - matrix->data) / matrix->ld;
+        }
+    }
+}
+
 double ReducedRowEchelonForm(Matrix matrix) {
     if(isEmpty(matrix))
         return -1;
-    int pivot = 0;
+    size_t pivot = 0;
     // function keeps track of determinant multiplier in case user needs to calculate
     // determinant value.
     double determinant_multiplier = 1;
-    for(int row = 0; row < matrix->num_rows; row++) {
-        if (pivot > matrix->num_cols-1)
-            return determinant_multiplier;
-        int i = row;
-        while (matrix->index[i][pivot] == 0) {
-            i++;
-            if (i >= matrix->num_rows-1) {
-                i = row;
-                pivot++;
-                if (pivot > matrix->num_cols-1)
-                    return determinant_multiplier;
+    STATS_BEGIN();
+    size_t eliminations = 0; // pivot columns cleared, for the FLOP count
+    // rows are reached through the index table, so a row swap is a pointer swap
+    double **rows = matrix->index;
+    for(size_t row = 0; row < matrix->num_rows && pivot < matrix->num_cols; pivot++) {
+        // partial pivoting: the largest magnitude entry left in the column
+        size_t i = row;
+        double largest = fabs(rows[row][pivot]);
+        for(size_t candidate = row + 1; candidate < matrix->num_rows; candidate++){
+            if(fabs(rows[candidate][pivot]) > largest){
+                largest = fabs(rows[candidate][pivot]);
+                i = candidate;
             }
         }
-        SwapRows(matrix, i, row);
-        determinant_multiplier *= matrix->index[row][pivot]; // Apply Rule 1 and Rule 2 of Properties of Row Operations for Determinants
-        DivideRow(matrix, row, matrix->index[row][pivot]);
-
-        for (i = 0; i < matrix->num_rows; i++) {
-            if (i != row)
-                AddMultipleRow(matrix,i,row,-matrix->index[i][pivot]); // Rule 3 of Properties of Row Operations for Determinants
+        if(largest == 0) // nothing to eliminate in this column
+            continue;
+        if(i != row){
+            double *swapped = rows[i];
+            rows[i] = rows[row];
+            rows[row] = swapped;
+            determinant_multiplier = -determinant_multiplier; // a row swap negates the determinant
+            STATS_PIVOT_SWAP();
         }
+        determinant_multiplier *= rows[row][pivot]; // Apply Rule 1 and Rule 2 of Properties of Row Operations for Determinants
+        matrix_kernels->scale(matrix->num_cols, 1.0 / rows[row][pivot], rows[row]);
+        rows[row][pivot] = 1.0; // exact, so the eliminations below leave exact zeros
+
+        EliminateJob job = {rows, matrix->num_cols, row, pivot};
+        ParallelFor(matrix->num_rows, RowChunk(matrix->num_cols), EliminateTask, &job);
+        row++;
+        eliminations++;
     }
+    ApplyRowOrder(matrix);
+    // per pivot: one row scaled, every other row updated by a multiply-add
+    STATS_END(MATRIX_STAT_RREF, eliminations * (2.0 * matrix->num_rows - 1) * matrix->num_cols);
     return determinant_multiplier;
 }
 
-Matrix Cholesky(Matrix matrix){
-    if(isEmpty(matrix))
-        return NULL;
-    Matrix new_matrix = NewMatrix(matrix->num_rows, matrix->num_cols);
-    // loop over each row
-    for(int i = 0; i < matrix->num_rows; i++){
-        double temp_for_diag = 0;
-        // calculate non-diagonal value
-        for(int j = 0; j < i; j++){
-            double temp_for_non_diag = 0.0;
-            for(int k = 0; k < j; k++)
-                // calculate non-diagonal value
-                temp_for_non_diag += (new_matrix->index[i][k] * new_matrix->index[j][k]);
-            new_matrix->index[i][j] = (1.0/new_matrix->index[j][j])*(matrix->index[i][j] - temp_for_non_diag);
-            temp_for_diag += (pow(new_matrix->index[i][j], 2.0));
-        }
-        // calculate diagonal value
-        new_matrix->index[i][i] = sqrt(matrix->index[i][i] - temp_for_diag);
-    }
-    return new_matrix;
-}
-
-
 /*******************************************************
  *             Matrix Helper Functions
  *******************************************************/
 void SwapRows(Matrix matrix, int rowA, int rowB){
-    for(int i = 0; i < matrix->num_cols; i++){
-        double temp = matrix->index[rowA][i];
-        matrix->index[rowA][i] = matrix->index[rowB][i];
-        matrix->index[rowB][i] = temp;
-    }
+    if(rowA == rowB)
+        return;
+    matrix_kernels->swap(matrix->num_cols, MATRIX_ROW(matrix, rowA), MATRIX_ROW(matrix, rowB));
 }
 
 void DivideRow(Matrix matrix, int row, double divisor){
-    for(int i = 0; i < matrix->num_cols; i++)
-        matrix->index[row][i] /= divisor; // Reduce row by dividing by a common divisor
+    // Reduce row by dividing by a common divisor (one division, then multiplies)
+    matrix_kernels->scale(matrix->num_cols, 1.0 / divisor, MATRIX_ROW(matrix, row));
 }
 
 
 void AddMultipleRow(Matrix matrix, int row_receiver, int row_multiple, double scalar){
-    for (int col = 0; col < matrix->num_cols; col++)
-        matrix->index[row_receiver][col] += scalar * matrix->index[row_multiple][col];
+    if(scalar == 0.0) // adding a zero multiple leaves the row untouched
+        return;
+    matrix_kernels->axpy(matrix->num_cols, scalar, MATRIX_ROW(matrix, row_multiple), MATRIX_ROW(matrix, row_receiver));
 }
 
 
 void SwapColumns(Matrix matrix){
-    size_t column_right = matrix->num_cols-1;
-    for(int column_left = 0; column_left < matrix->num_cols/2; column_left++){
-        for(int row = 0; row < matrix->num_rows; row++)
-            SwapValues(*(matrix->index+row)+column_left, *(matrix->index+row)+column_right);
-        column_right--;
-    }
+    FlipHorizontal(matrix);
 }
 
 void SwapValues(double *index_one, double *index_two){
@@ -239,6 +411,24 @@ void SwapValues(double *index_one, double *index_two){
     *index_two        = temp_value;
 }
 
+int MatricesOverlap(Matrix a, Matrix b){
+    if(a->data > b->data){
+        Matrix swapped = a;
+        a = b;
+        b = swapped;
+    }
+    size_t distance = (size_t)(b->data - a->data);
+    if(a->ld != b->ld){
+        // different row distances: compare the spans of storage
+        return distance < (a->num_rows - 1) * a->ld + a->num_cols;
+    }
+    // b[j][c] is a[j + shift][c + offset], or a[j + shift + 1][c + offset - ld]
+    // when it wraps past the end of a's row
+    size_t ld = a->ld, shift = distance / ld, offset = distance % ld;
+    return (shift < a->num_rows && offset < a->num_cols) ||
+           (shift + 1 < a->num_rows && offset + b->num_cols > ld);
+}
+
 int isEmpty(Matrix matrix){
     if(!matrix || matrix->num_rows <= 0 || matrix->num_cols <= 0)
         return 1;
@@ -258,9 +448,8 @@ int isSquare(Matrix matrix){
 int IsLinearIndependent(Matrix matrix){
     if(isEmpty(matrix))
         return -1;
-    // Linear independent matrices have a non-zero determinant
-    double determinant = Determinant(matrix);
-    if(determinant != 0)
+    // The columns are independent exactly when they are all needed for the rank
+    if(MatrixRank(matrix, 0.0) == matrix->num_cols)
         return 1;
     return 0;
 }
@@ -276,39 +465,89 @@ Matrix SolveSystem(Matrix matrix){
         return NULL;
     }
 
+    Matrix result_matrix = NewMatrix(matrix->num_rows, 1);
+    if(result_matrix && SolveSystemInto(result_matrix, matrix) != 0)
+        FreeMatrix(&result_matrix);
+    return result_matrix;
+}
+
+int SolveSystemInto(Matrix result_matrix, Matrix matrix){
+
+    if(isEmpty(matrix) || isEmpty(result_matrix))
+        return -1;
+
+    // Make sure the matrix is augmented with a constant column vector
+    if(matrix->num_cols < matrix->num_rows){
+        fprintf(stderr,"%s", "Must augment matrix with a constant vector");
+        return -1;
+    }
+    if(result_matrix->num_rows != matrix->num_rows || result_matrix->num_cols != 1){
+        fprintf(stderr,"%s", "Error - Result must be an Nx1 matrix");
+        return -1;
+    }
+
+    // A square, non-singular coefficient part is solved by LU without touching
+    // the input; the factorization lives in per-thread scratch
+    size_t n = matrix->num_rows;
+    STATS_BEGIN();
+    if(matrix->num_cols == n + 1){
+        if(SmallSolveDense(n, matrix->data, matrix->ld, matrix->data + n, matrix->ld,
+                           result_matrix->data, result_matrix->ld) == 0){
+            STATS_END(MATRIX_STAT_SOLVE_SYSTEM, 2.0 * n * n * n / 3 + 2.0 * n * n);
+            return 0;
+        }
+        size_t lu_bytes = n * n * sizeof(double);
+        lu_bytes = (lu_bytes + MATRIX_ALIGNMENT - 1) / MATRIX_ALIGNMENT * MATRIX_ALIGNMENT;
+        char *scratch = (char*)ThreadScratch(lu_bytes + n * sizeof(size_t));
+        if(scratch){
+            double *lu = (double*)scratch;
+            size_t *pivots = (size_t*)(scratch + lu_bytes);
+            int sign;
+            for(size_t i = 0; i < n; i++){
+                memcpy(lu + i*n, MATRIX_ROW(matrix, i), n * sizeof(double));
+                MATRIX_AT(result_matrix, i, 0) = MATRIX_AT(matrix, i, n);
+            }
+            if(LUFactorDense(n, lu, n, pivots, &sign) == 0){
+                LUSolveDense(n, lu, n, pivots, 1, result_matrix->data, result_matrix->ld);
+                STATS_END(MATRIX_STAT_SOLVE_SYSTEM, 2.0 * n * n * n / 3 + 2.0 * n * n);
+                return 0;
+            }
+        }
+        // singular (or out of memory): fall through to diagnose the system
+    }
+
     // Reduce system before solving for unknowns
     ReducedRowEchelonForm(matrix);
-    Matrix result_matrix = NewMatrix(matrix->num_rows,1);
 
     // Use back-substitution to solve reduced matrix
     for(int i = matrix->num_rows-1; i >= 0; i--){
 
         // The matrix has no solutions if it's inconsistent
-        if(matrix->index[i][i] == 0 && matrix->index[i][matrix->num_cols-1] != 0){
+        const double *row = MATRIX_ROW(matrix, i);
+        if(row[i] == 0 && row[matrix->num_cols-1] != 0){
             fprintf(stderr,"%s","No solutions");
-            return NULL;
+            STATS_END(MATRIX_STAT_SOLVE_SYSTEM, 0);
+            return -1;
         }
         // if the unknown variable has a non-zero coefficient, then a value for it must exist
-        else if(matrix->index[i][i] != 0) {
-            result_matrix->index[i][0] = matrix->index[i][matrix->num_cols-1];
+        else if(row[i] != 0) {
+            MATRIX_AT(result_matrix, i, 0) = row[matrix->num_cols-1];
 
             for(int j = i+1; j < matrix->num_rows; j++) {
-                if(matrix->index[i][j] != 0)
-                    result_matrix->index[i][0] = matrix->index[i][j] * result_matrix->index[j][0];
+                if(row[j] != 0)
+                    MATRIX_AT(result_matrix, i, 0) -= row[j] * MATRIX_AT(result_matrix, j, 0);
             }
 
-            result_matrix->index[i][0] /= matrix->index[i][i]; // cause of nan
+            MATRIX_AT(result_matrix, i, 0) /= row[i]; // cause of nan
         }
         // The matrix has infinitely many solutions if a zero row exists
         else{
             fprintf(stderr,"%s","Infinitely many solutions");
-            return NULL;
+            STATS_END(MATRIX_STAT_SOLVE_SYSTEM, 0);
+            return -1;
         }
     }
 
-    return result_matrix;
+    STATS_END(MATRIX_STAT_SOLVE_SYSTEM, (double)n * n);
+    return 0;
 }
-
-
-
-
@@ -9,34 +9,200 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <math.h>
+#include <stdint.h>
 
 
+// Every row starts on a boundary of this many bytes (cache line / AVX-512 width)
+#define MATRIX_ALIGNMENT 64
+
 typedef struct{
-    double **index;  // pointer to 2D array of matrix values
+    double **index;  // row pointers into data (index[i] == data + i*ld)
+    double *data;    // single 64-byte aligned buffer holding every row
     size_t num_rows;
     size_t num_cols;
+    size_t ld;       // leading dimension: distance (in doubles) between rows
+    unsigned flags;  // MATRIX_OWNS_* / MATRIX_MAPPED / MATRIX_VIEW bits: what FreeMatrix releases
 }matrix_struct;
 
 typedef matrix_struct* Matrix;
 
+// FreeMatrix frees data (and the row table) / the struct itself. Both are set
+// for NewMatrix from the heap; neither for matrices carved out of an arena.
+#define MATRIX_OWNS_DATA   0x1u
+#define MATRIX_OWNS_STRUCT 0x2u
+// The struct belongs to MapMatrix and data points into the file mapping;
+// FreeMatrix unmaps it
+#define MATRIX_MAPPED      0x4u
+// data belongs to another matrix (MatrixView); FreeMatrix leaves it alone
+#define MATRIX_VIEW        0x8u
+
+// Modes of MapMatrix
+#define MATRIX_MAP_READ_ONLY     0  // shared with the file, must not be written
+#define MATRIX_MAP_COPY_ON_WRITE 1  // writable; written pages become private copies
+
+typedef struct arena_struct* MatrixArena;
+
+// Lazy expressions: a graph owns every node built from it
+typedef struct expr_graph_struct* MatrixExprGraph;
+typedef struct expr_node_struct* MatrixExpr;
+
+// Single-precision counterpart of matrix_struct (rows padded to 16 floats)
+typedef struct{
+    float **index;   // row pointers into data (index[i] == data + i*ld)
+    float *data;     // single 64-byte aligned buffer holding every row
+    size_t num_rows;
+    size_t num_cols;
+    size_t ld;       // leading dimension: distance (in floats) between rows
+    unsigned flags;  // MATRIX_OWNS_* bits
+}matrixf_struct;
+
+typedef matrixf_struct* MatrixF;
+
+// Storage orders of a SparseMatrix
+#define SPARSE_CSR 0  // compressed sparse rows
+#define SPARSE_CSC 1  // compressed sparse columns
+
+typedef struct{
+    size_t num_rows;
+    size_t num_cols;
+    size_t nnz;        // number of stored values
+    int format;        // SPARSE_CSR or SPARSE_CSC
+    size_t *offsets;   // row (CSR) / column (CSC) m holds values [offsets[m], offsets[m+1])
+    uint32_t *indices; // column (CSR) / row (CSC) of every value, ascending within a row/column
+    double *values;
+}sparse_struct;
+
+typedef sparse_struct* SparseMatrix;
+
+// y = A * x for a square operator A of the size it was built with
+typedef void (*OperatorApply)(void *context, const double *x, double *y);
+
+typedef struct{
+    size_t size;          // A is size x size
+    OperatorApply apply;
+    void *context;        // passed to apply
+    Matrix dense;         // the matrix behind DenseOperator(), else NULL
+    SparseMatrix sparse;  // the matrix behind SparseOperator(), else NULL
+}LinearOperator;
+
+typedef struct preconditioner_struct* Preconditioner;
+
+typedef struct{
+    double tolerance;       // stop at ||b - A*x|| <= tolerance * ||b|| (0: 1e-8)
+    size_t max_iterations;  // 0: the larger of the system size and 1000
+    size_t restart;         // GMRES basis size before a restart (0: 30), or the
+                            // Lanczos basis of DominantEigenpairs (0: max(2k + 10, 20))
+    void (*monitor)(size_t iteration, double residual, void *context); // may be NULL
+    void *monitor_context;
+}SolverOptions;
+
+typedef struct{
+    size_t iterations;  // iterations performed
+    double residual;    // last relative residual ||b - A*x|| / ||b||
+    int converged;      // 1 if residual reached the tolerance
+}SolverReport;
+
+typedef struct{
+    Matrix lu;       // L (unit diagonal, not stored) below the diagonal, U on and above
+    size_t *pivots;  // row i was interchanged with row pivots[i] during factorization
+    int sign;        // parity of the row interchanges: +1 or -1
+    size_t singular; // 0, or one more than the index of the first zero pivot
+}lu_struct;
+
+typedef lu_struct* LUFactorization;
+
+typedef struct{
+    Matrix qr;            // transposed compact factor (num_cols x num_rows): row j holds
+                          // column j of R up to the diagonal and the Householder
+                          // vector of step j after it (its leading 1 implied)
+    double *tau;          // Householder scalars, one per step (min(num_rows, num_cols))
+    size_t *permutation;  // column j of A*P is column permutation[j] of A
+    size_t num_rows;      // shape of the factored matrix A
+    size_t num_cols;
+    size_t rank;          // numerical rank: leading |R[i][i]| > tolerance * |R[0][0]|
+    double tolerance;
+}qr_struct;
+
+typedef qr_struct* QRFactorization;
+
+typedef struct rank_tracker_struct* RankTracker;
+
+typedef struct{
+    int fd;              // the open tile file
+    size_t num_rows;
+    size_t num_cols;
+    size_t tile_size;    // tiles are tile_size x tile_size (edge tiles padded with zeros)
+    size_t tile_ld;      // values per stored tile row (tile_size rounded up to 8)
+    size_t tile_rows;    // tiles down the matrix
+    size_t tile_cols;    // tiles across the matrix
+    size_t tile_bytes;   // bytes per stored tile
+    size_t data_offset;  // bytes from the start of the file to the first tile
+}tiled_struct;
+
+typedef tiled_struct* TiledMatrix;
+
+typedef struct{
+    double *data;    // 64-byte aligned, structure-of-arrays (see BATCH_AT)
+    size_t count;    // number of matrices in the batch
+    size_t num_rows;
+    size_t num_cols;
+    size_t stride;   // count rounded up to a multiple of 8 (padding lanes)
+}batch_struct;
+
+typedef batch_struct* MatrixBatch;
+
+// Fixed-size square matrices for the unrolled kernels of small.c: plain
+// values (row-major, m[row][col]) that live on the stack, never the heap
+#define SMALL_MIN_DIM 2
+#define SMALL_MAX_DIM 8
+
+typedef struct{ double m[2][2]; }Matrix2x2;
+typedef struct{ double m[3][3]; }Matrix3x3;
+typedef struct{ double m[4][4]; }Matrix4x4;
+typedef struct{ double m[5][5]; }Matrix5x5;
+typedef struct{ double m[6][6]; }Matrix6x6;
+typedef struct{ double m[7][7]; }Matrix7x7;
+typedef struct{ double m[8][8]; }Matrix8x8;
+
+/*************************************************************************
+ * MATRIX_ROW(matrix, row) / MATRIX_AT(matrix, row, col)
+ *
+ *  Address of the first value of a row, and the value stored at [row][col].
+ *  Rows are ld doubles apart inside one contiguous buffer, so walking a
+ *  row is unit-stride and walking down a column is a fixed stride of ld.
+ ************************************************************************/
+#define MATRIX_ROW(matrix, row)     ((matrix)->data + (size_t)(row) * (matrix)->ld)
+#define MATRIX_AT(matrix, row, col) (MATRIX_ROW(matrix, row)[col])
+
 /*************************************************************************
  * Matrix NewMatrix(size_t num_rows, size_t num_cols)
  *
  * Allocates memory for a 2D matrix and returns a pointer to the first index
  *
+ *  All values live in one zero-initialized, 64-byte aligned buffer. Each
+ *  row is padded to a multiple of 8 doubles (see ld) so that every row
+ *  begins on a cache line. The row pointer table (index) is carved out of
+ *  the same buffer, so a matrix costs one allocation for its values no
+ *  matter how many rows it has. While an arena is active on the calling
+ *  thread the matrix comes out of the arena instead (see NewMatrixArena).
+ *
  * -> PARAMETERS:
  *    num_rows - number of rows in the matrix (must be a positive int)
  *    num_cols - number of columns in the matrix (must be a positive int)
  *
- * -> RETURNS: a matrix structure
+ * -> RETURNS: a matrix structure, or a NULL ptr if memory could not be
+ *             allocated
  ************************************************************************/
 Matrix NewMatrix(size_t num_rows, size_t num_cols);
 
 /*************************************************************************
- * void InitializeMatrix(Matrix *matrix)
+ * void FreeMatrix(Matrix *matrix)
  *
- * Frees memory from a dynamically matrix structure.
+ * Frees memory from a dynamically matrix structure. The value buffer is
+ * released with a single call regardless of the number of rows. Matrices
+ * allocated from an arena are left alone (only the pointer is cleared).
  *
  * NOTE: Do not forget to call this method when instantiating new matrices.
  * Not doing so can result in memory leaks.
@@ -46,6 +212,225 @@ Matrix NewMatrix(size_t num_rows, size_t num_cols);
  ************************************************************************/
 void FreeMatrix(Matrix *matrix);
 
+/*************************************************************************
+ * Matrix MatrixView(Matrix parent, size_t row, size_t col,
+ *                   size_t num_rows, size_t num_cols, size_t row_step)
+ *
+ *  A matrix that shares the storage of a block of its parent, without
+ *  copying: view[i][j] is parent[row + i*row_step][col + j]. Writing the
+ *  view writes the parent. A view is an ordinary Matrix (rows ld apart,
+ *  with ld a multiple of the parent's), so it can be passed to every
+ *  routine, including as the result of an ...Into function, and views of
+ *  views work. Only operations that would change its shape (a rectangular
+ *  Transpose) are refused.
+ *
+ *  The view is only valid while the parent's storage is; freeing it with
+ *  FreeMatrix releases the view alone. While an arena is active the view
+ *  comes out of the arena, like NewMatrix.
+ *
+ * -> PARAMETERS:
+ *    parent             - matrix (or view) to look into
+ *    row, col           - parent position of the view's [0][0]
+ *    num_rows, num_cols - extent of the view
+ *    row_step           - parent rows between consecutive view rows (0 or
+ *                         1 for a contiguous block)
+ *
+ * -> RETURNS: the view, or a NULL ptr if it does not lie inside the parent
+ *             or memory ran out
+ ************************************************************************/
+Matrix MatrixView(Matrix parent, size_t row, size_t col, size_t num_rows, size_t num_cols, size_t row_step);
+
+/*************************************************************************
+ * MatrixArena NewMatrixArena(size_t capacity)
+ *
+ *  Creates a scratch arena for temporary matrices. While an arena is
+ *  active on a thread (see UseMatrixArena()), NewMatrix on that thread
+ *  carves the struct, values and row table out of the arena instead of
+ *  calling malloc, and FreeMatrix on those matrices does nothing. The
+ *  arena grows in blocks as needed and keeps them across resets, so a loop
+ *  that resets it once per iteration stops allocating after the first.
+ *
+ * -> PARAMETERS:
+ *    capacity     - bytes to reserve up front (64KB minimum)
+ *
+ * -> RETURNS: the new arena, or NULL on failure
+ ************************************************************************/
+MatrixArena NewMatrixArena(size_t capacity);
+
+/*************************************************************************
+ * void FreeMatrixArena(MatrixArena *arena)
+ *
+ *  Releases the arena and every matrix allocated from it, and sets the
+ *  pointer to NULL. Deactivates it if it is active on the calling thread.
+ ************************************************************************/
+void FreeMatrixArena(MatrixArena *arena);
+
+/*************************************************************************
+ * void ResetMatrixArena(MatrixArena arena)
+ *
+ *  Releases every matrix allocated from the arena in O(1). Matrices
+ *  allocated from it before the reset must not be used afterwards.
+ ************************************************************************/
+void ResetMatrixArena(MatrixArena arena);
+
+/*************************************************************************
+ * MatrixArena UseMatrixArena(MatrixArena arena)
+ *
+ *  Makes arena back NewMatrix on the calling thread (NULL goes back to the
+ *  heap). Library functions that return a new matrix allocate it the same
+ *  way, so results are arena-owned while an arena is active. Objects that
+ *  hold matrices (factorizations, preconditioners) and the new storage of
+ *  a heap matrix reshaped by Transpose() always come from the heap.
+ *
+ * -> RETURNS: the arena that was active before, so calls can be nested
+ ************************************************************************/
+MatrixArena UseMatrixArena(MatrixArena arena);
+
+/*************************************************************************
+ * int SaveMatrix(Matrix matrix, const char *path)
+ * Matrix LoadMatrix(const char *path)
+ * Matrix MapMatrix(const char *path, int mode)
+ *
+ *  Binary matrix files. A file is a 64-byte header (magic "SMLCMAT",
+ *  format version, dtype, shape, row stride, alignment, data offset and a
+ *  byte-order mark) followed by the rows, padded to the same 64-byte
+ *  aligned stride a Matrix uses. Saving is one write of the whole buffer,
+ *  and loading is one read into a new matrix.
+ *
+ *  MapMatrix does not read the values at all: the file is mapped and the
+ *  returned Matrix points straight into the mapping, so pages are faulted
+ *  in as they are touched. With MATRIX_MAP_READ_ONLY the matrix must not
+ *  be modified (in-place operations on it crash). MATRIX_MAP_COPY_ON_WRITE
+ *  allows modification without changing the file. FreeMatrix unmaps the
+ *  file either way.
+ *
+ * -> RETURNS: 0 / the matrix on success, or -1 / NULL (and an error
+ *             message) if the file cannot be written, opened or is not a
+ *             valid matrix file for this machine
+ ************************************************************************/
+int SaveMatrix(Matrix matrix, const char *path);
+Matrix LoadMatrix(const char *path);
+Matrix MapMatrix(const char *path, int mode);
+
+/*************************************************************************
+ * TiledMatrix NewTiledMatrix(const char *path, size_t num_rows, size_t num_cols, size_t tile_size)
+ * TiledMatrix OpenTiledMatrix(const char *path)
+ * void CloseTiledMatrix(TiledMatrix *tiled)
+ *
+ *  Out-of-core matrices: the values live in a file on disk as square
+ *  tiles, and only the tiles an operation is working on are in memory, so
+ *  a matrix can be far larger than RAM. NewTiledMatrix creates (or
+ *  truncates) the file with every value zero; OpenTiledMatrix reopens one
+ *  for reading and writing. Each tile is stored in Matrix row layout and
+ *  moved with one read or write.
+ *
+ *  Larger tiles mean fewer, larger transfers and more arithmetic per byte
+ *  read: a tiled multiply does about tile_size / 8 FLOPs per byte, so with
+ *  the default of 1024 (8 MiB tiles) it is limited by the processor rather
+ *  than a fast local disk.
+ *
+ *  Closing releases the file handle; the file itself stays.
+ *
+ * -> PARAMETERS:
+ *    path      - file holding the tiles
+ *    tile_size - tile edge in values; 0 for 1024
+ *
+ * -> RETURNS: the tiled matrix, or a NULL ptr if the file could not be
+ *             created / is not a tiled matrix file
+ ************************************************************************/
+TiledMatrix NewTiledMatrix(const char *path, size_t num_rows, size_t num_cols, size_t tile_size);
+TiledMatrix OpenTiledMatrix(const char *path);
+void CloseTiledMatrix(TiledMatrix *tiled);
+
+/*************************************************************************
+ * int WriteTiledBlock(TiledMatrix tiled, size_t row, size_t col, Matrix block)
+ * int ReadTiledBlock(TiledMatrix tiled, size_t row, size_t col, Matrix block)
+ *
+ *  Copies an in-memory matrix into (or out of) the tiled matrix with its
+ *  [0][0] at (row, col), so a large matrix can be filled or inspected a
+ *  piece at a time. Tiles the block covers completely are written without
+ *  being read first.
+ *
+ * -> RETURNS: 0 on success, or -1 if the block does not fit or I/O failed
+ ************************************************************************/
+int WriteTiledBlock(TiledMatrix tiled, size_t row, size_t col, Matrix block);
+int ReadTiledBlock(TiledMatrix tiled, size_t row, size_t col, Matrix block);
+
+/*************************************************************************
+ * int TiledMultiply(TiledMatrix result_matrix, TiledMatrix matrix_A, TiledMatrix matrix_B, size_t memory_budget)
+ * int TiledAdd(TiledMatrix result_matrix, TiledMatrix matrix_A, TiledMatrix matrix_B, int subtract_flag, size_t memory_budget)
+ * int TiledCholesky(TiledMatrix tiled, size_t memory_budget)
+ *
+ *  MultiplyMatrices, AddMatrices and CholeskyInPlace on tiled matrices,
+ *  holding at most memory_budget bytes of tiles in memory. Operands are
+ *  read through asynchronous (POSIX AIO) reads issued ahead of the
+ *  computation into a ring of tile buffers, so the disk fetches the next
+ *  tiles while the in-memory kernels (the blocked multiply, the Cholesky
+ *  factorization) work on the current ones. Each result tile is written
+ *  once.
+ *
+ *  All operands must share one tile size. TiledAdd's result may be one of
+ *  its operands; TiledMultiply's may not. TiledCholesky overwrites the
+ *  lower triangle with L (left-looking, one column of tiles at a time) and
+ *  clears the tiles above the diagonal.
+ *
+ * -> PARAMETERS:
+ *    memory_budget - bytes of tile buffers to use; 0 for 256 MiB. It must
+ *                    hold at least 4 tiles (5 for TiledCholesky); beyond
+ *                    that up to 8 more reads are kept in flight
+ *
+ * -> RETURNS: 0 on success, -1 if the shapes or tile sizes do not agree, the
+ *             budget is too small or I/O failed. TiledCholesky returns one
+ *             more than the index of the failing pivot when the matrix is
+ *             not positive definite
+ ************************************************************************/
+int TiledMultiply(TiledMatrix result_matrix, TiledMatrix matrix_A, TiledMatrix matrix_B, size_t memory_budget);
+int TiledAdd(TiledMatrix result_matrix, TiledMatrix matrix_A, TiledMatrix matrix_B, int subtract_flag, size_t memory_budget);
+int TiledCholesky(TiledMatrix tiled, size_t memory_budget);
+
+/*************************************************************************
+ * Matrix ReadMatrixText(FILE *stream)
+ * Matrix LoadMatrixText(const char *path)
+ *
+ *  Reads a matrix written as text, one row per line, from a stream or a
+ *  file. Values may be separated by commas, semicolons, tabs or spaces
+ *  (runs of separators count as one), so CSV, TSV and whitespace layouts
+ *  all work. Blank lines and lines starting with '#' are skipped, and a
+ *  first line that is not numeric is taken as a column header. The shape
+ *  is inferred: every row must hold as many values as the first.
+ *
+ *  Input is read in 1 MB chunks and numbers are parsed by hand. The common
+ *  case (up to 19 significant digits, small exponent) costs one exact
+ *  multiply or divide. Other numbers, including inf and nan, go through
+ *  strtod.
+ *
+ * -> RETURNS: the matrix, or NULL (and an error message naming the line)
+ *             on malformed input
+ ************************************************************************/
+Matrix ReadMatrixText(FILE *stream);
+Matrix LoadMatrixText(const char *path);
+
+/*************************************************************************
+ * int WriteMatrixText(Matrix matrix, FILE *stream, int precision,
+ *                     char delimiter)
+ * int SaveMatrixText(Matrix matrix, const char *path, int precision,
+ *                    char delimiter)
+ *
+ *  Writes one row per line with values separated by delimiter, to a stream
+ *  or a file. Values are formatted into a 1 MB buffer that is written out
+ *  whenever it fills, with no stdio call per value.
+ *
+ * -> PARAMETERS:
+ *    precision - digits after the decimal point, as in "%.*f" (at most
+ *                15), or -1 for 17 significant digits, which read back
+ *                exactly. Magnitudes of 1e22 and up always use the latter.
+ *    delimiter - e.g. ',' for CSV, '\t' for TSV, ' '
+ *
+ * -> RETURNS: 0 on success, or -1 if the matrix is empty or the write fails
+ ************************************************************************/
+int WriteMatrixText(Matrix matrix, FILE *stream, int precision, char delimiter);
+int SaveMatrixText(Matrix matrix, const char *path, int precision, char delimiter);
+
 /*************************************************************************
  * void PrintMatrix(Matrix matrix)
  *
@@ -74,7 +459,9 @@ void SwapRows(Matrix matrix, int rowA, int rowB);
  * void DivideRow(Matrix matrix, int row, double divisor)
  *
  *  Divides each value in row by a divisor. This operation is typically
- *  performed to reduce rows that share a common divisor.
+ *  performed to reduce rows that share a common divisor. The row is
+ *  multiplied by the reciprocal of divisor, so results may differ from
+ *  true division in the last bit.
  *
  * -> PARAMETERS:
  *    matrix   - a matrix structure
@@ -99,9 +486,11 @@ void AddMultipleRow(Matrix matrix, int row_receiver, int row_multiple, double sc
 /*************************************************************************
  * double Reduced_row_echelon_form(Matrix matrix)
  *
- *  Converts a matrix to Reduced Row Echelon Form. This function uses
- *  3 helper functions (DivideRow(), AddMultipleRow, and SwapRows()) to
- *  perform elementary row operations.
+ *  Converts a matrix to Reduced Row Echelon Form with the elementary row
+ *  operations of DivideRow() and AddMultipleRow(). Each pivot is the
+ *  largest magnitude entry left in its column (partial pivoting). Row
+ *  interchanges only swap pointers in the matrix's index table; the rows
+ *  are moved into their final order once at the end, each at most once.
  *
  * -> PARAMETERS:
  *    matrix   - a matrix structure
@@ -118,9 +507,12 @@ double ReducedRowEchelonForm(Matrix matrix);
 /*************************************************************************
  * Matrix SolveSystem(Matrix matrix)
  *
- *  Solves a system of linear equations (a matrix) by converting the system
- *  to reduced row echelon form (calls ReducedRowEchelonForm()) and then
- *  performs back-substitution to solve for each unknown variable.
+ *  Solves a system of linear equations (a matrix augmented with a constant
+ *  column vector). When the coefficient part is square and non-singular
+ *  it is solved by LU decomposition with partial pivoting and the matrix
+ *  is left unchanged. Otherwise the system is converted to reduced row
+ *  echelon form (calls ReducedRowEchelonForm()) and back-substitution is
+ *  used to diagnose it.
  *
  * -> PARAMETERS:
  *    matrix   - a matrix structure
@@ -132,21 +524,233 @@ double ReducedRowEchelonForm(Matrix matrix);
  *    has no solutions (a zero row and then a value in the constant vector)
  *    or infinitely many solutions (a zero row). It will also output an
  *    error message.
+ *
+ *    NOTE: To solve the same coefficient matrix against many constant
+ *    vectors, factor it once with LUFactor() and call LUSolve().
  ************************************************************************/
 Matrix SolveSystem(Matrix matrix);
 
 /*************************************************************************
- * void Cholesky(Matrix original_matrix, Matrix new_matrix)
+ * int SolveSystemInto(Matrix result_matrix, Matrix matrix)
+ *
+ *  Same as SolveSystem(), but writes the solutions into an existing Nx1
+ *  matrix. The LU factorization lives in a per-thread scratch buffer that
+ *  is reused by later calls, so solving repeatedly does not allocate.
+ *
+ * -> RETURNS: 0 on success, or -1 if the shapes do not agree or the system
+ *             has no unique solution
+ ************************************************************************/
+int SolveSystemInto(Matrix result_matrix, Matrix matrix);
+
+/*************************************************************************
+ * LUFactorization LUFactor(Matrix matrix)
+ *
+ *  Factors a copy of an NxN matrix as P*A = L*U using a blocked LU
+ *  decomposition with partial pivoting. L and U are stored compactly in
+ *  one matrix (L's unit diagonal is implied) together with the row
+ *  interchanges. Factoring costs O(n^3) once; every later solve against
+ *  the factorization costs O(n^2) per right-hand side column.
+ *
+ * -> PARAMETERS:
+ *    matrix   - an NxN matrix structure (left unchanged)
+ *
+ * -> RETURNS: a factorization, or a NULL ptr if matrix is not square.
+ *             A singular matrix still factors; its singular field is then
+ *             non-zero and the solve functions refuse it.
+ *
+ *    NOTE: Release the factorization with FreeLUFactorization().
+ ************************************************************************/
+LUFactorization LUFactor(Matrix matrix);
+
+/*************************************************************************
+ * void FreeLUFactorization(LUFactorization *factor)
+ *
+ *  Frees a factorization returned by LUFactor() and sets it to NULL.
+ ************************************************************************/
+void FreeLUFactorization(LUFactorization *factor);
+
+/*************************************************************************
+ * int LUSolveInPlace(LUFactorization factor, Matrix rhs)
+ *
+ *  Overwrites rhs (an NxK block of right-hand side columns) with the
+ *  solution X of A * X = rhs.
+ *
+ * -> RETURNS: 0 on success, or -1 if the shapes differ or A is singular
+ ************************************************************************/
+int LUSolveInPlace(LUFactorization factor, Matrix rhs);
+
+/*************************************************************************
+ * Matrix LUSolve(LUFactorization factor, Matrix rhs)
+ *
+ *  Like LUSolveInPlace(), but returns the solution in a new matrix and
+ *  leaves rhs unchanged.
+ *
+ * -> RETURNS: the NxK solution, or a NULL ptr on failure
+ ************************************************************************/
+Matrix LUSolve(LUFactorization factor, Matrix rhs);
+
+/*************************************************************************
+ * int LUSolveVector(LUFactorization factor, double *vector)
+ *
+ *  Overwrites a contiguous array of N doubles with the solution x of
+ *  A * x = vector. This is the cheapest way to solve against one constant
+ *  vector at a time.
+ *
+ * -> RETURNS: 0 on success, or -1 if A is singular
+ ************************************************************************/
+int LUSolveVector(LUFactorization factor, double *vector);
+
+/*************************************************************************
+ * double LUDeterminant(LUFactorization factor)
+ *
+ *  The determinant of the factored matrix: the product of U's diagonal
+ *  times the sign of the row permutation. Costs O(n).
+ ************************************************************************/
+double LUDeterminant(LUFactorization factor);
+
+/*************************************************************************
+ * int LUUpdate(LUFactorization factor, Matrix vectors_U, Matrix vectors_V)
+ * int LUUpdateVector(LUFactorization factor, const double *u, const double *v)
+ *
+ *  Turns a factorization of A into one of A + U * V^T (A + u * v^T) in
+ *  O(k * n^2), by Bennett's algorithm applied once per column pair, instead
+ *  of the O(n^3) of a new LUFactor(). The row order chosen when A was
+ *  factored is kept, so an update that makes a pivot much smaller than the
+ *  entries below it loses accuracy; refactor after many large updates.
+ *
+ * -> PARAMETERS:
+ *    factor    - a non-singular factorization from LUFactor()
+ *    vectors_U - NxK matrix: the columns u_j
+ *    vectors_V - NxK matrix: the columns v_j
+ *    u, v      - arrays of N values
+ *
+ * -> RETURNS: 0 on success, 1 when the updated matrix needs a pivot the kept
+ *             row order cannot provide (a pivot became exactly zero; the
+ *             factorization is then marked singular and must be recomputed
+ *             with LUFactor()), or -1 on bad arguments or a factorization
+ *             that is already singular
+ ************************************************************************/
+int LUUpdate(LUFactorization factor, Matrix vectors_U, Matrix vectors_V);
+int LUUpdateVector(LUFactorization factor, const double *u, const double *v);
+
+/*************************************************************************
+ * QRFactorization QRFactor(Matrix matrix, double tolerance)
+ *
+ *  Factors a copy of an MxN matrix as A*P = Q*R with Householder
+ *  reflections and column pivoting: each step reduces the remaining column
+ *  of largest norm, so |R[i][i]| never increases down the diagonal and a
+ *  rank deficiency shows up as a tail of tiny diagonal entries. Blocks of
+ *  32 columns are reduced together and the rest of the matrix is updated
+ *  once per block with the blocked multiply (LAPACK's xGEQP3 scheme).
+ *
+ *  The numerical rank counts the leading diagonal entries above tolerance
+ *  times |R[0][0]|.
+ *
+ * -> PARAMETERS:
+ *    matrix    - an MxN matrix structure (left unchanged)
+ *    tolerance - relative rank threshold; 0 or less for max(M,N) * machine
+ *                epsilon
+ *
+ * -> RETURNS: a factorization, or a NULL ptr if matrix is empty or memory
+ *             ran out
+ *
+ *    NOTE: Release the factorization with FreeQRFactorization().
+ ************************************************************************/
+QRFactorization QRFactor(Matrix matrix, double tolerance);
+
+/*************************************************************************
+ * void FreeQRFactorization(QRFactorization *factor)
+ *
+ *  Frees a factorization returned by QRFactor() and sets it to NULL.
+ ************************************************************************/
+void FreeQRFactorization(QRFactorization *factor);
+
+/*************************************************************************
+ * Matrix QRSolve(QRFactorization factor, Matrix rhs)
+ * int QRSolveInto(Matrix solution, QRFactorization factor, Matrix rhs)
+ *
+ *  Least squares solution X (NxK) of A * X = rhs (MxK): the X minimizing
+ *  ||A * X - rhs|| column by column, which is the exact solution when the
+ *  system is consistent. Works for overdetermined systems (M > N), which
+ *  SolveSystem() cannot take. For a rank deficient A this is the basic
+ *  solution: the entries of X for the N - rank columns that pivoting put
+ *  last are zero.
+ *
+ * -> RETURNS: the solution in a new matrix / 0 on success, or NULL / -1 if
+ *             the shapes do not agree or memory ran out
+ ************************************************************************/
+Matrix QRSolve(QRFactorization factor, Matrix rhs);
+int QRSolveInto(Matrix solution, QRFactorization factor, Matrix rhs);
+
+/*************************************************************************
+ * Matrix LeastSquares(Matrix matrix, Matrix rhs)
+ *
+ *  QRFactor() with the default tolerance followed by QRSolve().
+ *
+ * -> RETURNS: the NxK least squares solution, or a NULL ptr on failure
+ ************************************************************************/
+Matrix LeastSquares(Matrix matrix, Matrix rhs);
+
+/*************************************************************************
+ * size_t MatrixRank(Matrix matrix, double tolerance)
+ *
+ *  Numerical rank of a matrix from a pivoted QR factorization (see
+ *  QRFactor() for the tolerance). The matrix is left unchanged.
+ *
+ * -> RETURNS: the rank, or 0 for an empty matrix
+ ************************************************************************/
+size_t MatrixRank(Matrix matrix, double tolerance);
+
+/*************************************************************************
+ * RankTracker NewRankTracker(size_t num_rows, double tolerance)
+ * void FreeRankTracker(RankTracker *tracker)
+ * int RankTrackerAppend(RankTracker tracker, const double *column)
+ * int RankTrackerAppendColumns(RankTracker tracker, Matrix columns)
+ * size_t RankTrackerRank(RankTracker tracker)
+ *
+ *  Tracks the rank of a set of columns with num_rows entries as columns are
+ *  appended one at a time, without refactoring. The tracker keeps an
+ *  orthonormal basis of the columns' span; an appended column is
+ *  orthogonalized against it (Gram-Schmidt, twice) and joins the basis when
+ *  what remains is larger than tolerance times the column's norm. Each
+ *  append costs O(num_rows * rank).
+ *
+ * -> PARAMETERS:
+ *    num_rows  - length of every column
+ *    tolerance - relative threshold; 0 or less for max(num_rows, 16) *
+ *                machine epsilon
+ *    column    - num_rows contiguous values
+ *    columns   - a num_rows x K matrix whose columns are appended in order
+ *
+ * -> RETURNS: RankTrackerAppend: 1 if the column raised the rank (it is
+ *             independent of those before it), 0 if not, -1 on error.
+ *             RankTrackerAppendColumns: how many columns raised the rank,
+ *             or -1 on error.
+ ************************************************************************/
+RankTracker NewRankTracker(size_t num_rows, double tolerance);
+void FreeRankTracker(RankTracker *tracker);
+int RankTrackerAppend(RankTracker tracker, const double *column);
+int RankTrackerAppendColumns(RankTracker tracker, Matrix columns);
+size_t RankTrackerRank(RankTracker tracker);
+
+/*************************************************************************
+ * Matrix Cholesky(Matrix matrix)
  *
  *   Similary to LU decomposition, The Cholesky decomposition is another
  *   method to convert a matrix to reduced row echelon form. Where applicable,
  *   the Cholesky decomposition is roughly twice as efficient as the LU
  *   decomposition for solving systems of linear equations.
  *
+ *   The factorization is blocked and right-looking: each diagonal block is
+ *   factored, the panel below it is solved in parallel, and the trailing
+ *   matrix is updated with the blocked GEMM (lower triangle only).
+ *
  * -> PARAMETERS:
- *    matrix  - a matrix structure
+ *    matrix  - a matrix structure (only its lower triangle is read)
  *
- * -> RETURNS:
+ * -> RETURNS: a new matrix holding the lower-triangular factor L, with
+ *             A = L * L^T, or a NULL ptr (and an error message naming the
+ *             failing pivot) if matrix is not positive definite
  *
  *    NOTE: The parameter matrix must be a Hermitian, positive-definite
  *    matrix (Symmetric and real for all values), in order for the algorithm
@@ -154,11 +758,101 @@ Matrix SolveSystem(Matrix matrix);
  ************************************************************************/
 Matrix Cholesky(Matrix matrix);
 
+/*************************************************************************
+ * int CholeskyInto(Matrix factor, Matrix matrix)
+ *
+ *   Same factorization as Cholesky(), but writes L into an existing NxN
+ *   matrix (the strictly upper triangle is zeroed). factor may be matrix
+ *   itself, which is the same as CholeskyInPlace().
+ *
+ * -> RETURNS: 0 on success, -1 if the shapes do not agree, or k > 0 if
+ *             the k-th pivot (row k-1) was not positive
+ ************************************************************************/
+int CholeskyInto(Matrix factor, Matrix matrix);
+
+/*************************************************************************
+ * int CholeskyInPlace(Matrix matrix)
+ *
+ *   Same factorization as Cholesky(), but overwrites matrix with L (the
+ *   strictly upper triangle is zeroed) instead of allocating a result.
+ *
+ * -> RETURNS: 0 on success, -1 if matrix is not square, or k > 0 if the
+ *             k-th pivot (row k-1) was not positive. In that case matrix
+ *             is left partially factored.
+ ************************************************************************/
+int CholeskyInPlace(Matrix matrix);
+
+/*************************************************************************
+ * int CholeskyPacked(Matrix matrix, double *packed)
+ *
+ *   Factors the lower triangle of matrix into packed lower-triangular
+ *   storage: row i of L is stored contiguously, starting at
+ *   packed[i*(i+1)/2], so the factor takes CHOLESKY_PACKED_SIZE(n) doubles
+ *   instead of n*n. matrix is not modified.
+ *
+ * -> PARAMETERS:
+ *    matrix  - an NxN symmetric positive-definite matrix
+ *    packed  - an array of at least CHOLESKY_PACKED_SIZE(n) doubles
+ *
+ * -> RETURNS: 0 on success, -1 on bad input, or k > 0 if the k-th pivot
+ *             was not positive
+ ************************************************************************/
+#define CHOLESKY_PACKED_SIZE(n) ((size_t)(n) * ((n) + 1) / 2)
+
+int CholeskyPacked(Matrix matrix, double *packed);
+
+/*************************************************************************
+ * int CholeskySolveInPlace(Matrix factor, Matrix rhs)
+ * Matrix CholeskySolve(Matrix factor, Matrix rhs)
+ * int CholeskySolvePacked(const double *packed, Matrix rhs)
+ *
+ *   Solve A * X = rhs for one or many right-hand side columns using the
+ *   factor L of A (from Cholesky()/CholeskyInPlace(), or packed from
+ *   CholeskyPacked()) by forward substitution with L followed by back
+ *   substitution with L^T. Each costs O(n^2) per column.
+ *
+ *   The InPlace and Packed forms overwrite rhs with X and return 0, or -1
+ *   if the shapes do not agree; CholeskySolve returns X in a new matrix
+ *   (or a NULL ptr) and leaves rhs unchanged.
+ ************************************************************************/
+int CholeskySolveInPlace(Matrix factor, Matrix rhs);
+Matrix CholeskySolve(Matrix factor, Matrix rhs);
+int CholeskySolvePacked(const double *packed, Matrix rhs);
+
+/*************************************************************************
+ * int CholeskyUpdate(Matrix factor, Matrix vectors, int downdate_flag)
+ * int CholeskyUpdateVector(Matrix factor, const double *vector, int downdate_flag)
+ *
+ *   Turns the factor L of A (from Cholesky()/CholeskyInPlace()) into the
+ *   factor of A + V * V^T, or of A - V * V^T when downdating, in place and
+ *   in O(k * n^2) instead of the O(n^3) of a new factorization. Each
+ *   column of V is one rank-1 step: L^-1 * v is found by forward
+ *   substitution, which fixes every rotation of the step (and whether a
+ *   downdate keeps the matrix positive definite) before L is changed; the
+ *   rows of L are then rotated in parallel.
+ *
+ * -> PARAMETERS:
+ *    factor        - NxN lower triangular factor, updated in place
+ *    vectors       - NxK matrix whose columns are the vectors v_j
+ *    vector        - array of N values (a single v)
+ *    downdate_flag - nonzero to subtract V * V^T, 0 to add it
+ *
+ * -> RETURNS: 0 on success, -1 on bad arguments, or one more than the index
+ *             of the first column whose downdate would leave a matrix that
+ *             is not positive definite. That column and the ones after it
+ *             are not applied; the factor is that of A minus the earlier
+ *             columns.
+ ************************************************************************/
+int CholeskyUpdate(Matrix factor, Matrix vectors, int downdate_flag);
+int CholeskyUpdateVector(Matrix factor, const double *vector, int downdate_flag);
+
 /*************************************************************************
  * Matrix MultiplyMatrices(Matrix matrix_A, Matrix matrix_B)
  *
  *  Calculates and returns a matrix as the result of the product of two
- *  matrices
+ *  matrices. The product is computed by a cache-blocked GEMM: A and B are
+ *  copied block by block into packed panels sized for the L2/L1 caches
+ *  and multiplied by a register-tiled micro-kernel.
  *
  * -> PARAMETERS:
  *    matrix_A     - a pointer to matrix A
@@ -169,6 +863,146 @@ Matrix Cholesky(Matrix matrix);
  ************************************************************************/
 Matrix MultiplyMatrices(Matrix matrix_A, Matrix matrix_b);
 
+/*************************************************************************
+ * int MultiplyMatricesInto(Matrix result_matrix, Matrix matrix_A, Matrix matrix_B)
+ *
+ *  Same as MultiplyMatrices(), but overwrites an existing MxP matrix
+ *  instead of allocating one. result_matrix must not be an operand.
+ *
+ * -> RETURNS: 0 on success, or -1 if the matrix dimensions do not agree
+ ************************************************************************/
+int MultiplyMatricesInto(Matrix result_matrix, Matrix matrix_A, Matrix matrix_B);
+
+/*************************************************************************
+ * int MultiplyMatricesAccumulate(Matrix matrix_C, double alpha,
+ *                                Matrix matrix_A, Matrix matrix_B, double beta)
+ *
+ *  General matrix multiply into an existing matrix:
+ *
+ *      C = alpha * A * B + beta * C
+ *
+ *  Pass beta = 1 to accumulate a product into C, or beta = 0 to overwrite
+ *  C (its old contents are then never read). Uses the same blocked engine
+ *  as MultiplyMatrices().
+ *
+ * -> PARAMETERS:
+ *    matrix_C     - an MxN matrix that receives the result
+ *    alpha        - scale applied to the product A*B
+ *    matrix_A     - an MxK matrix
+ *    matrix_B     - a KxN matrix
+ *    beta         - scale applied to the previous contents of C
+ *
+ * -> RETURNS: 0 on success, or -1 if the matrix dimensions do not agree
+ ************************************************************************/
+int MultiplyMatricesAccumulate(Matrix matrix_C, double alpha, Matrix matrix_A, Matrix matrix_B, double beta);
+
+/*************************************************************************
+ * Matrix MultiplyMatricesStrassen(Matrix matrix_A, Matrix matrix_B)
+ * int MultiplyMatricesStrassenInto(Matrix result_matrix, Matrix matrix_A, Matrix matrix_B)
+ * void SetStrassenCutoff(size_t cutoff) / size_t GetStrassenCutoff(void)
+ *
+ *  MultiplyMatrices() and MultiplyMatricesInto() by Strassen-Winograd
+ *  recursion: each level splits the operands into quadrants and forms the
+ *  product from 7 half-size products and 15 additions instead of 8
+ *  products, for O(n^2.81) work. Halves whose smallest dimension is at or
+ *  below the cutoff (default 1024, never less than 64) are multiplied by
+ *  the classical blocked kernel. An odd last row, column or inner index is
+ *  peeled off and finished by the classical kernel, so any shape works.
+ *  With more than one thread the seven products of the top level run
+ *  concurrently.
+ *
+ *  The workspace is allocated once per call before the recursion starts:
+ *  about 2 * n^2 / 3 doubles for n x n operands when running serially, about
+ *  4 * n^2 with the parallel top level (if that much is not available the
+ *  serial order is used, and with no room at all the classical product).
+ *
+ *  Accuracy: the classical product's error is bounded entry by entry,
+ *  |C - fl(A*B)| <= k * eps * |A| * |B|. Strassen-Winograd only satisfies
+ *  a norm-wise bound, ||C - fl(A*B)|| <= c * eps * ||A|| * ||B||, where c
+ *  grows like cutoff^2 * (k / cutoff)^log2(18) (about 4.2 powers of the
+ *  number of halvings) rather than like k.
+ *  In practice each level costs a fraction of a digit, and an entry that
+ *  is much smaller than ||A|| * ||B|| (from cancellation, or rows and
+ *  columns of very different scale) can lose most of its digits. Prefer
+ *  MultiplyMatrices when entries have widely varying magnitudes.
+ *
+ *  SetStrassenCutoff(0) restores the default and smaller values are raised
+ *  to 64; GetStrassenCutoff() reports the cutoff actually in effect.
+ *
+ * -> RETURNS: the product / 0 on success, or NULL / -1 if the matrix
+ *             dimensions do not agree (or the result is an operand)
+ ************************************************************************/
+Matrix MultiplyMatricesStrassen(Matrix matrix_A, Matrix matrix_B);
+int MultiplyMatricesStrassenInto(Matrix result_matrix, Matrix matrix_A, Matrix matrix_B);
+void SetStrassenCutoff(size_t cutoff);
+size_t GetStrassenCutoff(void);
+
+/*************************************************************************
+ * MatrixExprGraph NewMatrixExprGraph(void)
+ * void FreeMatrixExprGraph(MatrixExprGraph *graph)
+ * MatrixExpr ExprMatrix(MatrixExprGraph graph, Matrix matrix)
+ * MatrixExpr ExprAdd(MatrixExpr left, MatrixExpr right)
+ * MatrixExpr ExprSubtract(MatrixExpr left, MatrixExpr right)
+ * MatrixExpr ExprScale(MatrixExpr expr, double alpha)
+ * MatrixExpr ExprMultiply(MatrixExpr left, MatrixExpr right)
+ * MatrixExpr ExprTranspose(MatrixExpr expr)
+ *
+ *  Records a chain of matrix arithmetic without computing anything. Each
+ *  call adds one node to the graph its operands come from; ExprMatrix
+ *  wraps a matrix as a leaf (the matrix is borrowed and is read only when
+ *  the expression is evaluated). A node may be an operand of any number of
+ *  others. Freeing the graph frees every node built from it, but none of
+ *  the leaf matrices.
+ *
+ *  Builders return NULL for a NULL operand, so a chain with an error in it
+ *  evaluates to NULL / -1 instead of crashing.
+ *
+ * -> PARAMETERS:
+ *    graph  - the graph that owns the node (leaves only)
+ *    matrix - the matrix a leaf stands for
+ *    left, right, expr - operand expressions from the same graph
+ *    alpha  - scale factor
+ *
+ * -> RETURNS: the new node, or NULL if an operand is NULL, the shapes do
+ *             not agree or the node could not be allocated
+ ************************************************************************/
+MatrixExprGraph NewMatrixExprGraph(void);
+void FreeMatrixExprGraph(MatrixExprGraph *graph);
+MatrixExpr ExprMatrix(MatrixExprGraph graph, Matrix matrix);
+MatrixExpr ExprAdd(MatrixExpr left, MatrixExpr right);
+MatrixExpr ExprSubtract(MatrixExpr left, MatrixExpr right);
+MatrixExpr ExprScale(MatrixExpr expr, double alpha);
+MatrixExpr ExprMultiply(MatrixExpr left, MatrixExpr right);
+MatrixExpr ExprTranspose(MatrixExpr expr);
+
+/*************************************************************************
+ * Matrix EvaluateExpr(MatrixExpr expr)
+ * int EvaluateExprInto(Matrix result_matrix, MatrixExpr expr)
+ *
+ *  Evaluates an expression. Scales and subtractions become coefficients
+ *  and transposes are pushed down to the leaves, turning the expression
+ *  into a sum of scaled matrices and scaled products. All the plain
+ *  matrices are then summed in one fused pass over the result (transposed
+ *  ones read tile by tile), and each product is accumulated straight into
+ *  the result by the blocked multiply with its transposes folded into the
+ *  operand order, so alpha*A*B' + beta*C - D needs no temporary at all.
+ *  Only an operand of a product that is itself more than a (scaled or
+ *  transposed) matrix is evaluated into a temporary first.
+ *
+ *  The result may be one of the leaf matrices; if it is read transposed or
+ *  as a product operand the expression is evaluated beside it and copied.
+ *  The graph can be evaluated again after its leaf matrices change.
+ *
+ * -> PARAMETERS:
+ *    result_matrix - matrix with the expression's shape to receive it
+ *    expr          - expression to evaluate
+ *
+ * -> RETURNS: a new matrix / 0 on success, or NULL / -1 if expr is NULL,
+ *             the result has the wrong shape or memory ran out
+ ************************************************************************/
+Matrix EvaluateExpr(MatrixExpr expr);
+int EvaluateExprInto(Matrix result_matrix, MatrixExpr expr);
+
 /*************************************************************************
  * Matrix AddMatrices(Matrix matrix_A, Matrix matrix_B, int subtract_flag)
  *
@@ -187,22 +1021,34 @@ Matrix MultiplyMatrices(Matrix matrix_A, Matrix matrix_b);
  ************************************************************************/
 Matrix AddMatrices(Matrix matrix_A, Matrix matrix_B, int subtract_flag);
 
+/*************************************************************************
+ * int AddMatricesInto(Matrix result_matrix, Matrix matrix_A, Matrix matrix_B,
+ *                     int subtract_flag)
+ *
+ *  Same as AddMatrices(), but overwrites an existing matrix of the same
+ *  size instead of allocating one. result_matrix may be matrix_A or
+ *  matrix_B (e.g. A += B).
+ *
+ * -> RETURNS: 0 on success, or -1 if the matrices differ in size
+ ************************************************************************/
+int AddMatricesInto(Matrix result_matrix, Matrix matrix_A, Matrix matrix_B, int subtract_flag);
+
 /*************************************************************************
  * double Determinant(Matrix matrix)
  *
- *  Calculates and returns the determinant of a matrix. The matrix is first
- *  put in triangular form i.e. :
+ *  Calculates and returns the determinant of a matrix. A copy of the
+ *  matrix is put in upper triangular form by LU decomposition with partial
+ *  pivoting (see LUFactor()) i.e. :
  *
  *      1 2 1
  *      0 2 0
  *      0 0 1
  *
- *  The product of the diagonal and the determinant multiplier is the
- *  determinant of the matrix.
+ *  The product of the diagonal, negated once per row interchange, is the
+ *  determinant of the matrix. The matrix itself is left unchanged.
  *
- *  NOTE: matrix will be converted to reduced row echelon form. This is
- *        because the matrix needs to be in upper triangle form.
- *        See: double Reduced_row_echelon_form(..)
+ *  NOTE: To take the determinant of a matrix that is also being solved,
+ *        factor it once with LUFactor() and call LUDeterminant() instead.
  *
  * -> PARAMETERS:
  *    matrix                 - a matrix structure
@@ -217,11 +1063,31 @@ double Determinant(Matrix matrix);
  *  Takes the transpose of a matrix. The transpose of a matrix is every value
  *  within the matrix in index [i][j] swapped with [j][i].
  *
+ *  Square matrices are transposed in place, 64x64 cache blocks at a time,
+ *  with 8x8 tiles moved through SIMD registers. An MxN matrix becomes NxM:
+ *  its values are transposed into a new buffer that replaces the old one
+ *  (so previously saved row pointers become invalid).
+ *
  * -> PARAMETERS:
  *    matrix       - a matrix structure
  ************************************************************************/
 void Transpose(Matrix matrix);
 
+/*************************************************************************
+ * int TransposeInto(Matrix src, Matrix dst)
+ *
+ *  Writes the transpose of an MxN matrix into an existing NxM matrix
+ *  without modifying src. Works for any shape; passing the same square
+ *  matrix as src and dst transposes it in place.
+ *
+ * -> PARAMETERS:
+ *    src          - an MxN matrix structure
+ *    dst          - an NxM matrix structure that receives src^T
+ *
+ * -> RETURNS: 0 on success, or -1 if the shapes do not agree
+ ************************************************************************/
+int TransposeInto(Matrix src, Matrix dst);
+
 /*************************************************************************
  * void SwapValues(double *index_one, double *index_two)
  *
@@ -241,7 +1107,8 @@ void SwapValues(double *index_one, double *index_two);
  * void SwapColumns(Matrix matrix)
  *
  *  Interchanges values in columns within a matrix. (Like SwapValues(),
- *  but the operation is performed on the entire column).
+ *  but the operation is performed on the entire column). Equivalent to
+ *  FlipHorizontal().
  *
  * -> PARAMETERS:
  *    matrix       - a matrix structure
@@ -251,9 +1118,9 @@ void SwapColumns(Matrix matrix);
 /*************************************************************************
  * void RotateMatrixClockwise(Matrix matrix)
  *
- *  Rotates an NxN matrix 90 degrees clockwise. The function achieves this
- *  by first transposing the matrix (by calling Transpose()) and then by
- *  interchanging columns (by calling SwapColumns()).
+ *  Rotates an NxN matrix 90 degrees clockwise in a single pass: each value
+ *  moves once along a four-way cycle of positions, with the cycles walked
+ *  in 32x32 tiles so all four regions involved stay in cache.
  *
  * -> PARAMETERS:
  *    matrix      - a matrix structure
@@ -263,25 +1130,60 @@ void RotateMatrixClockwise(Matrix matrix);
 /*************************************************************************
  * RotateMatrixCounterClockwise(Matrix matrix)
  *
- *  Rotates an NxN matrix 90 degrees counterclockwise. This performs the
- *  same operations as RotateMatrixClockwise() except in reverse, i.e.,
- *  interchange columns, then transpose.
+ *  Rotates an NxN matrix 90 degrees counterclockwise. This runs the same
+ *  four-way cycles as RotateMatrixClockwise() in the opposite direction.
  *
  * -> PARAMETERS:
  *    matrix       - a matrix structure
  ************************************************************************/
 void RotateMatrixCounterClockwise(Matrix matrix);
 
+/*************************************************************************
+ * void Rotate180(Matrix matrix)
+ *
+ *  Rotates an MxN matrix 180 degrees in place by exchanging row i with
+ *  the reverse of row M-1-i. Works for any shape.
+ *
+ * -> PARAMETERS:
+ *    matrix       - a matrix structure
+ ************************************************************************/
+void Rotate180(Matrix matrix);
+
+/*************************************************************************
+ * void FlipHorizontal(Matrix matrix)
+ *
+ *  Mirrors an MxN matrix left to right in place (column j is exchanged
+ *  with column N-1-j), reversing each row with SIMD shuffles.
+ *
+ * -> PARAMETERS:
+ *    matrix       - a matrix structure
+ ************************************************************************/
+void FlipHorizontal(Matrix matrix);
+
+/*************************************************************************
+ * void FlipVertical(Matrix matrix)
+ *
+ *  Mirrors an MxN matrix top to bottom in place (row i is exchanged with
+ *  row M-1-i).
+ *
+ * -> PARAMETERS:
+ *    matrix       - a matrix structure
+ ************************************************************************/
+void FlipVertical(Matrix matrix);
+
 /*************************************************************************
  * int IsLinearIndependent(Matrix matrix)
  *
- *  Determines if a matrix is linearly independent. A matrix is said to be
- *  independent if it's determinant is not equal to 0.
+ *  Determines if the columns of an MxN matrix are linearly independent,
+ *  i.e. if its numerical rank (see MatrixRank()) is N. For a square matrix
+ *  this is the same as a non-zero determinant, but measured against a
+ *  tolerance instead of compared to exactly 0. The matrix is left
+ *  unchanged.
  *
  * -> PARAMETERS:
  *    matrix       - a matrix structure
  *
- * -> RETURNS: 0 for false or 1 for true
+ * -> RETURNS: 0 for false or 1 for true (-1 for an empty matrix)
  ************************************************************************/
 int IsLinearIndependent(Matrix matrix);
 
@@ -310,6 +1212,575 @@ int isSquare(Matrix matrix);
  ************************************************************************/
 int isEmpty(Matrix matrix);
 
+/*************************************************************************
+ * SparseMatrix NewSparseMatrix(size_t num_rows, size_t num_cols, size_t nnz,
+ *                              int format)
+ *
+ *  Allocates a compressed sparse matrix with room for nnz values and all
+ *  offsets zero, to be filled in by the caller. Only the nonzeros and one
+ *  offset per row (CSR) or column (CSC) are stored, at 12 bytes per value,
+ *  so matrices with tens of millions of nonzeros stay in memory even when
+ *  the dense form would not. Indices must be ascending within each row
+ *  (column); every function below produces them that way.
+ *
+ * -> PARAMETERS:
+ *    num_rows - rows of the matrix (at most 2^32-1)
+ *    num_cols - columns of the matrix (at most 2^32-1)
+ *    nnz      - number of stored values
+ *    format   - SPARSE_CSR or SPARSE_CSC
+ *
+ * -> RETURNS: the new sparse matrix, or NULL on failure
+ ************************************************************************/
+SparseMatrix NewSparseMatrix(size_t num_rows, size_t num_cols, size_t nnz, int format);
+void FreeSparseMatrix(SparseMatrix *sparse);
+
+/*************************************************************************
+ * SparseMatrix SparseFromDense(Matrix dense, double drop_tolerance, int format)
+ * Matrix SparseToDense(SparseMatrix sparse)
+ *
+ *  Converts between the dense and compressed forms. Values whose magnitude
+ *  is at most drop_tolerance (pass 0 to keep every nonzero) are dropped.
+ ************************************************************************/
+SparseMatrix SparseFromDense(Matrix dense, double drop_tolerance, int format);
+Matrix SparseToDense(SparseMatrix sparse);
+
+/*************************************************************************
+ * SparseMatrix SparseFromTriplets(size_t num_rows, size_t num_cols,
+ *                                 size_t count, const size_t *rows,
+ *                                 const size_t *cols, const double *values,
+ *                                 int format)
+ *
+ *  Builds a sparse matrix from count (row, column, value) triplets in any
+ *  order. Triplets naming the same entry are summed, as when assembling a
+ *  finite-element stiffness matrix.
+ *
+ * -> RETURNS: the new sparse matrix, or NULL if a triplet lies outside the
+ *             matrix or memory runs out
+ ************************************************************************/
+SparseMatrix SparseFromTriplets(size_t num_rows, size_t num_cols, size_t count, const size_t *rows,
+                                const size_t *cols, const double *values, int format);
+
+/*************************************************************************
+ * SparseMatrix SparseConvert(SparseMatrix sparse, int format)
+ *
+ *  Returns a copy of sparse stored as format (CSR <-> CSC in O(nnz)).
+ ************************************************************************/
+SparseMatrix SparseConvert(SparseMatrix sparse, int format);
+
+/*************************************************************************
+ * int SparseMultiplyVector(SparseMatrix sparse, int transpose,
+ *                          const double *x, double *y)
+ *
+ *  y = A * x, or y = A^T * x when transpose is non-zero. For a CSR matrix
+ *  (or a CSC one transposed) each output is one sparse dot product and the
+ *  work is split between threads by nonzeros, not rows, so a few dense rows
+ *  do not stall the rest. The other two cases scatter into y serially.
+ *
+ * -> PARAMETERS:
+ *    sparse       - an MxN sparse matrix
+ *    transpose    - non-zero to multiply by the transpose
+ *    x            - N values (M when transposed)
+ *    y            - M values (N when transposed), overwritten; not x
+ *
+ * -> RETURNS: 0 on success, or -1 on bad arguments
+ ************************************************************************/
+int SparseMultiplyVector(SparseMatrix sparse, int transpose, const double *x, double *y);
+
+/*************************************************************************
+ * Matrix SparseMultiplyDense(SparseMatrix sparse, Matrix dense)
+ * int SparseMultiplyDenseInto(Matrix result_matrix, SparseMatrix sparse,
+ *                             Matrix dense)
+ *
+ *  Product of an MxN sparse matrix and an NxP dense matrix, as a new MxP
+ *  matrix or written over an existing one. Runs in parallel over rows
+ *  (CSR, balanced by nonzeros) or over 64-column slices of the result (CSC).
+ *
+ * -> RETURNS: the product / 0, or NULL / -1 if the shapes do not agree
+ ************************************************************************/
+Matrix SparseMultiplyDense(SparseMatrix sparse, Matrix dense);
+int SparseMultiplyDenseInto(Matrix result_matrix, SparseMatrix sparse, Matrix dense);
+
+/*************************************************************************
+ * SparseMatrix SparseAdd(SparseMatrix sparse_A, SparseMatrix sparse_B,
+ *                        int subtract_flag)
+ *
+ *  A + B (or A - B when subtract_flag is 1) in A's format, merging the
+ *  sorted rows (columns) of both in parallel. Entries that cancel are kept
+ *  as explicit zeros.
+ *
+ * -> RETURNS: the sum, or NULL if the matrices differ in size
+ ************************************************************************/
+SparseMatrix SparseAdd(SparseMatrix sparse_A, SparseMatrix sparse_B, int subtract_flag);
+
+/*************************************************************************
+ * LinearOperator DenseOperator(Matrix matrix)
+ * LinearOperator SparseOperator(SparseMatrix sparse)
+ * LinearOperator MatrixFreeOperator(size_t size, OperatorApply apply,
+ *                                   void *context)
+ *
+ *  Wraps the system matrix for the iterative solvers below. A matrix-free
+ *  operator only needs a callback computing y = A * x, so A never has to
+ *  be formed. Products with dense and CSR matrices run in parallel. The
+ *  operator refers to matrix / sparse, which must outlive it.
+ ************************************************************************/
+LinearOperator DenseOperator(Matrix matrix);
+LinearOperator SparseOperator(SparseMatrix sparse);
+LinearOperator MatrixFreeOperator(size_t size, OperatorApply apply, void *context);
+
+/*************************************************************************
+ * Preconditioner NewJacobiPreconditioner(const LinearOperator *op)
+ * Preconditioner NewIncompleteCholeskyPreconditioner(const LinearOperator *op)
+ * Preconditioner NewILU0Preconditioner(const LinearOperator *op)
+ * Preconditioner NewCustomPreconditioner(size_t size, OperatorApply apply,
+ *                                        void *context)
+ * void FreePreconditioner(Preconditioner *preconditioner)
+ *
+ *  Approximations M of A whose inverse is cheap to apply, passed to the
+ *  solvers to cut the number of iterations:
+ *
+ *    Jacobi     - M = diag(A) (zero diagonal entries are left unscaled)
+ *    IC(0)      - M = L * L^T for symmetric positive-definite A, with L
+ *                 kept to the nonzero pattern of A's lower triangle
+ *    ILU(0)     - M = L * U, with L and U kept to the pattern of A
+ *    custom     - apply(context, r, z) computes z = M^-1 * r
+ *
+ *  On a dense operator every entry is in the pattern, so IC(0) and ILU(0)
+ *  are the full blocked Cholesky and LU factorizations. The built-in ones
+ *  need a dense or sparse operator, not a matrix-free one, and copy what
+ *  they need from it.
+ *
+ * -> RETURNS: the preconditioner, or NULL on a bad operator, a dense
+ *             factorization that breaks down, or a memory failure
+ ************************************************************************/
+Preconditioner NewJacobiPreconditioner(const LinearOperator *op);
+Preconditioner NewIncompleteCholeskyPreconditioner(const LinearOperator *op);
+Preconditioner NewILU0Preconditioner(const LinearOperator *op);
+Preconditioner NewCustomPreconditioner(size_t size, OperatorApply apply, void *context);
+void FreePreconditioner(Preconditioner *preconditioner);
+
+/*************************************************************************
+ * int SolveCG(const LinearOperator *op, Preconditioner preconditioner,
+ *             const double *b, double *x, const SolverOptions *options,
+ *             SolverReport *report)
+ * int SolveBiCGSTAB(...same parameters...)
+ * int SolveGMRES(...same parameters...)
+ *
+ *  Krylov solvers for A * x = b that only touch A through products with
+ *  vectors. Conjugate gradient needs A (and M) symmetric positive
+ *  definite; BiCGSTAB and restarted GMRES handle general matrices (GMRES
+ *  more robustly, BiCGSTAB with less memory). BiCGSTAB and GMRES apply the
+ *  preconditioner on the right, so the residual they report is the true
+ *  one.
+ *
+ * -> PARAMETERS:
+ *    op             - the square system matrix
+ *    preconditioner - M, or NULL for none
+ *    b              - right-hand side (op->size values)
+ *    x              - initial guess, replaced by the solution
+ *    options        - tolerance, limits and progress callback (NULL for
+ *                     the defaults)
+ *    report         - receives iterations and final residual (may be NULL)
+ *
+ * -> RETURNS: 0 when the tolerance was reached, 1 when the iteration limit
+ *             or a breakdown stopped it first (x holds the last iterate),
+ *             or -1 on bad arguments
+ ************************************************************************/
+int SolveCG(const LinearOperator *op, Preconditioner preconditioner, const double *b, double *x,
+            const SolverOptions *options, SolverReport *report);
+int SolveBiCGSTAB(const LinearOperator *op, Preconditioner preconditioner, const double *b, double *x,
+                  const SolverOptions *options, SolverReport *report);
+int SolveGMRES(const LinearOperator *op, Preconditioner preconditioner, const double *b, double *x,
+               const SolverOptions *options, SolverReport *report);
+
+/*************************************************************************
+ * int SymmetricEigen(Matrix matrix, double *eigenvalues, Matrix eigenvectors)
+ *
+ *  All eigenvalues, and optionally eigenvectors, of a symmetric matrix.
+ *  The matrix is reduced to tridiagonal form by blocked Householder
+ *  reflectors (most of the work in GEMM updates), the tridiagonal problem
+ *  is solved by implicit QL iteration with Wilkinson shifts, and the
+ *  eigenvectors are formed by applying the reflectors back in blocks.
+ *  Only the lower triangle of matrix is read.
+ *
+ * -> PARAMETERS:
+ *    matrix       - NxN symmetric matrix, left unchanged
+ *    eigenvalues  - array of N values, filled in ascending order
+ *    eigenvectors - NxN matrix whose column i receives the unit
+ *                   eigenvector of eigenvalues[i], or NULL
+ *
+ * -> RETURNS: 0 on success, or -1 on bad arguments or when the iteration
+ *             does not converge
+ ************************************************************************/
+int SymmetricEigen(Matrix matrix, double *eigenvalues, Matrix eigenvectors);
+
+/*************************************************************************
+ * int DominantEigenpairs(const LinearOperator *op, size_t k,
+ *                        double *eigenvalues, Matrix eigenvectors,
+ *                        const SolverOptions *options, SolverReport *report)
+ *
+ *  The k eigenvalues of largest magnitude of a symmetric operator, and
+ *  their eigenvectors, by thick-restart Lanczos with full
+ *  reorthogonalization. A is only touched through op->apply, so dense,
+ *  sparse and matrix-free operators all work; the rest of each step is
+ *  vector work split over threads. For k = 1 this converges where power
+ *  iteration would, in far fewer products.
+ *
+ * -> PARAMETERS:
+ *    op           - the symmetric operator
+ *    k            - how many eigenpairs, 1 <= k <= op->size
+ *    eigenvalues  - array of k values, by decreasing magnitude
+ *    eigenvectors - NxK matrix receiving the unit eigenvectors as columns,
+ *                   or NULL
+ *    options      - tolerance on max |A*x - lambda*x| / |lambda_max|,
+ *                   max_iterations on products with A, restart as the
+ *                   basis size (NULL for the defaults)
+ *    report       - receives products with A and final residual (may be
+ *                   NULL)
+ *
+ * -> RETURNS: 0 when the tolerance was reached, 1 when the iteration limit
+ *             stopped it first (the current estimates are returned), or -1
+ *             on bad arguments or a failure (no memory, or the projected
+ *             eigenproblem did not converge), with nothing written
+ ************************************************************************/
+int DominantEigenpairs(const LinearOperator *op, size_t k, double *eigenvalues, Matrix eigenvectors,
+                       const SolverOptions *options, SolverReport *report);
+
+/*************************************************************************
+ * MatrixF NewMatrixF(size_t num_rows, size_t num_cols)
+ * void FreeMatrixF(MatrixF *matrix)
+ *
+ *  Single-precision matrices: the layout of a Matrix (one aligned buffer,
+ *  rows padded to a cache line) with floats, so twice as many values fit
+ *  in every cache line and SIMD register. Values start at zero; they
+ *  always come from the heap, never from an arena. MATRIXF_ROW and
+ *  MATRIXF_AT address them like MATRIX_ROW and MATRIX_AT.
+ *
+ * -> RETURNS: the new matrix, or NULL on failure
+ ************************************************************************/
+#define MATRIXF_ROW(matrix, row)     ((matrix)->data + (size_t)(row) * (matrix)->ld)
+#define MATRIXF_AT(matrix, row, col) (MATRIXF_ROW(matrix, row)[col])
+
+MatrixF NewMatrixF(size_t num_rows, size_t num_cols);
+void FreeMatrixF(MatrixF *matrix);
+
+/*************************************************************************
+ * MatrixF MatrixToFloat(Matrix matrix)
+ * Matrix MatrixToDouble(MatrixF matrix)
+ *
+ *  Copies of a matrix in the other precision. Values round to the nearest
+ *  float (magnitudes beyond FLT_MAX become infinite); widening is exact.
+ *
+ * -> RETURNS: the new matrix, or NULL on an empty matrix or failure
+ ************************************************************************/
+MatrixF MatrixToFloat(Matrix matrix);
+Matrix MatrixToDouble(MatrixF matrix);
+
+/*************************************************************************
+ * MatrixF MultiplyMatricesF(MatrixF matrix_A, MatrixF matrix_B)
+ * int MultiplyMatricesIntoF(MatrixF result_matrix, MatrixF matrix_A, MatrixF matrix_B)
+ * int AddMatricesIntoF(MatrixF result_matrix, MatrixF matrix_A, MatrixF matrix_B,
+ *                      int subtract_flag)
+ *
+ *  MultiplyMatrices(), MultiplyMatricesInto() and AddMatricesInto() in
+ *  single precision, on the same blocked GEMM engine and SIMD kernels
+ *  (instantiated for float).
+ *
+ * -> RETURNS: the product / 0 on success, or NULL / -1 if the matrix
+ *             dimensions do not agree (or the result of a multiply is one
+ *             of its operands)
+ ************************************************************************/
+MatrixF MultiplyMatricesF(MatrixF matrix_A, MatrixF matrix_B);
+int MultiplyMatricesIntoF(MatrixF result_matrix, MatrixF matrix_A, MatrixF matrix_B);
+int AddMatricesIntoF(MatrixF result_matrix, MatrixF matrix_A, MatrixF matrix_B, int subtract_flag);
+
+/*************************************************************************
+ * int SolveMixedPrecision(Matrix matrix, Matrix rhs, Matrix solution,
+ *                         const SolverOptions *options, SolverReport *report)
+ *
+ *  Solves matrix * solution = rhs to double accuracy while doing the
+ *  O(n^3) work in single precision: A is rounded to float and factored
+ *  by the float LU, then each column of the solution is refined with
+ *
+ *      r = b - A*x (in double),  solve A*d = r with the float factors,
+ *      x = x + d
+ *
+ *  until ||r||_inf <= ||x||_inf * ||A||_inf * sqrt(n) * DBL_EPSILON for
+ *  every column (or ||r|| <= tolerance * ||b|| when options gives a
+ *  tolerance). This converges when A is not too ill-conditioned for float
+ *  (condition number well below 1e7). If the float factorization is
+ *  singular, or refinement stalls or runs out of iterations, the system is
+ *  solved again with a double LU instead, so the result is always as
+ *  accurate as LUSolve()'s.
+ *
+ * -> PARAMETERS:
+ *    matrix   - the NxN system matrix (unchanged)
+ *    rhs      - NxK right-hand sides
+ *    solution - an NxK matrix that receives the solutions
+ *    options  - tolerance and max_iterations (refinement steps, 0: 30);
+ *               NULL for the defaults. The other fields are unused.
+ *    report   - receives the refinement steps and the largest relative
+ *               residual ||b - A*x||_2 / ||b||_2 of a column, with
+ *               converged = 0 if the double fallback was needed (may be
+ *               NULL)
+ *
+ * -> RETURNS: 0 when refinement converged, 1 when the double LU fallback
+ *             produced the solution, or -1 on bad arguments, a singular
+ *             matrix or a memory failure
+ ************************************************************************/
+int SolveMixedPrecision(Matrix matrix, Matrix rhs, Matrix solution,
+                        const SolverOptions *options, SolverReport *report);
+
+/*************************************************************************
+ * MatrixBatch NewMatrixBatch(size_t count, size_t num_rows, size_t num_cols)
+ *
+ *  Allocates a batch of count matrices that all share one small shape,
+ *  stored structure-of-arrays: entry [r][c] of every matrix is contiguous,
+ *  so the batch functions below process 8 matrices per SIMD operation
+ *  (one per lane) without mallocs or branches per matrix. Values start at
+ *  zero. BATCH_AT(batch, b, r, c) is entry [r][c] of matrix b.
+ *
+ * -> PARAMETERS:
+ *    count    - number of matrices
+ *    num_rows - rows of each matrix
+ *    num_cols - columns of each matrix
+ *
+ * -> RETURNS: the new batch, or NULL on failure
+ ************************************************************************/
+#define BATCH_AT(batch, b, r, c) \
+    ((batch)->data[((size_t)(r) * (batch)->num_cols + (c)) * (batch)->stride + (b)])
+
+// Largest N accepted by the NxN batch operations (determinant, solve,
+// inverse, Cholesky), which keep a working copy of 8 matrices on the stack
+#define BATCH_MAX_DIM 16
+
+MatrixBatch NewMatrixBatch(size_t count, size_t num_rows, size_t num_cols);
+void FreeMatrixBatch(MatrixBatch *batch);
+
+/*************************************************************************
+ * int BatchSetMatrix(MatrixBatch batch, size_t index, Matrix matrix)
+ * int BatchGetMatrix(MatrixBatch batch, size_t index, Matrix matrix)
+ *
+ *  Copies a Matrix of the batch's shape into, or out of, slot index.
+ *
+ * -> RETURNS: 0 on success, or -1 if the shapes do not agree
+ ************************************************************************/
+int BatchSetMatrix(MatrixBatch batch, size_t index, Matrix matrix);
+int BatchGetMatrix(MatrixBatch batch, size_t index, Matrix matrix);
+
+/*************************************************************************
+ * int BatchMultiply(MatrixBatch batch_A, MatrixBatch batch_B, MatrixBatch batch_C)
+ *
+ *  C[b] = A[b] * B[b] for every matrix b of the batches.
+ *
+ * -> PARAMETERS:
+ *    batch_A      - count MxN matrices
+ *    batch_B      - count NxP matrices
+ *    batch_C      - count MxP matrices receiving the products (distinct
+ *                   from batch_A and batch_B)
+ *
+ * -> RETURNS: 0 on success, or -1 if the shapes do not agree
+ ************************************************************************/
+int BatchMultiply(MatrixBatch batch_A, MatrixBatch batch_B, MatrixBatch batch_C);
+
+/*************************************************************************
+ * int BatchDeterminant(MatrixBatch batch, double *determinants)
+ *
+ *  Determinant of every NxN matrix of the batch, by Gaussian elimination
+ *  with partial pivoting chosen separately for each matrix.
+ *
+ * -> PARAMETERS:
+ *    batch        - count NxN matrices (N <= BATCH_MAX_DIM)
+ *    determinants - array of count doubles receiving the results
+ *
+ * -> RETURNS: 0 on success, or -1 on a bad shape
+ ************************************************************************/
+int BatchDeterminant(MatrixBatch batch, double *determinants);
+
+/*************************************************************************
+ * int BatchSolve(MatrixBatch batch_A, MatrixBatch batch_B)
+ *
+ *  Solves A[b] * X = B[b] for every b, overwriting B[b] with X. batch_A is
+ *  not modified. The solutions of singular matrices are set to NaN.
+ *
+ * -> PARAMETERS:
+ *    batch_A      - count NxN matrices (N <= BATCH_MAX_DIM)
+ *    batch_B      - count NxK right-hand sides, replaced by the solutions
+ *
+ * -> RETURNS: the number of singular matrices (0 when all were solved),
+ *             or -1 on a bad shape
+ ************************************************************************/
+int BatchSolve(MatrixBatch batch_A, MatrixBatch batch_B);
+
+/*************************************************************************
+ * int BatchInverse(MatrixBatch batch, MatrixBatch inverse)
+ *
+ *  inverse[b] = batch[b]^-1 for every b (BatchSolve() against identity).
+ *
+ * -> RETURNS: the number of singular matrices (their inverses are NaN),
+ *             or -1 on a bad shape
+ ************************************************************************/
+int BatchInverse(MatrixBatch batch, MatrixBatch inverse);
+
+/*************************************************************************
+ * int BatchCholesky(MatrixBatch batch, MatrixBatch factor)
+ *
+ *  factor[b] = L with batch[b] = L * L^T for every b. Only the lower
+ *  triangle of each input is read; the upper triangle of L is zero.
+ *
+ * -> RETURNS: the number of matrices that are not positive definite
+ *             (their factors are NaN), or -1 on a bad shape
+ ************************************************************************/
+int BatchCholesky(MatrixBatch batch, MatrixBatch factor);
+
+/*************************************************************************
+ * MatrixNxN MultiplyNxN(const MatrixNxN *a, const MatrixNxN *b)
+ * MatrixNxN TransposeNxN(const MatrixNxN *a)
+ * double DeterminantNxN(const MatrixNxN *a)
+ * int InverseNxN(const MatrixNxN *a, MatrixNxN *inverse)
+ * int SolveNxN(const MatrixNxN *a, const double *b, double *x)
+ * int LoadMatrixNxN(Matrix matrix, MatrixNxN *small)
+ * int StoreMatrixNxN(const MatrixNxN *small, Matrix matrix)
+ *
+ *  Generated for every N from SMALL_MIN_DIM to SMALL_MAX_DIM (Multiply2x2
+ *  through Multiply8x8, and so on). The loops are fully unrolled for the
+ *  fixed size, nothing is allocated, and results are returned by value.
+ *  2x2 and 3x3 determinants and inverses use the closed cofactor forms;
+ *  larger ones, and all solves, an unrolled LU with partial pivoting.
+ *
+ *  MultiplyMatrices(Into), Determinant, Transpose(Into) and
+ *  SolveSystem(Into) use these kernels on their own when every operand is
+ *  N x N (N x N+1 augmented for the solve) with N in that range.
+ *
+ * -> PARAMETERS:
+ *    a, b    - operands (the result may be stored over either)
+ *    inverse - receives a^-1
+ *    b, x    - (SolveNxN) right-hand side and solution of a*x = b, N
+ *              values each (x may equal b)
+ *    matrix  - an N x N Matrix copied from (Load) or into (Store)
+ *
+ * -> RETURNS: (Inverse, Solve) 0, or -1 when a is singular;
+ *             (Load, Store) 0, or -1 when the shapes do not agree
+ ************************************************************************/
+#define SMALL_MATRIX_DECLARE(N) \
+    Matrix##N##x##N Multiply##N##x##N(const Matrix##N##x##N *a, const Matrix##N##x##N *b); \
+    Matrix##N##x##N Transpose##N##x##N(const Matrix##N##x##N *a); \
+    double Determinant##N##x##N(const Matrix##N##x##N *a); \
+    int Inverse##N##x##N(const Matrix##N##x##N *a, Matrix##N##x##N *inverse); \
+    int Solve##N##x##N(const Matrix##N##x##N *a, const double *b, double *x); \
+    int LoadMatrix##N##x##N(Matrix matrix, Matrix##N##x##N *small); \
+    int StoreMatrix##N##x##N(const Matrix##N##x##N *small, Matrix matrix);
+
+SMALL_MATRIX_DECLARE(2)
+SMALL_MATRIX_DECLARE(3)
+SMALL_MATRIX_DECLARE(4)
+SMALL_MATRIX_DECLARE(5)
+SMALL_MATRIX_DECLARE(6)
+SMALL_MATRIX_DECLARE(7)
+SMALL_MATRIX_DECLARE(8)
+
+#undef SMALL_MATRIX_DECLARE
+
+/*************************************************************************
+ * void SetMatrixThreads(size_t num_threads) / size_t GetMatrixThreads(void)
+ *
+ *  MultiplyMatrices, AddMatrices, Transpose, LUFactor and the row updates
+ *  inside ReducedRowEchelonForm and Cholesky split their work across a
+ *  pool of worker threads that the library starts on first use and keeps
+ *  alive. Inputs too small to benefit run on the calling thread.
+ *
+ *  By default one thread per online core is used; the environment
+ *  variable SMLC_NUM_THREADS overrides that default. SetMatrixThreads()
+ *  changes the count at any time (pass 0 to return to one per core, pass
+ *  1 to run everything serially).
+ *
+ * -> PARAMETERS:
+ *    num_threads  - total threads used per operation, including the caller
+ ************************************************************************/
+void SetMatrixThreads(size_t num_threads);
+size_t GetMatrixThreads(void);
+
+/*************************************************************************
+ * const char *MatrixKernelName(void)
+ *
+ *  The row operations (SwapRows, DivideRow, AddMultipleRow), AddMatrices
+ *  and the multiply micro-kernel have scalar, SSE2, AVX2 and AVX-512
+ *  versions. The widest set supported by the CPU is picked once when the
+ *  program starts; setting the environment variable SMLC_ISA to scalar,
+ *  sse2, avx2 or avx512 forces a narrower set.
+ *
+ * -> RETURNS: the name of the kernel set in use, e.g. "avx2"
+ ************************************************************************/
+const char *MatrixKernelName(void);
+
+/*************************************************************************
+ * void GetMatrixStats(MatrixStats *stats)
+ * void ResetMatrixStats(void)
+ * int WriteMatrixStatsJSON(FILE *stream)
+ *
+ *  Counters kept by a library built with SMLC_ENABLE_STATS defined
+ *  (make STATS=1). For every entry point below they record the number of
+ *  calls, the total and the longest wall time of a call and the floating
+ *  point operations performed (0 where no FLOP count applies). Times are
+ *  inclusive: SolveSystem's time also appears under RREF when it falls
+ *  back to elimination, Determinant's under LU factor, and so on. Besides
+ *  these, the bytes NewMatrix allocated and the row interchanges made by
+ *  ReducedRowEchelonForm are counted. Counters are updated atomically, so
+ *  calls from any thread are included.
+ *
+ *  Without SMLC_ENABLE_STATS the instrumentation compiles to nothing;
+ *  these functions then report enabled = 0 and all counters 0.
+ *
+ *  GetMatrixStats() takes a snapshot, ResetMatrixStats() zeroes every
+ *  counter, and WriteMatrixStatsJSON() writes the snapshot as one JSON
+ *  object, e.g. {"enabled": true, "bytes_allocated": ..., "pivot_swaps":
+ *  ..., "operations": {"multiply": {"calls": ..., "total_seconds": ...,
+ *  "max_seconds": ..., "flops": ...}, ...}}.
+ *
+ * -> RETURNS: (WriteMatrixStatsJSON) 0 on success, -1 on a write error
+ ************************************************************************/
+// Entry points counted by the statistics (index into MatrixStats.ops)
+#define MATRIX_STAT_NEW_MATRIX      0   // NewMatrix
+#define MATRIX_STAT_MULTIPLY        1   // MultiplyMatrices(Into), MultiplyMatricesAccumulate
+#define MATRIX_STAT_ADD             2   // AddMatrices(Into)
+#define MATRIX_STAT_TRANSPOSE       3   // Transpose, TransposeInto
+#define MATRIX_STAT_ROTATE          4   // the rotations and flips
+#define MATRIX_STAT_RREF            5   // ReducedRowEchelonForm
+#define MATRIX_STAT_SOLVE_SYSTEM    6   // SolveSystem(Into)
+#define MATRIX_STAT_DETERMINANT     7   // Determinant
+#define MATRIX_STAT_LU_FACTOR       8   // LUFactor
+#define MATRIX_STAT_LU_SOLVE        9   // LUSolve(InPlace), LUSolveVector
+#define MATRIX_STAT_CHOLESKY        10  // Cholesky(Into/InPlace/Packed)
+#define MATRIX_STAT_CHOLESKY_SOLVE  11  // CholeskySolve(InPlace/Packed)
+#define MATRIX_STAT_SPARSE_MULTIPLY 12  // SparseMultiplyVector, SparseMultiplyDense(Into)
+#define MATRIX_STAT_KRYLOV          13  // SolveCG, SolveBiCGSTAB, SolveGMRES
+#define MATRIX_STAT_MIXED_SOLVE     14  // SolveMixedPrecision
+#define MATRIX_STAT_BATCH           15  // BatchMultiply, BatchDeterminant, BatchSolve, BatchInverse, BatchCholesky
+#define MATRIX_STAT_FILE_IO         16  // Save/Load/MapMatrix, the text readers and writers
+#define MATRIX_STAT_QR              17  // QRFactor, QRSolve(Into)
+#define MATRIX_STAT_TILED           18  // TiledMultiply, TiledAdd, TiledCholesky, the tiled block transfers
+#define MATRIX_STAT_FACTOR_UPDATE   19  // CholeskyUpdate(Vector), LUUpdate(Vector)
+#define MATRIX_STAT_EIGEN           20  // SymmetricEigen, DominantEigenpairs
+#define MATRIX_STAT_COUNT           21
+
+typedef struct{
+    const char *name;   // e.g. "multiply"
+    uint64_t calls;
+    uint64_t total_ns;  // wall time summed over calls
+    uint64_t max_ns;    // longest single call
+    uint64_t flops;
+}MatrixOpStats;
+
+typedef struct{
+    int enabled;              // 0 when built without SMLC_ENABLE_STATS
+    uint64_t bytes_allocated; // by NewMatrix (values and row tables)
+    uint64_t pivot_swaps;     // row interchanges in ReducedRowEchelonForm
+    MatrixOpStats ops[MATRIX_STAT_COUNT];
+}MatrixStats;
+
+void GetMatrixStats(MatrixStats *stats);
+void ResetMatrixStats(void);
+int WriteMatrixStatsJSON(FILE *stream);
+
 
 
 #endif //MATRIX_H
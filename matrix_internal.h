@@ -0,0 +1,314 @@
+/****************************
+ * Author: Blake A. Molina
+ * Created on: 10/17/26
+ * License: GPL
+ ****************************/
+
+#ifndef MATRIX_INTERNAL_H
+#define MATRIX_INTERNAL_H
+
+#include "matrix.h"
+
+/*************************************************************************
+ *  Library-private helpers shared between the translation units of smlc.
+ *  Nothing declared here is part of the public API.
+ ************************************************************************/
+
+/*************************************************************************
+ * void *AllocateAligned(size_t size) / void FreeAligned(void *buffer)
+ *
+ *  Allocates a buffer aligned to MATRIX_ALIGNMENT (size is rounded up to
+ *  a whole number of alignment units). Returns NULL on failure.
+ ************************************************************************/
+void *AllocateAligned(size_t size);
+void FreeAligned(void *buffer);
+
+/*************************************************************************
+ * MatrixArena ActiveArena(void)
+ * void *ArenaAllocate(MatrixArena arena, size_t size)
+ *
+ *  The arena backing NewMatrix on the calling thread (NULL for the heap),
+ *  and a MATRIX_ALIGNMENT aligned allocation from an arena (NULL when the
+ *  system is out of memory).
+ ************************************************************************/
+MatrixArena ActiveArena(void);
+void *ArenaAllocate(MatrixArena arena, size_t size);
+
+/*************************************************************************
+ * void ReleaseMappedMatrix(Matrix matrix)
+ *
+ *  Unmaps the file behind a matrix from MapMatrix() and frees its struct
+ *  and row table. Called by FreeMatrix for MATRIX_MAPPED matrices.
+ ************************************************************************/
+void ReleaseMappedMatrix(Matrix matrix);
+
+/*************************************************************************
+ * int FormatMatrixText(Matrix matrix, FILE *stream, int precision,
+ *                      char delimiter, int trailing_delimiter)
+ *
+ *  WriteMatrixText(), optionally also ending every row with delimiter
+ *  (the PrintMatrix layout).
+ ************************************************************************/
+int FormatMatrixText(Matrix matrix, FILE *stream, int precision, char delimiter, int trailing_delimiter);
+
+/*************************************************************************
+ * void *ThreadScratch(size_t size)
+ *
+ *  A per-thread, grow-only aligned buffer of at least size bytes for
+ *  temporaries of functions that write into caller-owned output. The
+ *  buffer is reused by the next call on the same thread.
+ ************************************************************************/
+void *ThreadScratch(size_t size);
+
+/*************************************************************************
+ * void FreeAtThreadExit(void **buffer)
+ *
+ *  Registers a thread-local pointer to an AllocateAligned() buffer, which
+ *  is then freed (and the pointer cleared) when the calling thread exits,
+ *  so threads that come and go do not leak their scratch. Call it once per
+ *  pointer and thread, when the buffer is first allocated.
+ ************************************************************************/
+void FreeAtThreadExit(void **buffer);
+
+/*************************************************************************
+ * int MatricesOverlap(Matrix a, Matrix b)
+ *
+ *  Whether two matrices share any value. Exact for matrices with the same
+ *  row distance (e.g. views of one parent, so disjoint blocks of a matrix
+ *  do not overlap); otherwise the spans of their storage are compared.
+ ************************************************************************/
+int MatricesOverlap(Matrix a, Matrix b);
+
+/*************************************************************************
+ * void DenseGemm(int trans_a, int trans_b, size_t m, size_t n, size_t k,
+ *                double alpha, const double *A, size_t lda,
+ *                const double *B, size_t ldb,
+ *                double beta, double *C, size_t ldc)
+ *
+ *  Row-major general matrix multiply on raw storage:
+ *
+ *      C = alpha * op(A) * op(B) + beta * C
+ *
+ *  where op(X) is X, or X transposed when the matching trans flag is
+ *  non-zero. op(A) is m x k, op(B) is k x n and C is m x n. When beta is 0
+ *  C is write-only (its previous contents are never read).
+ ************************************************************************/
+void DenseGemm(int trans_a, int trans_b, size_t m, size_t n, size_t k,
+               double alpha, const double *A, size_t lda,
+               const double *B, size_t ldb,
+               double beta, double *C, size_t ldc);
+
+/*************************************************************************
+ * void DenseGemmF(...same parameters, with float in place of double...)
+ *
+ *  DenseGemm() for float32 storage, built from the same source
+ *  (gemm_driver.h) around matrix_kernels_f.
+ ************************************************************************/
+void DenseGemmF(int trans_a, int trans_b, size_t m, size_t n, size_t k,
+                float alpha, const float *A, size_t lda,
+                const float *B, size_t ldb,
+                float beta, float *C, size_t ldc);
+
+/*************************************************************************
+ * size_t LUFactorDense(size_t n, double *a, size_t lda, size_t *pivots, int *sign)
+ *
+ *  Blocked right-looking LU with partial pivoting of the n x n matrix at a,
+ *  in place: the unit lower factor L ends up below the diagonal and U on
+ *  and above it. Row i was interchanged with row pivots[i] (>= i) at step
+ *  i; sign receives the parity of those interchanges (+1 or -1).
+ *
+ *  Returns 0, or one more than the index of the first exactly zero pivot.
+ ************************************************************************/
+size_t LUFactorDense(size_t n, double *a, size_t lda, size_t *pivots, int *sign);
+
+/*************************************************************************
+ * void LUSolveDense(size_t n, const double *lu, size_t lda, const size_t *pivots,
+ *                   size_t k, double *b, size_t ldb)
+ *
+ *  Overwrites the n x k block b with the solution of A * X = b, given the
+ *  factorization of A produced by LUFactorDense(). O(n^2) per column.
+ ************************************************************************/
+void LUSolveDense(size_t n, const double *lu, size_t lda, const size_t *pivots,
+                  size_t k, double *b, size_t ldb);
+
+/*************************************************************************
+ * size_t LUFactorDenseF(size_t n, float *a, size_t lda, size_t *pivots, int *sign)
+ * void LUSolveDenseF(size_t n, const float *lu, size_t lda, const size_t *pivots,
+ *                    size_t k, float *b, size_t ldb)
+ *
+ *  LUFactorDense() and LUSolveDense() for float32 storage (lu_kernels.h).
+ ************************************************************************/
+size_t LUFactorDenseF(size_t n, float *a, size_t lda, size_t *pivots, int *sign);
+void LUSolveDenseF(size_t n, const float *lu, size_t lda, const size_t *pivots,
+                   size_t k, float *b, size_t ldb);
+
+/*************************************************************************
+ * size_t CholeskyDense(size_t n, double *a, size_t lda)
+ *
+ *  Blocked right-looking Cholesky of the symmetric positive-definite n x n
+ *  matrix at a, in place. Only the lower triangle is read; on success it
+ *  holds L (A = L * L^T) and the strictly upper triangle is zeroed.
+ *
+ *  Returns 0, or one more than the index of the first pivot that was not
+ *  positive (the factorization stops there).
+ ************************************************************************/
+size_t CholeskyDense(size_t n, double *a, size_t lda);
+
+/*************************************************************************
+ * void CholeskySolveDense(size_t n, const double *l, size_t ldl,
+ *                         size_t k, double *b, size_t ldb)
+ *
+ *  Overwrites the n x k block b with the solution of L * L^T * X = b by
+ *  forward then back substitution with the factor from CholeskyDense().
+ ************************************************************************/
+void CholeskySolveDense(size_t n, const double *l, size_t ldl, size_t k, double *b, size_t ldb);
+
+/*************************************************************************
+ * double HouseholderReflector(size_t n, double *x)
+ *
+ *  Reflector H = I - tau * v * v^T with H * x = (beta, 0, ..., 0), built in
+ *  place: x[0] becomes beta and x[1:] the tail of v (v[0] = 1 is implied).
+ *  Returns tau (0 when x[1:] is already zero and H = I).
+ ************************************************************************/
+double HouseholderReflector(size_t n, double *x);
+
+/*************************************************************************
+ * void TransposeDense(size_t rows, size_t cols, const double *src, size_t lds,
+ *                     double *dst, size_t ldd)
+ * void TransposeSquareDense(size_t n, double *a, size_t ld)
+ *
+ *  dst (cols x rows) = src (rows x cols)^T for non-overlapping storage, and
+ *  the in-place transpose of an n x n matrix. Both walk 64x64 cache blocks
+ *  in parallel and move 8x8 tiles with the SIMD transpose_tile kernel.
+ ************************************************************************/
+void TransposeDense(size_t rows, size_t cols, const double *src, size_t lds, double *dst, size_t ldd);
+void TransposeSquareDense(size_t n, double *a, size_t ld);
+
+/*************************************************************************
+ * int SmallMultiplyDense(size_t n, const double *a, size_t lda,
+ *                        const double *b, size_t ldb, double *c, size_t ldc)
+ * int SmallDeterminantDense(size_t n, const double *a, size_t lda, double *determinant)
+ * int SmallTransposeDense(size_t n, const double *src, size_t lds, double *dst, size_t ldd)
+ * int SmallSolveDense(size_t n, const double *a, size_t lda, const double *b, size_t incb,
+ *                     double *x, size_t incx)
+ *
+ *  The fully unrolled n x n kernels of small.c on strided storage: c = a*b,
+ *  det(a), dst = src^T (src may equal dst) and the solution x of a*x = b,
+ *  whose entries are incb and incx doubles apart. Each loads its operands
+ *  into a fixed-size matrix before storing anything.
+ *
+ *  Return 0, or -1 when n is outside [SMALL_MIN_DIM, SMALL_MAX_DIM] (and,
+ *  for the solve, when a is singular) so the caller takes its general path.
+ ************************************************************************/
+int SmallMultiplyDense(size_t n, const double *a, size_t lda, const double *b, size_t ldb,
+                       double *c, size_t ldc);
+int SmallDeterminantDense(size_t n, const double *a, size_t lda, double *determinant);
+int SmallTransposeDense(size_t n, const double *src, size_t lds, double *dst, size_t ldd);
+int SmallSolveDense(size_t n, const double *a, size_t lda, const double *b, size_t incb,
+                    double *x, size_t incx);
+
+/*************************************************************************
+ * void ParallelFor(size_t count, size_t min_chunk, ParallelTask task, void *context)
+ *
+ *  Runs task(context, begin, end) over disjoint ranges covering [0, count)
+ *  on the library's persistent thread pool (threadpool.c), with the
+ *  calling thread taking a share. At most GetMatrixThreads() ranges are
+ *  used and none is shorter than min_chunk, so passing min_chunk >= count
+ *  (or any small count) runs the whole loop serially on the caller.
+ *  Calls made from inside a task also run serially.
+ ************************************************************************/
+typedef void (*ParallelTask)(void *context, size_t begin, size_t end);
+
+void ParallelFor(size_t count, size_t min_chunk, ParallelTask task, void *context);
+
+/*************************************************************************
+ * MatrixKernels / matrix_kernels
+ *
+ *  Table of the innermost loops used by the row operations, AddMatrices
+ *  and the GEMM engine. simd.c provides scalar, SSE2, AVX2 and AVX-512
+ *  versions and points matrix_kernels at the widest set the CPU supports
+ *  once, at program startup.
+ *
+ *    axpy       - y = y + alpha * x
+ *    scale      - x = alpha * x
+ *    swap       - exchange x and y
+ *    add        - z = x + beta * y (z may alias x or y)
+ *    dot        - returns the sum of x[i] * y[i]
+ *    gemm_micro - GEMM_MR x GEMM_NR tile = packed A panel * packed B panel
+ *                 over kc steps (tile must be MATRIX_ALIGNMENT aligned)
+ *    transpose_tile - dst = src^T for one TRANSPOSE_TILE x TRANSPOSE_TILE
+ *                 block (src and dst must not overlap)
+ *    swap_reversed - exchange x[i] with y[n-1-i] (x and y must not overlap)
+ ************************************************************************/
+// Register tile of the GEMM micro-kernel (rows of A x columns of B)
+#define GEMM_MR 6
+#define GEMM_NR 8
+// Edge length of the block moved by one transpose_tile call
+#define TRANSPOSE_TILE 8
+
+typedef struct{
+    const char *name;
+    void (*axpy)(size_t n, double alpha, const double *x, double *y);
+    void (*scale)(size_t n, double alpha, double *x);
+    void (*swap)(size_t n, double *x, double *y);
+    void (*add)(size_t n, const double *x, double beta, const double *y, double *z);
+    double (*dot)(size_t n, const double *x, const double *y);
+    void (*gemm_micro)(size_t kc, const double *a, const double *b, double *tile);
+    void (*transpose_tile)(const double *src, size_t lds, double *dst, size_t ldd);
+    void (*swap_reversed)(size_t n, double *x, double *y);
+}MatrixKernels;
+
+extern const MatrixKernels *matrix_kernels;
+
+/*************************************************************************
+ * MatrixKernelsF / matrix_kernels_f
+ *
+ *  The same loops for float32 storage (see MatrixF), generated for every
+ *  instruction set from the vector_kernels.h template. Each register holds
+ *  twice as many values as with doubles, so the GEMM tile is twice as
+ *  wide. matrix_kernels_f always uses the same instruction set as
+ *  matrix_kernels.
+ ************************************************************************/
+#define GEMMF_MR 6
+#define GEMMF_NR 16
+
+typedef struct{
+    const char *name;
+    void (*axpy)(size_t n, float alpha, const float *x, float *y);
+    void (*scale)(size_t n, float alpha, float *x);
+    void (*swap)(size_t n, float *x, float *y);
+    void (*add)(size_t n, const float *x, float beta, const float *y, float *z);
+    float (*dot)(size_t n, const float *x, const float *y);
+    void (*gemm_micro)(size_t kc, const float *a, const float *b, float *tile);
+}MatrixKernelsF;
+
+extern const MatrixKernelsF *matrix_kernels_f;
+
+/*************************************************************************
+ * STATS_BEGIN() / STATS_END(op, flops)
+ * STATS_ALLOCATED(bytes) / STATS_PIVOT_SWAP()
+ *
+ *  Instrumentation behind GetMatrixStats (stats.c). STATS_BEGIN() starts
+ *  the clock in the current scope and STATS_END() records one call of
+ *  entry point op (a MATRIX_STAT_* index) with its FLOP count; the other
+ *  two bump the allocation and pivot counters. Without SMLC_ENABLE_STATS
+ *  all four expand to no-ops and their arguments are not evaluated.
+ ************************************************************************/
+#ifdef SMLC_ENABLE_STATS
+uint64_t StatsClock(void);
+void StatsRecord(int op, uint64_t start, uint64_t flops);
+void StatsAllocated(uint64_t bytes);
+void StatsPivotSwap(void);
+
+#define STATS_BEGIN()           const uint64_t stats_start = StatsClock()
+#define STATS_END(op, flops)    StatsRecord((op), stats_start, (uint64_t)(flops))
+#define STATS_ALLOCATED(bytes)  StatsAllocated((uint64_t)(bytes))
+#define STATS_PIVOT_SWAP()      StatsPivotSwap()
+#else
+#define STATS_BEGIN()           ((void)0)
+#define STATS_END(op, flops)    ((void)sizeof(flops))
+#define STATS_ALLOCATED(bytes)  ((void)0)
+#define STATS_PIVOT_SWAP()      ((void)0)
+#endif
+
+#endif //MATRIX_INTERNAL_H
@@ -0,0 +1,280 @@
+/****************************
+ * Author: Blake A. Molina
+ * Created on: 10/17/26
+ * License: GPL
+ ****************************/
+
+#include <float.h>
+#include "matrix_internal.h"
+
+// Refinement steps SolveMixedPrecision takes before falling back to double
+#define REFINEMENT_STEPS 30
+
+/*******************************************************
+ *          Single-Precision Matrices
+ *******************************************************/
+static int isEmptyF(MatrixF matrix){
+    return !matrix || matrix->num_rows == 0 || matrix->num_cols == 0;
+}
+
+MatrixF NewMatrixF(size_t num_rows, size_t num_cols){
+    const size_t per_line = MATRIX_ALIGNMENT / sizeof(float);
+    size_t ld          = (num_cols + per_line - 1) / per_line * per_line;
+    size_t value_bytes = num_rows * ld * sizeof(float);
+    size_t total_bytes = value_bytes + num_rows * sizeof(float*);
+
+    MatrixF matrix = (MatrixF)malloc(sizeof(matrixf_struct));
+    if(!matrix){
+        fprintf(stderr, "%s", "Error - Could not allocate matrix");
+        return NULL;
+    }
+    // values followed by the row pointer table, as in NewMatrix
+    matrix->data = (float*)AllocateAligned(total_bytes > 0 ? total_bytes : 1);
+    if(!matrix->data){
+        fprintf(stderr, "%s", "Error - Could not allocate matrix");
+        free(matrix);
+        return NULL;
+    }
+    matrix->flags    = MATRIX_OWNS_DATA | MATRIX_OWNS_STRUCT;
+    matrix->num_rows = num_rows;
+    matrix->num_cols = num_cols;
+    matrix->ld       = ld;
+    memset(matrix->data, 0, value_bytes);
+
+    matrix->index = (float**)((char*)matrix->data + value_bytes);
+    for(size_t i = 0; i < num_rows; i++)
+        matrix->index[i] = MATRIXF_ROW(matrix, i);
+    return matrix;
+}
+
+void FreeMatrixF(MatrixF *matrix){
+    if(matrix && *matrix){
+        FreeAligned((*matrix)->data);
+        free(*matrix);
+        *matrix = NULL;
+    }
+}
+
+
+/*******************************************************
+ *          Conversions
+ *******************************************************/
+// Row-by-row copies between the two storage types
+static void NarrowRows(size_t rows, size_t cols, const double *src, size_t lds, float *dst, size_t ldd){
+    for(size_t i = 0; i < rows; i++)
+        for(size_t j = 0; j < cols; j++)
+            dst[i*ldd + j] = (float)src[i*lds + j];
+}
+
+static void WidenRows(size_t rows, size_t cols, const float *src, size_t lds, double *dst, size_t ldd){
+    for(size_t i = 0; i < rows; i++)
+        for(size_t j = 0; j < cols; j++)
+            dst[i*ldd + j] = (double)src[i*lds + j];
+}
+
+MatrixF MatrixToFloat(Matrix matrix){
+    if(isEmpty(matrix))
+        return NULL;
+    MatrixF converted = NewMatrixF(matrix->num_rows, matrix->num_cols);
+    if(converted)
+        NarrowRows(matrix->num_rows, matrix->num_cols, matrix->data, matrix->ld, converted->data, converted->ld);
+    return converted;
+}
+
+Matrix MatrixToDouble(MatrixF matrix){
+    if(isEmptyF(matrix))
+        return NULL;
+    Matrix converted = NewMatrix(matrix->num_rows, matrix->num_cols);
+    if(converted)
+        WidenRows(matrix->num_rows, matrix->num_cols, matrix->data, matrix->ld, converted->data, converted->ld);
+    return converted;
+}
+
+
+/*******************************************************
+ *          Single-Precision Arithmetic
+ *******************************************************/
+MatrixF MultiplyMatricesF(MatrixF matrix_A, MatrixF matrix_B){
+    if(isEmptyF(matrix_A) || isEmptyF(matrix_B) || matrix_A->num_cols != matrix_B->num_rows){
+        fprintf(stderr, "%s", "Error - Matrix A's column count must equal matrix B's row count to multiply");
+        return NULL;
+    }
+    MatrixF result_matrix = NewMatrixF(matrix_A->num_rows, matrix_B->num_cols);
+    if(!result_matrix)
+        return NULL;
+    MultiplyMatricesIntoF(result_matrix, matrix_A, matrix_B);
+    return result_matrix;
+}
+
+int MultiplyMatricesIntoF(MatrixF result_matrix, MatrixF matrix_A, MatrixF matrix_B){
+    if(isEmptyF(matrix_A) || isEmptyF(matrix_B) || isEmptyF(result_matrix) ||
+       matrix_A->num_cols != matrix_B->num_rows ||
+       result_matrix->num_rows != matrix_A->num_rows || result_matrix->num_cols != matrix_B->num_cols){
+        fprintf(stderr, "%s", "Error - Result must be MxP to hold the product of an MxN and an NxP matrix");
+        return -1;
+    }
+    // float matrices have no views, so sharing storage means being the same matrix
+    if(result_matrix == matrix_A || result_matrix == matrix_B){
+        fprintf(stderr, "%s", "Error - Result of a multiplication cannot be one of its operands");
+        return -1;
+    }
+    DenseGemmF(0, 0, matrix_A->num_rows, matrix_B->num_cols, matrix_A->num_cols,
+               1.0f, matrix_A->data, matrix_A->ld, matrix_B->data, matrix_B->ld,
+               0.0f, result_matrix->data, result_matrix->ld);
+    return 0;
+}
+
+int AddMatricesIntoF(MatrixF result_matrix, MatrixF matrix_A, MatrixF matrix_B, int subtract_flag){
+    if(isEmptyF(matrix_A) || isEmptyF(matrix_B) || isEmptyF(result_matrix) ||
+       matrix_A->num_rows != matrix_B->num_rows || matrix_A->num_cols != matrix_B->num_cols ||
+       result_matrix->num_rows != matrix_A->num_rows || result_matrix->num_cols != matrix_A->num_cols){
+        fprintf(stderr, "%s", "Error - Need matrices of the same size to perform matrix addition");
+        return -1;
+    }
+    float beta = subtract_flag == 1 ? -1.0f : 1.0f;
+    for(size_t i = 0; i < matrix_A->num_rows; i++)
+        matrix_kernels_f->add(matrix_A->num_cols, MATRIXF_ROW(matrix_A, i), beta,
+                              MATRIXF_ROW(matrix_B, i), MATRIXF_ROW(result_matrix, i));
+    return 0;
+}
+
+
+/*******************************************************
+ *          Mixed-Precision Solve
+ *******************************************************/
+// residual = rhs - matrix * solution in double precision. Returns the
+// largest relative residual ||r||_2 / ||b||_2 of a column and sets *passed
+// when every column meets the stopping test of SolveMixedPrecision.
+static double Residual(Matrix matrix, Matrix rhs, Matrix solution, Matrix residual,
+                       double matrix_norm, double tolerance, double *norms, int *passed){
+    size_t n = matrix->num_rows, k = rhs->num_cols;
+    for(size_t i = 0; i < n; i++)
+        memcpy(MATRIX_ROW(residual, i), MATRIX_ROW(rhs, i), k * sizeof(double));
+    DenseGemm(0, 0, n, k, n, -1.0, matrix->data, matrix->ld, solution->data, solution->ld,
+              1.0, residual->data, residual->ld);
+
+    // per column: ||r||_inf, ||x||_inf, ||r||_2^2 and ||b||_2^2
+    double *r_max = norms, *x_max = norms + k, *r_sum = norms + 2*k, *b_sum = norms + 3*k;
+    memset(norms, 0, 4 * k * sizeof(double));
+    for(size_t i = 0; i < n; i++){
+        const double *r = MATRIX_ROW(residual, i), *x = MATRIX_ROW(solution, i), *b = MATRIX_ROW(rhs, i);
+        for(size_t j = 0; j < k; j++){
+            r_max[j] = fmax(r_max[j], fabs(r[j]));
+            x_max[j] = fmax(x_max[j], fabs(x[j]));
+            r_sum[j] += r[j] * r[j];
+            b_sum[j] += b[j] * b[j];
+        }
+    }
+    double worst = 0.0;
+    *passed = 1;
+    for(size_t j = 0; j < k; j++){
+        double r_norm = sqrt(r_sum[j]), b_norm = sqrt(b_sum[j]);
+        double relative = b_norm > 0.0 ? r_norm / b_norm : r_norm;
+        if(!(relative <= worst)) // also propagates NaN
+            worst = relative;
+        if(tolerance > 0.0 ? !(r_norm <= tolerance * b_norm)
+                           : !(r_max[j] <= x_max[j] * matrix_norm * sqrt((double)n) * DBL_EPSILON))
+            *passed = 0;
+    }
+    return worst;
+}
+
+int SolveMixedPrecision(Matrix matrix, Matrix rhs, Matrix solution,
+                        const SolverOptions *options, SolverReport *report){
+    if(isEmpty(matrix) || !isSquare(matrix) || isEmpty(rhs) || isEmpty(solution) ||
+       rhs->num_rows != matrix->num_rows || solution->num_rows != rhs->num_rows ||
+       solution->num_cols != rhs->num_cols || solution == matrix || solution == rhs){
+        fprintf(stderr, "%s", "Error - Need an NxN matrix, NxK right-hand sides and a separate NxK solution");
+        return -1;
+    }
+    size_t n = matrix->num_rows, k = rhs->num_cols;
+    size_t max_steps = options && options->max_iterations ? options->max_iterations : REFINEMENT_STEPS;
+    double tolerance = options ? options->tolerance : 0.0;
+    STATS_BEGIN();
+
+    double matrix_norm = 0.0; // ||A||_inf
+    for(size_t i = 0; i < n; i++){
+        const double *row = MATRIX_ROW(matrix, i);
+        double sum = 0.0;
+        for(size_t j = 0; j < n; j++)
+            sum += fabs(row[j]);
+        matrix_norm = fmax(matrix_norm, sum);
+    }
+
+    MatrixF factor = MatrixToFloat(matrix);
+    MatrixF correction = NewMatrixF(n, k);
+    Matrix residual = NewMatrix(n, k);
+    size_t *pivots = (size_t*)malloc(n * sizeof(size_t));
+    double *norms = (double*)malloc(4 * k * sizeof(double));
+    int status = factor && correction && residual && pivots && norms ? 0 : -1;
+
+    size_t steps = 0;
+    int converged = 0, sign;
+    double worst = INFINITY;
+    if(status == 0 && LUFactorDenseF(n, factor->data, factor->ld, pivots, &sign) == 0){
+        // x = A^-1 b with the float factors, then x += A^-1 (b - A*x) while
+        // the residual keeps shrinking
+        NarrowRows(n, k, rhs->data, rhs->ld, correction->data, correction->ld);
+        LUSolveDenseF(n, factor->data, factor->ld, pivots, k, correction->data, correction->ld);
+        WidenRows(n, k, correction->data, correction->ld, solution->data, solution->ld);
+        for(;;){
+            int passed;
+            double previous = worst;
+            worst = Residual(matrix, rhs, solution, residual, matrix_norm, tolerance, norms, &passed);
+            if(passed){
+                converged = 1;
+                break;
+            }
+            if(steps == max_steps || !(worst < previous))
+                break; // out of steps, stalled, or diverging: A is too ill-conditioned for float
+            NarrowRows(n, k, residual->data, residual->ld, correction->data, correction->ld);
+            LUSolveDenseF(n, factor->data, factor->ld, pivots, k, correction->data, correction->ld);
+            for(size_t i = 0; i < n; i++){
+                double *x = MATRIX_ROW(solution, i);
+                const float *d = MATRIXF_ROW(correction, i);
+                for(size_t j = 0; j < k; j++)
+                    x[j] += (double)d[j];
+            }
+            steps++;
+        }
+    }
+    FreeMatrixF(&factor);
+    FreeMatrixF(&correction);
+
+    if(status == 0 && !converged){
+        // factor again in double: the float factors could not deliver
+        Matrix lu = NewMatrix(n, n);
+        status = lu ? 0 : -1;
+        if(lu){
+            for(size_t i = 0; i < n; i++)
+                memcpy(MATRIX_ROW(lu, i), MATRIX_ROW(matrix, i), n * sizeof(double));
+            if(LUFactorDense(n, lu->data, lu->ld, pivots, &sign) != 0){
+                fprintf(stderr, "%s", "Error - Matrix is singular");
+                status = -1;
+            }
+            else{
+                for(size_t i = 0; i < n; i++)
+                    memcpy(MATRIX_ROW(solution, i), MATRIX_ROW(rhs, i), k * sizeof(double));
+                LUSolveDense(n, lu->data, lu->ld, pivots, k, solution->data, solution->ld);
+                int passed;
+                worst = Residual(matrix, rhs, solution, residual, matrix_norm, tolerance, norms, &passed);
+                status = 1;
+            }
+            FreeMatrix(&lu);
+        }
+    }
+    else if(status != 0)
+        fprintf(stderr, "%s", "Error - Could not allocate memory for mixed-precision solve");
+    FreeMatrix(&residual);
+    free(pivots);
+    free(norms);
+
+    if(report){
+        report->iterations = steps;
+        report->residual = worst;
+        report->converged = converged;
+    }
+    // factorization(s), plus a residual and a solve per refinement step
+    STATS_END(MATRIX_STAT_MIXED_SOLVE, (converged ? 1.0 : 2.0) * 2.0 * n * n * n / 3 + (steps + 1) * 4.0 * n * n * k);
+    return status;
+}
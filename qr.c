@@ -0,0 +1,410 @@
+/****************************
+ * Author: Blake A. Molina
+ * Created on: 10/17/26
+ * License: GPL
+ ****************************/
+
+#include <float.h>
+#include "matrix_internal.h"
+
+// Columns factored per panel before the trailing matrix is updated with GEMM
+#define QR_BLOCK 32
+
+/*************************************************************************
+ *  The factorization works on W = A^T (row-major), so column j of A is the
+ *  contiguous row j of W and every Householder step is a dot or axpy over
+ *  rows. Panels follow LAPACK's xLAQPS: the pivot column is updated with
+ *  the panel's earlier reflectors just before it is reduced, the trailing
+ *  matrix only once per panel through F (A22 -= V * F^T, or W22 -= F * V^T
+ *  here), and the remaining column norms are downdated, with a norm that
+ *  has lost too many digits recomputed at the end of the panel.
+ ************************************************************************/
+
+/*******************************************************
+ *          Householder Kernels
+ *******************************************************/
+// 2-norm of x, rescaled when the plain sum of squares over- or underflows
+static double Norm2(size_t n, const double *x){
+    double sum = matrix_kernels->dot(n, x, x);
+    if(sum < DBL_MAX && (sum > DBL_MIN || sum == 0.0))
+        return sqrt(sum);
+    double scale = 0.0;
+    for(size_t i = 0; i < n; i++)
+        scale = fabs(x[i]) > scale ? fabs(x[i]) : scale;
+    if(scale == 0.0 || scale != scale)
+        return scale;
+    sum = 0.0;
+    for(size_t i = 0; i < n; i++)
+        sum += (x[i] / scale) * (x[i] / scale);
+    return scale * sqrt(sum);
+}
+
+double HouseholderReflector(size_t n, double *x){
+    double tail = n > 1 ? Norm2(n - 1, x + 1) : 0.0;
+    if(tail == 0.0)
+        return 0.0;
+    double alpha = x[0];
+    double beta = -copysign(hypot(alpha, tail), alpha);
+    matrix_kernels->scale(n - 1, 1.0 / (alpha - beta), x + 1);
+    x[0] = beta;
+    return (beta - alpha) / beta;
+}
+
+
+/*******************************************************
+ *          Pivoted Panel Factorization
+ *******************************************************/
+typedef struct{
+    double *w, *f;
+    size_t ldw, ldf;
+    size_t pivot, row, length;  // pivot column, its row, rows left below it
+    size_t first, start;        // first trailing column, first column of the panel
+    double tau;
+}PanelColumnJob;
+
+// F[j - start, k] = tau * A(row:m, j)^T * v for trailing columns j
+static void PanelColumnTask(void *context, size_t begin, size_t end){
+    const PanelColumnJob *job = (const PanelColumnJob*)context;
+    const double *v = job->w + job->pivot * job->ldw + job->row;
+    for(size_t j = job->first + begin; j < job->first + end; j++)
+        job->f[(j - job->start) * job->ldf] = job->tau * matrix_kernels->dot(job->length, job->w + j * job->ldw + job->row, v);
+}
+
+// Factors up to QR_BLOCK columns of W (num_cols x num_rows) starting at
+// column start, pivoting on the largest remaining norm1 (norm2 holds the
+// norms the downdates are measured against). Returns the columns done.
+static size_t FactorPanel(double *w, size_t ldw, size_t num_rows, size_t num_cols, size_t start,
+                          double *tau, size_t *permutation, double *norm1, double *norm2, double *f, double *work){
+    const double tolerance = sqrt(DBL_EPSILON);
+    const size_t last_row = num_rows < num_cols ? num_rows : num_cols;
+    const size_t ldf = QR_BLOCK;
+    size_t width = num_cols - start < QR_BLOCK ? num_cols - start : QR_BLOCK;
+    if(width > num_rows - start)
+        width = num_rows - start;
+    int stale = 0;  // a norm was marked for recomputation (norm2 < 0)
+    size_t k = 0;
+    while(k < width && !stale){
+        const size_t column = start + k, row = column;  // factoring row `row` of A
+        double *w_k = w + column * ldw;
+
+        size_t pivot = column;
+        for(size_t j = column + 1; j < num_cols; j++)
+            if(norm1[j] > norm1[pivot])
+                pivot = j;
+        if(pivot != column){
+            matrix_kernels->swap(num_rows, w + pivot * ldw, w_k);
+            matrix_kernels->swap(k, f + (pivot - start) * ldf, f + k * ldf);
+            size_t index = permutation[pivot];
+            permutation[pivot] = permutation[column];
+            permutation[column] = index;
+            norm1[pivot] = norm1[column];
+            norm2[pivot] = norm2[column];
+        }
+
+        // bring the pivot column up to date with the panel's reflectors
+        for(size_t c = 0; c < k; c++)
+            matrix_kernels->axpy(num_rows - row, -f[k * ldf + c], w + (start + c) * ldw + row, w_k + row);
+
+        tau[column] = HouseholderReflector(num_rows - row, w_k + row);
+        const double diagonal = w_k[row];
+        w_k[row] = 1.0;
+
+        // column k of F: tau * A(row:m, trailing)^T * v, corrected for the
+        // panel's earlier reflectors
+        PanelColumnJob job = {w, f + k, ldw, ldf, column, row, num_rows - row, column + 1, start, tau[column]};
+        size_t trailing = num_cols - column - 1;
+        ParallelFor(trailing, trailing * (num_rows - row) >= 65536 ? 1 : trailing + 1, PanelColumnTask, &job);
+        for(size_t i = 0; i <= k; i++)
+            f[i * ldf + k] = 0.0;
+        if(k > 0){
+            for(size_t c = 0; c < k; c++)
+                work[c] = -tau[column] * matrix_kernels->dot(num_rows - row, w + (start + c) * ldw + row, w_k + row);
+            for(size_t i = 0; i < num_cols - start; i++)
+                f[i * ldf + k] += matrix_kernels->dot(k, f + i * ldf, work);
+        }
+
+        // update row `row` of the trailing columns: A(row, j) -= A(row, panel) * F(j, :)^T
+        for(size_t c = 0; c <= k; c++)
+            work[c] = w[(start + c) * ldw + row];
+        for(size_t j = column + 1; j < num_cols; j++)
+            w[j * ldw + row] -= matrix_kernels->dot(k + 1, work, f + (j - start) * ldf);
+
+        // downdate the trailing norms by the entry just moved into R
+        if(row + 1 < last_row){
+            for(size_t j = column + 1; j < num_cols; j++){
+                if(norm1[j] == 0.0)
+                    continue;
+                double ratio = fabs(w[j * ldw + row]) / norm1[j];
+                ratio = (1.0 + ratio) * (1.0 - ratio);
+                ratio = ratio > 0.0 ? ratio : 0.0;
+                double relative = norm1[j] / norm2[j];
+                if(ratio * relative * relative <= tolerance){
+                    norm2[j] = -1.0;
+                    stale = 1;
+                }
+                else
+                    norm1[j] *= sqrt(ratio);
+            }
+        }
+        w_k[row] = diagonal;
+        k++;
+    }
+
+    // trailing matrix: W22 -= F2 * V2^T
+    size_t next = start + k;
+    if(next < num_cols && next < num_rows)
+        DenseGemm(0, 0, num_cols - next, num_rows - next, k, -1.0, f + k * ldf, ldf,
+                  w + start * ldw + next, ldw, 1.0, w + next * ldw + next, ldw);
+
+    for(size_t j = next; stale && j < num_cols; j++){
+        if(norm2[j] < 0.0){
+            norm1[j] = next < num_rows ? Norm2(num_rows - next, w + j * ldw + next) : 0.0;
+            norm2[j] = norm1[j];
+        }
+    }
+    return k;
+}
+
+
+/*******************************************************
+ *          QR Factorization Objects
+ *******************************************************/
+QRFactorization QRFactor(Matrix matrix, double tolerance){
+    if(isEmpty(matrix))
+        return NULL;
+    size_t m = matrix->num_rows, n = matrix->num_cols, steps = m < n ? m : n;
+    STATS_BEGIN();
+    QRFactorization factor = (QRFactorization)calloc(1, sizeof(qr_struct));
+    if(!factor)
+        return NULL;
+    // the factor outlives any arena scope the caller is in
+    MatrixArena previous = UseMatrixArena(NULL);
+    factor->qr = NewMatrix(n, m);
+    UseMatrixArena(previous);
+    factor->tau = (double*)malloc(steps * sizeof(double));
+    factor->permutation = (size_t*)malloc(n * sizeof(size_t));
+    double *norms = (double*)malloc((2 * n + QR_BLOCK) * sizeof(double));
+    double *f = (double*)AllocateAligned(n * QR_BLOCK * sizeof(double));
+    if(!factor->qr || !factor->tau || !factor->permutation || !norms || !f){
+        fprintf(stderr, "%s", "Error - Could not allocate memory for QR factorization");
+        free(norms);
+        FreeAligned(f);
+        FreeQRFactorization(&factor);
+        return NULL;
+    }
+    factor->num_rows = m;
+    factor->num_cols = n;
+    TransposeInto(matrix, factor->qr);
+    double *norm1 = norms, *norm2 = norms + n, *work = norms + 2 * n;
+    for(size_t j = 0; j < n; j++){
+        factor->permutation[j] = j;
+        norm1[j] = norm2[j] = Norm2(m, MATRIX_ROW(factor->qr, j));
+    }
+    for(size_t j = 0; j < steps; )
+        j += FactorPanel(factor->qr->data, factor->qr->ld, m, n, j, factor->tau,
+                         factor->permutation, norm1, norm2, f, work);
+    free(norms);
+    FreeAligned(f);
+
+    // pivoting keeps |R[i][i]| non-increasing, so the rank is a prefix
+    factor->tolerance = tolerance > 0.0 ? tolerance : (double)(m > n ? m : n) * DBL_EPSILON;
+    double threshold = factor->tolerance * fabs(MATRIX_AT(factor->qr, 0, 0));
+    while(factor->rank < steps && fabs(MATRIX_AT(factor->qr, factor->rank, factor->rank)) > threshold)
+        factor->rank++;
+    STATS_END(MATRIX_STAT_QR, 4.0 * m * n * steps - 2.0 * (m + n) * steps * steps + 4.0 * steps * steps * steps / 3);
+    return factor;
+}
+
+void FreeQRFactorization(QRFactorization *factor){
+    if(factor && *factor){
+        FreeMatrix(&(*factor)->qr);
+        free((*factor)->tau);
+        free((*factor)->permutation);
+        free(*factor);
+        *factor = NULL;
+    }
+}
+
+int QRSolveInto(Matrix solution, QRFactorization factor, Matrix rhs){
+    if(!factor || isEmpty(rhs) || isEmpty(solution) || rhs->num_rows != factor->num_rows ||
+       solution->num_rows != factor->num_cols || solution->num_cols != rhs->num_cols){
+        fprintf(stderr, "%s", "Error - Right-hand side must have the factored matrix's rows and the solution its columns");
+        return -1;
+    }
+    size_t m = factor->num_rows, k = rhs->num_cols, rank = factor->rank;
+    STATS_BEGIN();
+    Matrix c = NewMatrix(m, k);
+    double *projection = (double*)malloc(k * sizeof(double));
+    if(!c || !projection){
+        fprintf(stderr, "%s", "Error - Could not allocate memory for least squares solve");
+        FreeMatrix(&c);
+        free(projection);
+        return -1;
+    }
+    for(size_t i = 0; i < m; i++)
+        memcpy(MATRIX_ROW(c, i), MATRIX_ROW(rhs, i), k * sizeof(double));
+
+    // C = Q^T * rhs, one reflector at a time (only the first rank rows are used)
+    for(size_t j = 0; j < rank; j++){
+        const double *v = MATRIX_ROW(factor->qr, j);
+        memcpy(projection, MATRIX_ROW(c, j), k * sizeof(double));
+        for(size_t i = j + 1; i < m; i++)
+            matrix_kernels->axpy(k, v[i], MATRIX_ROW(c, i), projection);
+        matrix_kernels->scale(k, -factor->tau[j], projection);
+        matrix_kernels->axpy(k, 1.0, projection, MATRIX_ROW(c, j));
+        for(size_t i = j + 1; i < m; i++)
+            matrix_kernels->axpy(k, v[i], projection, MATRIX_ROW(c, i));
+    }
+    // R11 * Y = C(0:rank), column by column of R (row j of the factor)
+    for(size_t j = rank; j-- > 0; ){
+        const double *r_column = MATRIX_ROW(factor->qr, j);
+        matrix_kernels->scale(k, 1.0 / r_column[j], MATRIX_ROW(c, j));
+        for(size_t i = 0; i < j; i++)
+            matrix_kernels->axpy(k, -r_column[i], MATRIX_ROW(c, j), MATRIX_ROW(c, i));
+    }
+    // X = P * [Y; 0]
+    for(size_t j = 0; j < factor->num_cols; j++){
+        double *x_row = MATRIX_ROW(solution, factor->permutation[j]);
+        if(j < rank)
+            memcpy(x_row, MATRIX_ROW(c, j), k * sizeof(double));
+        else
+            memset(x_row, 0, k * sizeof(double));
+    }
+    FreeMatrix(&c);
+    free(projection);
+    STATS_END(MATRIX_STAT_QR, 4.0 * m * rank * k);
+    return 0;
+}
+
+Matrix QRSolve(QRFactorization factor, Matrix rhs){
+    if(!factor || isEmpty(rhs))
+        return NULL;
+    Matrix solution = NewMatrix(factor->num_cols, rhs->num_cols);
+    if(solution && QRSolveInto(solution, factor, rhs) != 0)
+        FreeMatrix(&solution);
+    return solution;
+}
+
+Matrix LeastSquares(Matrix matrix, Matrix rhs){
+    if(isEmpty(matrix) || isEmpty(rhs) || rhs->num_rows != matrix->num_rows){
+        fprintf(stderr, "%s", "Error - Right-hand side must have as many rows as the matrix");
+        return NULL;
+    }
+    QRFactorization factor = QRFactor(matrix, 0.0);
+    Matrix solution = QRSolve(factor, rhs);
+    FreeQRFactorization(&factor);
+    return solution;
+}
+
+size_t MatrixRank(Matrix matrix, double tolerance){
+    QRFactorization factor = QRFactor(matrix, tolerance);
+    size_t rank = factor ? factor->rank : 0;
+    FreeQRFactorization(&factor);
+    return rank;
+}
+
+
+/*******************************************************
+ *          Incremental Rank Tracking
+ *******************************************************/
+struct rank_tracker_struct{
+    double *basis;        // rank orthonormal rows of length num_rows, ld apart
+    double *residual;     // the column being appended
+    size_t num_rows, ld;
+    size_t rank, capacity;
+    double tolerance;
+};
+
+RankTracker NewRankTracker(size_t num_rows, double tolerance){
+    if(num_rows == 0)
+        return NULL;
+    RankTracker tracker = (RankTracker)calloc(1, sizeof(struct rank_tracker_struct));
+    if(tracker){
+        tracker->num_rows = num_rows;
+        tracker->ld = (num_rows + 7) & ~(size_t)7;
+        tracker->tolerance = tolerance > 0.0 ? tolerance : (double)(num_rows > 16 ? num_rows : 16) * DBL_EPSILON;
+        tracker->residual = (double*)AllocateAligned(tracker->ld * sizeof(double));
+    }
+    if(!tracker || !tracker->residual){
+        fprintf(stderr, "%s", "Error - Could not allocate rank tracker");
+        FreeRankTracker(&tracker);
+    }
+    return tracker;
+}
+
+void FreeRankTracker(RankTracker *tracker){
+    if(tracker && *tracker){
+        FreeAligned((*tracker)->basis);
+        FreeAligned((*tracker)->residual);
+        free(*tracker);
+        *tracker = NULL;
+    }
+}
+
+size_t RankTrackerRank(RankTracker tracker){
+    return tracker ? tracker->rank : 0;
+}
+
+// Orthogonalizes tracker->residual against the basis (classical Gram-Schmidt
+// run twice, which is enough to keep the basis orthogonal to working
+// precision) and adds it if what is left is above the tolerance
+static int AppendResidual(RankTracker tracker){
+    size_t n = tracker->num_rows;
+    double *r = tracker->residual;
+    double original = Norm2(n, r);
+    if(original == 0.0 || tracker->rank == n)
+        return 0;
+    for(int pass = 0; pass < 2; pass++){
+        for(size_t i = 0; i < tracker->rank; i++){
+            const double *q = tracker->basis + i * tracker->ld;
+            matrix_kernels->axpy(n, -matrix_kernels->dot(n, q, r), q, r);
+        }
+    }
+    double remaining = Norm2(n, r);
+    if(!(remaining > tracker->tolerance * original))
+        return 0;
+    if(tracker->rank == tracker->capacity){
+        size_t capacity = tracker->capacity ? tracker->capacity * 2 : 16;
+        if(capacity > n)
+            capacity = n;
+        double *grown = (double*)AllocateAligned(capacity * tracker->ld * sizeof(double));
+        if(!grown){
+            fprintf(stderr, "%s", "Error - Could not grow rank tracker");
+            return -1;
+        }
+        if(tracker->rank > 0)
+            memcpy(grown, tracker->basis, tracker->rank * tracker->ld * sizeof(double));
+        FreeAligned(tracker->basis);
+        tracker->basis = grown;
+        tracker->capacity = capacity;
+    }
+    double *q = tracker->basis + tracker->rank * tracker->ld;
+    for(size_t i = 0; i < n; i++)
+        q[i] = r[i] / remaining;
+    tracker->rank++;
+    return 1;
+}
+
+int RankTrackerAppend(RankTracker tracker, const double *column){
+    if(!tracker || !column)
+        return -1;
+    memcpy(tracker->residual, column, tracker->num_rows * sizeof(double));
+    return AppendResidual(tracker);
+}
+
+int RankTrackerAppendColumns(RankTracker tracker, Matrix columns){
+    if(!tracker || isEmpty(columns) || columns->num_rows != tracker->num_rows){
+        fprintf(stderr, "%s", "Error - Columns must have as many rows as the tracker");
+        return -1;
+    }
+    int added = 0;
+    for(size_t j = 0; j < columns->num_cols; j++){
+        for(size_t i = 0; i < columns->num_rows; i++)
+            tracker->residual[i] = MATRIX_AT(columns, i, j);
+        int status = AppendResidual(tracker);
+        if(status < 0)
+            return -1;
+        added += status;
+    }
+    return added;
+}
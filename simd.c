@@ -0,0 +1,586 @@
+/****************************
+ * Author: Blake A. Molina
+ * Created on: 10/17/26
+ * License: GPL
+ ****************************/
+
+#include "matrix_internal.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define MATRIX_X86_DISPATCH 1
+#include <immintrin.h>
+#endif
+
+/*******************************************************
+ *          Scalar Kernels (portable fallback)
+ *******************************************************/
+static void AxpyScalar(size_t n, double alpha, const double *restrict x, double *restrict y){
+    for(size_t i = 0; i < n; i++)
+        y[i] += alpha * x[i];
+}
+
+static void ScaleScalar(size_t n, double alpha, double *x){
+    for(size_t i = 0; i < n; i++)
+        x[i] *= alpha;
+}
+
+static void SwapScalar(size_t n, double *restrict x, double *restrict y){
+    for(size_t i = 0; i < n; i++){
+        double temp = x[i];
+        x[i] = y[i];
+        y[i] = temp;
+    }
+}
+
+static void AddScalar(size_t n, const double *x, double beta, const double *y, double *z){
+    for(size_t i = 0; i < n; i++)
+        z[i] = x[i] + beta * y[i];
+}
+
+static double DotScalar(size_t n, const double *x, const double *y){
+    // four partial sums break the dependency chain of a single accumulator
+    double s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+    size_t i = 0;
+    for(; i + 4 <= n; i += 4){
+        s0 += x[i] * y[i];
+        s1 += x[i+1] * y[i+1];
+        s2 += x[i+2] * y[i+2];
+        s3 += x[i+3] * y[i+3];
+    }
+    for(; i < n; i++)
+        s0 += x[i] * y[i];
+    return (s0 + s1) + (s2 + s3);
+}
+
+// Portable GEMM_MR x GEMM_NR micro-kernel. The accumulators are a fixed-size
+// local array so the compiler can keep them in registers for the whole loop.
+static void GemmMicroScalar(size_t kc, const double *restrict a, const double *restrict b,
+                            double *restrict tile){
+    double acc[GEMM_MR][GEMM_NR] = {{0}};
+    for(size_t p = 0; p < kc; p++){
+        for(int i = 0; i < GEMM_MR; i++){
+            const double a_value = a[i];
+            for(int j = 0; j < GEMM_NR; j++)
+                acc[i][j] += a_value * b[j];
+        }
+        a += GEMM_MR;
+        b += GEMM_NR;
+    }
+    for(int i = 0; i < GEMM_MR; i++)
+        for(int j = 0; j < GEMM_NR; j++)
+            tile[i*GEMM_NR + j] = acc[i][j];
+}
+
+static void TransposeTileScalar(const double *restrict src, size_t lds, double *restrict dst, size_t ldd){
+    for(size_t i = 0; i < TRANSPOSE_TILE; i++)
+        for(size_t j = 0; j < TRANSPOSE_TILE; j++)
+            dst[j*ldd + i] = src[i*lds + j];
+}
+
+static void SwapReversedScalar(size_t n, double *restrict x, double *restrict y){
+    for(size_t i = 0; i < n; i++){
+        double temp = x[i];
+        x[i] = y[n-1-i];
+        y[n-1-i] = temp;
+    }
+}
+
+static const MatrixKernels scalar_kernels = {
+    "scalar", AxpyScalar, ScaleScalar, SwapScalar, AddScalar, DotScalar, GemmMicroScalar,
+    TransposeTileScalar, SwapReversedScalar
+};
+
+
+/*******************************************************
+ *          Float32 Kernels (from vector_kernels.h)
+ *******************************************************/
+// Products and sums are fused into FMAs where the target has them, as the
+// hand-written double kernels do
+#pragma GCC push_options
+#pragma GCC optimize("fp-contract=fast")
+#define REAL float
+#define KERNEL_TABLE MatrixKernelsF
+#define KERNEL_MR GEMMF_MR
+#define KERNEL_NR GEMMF_NR
+
+#define KERNEL_ISA scalar
+#define LANES 1
+#include "vector_kernels.h"
+
+#ifdef MATRIX_X86_DISPATCH
+#pragma GCC push_options
+#pragma GCC target("sse2")
+#define KERNEL_ISA sse2
+#define LANES 4
+#include "vector_kernels.h"
+#pragma GCC pop_options
+
+#pragma GCC push_options
+#pragma GCC target("avx2,fma")
+#define KERNEL_ISA avx2
+#define LANES 8
+#include "vector_kernels.h"
+#pragma GCC pop_options
+
+#pragma GCC push_options
+#pragma GCC target("avx512f")
+#define KERNEL_ISA avx512
+#define LANES 16
+#include "vector_kernels.h"
+#pragma GCC pop_options
+#endif
+
+#undef REAL
+#undef KERNEL_TABLE
+#undef KERNEL_MR
+#undef KERNEL_NR
+#pragma GCC pop_options
+
+#ifdef MATRIX_X86_DISPATCH
+
+/*******************************************************
+ *          SSE2 Kernels (2 doubles per register)
+ *******************************************************/
+__attribute__((target("sse2")))
+static void AxpySSE2(size_t n, double alpha, const double *restrict x, double *restrict y){
+    const __m128d a = _mm_set1_pd(alpha);
+    size_t i = 0;
+    for(; i + 4 <= n; i += 4){
+        __m128d y0 = _mm_add_pd(_mm_loadu_pd(y + i),     _mm_mul_pd(a, _mm_loadu_pd(x + i)));
+        __m128d y1 = _mm_add_pd(_mm_loadu_pd(y + i + 2), _mm_mul_pd(a, _mm_loadu_pd(x + i + 2)));
+        _mm_storeu_pd(y + i, y0);
+        _mm_storeu_pd(y + i + 2, y1);
+    }
+    for(; i < n; i++)
+        y[i] += alpha * x[i];
+}
+
+__attribute__((target("sse2")))
+static void ScaleSSE2(size_t n, double alpha, double *x){
+    const __m128d a = _mm_set1_pd(alpha);
+    size_t i = 0;
+    for(; i + 4 <= n; i += 4){
+        _mm_storeu_pd(x + i,     _mm_mul_pd(a, _mm_loadu_pd(x + i)));
+        _mm_storeu_pd(x + i + 2, _mm_mul_pd(a, _mm_loadu_pd(x + i + 2)));
+    }
+    for(; i < n; i++)
+        x[i] *= alpha;
+}
+
+__attribute__((target("sse2")))
+static void SwapSSE2(size_t n, double *restrict x, double *restrict y){
+    size_t i = 0;
+    for(; i + 2 <= n; i += 2){
+        __m128d x0 = _mm_loadu_pd(x + i);
+        __m128d y0 = _mm_loadu_pd(y + i);
+        _mm_storeu_pd(x + i, y0);
+        _mm_storeu_pd(y + i, x0);
+    }
+    for(; i < n; i++){
+        double temp = x[i];
+        x[i] = y[i];
+        y[i] = temp;
+    }
+}
+
+__attribute__((target("sse2")))
+static void AddSSE2(size_t n, const double *x, double beta, const double *y, double *z){
+    const __m128d b = _mm_set1_pd(beta);
+    size_t i = 0;
+    for(; i + 2 <= n; i += 2)
+        _mm_storeu_pd(z + i, _mm_add_pd(_mm_loadu_pd(x + i), _mm_mul_pd(b, _mm_loadu_pd(y + i))));
+    for(; i < n; i++)
+        z[i] = x[i] + beta * y[i];
+}
+
+__attribute__((target("sse2")))
+static double DotSSE2(size_t n, const double *x, const double *y){
+    __m128d s0 = _mm_setzero_pd(), s1 = _mm_setzero_pd();
+    size_t i = 0;
+    for(; i + 4 <= n; i += 4){
+        s0 = _mm_add_pd(s0, _mm_mul_pd(_mm_loadu_pd(x + i),     _mm_loadu_pd(y + i)));
+        s1 = _mm_add_pd(s1, _mm_mul_pd(_mm_loadu_pd(x + i + 2), _mm_loadu_pd(y + i + 2)));
+    }
+    double lanes[2];
+    _mm_storeu_pd(lanes, _mm_add_pd(s0, s1));
+    double sum = lanes[0] + lanes[1];
+    for(; i < n; i++)
+        sum += x[i] * y[i];
+    return sum;
+}
+
+// 8x8 transpose as sixteen 2x2 register transposes
+__attribute__((target("sse2")))
+static void TransposeTileSSE2(const double *restrict src, size_t lds, double *restrict dst, size_t ldd){
+    for(size_t i = 0; i < TRANSPOSE_TILE; i += 2){
+        for(size_t j = 0; j < TRANSPOSE_TILE; j += 2){
+            __m128d r0 = _mm_loadu_pd(src + i*lds + j);
+            __m128d r1 = _mm_loadu_pd(src + (i + 1)*lds + j);
+            _mm_storeu_pd(dst + j*ldd + i,       _mm_unpacklo_pd(r0, r1));
+            _mm_storeu_pd(dst + (j + 1)*ldd + i, _mm_unpackhi_pd(r0, r1));
+        }
+    }
+}
+
+__attribute__((target("sse2")))
+static void SwapReversedSSE2(size_t n, double *restrict x, double *restrict y){
+    size_t i = 0;
+    for(; i + 2 <= n; i += 2){
+        __m128d x0 = _mm_loadu_pd(x + i);
+        __m128d y0 = _mm_loadu_pd(y + n - i - 2);
+        _mm_storeu_pd(x + i,         _mm_shuffle_pd(y0, y0, 1));
+        _mm_storeu_pd(y + n - i - 2, _mm_shuffle_pd(x0, x0, 1));
+    }
+    for(; i < n; i++){
+        double temp = x[i];
+        x[i] = y[n-1-i];
+        y[n-1-i] = temp;
+    }
+}
+
+static const MatrixKernels sse2_kernels = {
+    "sse2", AxpySSE2, ScaleSSE2, SwapSSE2, AddSSE2, DotSSE2, GemmMicroScalar,
+    TransposeTileSSE2, SwapReversedSSE2
+};
+
+
+/*******************************************************
+ *          AVX2 + FMA Kernels (4 doubles per register)
+ *******************************************************/
+__attribute__((target("avx2,fma")))
+static void AxpyAVX2(size_t n, double alpha, const double *restrict x, double *restrict y){
+    const __m256d a = _mm256_set1_pd(alpha);
+    size_t i = 0;
+    for(; i + 8 <= n; i += 8){
+        __m256d y0 = _mm256_fmadd_pd(a, _mm256_loadu_pd(x + i),     _mm256_loadu_pd(y + i));
+        __m256d y1 = _mm256_fmadd_pd(a, _mm256_loadu_pd(x + i + 4), _mm256_loadu_pd(y + i + 4));
+        _mm256_storeu_pd(y + i, y0);
+        _mm256_storeu_pd(y + i + 4, y1);
+    }
+    for(; i < n; i++)
+        y[i] += alpha * x[i];
+}
+
+__attribute__((target("avx2,fma")))
+static void ScaleAVX2(size_t n, double alpha, double *x){
+    const __m256d a = _mm256_set1_pd(alpha);
+    size_t i = 0;
+    for(; i + 8 <= n; i += 8){
+        _mm256_storeu_pd(x + i,     _mm256_mul_pd(a, _mm256_loadu_pd(x + i)));
+        _mm256_storeu_pd(x + i + 4, _mm256_mul_pd(a, _mm256_loadu_pd(x + i + 4)));
+    }
+    for(; i < n; i++)
+        x[i] *= alpha;
+}
+
+__attribute__((target("avx2,fma")))
+static void SwapAVX2(size_t n, double *restrict x, double *restrict y){
+    size_t i = 0;
+    for(; i + 4 <= n; i += 4){
+        __m256d x0 = _mm256_loadu_pd(x + i);
+        __m256d y0 = _mm256_loadu_pd(y + i);
+        _mm256_storeu_pd(x + i, y0);
+        _mm256_storeu_pd(y + i, x0);
+    }
+    for(; i < n; i++){
+        double temp = x[i];
+        x[i] = y[i];
+        y[i] = temp;
+    }
+}
+
+__attribute__((target("avx2,fma")))
+static void AddAVX2(size_t n, const double *x, double beta, const double *y, double *z){
+    const __m256d b = _mm256_set1_pd(beta);
+    size_t i = 0;
+    for(; i + 4 <= n; i += 4)
+        _mm256_storeu_pd(z + i, _mm256_fmadd_pd(b, _mm256_loadu_pd(y + i), _mm256_loadu_pd(x + i)));
+    for(; i < n; i++)
+        z[i] = x[i] + beta * y[i];
+}
+
+// 6x8 tile in 12 ymm accumulators: two B vectors per k step, one broadcast of A per row
+__attribute__((target("avx2,fma")))
+static void GemmMicroAVX2(size_t kc, const double *restrict a, const double *restrict b,
+                          double *restrict tile){
+    __m256d c00 = _mm256_setzero_pd(), c01 = _mm256_setzero_pd();
+    __m256d c10 = _mm256_setzero_pd(), c11 = _mm256_setzero_pd();
+    __m256d c20 = _mm256_setzero_pd(), c21 = _mm256_setzero_pd();
+    __m256d c30 = _mm256_setzero_pd(), c31 = _mm256_setzero_pd();
+    __m256d c40 = _mm256_setzero_pd(), c41 = _mm256_setzero_pd();
+    __m256d c50 = _mm256_setzero_pd(), c51 = _mm256_setzero_pd();
+    for(size_t p = 0; p < kc; p++){
+        const __m256d b0 = _mm256_load_pd(b);
+        const __m256d b1 = _mm256_load_pd(b + 4);
+        __m256d a_value;
+        a_value = _mm256_broadcast_sd(a + 0); c00 = _mm256_fmadd_pd(a_value, b0, c00); c01 = _mm256_fmadd_pd(a_value, b1, c01);
+        a_value = _mm256_broadcast_sd(a + 1); c10 = _mm256_fmadd_pd(a_value, b0, c10); c11 = _mm256_fmadd_pd(a_value, b1, c11);
+        a_value = _mm256_broadcast_sd(a + 2); c20 = _mm256_fmadd_pd(a_value, b0, c20); c21 = _mm256_fmadd_pd(a_value, b1, c21);
+        a_value = _mm256_broadcast_sd(a + 3); c30 = _mm256_fmadd_pd(a_value, b0, c30); c31 = _mm256_fmadd_pd(a_value, b1, c31);
+        a_value = _mm256_broadcast_sd(a + 4); c40 = _mm256_fmadd_pd(a_value, b0, c40); c41 = _mm256_fmadd_pd(a_value, b1, c41);
+        a_value = _mm256_broadcast_sd(a + 5); c50 = _mm256_fmadd_pd(a_value, b0, c50); c51 = _mm256_fmadd_pd(a_value, b1, c51);
+        a += GEMM_MR;
+        b += GEMM_NR;
+    }
+    _mm256_store_pd(tile + 0*GEMM_NR, c00); _mm256_store_pd(tile + 0*GEMM_NR + 4, c01);
+    _mm256_store_pd(tile + 1*GEMM_NR, c10); _mm256_store_pd(tile + 1*GEMM_NR + 4, c11);
+    _mm256_store_pd(tile + 2*GEMM_NR, c20); _mm256_store_pd(tile + 2*GEMM_NR + 4, c21);
+    _mm256_store_pd(tile + 3*GEMM_NR, c30); _mm256_store_pd(tile + 3*GEMM_NR + 4, c31);
+    _mm256_store_pd(tile + 4*GEMM_NR, c40); _mm256_store_pd(tile + 4*GEMM_NR + 4, c41);
+    _mm256_store_pd(tile + 5*GEMM_NR, c50); _mm256_store_pd(tile + 5*GEMM_NR + 4, c51);
+}
+
+__attribute__((target("avx2,fma")))
+static double DotAVX2(size_t n, const double *x, const double *y){
+    __m256d s0 = _mm256_setzero_pd(), s1 = _mm256_setzero_pd();
+    size_t i = 0;
+    for(; i + 8 <= n; i += 8){
+        s0 = _mm256_fmadd_pd(_mm256_loadu_pd(x + i),     _mm256_loadu_pd(y + i),     s0);
+        s1 = _mm256_fmadd_pd(_mm256_loadu_pd(x + i + 4), _mm256_loadu_pd(y + i + 4), s1);
+    }
+    double lanes[4];
+    _mm256_storeu_pd(lanes, _mm256_add_pd(s0, s1));
+    double sum = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+    for(; i < n; i++)
+        sum += x[i] * y[i];
+    return sum;
+}
+
+// 8x8 transpose as four 4x4 register transposes (unpack, then swap 128-bit halves)
+__attribute__((target("avx2,fma")))
+static void TransposeTileAVX2(const double *restrict src, size_t lds, double *restrict dst, size_t ldd){
+    for(size_t i = 0; i < TRANSPOSE_TILE; i += 4){
+        for(size_t j = 0; j < TRANSPOSE_TILE; j += 4){
+            const double *s = src + i*lds + j;
+            __m256d r0 = _mm256_loadu_pd(s);
+            __m256d r1 = _mm256_loadu_pd(s + lds);
+            __m256d r2 = _mm256_loadu_pd(s + 2*lds);
+            __m256d r3 = _mm256_loadu_pd(s + 3*lds);
+            __m256d t0 = _mm256_unpacklo_pd(r0, r1);
+            __m256d t1 = _mm256_unpackhi_pd(r0, r1);
+            __m256d t2 = _mm256_unpacklo_pd(r2, r3);
+            __m256d t3 = _mm256_unpackhi_pd(r2, r3);
+            double *d = dst + j*ldd + i;
+            _mm256_storeu_pd(d,         _mm256_permute2f128_pd(t0, t2, 0x20));
+            _mm256_storeu_pd(d + ldd,   _mm256_permute2f128_pd(t1, t3, 0x20));
+            _mm256_storeu_pd(d + 2*ldd, _mm256_permute2f128_pd(t0, t2, 0x31));
+            _mm256_storeu_pd(d + 3*ldd, _mm256_permute2f128_pd(t1, t3, 0x31));
+        }
+    }
+}
+
+__attribute__((target("avx2,fma")))
+static void SwapReversedAVX2(size_t n, double *restrict x, double *restrict y){
+    size_t i = 0;
+    for(; i + 4 <= n; i += 4){
+        __m256d x0 = _mm256_loadu_pd(x + i);
+        __m256d y0 = _mm256_loadu_pd(y + n - i - 4);
+        _mm256_storeu_pd(x + i,         _mm256_permute4x64_pd(y0, 0x1B));
+        _mm256_storeu_pd(y + n - i - 4, _mm256_permute4x64_pd(x0, 0x1B));
+    }
+    for(; i < n; i++){
+        double temp = x[i];
+        x[i] = y[n-1-i];
+        y[n-1-i] = temp;
+    }
+}
+
+static const MatrixKernels avx2_kernels = {
+    "avx2", AxpyAVX2, ScaleAVX2, SwapAVX2, AddAVX2, DotAVX2, GemmMicroAVX2,
+    TransposeTileAVX2, SwapReversedAVX2
+};
+
+
+/*******************************************************
+ *          AVX-512 Kernels (8 doubles per register)
+ *******************************************************/
+// Tails are handled with a lane mask instead of a scalar loop
+#define TAIL_MASK(count) ((__mmask8)((1u << (count)) - 1u))
+
+__attribute__((target("avx512f")))
+static void AxpyAVX512(size_t n, double alpha, const double *restrict x, double *restrict y){
+    const __m512d a = _mm512_set1_pd(alpha);
+    size_t i = 0;
+    for(; i + 16 <= n; i += 16){
+        __m512d y0 = _mm512_fmadd_pd(a, _mm512_loadu_pd(x + i),     _mm512_loadu_pd(y + i));
+        __m512d y1 = _mm512_fmadd_pd(a, _mm512_loadu_pd(x + i + 8), _mm512_loadu_pd(y + i + 8));
+        _mm512_storeu_pd(y + i, y0);
+        _mm512_storeu_pd(y + i + 8, y1);
+    }
+    for(; i < n; i += 8){
+        __mmask8 mask = n - i >= 8 ? (__mmask8)0xFF : TAIL_MASK(n - i);
+        __m512d y0 = _mm512_fmadd_pd(a, _mm512_maskz_loadu_pd(mask, x + i), _mm512_maskz_loadu_pd(mask, y + i));
+        _mm512_mask_storeu_pd(y + i, mask, y0);
+    }
+}
+
+__attribute__((target("avx512f")))
+static void ScaleAVX512(size_t n, double alpha, double *x){
+    const __m512d a = _mm512_set1_pd(alpha);
+    for(size_t i = 0; i < n; i += 8){
+        __mmask8 mask = n - i >= 8 ? (__mmask8)0xFF : TAIL_MASK(n - i);
+        _mm512_mask_storeu_pd(x + i, mask, _mm512_mul_pd(a, _mm512_maskz_loadu_pd(mask, x + i)));
+    }
+}
+
+__attribute__((target("avx512f")))
+static void SwapAVX512(size_t n, double *restrict x, double *restrict y){
+    for(size_t i = 0; i < n; i += 8){
+        __mmask8 mask = n - i >= 8 ? (__mmask8)0xFF : TAIL_MASK(n - i);
+        __m512d x0 = _mm512_maskz_loadu_pd(mask, x + i);
+        __m512d y0 = _mm512_maskz_loadu_pd(mask, y + i);
+        _mm512_mask_storeu_pd(x + i, mask, y0);
+        _mm512_mask_storeu_pd(y + i, mask, x0);
+    }
+}
+
+__attribute__((target("avx512f")))
+static void AddAVX512(size_t n, const double *x, double beta, const double *y, double *z){
+    const __m512d b = _mm512_set1_pd(beta);
+    for(size_t i = 0; i < n; i += 8){
+        __mmask8 mask = n - i >= 8 ? (__mmask8)0xFF : TAIL_MASK(n - i);
+        __m512d sum = _mm512_fmadd_pd(b, _mm512_maskz_loadu_pd(mask, y + i), _mm512_maskz_loadu_pd(mask, x + i));
+        _mm512_mask_storeu_pd(z + i, mask, sum);
+    }
+}
+
+// 6x8 tile in 6 zmm accumulators: one B vector per k step
+__attribute__((target("avx512f")))
+static void GemmMicroAVX512(size_t kc, const double *restrict a, const double *restrict b,
+                            double *restrict tile){
+    __m512d c0 = _mm512_setzero_pd(), c1 = _mm512_setzero_pd(), c2 = _mm512_setzero_pd();
+    __m512d c3 = _mm512_setzero_pd(), c4 = _mm512_setzero_pd(), c5 = _mm512_setzero_pd();
+    for(size_t p = 0; p < kc; p++){
+        const __m512d b0 = _mm512_load_pd(b);
+        c0 = _mm512_fmadd_pd(_mm512_set1_pd(a[0]), b0, c0);
+        c1 = _mm512_fmadd_pd(_mm512_set1_pd(a[1]), b0, c1);
+        c2 = _mm512_fmadd_pd(_mm512_set1_pd(a[2]), b0, c2);
+        c3 = _mm512_fmadd_pd(_mm512_set1_pd(a[3]), b0, c3);
+        c4 = _mm512_fmadd_pd(_mm512_set1_pd(a[4]), b0, c4);
+        c5 = _mm512_fmadd_pd(_mm512_set1_pd(a[5]), b0, c5);
+        a += GEMM_MR;
+        b += GEMM_NR;
+    }
+    _mm512_store_pd(tile + 0*GEMM_NR, c0);
+    _mm512_store_pd(tile + 1*GEMM_NR, c1);
+    _mm512_store_pd(tile + 2*GEMM_NR, c2);
+    _mm512_store_pd(tile + 3*GEMM_NR, c3);
+    _mm512_store_pd(tile + 4*GEMM_NR, c4);
+    _mm512_store_pd(tile + 5*GEMM_NR, c5);
+}
+
+__attribute__((target("avx512f")))
+static double DotAVX512(size_t n, const double *x, const double *y){
+    __m512d s0 = _mm512_setzero_pd(), s1 = _mm512_setzero_pd();
+    size_t i = 0;
+    for(; i + 16 <= n; i += 16){
+        s0 = _mm512_fmadd_pd(_mm512_loadu_pd(x + i),     _mm512_loadu_pd(y + i),     s0);
+        s1 = _mm512_fmadd_pd(_mm512_loadu_pd(x + i + 8), _mm512_loadu_pd(y + i + 8), s1);
+    }
+    for(; i < n; i += 8){
+        __mmask8 mask = n - i >= 8 ? (__mmask8)0xFF : TAIL_MASK(n - i);
+        s0 = _mm512_fmadd_pd(_mm512_maskz_loadu_pd(mask, x + i), _mm512_maskz_loadu_pd(mask, y + i), s0);
+    }
+    return _mm512_reduce_add_pd(_mm512_add_pd(s0, s1));
+}
+
+// 8x8 transpose in registers: unpack row pairs, gather 128-bit lanes into
+// 4-row groups, then join the 256-bit halves of the two groups
+__attribute__((target("avx512f")))
+static void TransposeTileAVX512(const double *restrict src, size_t lds, double *restrict dst, size_t ldd){
+    __m512d r[8], a[8], c[8];
+    for(int i = 0; i < 8; i++)
+        r[i] = _mm512_loadu_pd(src + i*lds);
+    for(int i = 0; i < 8; i += 2){
+        a[i]     = _mm512_unpacklo_pd(r[i], r[i + 1]); // columns 0,2,4,6 of rows i,i+1
+        a[i + 1] = _mm512_unpackhi_pd(r[i], r[i + 1]); // columns 1,3,5,7
+    }
+    const __m512i even_lanes = _mm512_set_epi64(13, 12, 5, 4, 9, 8, 1, 0);
+    const __m512i odd_lanes  = _mm512_set_epi64(15, 14, 7, 6, 11, 10, 3, 2);
+    for(int g = 0; g < 8; g += 4){
+        c[g]     = _mm512_permutex2var_pd(a[g],     even_lanes, a[g + 2]); // columns 0,4
+        c[g + 1] = _mm512_permutex2var_pd(a[g],     odd_lanes,  a[g + 2]); // columns 2,6
+        c[g + 2] = _mm512_permutex2var_pd(a[g + 1], even_lanes, a[g + 3]); // columns 1,5
+        c[g + 3] = _mm512_permutex2var_pd(a[g + 1], odd_lanes,  a[g + 3]); // columns 3,7
+    }
+    const __m512i low_halves  = _mm512_set_epi64(11, 10, 9, 8, 3, 2, 1, 0);
+    const __m512i high_halves = _mm512_set_epi64(15, 14, 13, 12, 7, 6, 5, 4);
+    const int column_of[4] = {0, 2, 1, 3};
+    for(int q = 0; q < 4; q++){
+        int column = column_of[q];
+        _mm512_storeu_pd(dst + column*ldd,       _mm512_permutex2var_pd(c[q], low_halves,  c[q + 4]));
+        _mm512_storeu_pd(dst + (column + 4)*ldd, _mm512_permutex2var_pd(c[q], high_halves, c[q + 4]));
+    }
+}
+
+__attribute__((target("avx512f")))
+static void SwapReversedAVX512(size_t n, double *restrict x, double *restrict y){
+    const __m512i reverse = _mm512_set_epi64(0, 1, 2, 3, 4, 5, 6, 7);
+    size_t i = 0;
+    for(; i + 8 <= n; i += 8){
+        __m512d x0 = _mm512_loadu_pd(x + i);
+        __m512d y0 = _mm512_loadu_pd(y + n - i - 8);
+        _mm512_storeu_pd(x + i,         _mm512_permutexvar_pd(reverse, y0));
+        _mm512_storeu_pd(y + n - i - 8, _mm512_permutexvar_pd(reverse, x0));
+    }
+    for(; i < n; i++){
+        double temp = x[i];
+        x[i] = y[n-1-i];
+        y[n-1-i] = temp;
+    }
+}
+
+static const MatrixKernels avx512_kernels = {
+    "avx512", AxpyAVX512, ScaleAVX512, SwapAVX512, AddAVX512, DotAVX512, GemmMicroAVX512,
+    TransposeTileAVX512, SwapReversedAVX512
+};
+
+#endif //MATRIX_X86_DISPATCH
+
+
+/*******************************************************
+ *          Runtime Dispatch
+ *******************************************************/
+// Starts out portable so calls made before the constructor runs still work
+const MatrixKernels *matrix_kernels = &scalar_kernels;
+const MatrixKernelsF *matrix_kernels_f = &MatrixKernelsF_scalar;
+
+#ifdef MATRIX_X86_DISPATCH
+// Picks the widest kernel set the CPU (and OS) supports. SMLC_ISA may name a
+// narrower set (scalar, sse2, avx2, avx512) to force it, e.g. for testing.
+__attribute__((constructor))
+static void SelectMatrixKernels(void){
+    const MatrixKernels *supported[4];
+    const MatrixKernelsF *supported_f[4];
+    int count = 0;
+    __builtin_cpu_init();
+    supported_f[count] = &MatrixKernelsF_scalar;
+    supported[count++] = &scalar_kernels;
+    if(__builtin_cpu_supports("sse2")){
+        supported_f[count] = &MatrixKernelsF_sse2;
+        supported[count++] = &sse2_kernels;
+    }
+    if(__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")){
+        supported_f[count] = &MatrixKernelsF_avx2;
+        supported[count++] = &avx2_kernels;
+    }
+    if(__builtin_cpu_supports("avx512f")){
+        supported_f[count] = &MatrixKernelsF_avx512;
+        supported[count++] = &avx512_kernels;
+    }
+
+    int chosen = count - 1;
+    const char *forced = getenv("SMLC_ISA");
+    if(forced){
+        for(int i = 0; i < count; i++)
+            if(strcmp(forced, supported[i]->name) == 0)
+                chosen = i;
+    }
+    matrix_kernels = supported[chosen];
+    matrix_kernels_f = supported_f[chosen];
+}
+#endif
+
+const char *MatrixKernelName(void){
+    return matrix_kernels->name;
+}
@@ -0,0 +1,86 @@
+/****************************
+ * Author: Blake A. Molina
+ * Created on: 10/17/26
+ * License: GPL
+ ****************************/
+
+#include "matrix_internal.h"
+
+// Applied to every loop of small_kernels.h: the bounds are compile-time
+// constants no larger than SMALL_MAX_DIM, so each loop flattens completely
+#define SMALL_UNROLL _Pragma("GCC unroll 8")
+
+/*******************************************************
+ *          2x2 Through 8x8 Kernels
+ *******************************************************/
+#define SMALL_N 2
+#include "small_kernels.h"
+#define SMALL_N 3
+#include "small_kernels.h"
+#define SMALL_N 4
+#include "small_kernels.h"
+#define SMALL_N 5
+#include "small_kernels.h"
+#define SMALL_N 6
+#include "small_kernels.h"
+#define SMALL_N 7
+#include "small_kernels.h"
+#define SMALL_N 8
+#include "small_kernels.h"
+
+
+/*******************************************************
+ *          Dispatch by Size
+ *******************************************************/
+typedef struct{
+    void (*multiply)(const double *a, size_t lda, const double *b, size_t ldb, double *c, size_t ldc);
+    double (*determinant)(const double *a, size_t lda);
+    void (*transpose)(const double *src, size_t lds, double *dst, size_t ldd);
+    int (*solve)(const double *a, size_t lda, const double *b, size_t incb, double *x, size_t incx);
+}SmallKernels;
+
+#define SMALL_ENTRY(n) {Multiply##n##x##n##Dense, Determinant##n##x##n##Dense, \
+                        Transpose##n##x##n##Dense, Solve##n##x##n##Dense}
+
+// Indexed by N - SMALL_MIN_DIM
+static const SmallKernels small_kernels[SMALL_MAX_DIM - SMALL_MIN_DIM + 1] = {
+    SMALL_ENTRY(2), SMALL_ENTRY(3), SMALL_ENTRY(4), SMALL_ENTRY(5),
+    SMALL_ENTRY(6), SMALL_ENTRY(7), SMALL_ENTRY(8)
+};
+
+static const SmallKernels *SmallKernelsFor(size_t n){
+    return n >= SMALL_MIN_DIM && n <= SMALL_MAX_DIM ? &small_kernels[n - SMALL_MIN_DIM] : NULL;
+}
+
+int SmallMultiplyDense(size_t n, const double *a, size_t lda, const double *b, size_t ldb,
+                       double *c, size_t ldc){
+    const SmallKernels *kernels = SmallKernelsFor(n);
+    if(!kernels)
+        return -1;
+    kernels->multiply(a, lda, b, ldb, c, ldc);
+    return 0;
+}
+
+int SmallDeterminantDense(size_t n, const double *a, size_t lda, double *determinant){
+    const SmallKernels *kernels = SmallKernelsFor(n);
+    if(!kernels)
+        return -1;
+    *determinant = kernels->determinant(a, lda);
+    return 0;
+}
+
+int SmallTransposeDense(size_t n, const double *src, size_t lds, double *dst, size_t ldd){
+    const SmallKernels *kernels = SmallKernelsFor(n);
+    if(!kernels)
+        return -1;
+    kernels->transpose(src, lds, dst, ldd);
+    return 0;
+}
+
+int SmallSolveDense(size_t n, const double *a, size_t lda, const double *b, size_t incb,
+                    double *x, size_t incx){
+    const SmallKernels *kernels = SmallKernelsFor(n);
+    if(!kernels)
+        return -1;
+    return kernels->solve(a, lda, b, incb, x, incx);
+}
@@ -0,0 +1,324 @@
+/****************************
+ * Author: Blake A. Molina
+ * Created on: 10/17/26
+ * License: GPL
+ ****************************/
+
+/*************************************************************************
+ * Fixed-size NxN kernels, included by small.c once per N from
+ * SMALL_MIN_DIM to SMALL_MAX_DIM.
+ *
+ *  Before each inclusion small.c defines SMALL_N. The inclusion defines the
+ *  public Matrix<N>x<N> functions declared in matrix.h and the static
+ *  <name><N>x<N>Dense wrappers that the generic entry points reach through
+ *  small_kernels[]. Every loop bound is the constant SMALL_N, so with
+ *  SMALL_UNROLL the compiler flattens the loops completely and keeps the
+ *  working values in registers.
+ *
+ *  2x2 and 3x3 determinants and inverses use the closed (cofactor) forms;
+ *  larger sizes and every solve use an unrolled LU with partial pivoting.
+ *
+ *  There is deliberately no include guard.
+ ************************************************************************/
+
+#define SMALL_CONCAT_(name, n)    name##n##x##n
+#define SMALL_CONCAT(name, n)     SMALL_CONCAT_(name, n)
+#define SMALL_NAME(name)          SMALL_CONCAT(name, SMALL_N)
+#define SMALL_DENSE_(name, n)     name##n##x##n##Dense
+#define SMALL_DENSE(name, n)      SMALL_DENSE_(name, n)
+#define SMALL_STATIC(name)        SMALL_DENSE(name, SMALL_N)
+
+#define SMALL_TYPE SMALL_NAME(Matrix)
+
+
+/*******************************************************
+ *          Loads, Stores & LU
+ *******************************************************/
+static SMALL_TYPE SMALL_STATIC(Load)(const double *a, size_t lda){
+    SMALL_TYPE result;
+    SMALL_UNROLL
+    for(int i = 0; i < SMALL_N; i++)
+        SMALL_UNROLL
+        for(int j = 0; j < SMALL_N; j++)
+            result.m[i][j] = a[i*lda + j];
+    return result;
+}
+
+static void SMALL_STATIC(Store)(const SMALL_TYPE *matrix, double *a, size_t lda){
+    SMALL_UNROLL
+    for(int i = 0; i < SMALL_N; i++)
+        SMALL_UNROLL
+        for(int j = 0; j < SMALL_N; j++)
+            a[i*lda + j] = matrix->m[i][j];
+}
+
+// In-place LU with partial pivoting: unit L below the diagonal, U on and
+// above it; whole rows k and pivots[k] were exchanged at step k. Returns the
+// sign of the row permutation, or 0 when a pivot is exactly zero.
+static int SMALL_STATIC(Factor)(SMALL_TYPE *lu, int pivots[SMALL_N]){
+    int sign = 1;
+    SMALL_UNROLL
+    for(int k = 0; k < SMALL_N; k++){
+        int pivot = k;
+        double largest = fabs(lu->m[k][k]);
+        SMALL_UNROLL
+        for(int i = k + 1; i < SMALL_N; i++)
+            if(fabs(lu->m[i][k]) > largest){
+                largest = fabs(lu->m[i][k]);
+                pivot = i;
+            }
+        pivots[k] = pivot;
+        if(largest == 0.0)
+            return 0;
+        if(pivot != k){
+            sign = -sign;
+            SMALL_UNROLL
+            for(int j = 0; j < SMALL_N; j++){
+                double temp = lu->m[k][j];
+                lu->m[k][j] = lu->m[pivot][j];
+                lu->m[pivot][j] = temp;
+            }
+        }
+        double reciprocal = 1.0 / lu->m[k][k];
+        SMALL_UNROLL
+        for(int i = k + 1; i < SMALL_N; i++){
+            double l = lu->m[i][k] * reciprocal;
+            lu->m[i][k] = l;
+            SMALL_UNROLL
+            for(int j = k + 1; j < SMALL_N; j++)
+                lu->m[i][j] -= l * lu->m[k][j];
+        }
+    }
+    return sign;
+}
+
+
+/*******************************************************
+ *          Public Fixed-Size Operations
+ *******************************************************/
+SMALL_TYPE SMALL_NAME(Multiply)(const SMALL_TYPE *a, const SMALL_TYPE *b){
+    // row i of the product is the combination of B's rows weighted by row i
+    // of A: N broadcasts and N vector multiply-adds per row
+    SMALL_TYPE result;
+    SMALL_UNROLL
+    for(int i = 0; i < SMALL_N; i++){
+        double row[SMALL_N];
+        SMALL_UNROLL
+        for(int j = 0; j < SMALL_N; j++)
+            row[j] = a->m[i][0] * b->m[0][j];
+        SMALL_UNROLL
+        for(int k = 1; k < SMALL_N; k++)
+            SMALL_UNROLL
+            for(int j = 0; j < SMALL_N; j++)
+                row[j] += a->m[i][k] * b->m[k][j];
+        SMALL_UNROLL
+        for(int j = 0; j < SMALL_N; j++)
+            result.m[i][j] = row[j];
+    }
+    return result;
+}
+
+SMALL_TYPE SMALL_NAME(Transpose)(const SMALL_TYPE *a){
+    SMALL_TYPE result;
+    SMALL_UNROLL
+    for(int i = 0; i < SMALL_N; i++)
+        SMALL_UNROLL
+        for(int j = 0; j < SMALL_N; j++)
+            result.m[j][i] = a->m[i][j];
+    return result;
+}
+
+double SMALL_NAME(Determinant)(const SMALL_TYPE *a){
+#if SMALL_N == 2
+    return a->m[0][0] * a->m[1][1] - a->m[0][1] * a->m[1][0];
+#elif SMALL_N == 3
+    return a->m[0][0] * (a->m[1][1] * a->m[2][2] - a->m[1][2] * a->m[2][1])
+         + a->m[0][1] * (a->m[1][2] * a->m[2][0] - a->m[1][0] * a->m[2][2])
+         + a->m[0][2] * (a->m[1][0] * a->m[2][1] - a->m[1][1] * a->m[2][0]);
+#else
+    SMALL_TYPE lu = *a;
+    int pivots[SMALL_N];
+    double determinant = SMALL_STATIC(Factor)(&lu, pivots);
+    SMALL_UNROLL
+    for(int i = 0; i < SMALL_N; i++)
+        determinant *= lu.m[i][i];
+    return determinant;
+#endif
+}
+
+int SMALL_NAME(Inverse)(const SMALL_TYPE *a, SMALL_TYPE *inverse){
+#if SMALL_N == 2
+    double determinant = SMALL_NAME(Determinant)(a);
+    if(determinant == 0.0)
+        return -1;
+    double scale = 1.0 / determinant;
+    SMALL_TYPE result = {{{ a->m[1][1] * scale, -a->m[0][1] * scale},
+                          {-a->m[1][0] * scale,  a->m[0][0] * scale}}};
+    *inverse = result;
+    return 0;
+#elif SMALL_N == 3
+    // adjugate: the transposed cofactors
+    SMALL_TYPE result;
+    result.m[0][0] = a->m[1][1] * a->m[2][2] - a->m[1][2] * a->m[2][1];
+    result.m[1][0] = a->m[1][2] * a->m[2][0] - a->m[1][0] * a->m[2][2];
+    result.m[2][0] = a->m[1][0] * a->m[2][1] - a->m[1][1] * a->m[2][0];
+    double determinant = a->m[0][0] * result.m[0][0] + a->m[0][1] * result.m[1][0] + a->m[0][2] * result.m[2][0];
+    if(determinant == 0.0)
+        return -1;
+    result.m[0][1] = a->m[0][2] * a->m[2][1] - a->m[0][1] * a->m[2][2];
+    result.m[1][1] = a->m[0][0] * a->m[2][2] - a->m[0][2] * a->m[2][0];
+    result.m[2][1] = a->m[0][1] * a->m[2][0] - a->m[0][0] * a->m[2][1];
+    result.m[0][2] = a->m[0][1] * a->m[1][2] - a->m[0][2] * a->m[1][1];
+    result.m[1][2] = a->m[0][2] * a->m[1][0] - a->m[0][0] * a->m[1][2];
+    result.m[2][2] = a->m[0][0] * a->m[1][1] - a->m[0][1] * a->m[1][0];
+    double scale = 1.0 / determinant;
+    SMALL_UNROLL
+    for(int i = 0; i < SMALL_N; i++)
+        SMALL_UNROLL
+        for(int j = 0; j < SMALL_N; j++)
+            result.m[i][j] *= scale;
+    *inverse = result;
+    return 0;
+#else
+    SMALL_TYPE lu = *a, x;
+    int pivots[SMALL_N];
+    if(SMALL_STATIC(Factor)(&lu, pivots) == 0)
+        return -1;
+    // X = P * I, then forward substitution with L and back substitution
+    // with U, a whole row of X at a time
+    SMALL_UNROLL
+    for(int i = 0; i < SMALL_N; i++)
+        SMALL_UNROLL
+        for(int j = 0; j < SMALL_N; j++)
+            x.m[i][j] = i == j;
+    SMALL_UNROLL
+    for(int k = 0; k < SMALL_N; k++)
+        if(pivots[k] != k)
+            SMALL_UNROLL
+            for(int j = 0; j < SMALL_N; j++){
+                double temp = x.m[k][j];
+                x.m[k][j] = x.m[pivots[k]][j];
+                x.m[pivots[k]][j] = temp;
+            }
+    SMALL_UNROLL
+    for(int i = 1; i < SMALL_N; i++)
+        SMALL_UNROLL
+        for(int k = 0; k < i; k++)
+            SMALL_UNROLL
+            for(int j = 0; j < SMALL_N; j++)
+                x.m[i][j] -= lu.m[i][k] * x.m[k][j];
+    SMALL_UNROLL
+    for(int i = SMALL_N - 1; i >= 0; i--){
+        SMALL_UNROLL
+        for(int k = i + 1; k < SMALL_N; k++)
+            SMALL_UNROLL
+            for(int j = 0; j < SMALL_N; j++)
+                x.m[i][j] -= lu.m[i][k] * x.m[k][j];
+        double reciprocal = 1.0 / lu.m[i][i];
+        SMALL_UNROLL
+        for(int j = 0; j < SMALL_N; j++)
+            x.m[i][j] *= reciprocal;
+    }
+    *inverse = x;
+    return 0;
+#endif
+}
+
+int SMALL_NAME(Solve)(const SMALL_TYPE *a, const double *b, double *x){
+    SMALL_TYPE lu = *a;
+    int pivots[SMALL_N];
+    if(SMALL_STATIC(Factor)(&lu, pivots) == 0)
+        return -1;
+    double y[SMALL_N];
+    SMALL_UNROLL
+    for(int i = 0; i < SMALL_N; i++)
+        y[i] = b[i];
+    SMALL_UNROLL
+    for(int k = 0; k < SMALL_N; k++){
+        double temp = y[k];
+        y[k] = y[pivots[k]];
+        y[pivots[k]] = temp;
+    }
+    SMALL_UNROLL
+    for(int i = 1; i < SMALL_N; i++)
+        SMALL_UNROLL
+        for(int k = 0; k < i; k++)
+            y[i] -= lu.m[i][k] * y[k];
+    SMALL_UNROLL
+    for(int i = SMALL_N - 1; i >= 0; i--){
+        SMALL_UNROLL
+        for(int k = i + 1; k < SMALL_N; k++)
+            y[i] -= lu.m[i][k] * y[k];
+        y[i] /= lu.m[i][i];
+    }
+    SMALL_UNROLL
+    for(int i = 0; i < SMALL_N; i++)
+        x[i] = y[i];
+    return 0;
+}
+
+int SMALL_NAME(LoadMatrix)(Matrix matrix, SMALL_TYPE *small){
+    if(isEmpty(matrix) || !small || matrix->num_rows != SMALL_N || matrix->num_cols != SMALL_N){
+        fprintf(stderr, "%s", "Error - Matrix shape does not match the fixed-size matrix");
+        return -1;
+    }
+    *small = SMALL_STATIC(Load)(matrix->data, matrix->ld);
+    return 0;
+}
+
+int SMALL_NAME(StoreMatrix)(const SMALL_TYPE *small, Matrix matrix){
+    if(isEmpty(matrix) || !small || matrix->num_rows != SMALL_N || matrix->num_cols != SMALL_N){
+        fprintf(stderr, "%s", "Error - Matrix shape does not match the fixed-size matrix");
+        return -1;
+    }
+    SMALL_STATIC(Store)(small, matrix->data, matrix->ld);
+    return 0;
+}
+
+
+/*******************************************************
+ *          Strided Wrappers for small_kernels[]
+ *******************************************************/
+static void SMALL_STATIC(Multiply)(const double *a, size_t lda, const double *b, size_t ldb,
+                                   double *c, size_t ldc){
+    SMALL_TYPE small_a = SMALL_STATIC(Load)(a, lda), small_b = SMALL_STATIC(Load)(b, ldb);
+    SMALL_TYPE product = SMALL_NAME(Multiply)(&small_a, &small_b);
+    SMALL_STATIC(Store)(&product, c, ldc);
+}
+
+static double SMALL_STATIC(Determinant)(const double *a, size_t lda){
+    SMALL_TYPE small = SMALL_STATIC(Load)(a, lda);
+    return SMALL_NAME(Determinant)(&small);
+}
+
+static void SMALL_STATIC(Transpose)(const double *src, size_t lds, double *dst, size_t ldd){
+    // the whole source is loaded before anything is stored, so src == dst
+    // transposes in place
+    SMALL_TYPE small = SMALL_STATIC(Load)(src, lds);
+    SMALL_TYPE transposed = SMALL_NAME(Transpose)(&small);
+    SMALL_STATIC(Store)(&transposed, dst, ldd);
+}
+
+static int SMALL_STATIC(Solve)(const double *a, size_t lda, const double *b, size_t incb,
+                               double *x, size_t incx){
+    SMALL_TYPE small = SMALL_STATIC(Load)(a, lda);
+    double rhs[SMALL_N], solution[SMALL_N];
+    SMALL_UNROLL
+    for(int i = 0; i < SMALL_N; i++)
+        rhs[i] = b[i*incb];
+    if(SMALL_NAME(Solve)(&small, rhs, solution) != 0)
+        return -1;
+    SMALL_UNROLL
+    for(int i = 0; i < SMALL_N; i++)
+        x[i*incx] = solution[i];
+    return 0;
+}
+
+#undef SMALL_TYPE
+#undef SMALL_STATIC
+#undef SMALL_DENSE
+#undef SMALL_DENSE_
+#undef SMALL_NAME
+#undef SMALL_CONCAT
+#undef SMALL_CONCAT_
+#undef SMALL_N
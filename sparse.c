@@ -0,0 +1,525 @@
+/****************************
+ * Author: Blake A. Molina
+ * Created on: 10/17/26
+ * License: GPL
+ ****************************/
+
+#include "matrix_internal.h"
+
+// Smallest share of nonzeros worth handing to a thread
+#define SPARSE_MIN_NONZEROS 16384
+
+// Majors (rows of a CSR, columns of a CSC matrix) and minors
+#define NUM_MAJOR(sparse) ((sparse)->format == SPARSE_CSR ? (sparse)->num_rows : (sparse)->num_cols)
+#define NUM_MINOR(sparse) ((sparse)->format == SPARSE_CSR ? (sparse)->num_cols : (sparse)->num_rows)
+
+
+/*******************************************************
+ *     Sparse Instantiation & Deletion
+ *******************************************************/
+SparseMatrix NewSparseMatrix(size_t num_rows, size_t num_cols, size_t nnz, int format){
+    if((format != SPARSE_CSR && format != SPARSE_CSC) || num_rows > UINT32_MAX || num_cols > UINT32_MAX){
+        fprintf(stderr, "%s", "Error - Sparse matrices are CSR or CSC with at most 2^32-1 rows and columns");
+        return NULL;
+    }
+    SparseMatrix sparse = (SparseMatrix)malloc(sizeof(sparse_struct));
+    if(!sparse){
+        fprintf(stderr, "%s", "Error - Could not allocate sparse matrix");
+        return NULL;
+    }
+    sparse->num_rows = num_rows;
+    sparse->num_cols = num_cols;
+    sparse->nnz = nnz;
+    sparse->format = format;
+    size_t majors = NUM_MAJOR(sparse);
+    sparse->offsets = (size_t*)calloc(majors + 1, sizeof(size_t));
+    sparse->indices = (uint32_t*)AllocateAligned((nnz ? nnz : 1) * sizeof(uint32_t));
+    sparse->values  = (double*)AllocateAligned((nnz ? nnz : 1) * sizeof(double));
+    if(!sparse->offsets || !sparse->indices || !sparse->values){
+        fprintf(stderr, "%s", "Error - Could not allocate sparse matrix");
+        FreeSparseMatrix(&sparse);
+        return NULL;
+    }
+    return sparse;
+}
+
+void FreeSparseMatrix(SparseMatrix *sparse){
+    if(sparse && *sparse){
+        free((*sparse)->offsets);
+        FreeAligned((*sparse)->indices);
+        FreeAligned((*sparse)->values);
+        free(*sparse);
+        *sparse = NULL;
+    }
+}
+
+
+/*******************************************************
+ *          Nonzero-balanced Partitioning
+ *******************************************************/
+// First major whose offset is >= position
+static size_t LowerBound(const size_t *offsets, size_t majors, size_t position){
+    size_t low = 0, high = majors + 1;
+    while(low < high){
+        size_t middle = low + (high - low) / 2;
+        if(offsets[middle] < position)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+    return low;
+}
+
+// Maps a share [begin, end) of the nonzeros to the majors that start inside
+// it, so every thread gets about the same number of nonzeros however they are
+// spread. The share ending at nnz also takes trailing empty majors.
+static void MajorRange(const SparseMatrix sparse, size_t begin, size_t end,
+                       size_t *first, size_t *last){
+    size_t majors = NUM_MAJOR(sparse);
+    *first = begin == 0 ? 0 : LowerBound(sparse->offsets, majors, begin);
+    *last  = end >= sparse->nnz ? majors : LowerBound(sparse->offsets, majors, end);
+}
+
+// Runs task over the nonzeros of sparse; an empty matrix still gets one call
+// so the task can clear its output
+static void ParallelForNonzeros(const SparseMatrix sparse, ParallelTask task, void *context){
+    if(sparse->nnz == 0)
+        task(context, 0, 0);
+    else
+        ParallelFor(sparse->nnz, SPARSE_MIN_NONZEROS, task, context);
+}
+
+
+/*******************************************************
+ *          Conversions
+ *******************************************************/
+typedef struct{
+    Matrix dense;
+    SparseMatrix sparse;
+    double drop_tolerance;
+}DenseRowsJob;
+
+// Pass 1: nonzeros per dense row, stored in offsets[row + 1]
+static void CountDenseRowsTask(void *context, size_t begin, size_t end){
+    const DenseRowsJob *job = (const DenseRowsJob*)context;
+    for(size_t i = begin; i < end; i++){
+        const double *row = MATRIX_ROW(job->dense, i);
+        size_t count = 0;
+        for(size_t j = 0; j < job->dense->num_cols; j++)
+            count += fabs(row[j]) > job->drop_tolerance;
+        job->sparse->offsets[i + 1] = count;
+    }
+}
+
+// Pass 2: copy the kept values of each row to its slot
+static void FillDenseRowsTask(void *context, size_t begin, size_t end){
+    const DenseRowsJob *job = (const DenseRowsJob*)context;
+    for(size_t i = begin; i < end; i++){
+        const double *row = MATRIX_ROW(job->dense, i);
+        size_t slot = job->sparse->offsets[i];
+        for(size_t j = 0; j < job->dense->num_cols; j++){
+            if(fabs(row[j]) > job->drop_tolerance){
+                job->sparse->indices[slot] = (uint32_t)j;
+                job->sparse->values[slot++] = row[j];
+            }
+        }
+    }
+}
+
+SparseMatrix SparseFromDense(Matrix dense, double drop_tolerance, int format){
+    if(isEmpty(dense))
+        return NULL;
+    SparseMatrix rows = NewSparseMatrix(dense->num_rows, dense->num_cols, 0, SPARSE_CSR);
+    if(!rows)
+        return NULL;
+    size_t chunk = dense->num_cols >= 16384 ? 1 : 16384 / dense->num_cols;
+    DenseRowsJob job = {dense, rows, drop_tolerance};
+    ParallelFor(dense->num_rows, chunk, CountDenseRowsTask, &job);
+    for(size_t i = 0; i < dense->num_rows; i++)
+        rows->offsets[i + 1] += rows->offsets[i];
+    rows->nnz = rows->offsets[dense->num_rows];
+
+    FreeAligned(rows->indices);
+    FreeAligned(rows->values);
+    rows->indices = (uint32_t*)AllocateAligned((rows->nnz ? rows->nnz : 1) * sizeof(uint32_t));
+    rows->values  = (double*)AllocateAligned((rows->nnz ? rows->nnz : 1) * sizeof(double));
+    if(!rows->indices || !rows->values){
+        fprintf(stderr, "%s", "Error - Could not allocate sparse matrix");
+        FreeSparseMatrix(&rows);
+        return NULL;
+    }
+    ParallelFor(dense->num_rows, chunk, FillDenseRowsTask, &job);
+    if(format == SPARSE_CSR)
+        return rows;
+    SparseMatrix columns = SparseConvert(rows, format);
+    FreeSparseMatrix(&rows);
+    return columns;
+}
+
+typedef struct{
+    SparseMatrix sparse;
+    Matrix dense;
+}ScatterJob;
+
+static void ScatterRowsTask(void *context, size_t begin, size_t end){
+    const ScatterJob *job = (const ScatterJob*)context;
+    for(size_t i = begin; i < end; i++){
+        double *row = MATRIX_ROW(job->dense, i);
+        for(size_t p = job->sparse->offsets[i]; p < job->sparse->offsets[i + 1]; p++)
+            row[job->sparse->indices[p]] = job->sparse->values[p];
+    }
+}
+
+Matrix SparseToDense(SparseMatrix sparse){
+    if(!sparse)
+        return NULL;
+    Matrix dense = NewMatrix(sparse->num_rows, sparse->num_cols);
+    if(!dense)
+        return NULL;
+    if(sparse->format == SPARSE_CSR){
+        ScatterJob job = {sparse, dense};
+        ParallelFor(sparse->num_rows, 64, ScatterRowsTask, &job);
+    }
+    else{
+        for(size_t j = 0; j < sparse->num_cols; j++)
+            for(size_t p = sparse->offsets[j]; p < sparse->offsets[j + 1]; p++)
+                MATRIX_AT(dense, sparse->indices[p], j) = sparse->values[p];
+    }
+    return dense;
+}
+
+SparseMatrix SparseConvert(SparseMatrix sparse, int format){
+    if(!sparse)
+        return NULL;
+    SparseMatrix result = NewSparseMatrix(sparse->num_rows, sparse->num_cols, sparse->nnz, format);
+    if(!result)
+        return NULL;
+    if(format == sparse->format){
+        memcpy(result->offsets, sparse->offsets, (NUM_MAJOR(sparse) + 1) * sizeof(size_t));
+        memcpy(result->indices, sparse->indices, sparse->nnz * sizeof(uint32_t));
+        memcpy(result->values, sparse->values, sparse->nnz * sizeof(double));
+        return result;
+    }
+    // Counting sort by the old minor index. Majors are visited in order, so
+    // the new minor indices come out sorted.
+    size_t majors = NUM_MAJOR(sparse), minors = NUM_MINOR(sparse);
+    for(size_t p = 0; p < sparse->nnz; p++)
+        result->offsets[sparse->indices[p] + 1]++;
+    for(size_t m = 0; m < minors; m++)
+        result->offsets[m + 1] += result->offsets[m];
+    size_t *next = (size_t*)malloc((minors ? minors : 1) * sizeof(size_t));
+    if(!next){
+        FreeSparseMatrix(&result);
+        return NULL;
+    }
+    memcpy(next, result->offsets, minors * sizeof(size_t));
+    for(size_t major = 0; major < majors; major++){
+        for(size_t p = sparse->offsets[major]; p < sparse->offsets[major + 1]; p++){
+            size_t slot = next[sparse->indices[p]]++;
+            result->indices[slot] = (uint32_t)major;
+            result->values[slot] = sparse->values[p];
+        }
+    }
+    free(next);
+    return result;
+}
+
+typedef struct{
+    uint32_t index;
+    double value;
+}SparseEntry;
+
+static int CompareEntries(const void *a, const void *b){
+    uint32_t x = ((const SparseEntry*)a)->index, y = ((const SparseEntry*)b)->index;
+    return (x > y) - (x < y);
+}
+
+typedef struct{
+    const size_t *offsets;
+    SparseEntry *entries;
+}SortMajorsJob;
+
+static void SortMajorsTask(void *context, size_t begin, size_t end){
+    const SortMajorsJob *job = (const SortMajorsJob*)context;
+    for(size_t major = begin; major < end; major++){
+        size_t count = job->offsets[major + 1] - job->offsets[major];
+        if(count > 1)
+            qsort(job->entries + job->offsets[major], count, sizeof(SparseEntry), CompareEntries);
+    }
+}
+
+SparseMatrix SparseFromTriplets(size_t num_rows, size_t num_cols, size_t count, const size_t *rows,
+                                const size_t *cols, const double *values, int format){
+    SparseMatrix sparse = NewSparseMatrix(num_rows, num_cols, count, format);
+    if(!sparse)
+        return NULL;
+    SparseEntry *entries = (SparseEntry*)malloc((count ? count : 1) * sizeof(SparseEntry));
+    if(!entries){
+        FreeSparseMatrix(&sparse);
+        return NULL;
+    }
+    // bucket the triplets by major, then sort every major by minor index
+    const size_t *major_of = format == SPARSE_CSR ? rows : cols;
+    const size_t *minor_of = format == SPARSE_CSR ? cols : rows;
+    size_t majors = NUM_MAJOR(sparse);
+    for(size_t t = 0; t < count; t++){
+        if(rows[t] >= num_rows || cols[t] >= num_cols){
+            fprintf(stderr, "Error - Triplet %zu lies outside the matrix", t);
+            free(entries);
+            FreeSparseMatrix(&sparse);
+            return NULL;
+        }
+        sparse->offsets[major_of[t] + 1]++;
+    }
+    for(size_t m = 0; m < majors; m++)
+        sparse->offsets[m + 1] += sparse->offsets[m];
+    for(size_t t = 0; t < count; t++){
+        size_t slot = sparse->offsets[major_of[t]]++;
+        entries[slot].index = (uint32_t)minor_of[t];
+        entries[slot].value = values[t];
+    }
+    for(size_t m = majors; m > 0; m--) // undo the shift left by the fill
+        sparse->offsets[m] = sparse->offsets[m - 1];
+    sparse->offsets[0] = 0;
+    SortMajorsJob job = {sparse->offsets, entries};
+    ParallelFor(majors, 1024, SortMajorsTask, &job);
+
+    // compact, summing duplicate entries (the usual finite-element assembly)
+    size_t out = 0;
+    for(size_t m = 0; m < majors; m++){
+        size_t begin = sparse->offsets[m], end = sparse->offsets[m + 1];
+        sparse->offsets[m] = out;
+        for(size_t p = begin; p < end; p++){
+            if(out > sparse->offsets[m] && sparse->indices[out - 1] == entries[p].index){
+                sparse->values[out - 1] += entries[p].value;
+                continue;
+            }
+            sparse->indices[out] = entries[p].index;
+            sparse->values[out++] = entries[p].value;
+        }
+    }
+    sparse->offsets[majors] = out;
+    sparse->nnz = out;
+    free(entries);
+    return sparse;
+}
+
+
+/*******************************************************
+ *          Sparse Matrix-Vector Multiply
+ *******************************************************/
+typedef struct{
+    SparseMatrix sparse;
+    const double *x;
+    double *y;
+}SpmvJob;
+
+// y[major] = dot(major, x) for the majors owned by this share of nonzeros
+static void GatherTask(void *context, size_t begin, size_t end){
+    const SpmvJob *job = (const SpmvJob*)context;
+    const size_t *offsets = job->sparse->offsets;
+    const uint32_t *indices = job->sparse->indices;
+    const double *values = job->sparse->values;
+    size_t first, last;
+    MajorRange(job->sparse, begin, end, &first, &last);
+    for(size_t major = first; major < last; major++){
+        double sum = 0.0;
+        for(size_t p = offsets[major]; p < offsets[major + 1]; p++)
+            sum += values[p] * job->x[indices[p]];
+        job->y[major] = sum;
+    }
+}
+
+int SparseMultiplyVector(SparseMatrix sparse, int transpose, const double *x, double *y){
+    if(!sparse || !x || !y || x == y){
+        fprintf(stderr, "%s", "Error - Need a sparse matrix and two distinct vectors");
+        return -1;
+    }
+    STATS_BEGIN();
+    SpmvJob job = {sparse, x, y};
+    // A CSR matrix times x (and a CSC matrix transposed times x) is one dot
+    // product per major: gathered in parallel, balanced by nonzeros
+    if((sparse->format == SPARSE_CSR) != (transpose != 0)){
+        ParallelForNonzeros(sparse, GatherTask, &job);
+        STATS_END(MATRIX_STAT_SPARSE_MULTIPLY, 2.0 * sparse->nnz);
+        return 0;
+    }
+    // Otherwise each major scatters into y; done on the calling thread
+    size_t outputs = transpose ? sparse->num_cols : sparse->num_rows;
+    memset(y, 0, outputs * sizeof(double));
+    for(size_t major = 0; major < NUM_MAJOR(sparse); major++){
+        double scale = x[major];
+        if(scale == 0.0)
+            continue;
+        for(size_t p = sparse->offsets[major]; p < sparse->offsets[major + 1]; p++)
+            y[sparse->indices[p]] += sparse->values[p] * scale;
+    }
+    STATS_END(MATRIX_STAT_SPARSE_MULTIPLY, 2.0 * sparse->nnz);
+    return 0;
+}
+
+
+/*******************************************************
+ *          Sparse-Dense Multiply
+ *******************************************************/
+typedef struct{
+    SparseMatrix sparse;
+    Matrix dense, result;
+}SpmmJob;
+
+// CSR: row i of the result is a combination of the rows of B picked out by
+// row i of A, built with the axpy kernel
+static void SpmmRowsTask(void *context, size_t begin, size_t end){
+    const SpmmJob *job = (const SpmmJob*)context;
+    const size_t n = job->dense->num_cols;
+    size_t first, last;
+    MajorRange(job->sparse, begin, end, &first, &last);
+    for(size_t i = first; i < last; i++){
+        double *row = MATRIX_ROW(job->result, i);
+        memset(row, 0, n * sizeof(double));
+        for(size_t p = job->sparse->offsets[i]; p < job->sparse->offsets[i + 1]; p++)
+            matrix_kernels->axpy(n, job->sparse->values[p], MATRIX_ROW(job->dense, job->sparse->indices[p]), row);
+    }
+}
+
+// CSC: every column k of A scatters multiples of row k of B; threads take
+// disjoint column slices of B and the result so the scatters never collide
+static void SpmmSlicesTask(void *context, size_t begin, size_t end){
+    const SpmmJob *job = (const SpmmJob*)context;
+    const size_t col0 = begin * 64, width = (end * 64 < job->dense->num_cols ? end * 64 : job->dense->num_cols) - col0;
+    for(size_t i = 0; i < job->result->num_rows; i++)
+        memset(MATRIX_ROW(job->result, i) + col0, 0, width * sizeof(double));
+    for(size_t k = 0; k < job->sparse->num_cols; k++){
+        const double *b_row = MATRIX_ROW(job->dense, k) + col0;
+        for(size_t p = job->sparse->offsets[k]; p < job->sparse->offsets[k + 1]; p++)
+            matrix_kernels->axpy(width, job->sparse->values[p], b_row,
+                                 MATRIX_ROW(job->result, job->sparse->indices[p]) + col0);
+    }
+}
+
+int SparseMultiplyDenseInto(Matrix result_matrix, SparseMatrix sparse, Matrix dense){
+    if(!sparse || isEmpty(dense) || isEmpty(result_matrix) || sparse->num_cols != dense->num_rows ||
+       result_matrix->num_rows != sparse->num_rows || result_matrix->num_cols != dense->num_cols){
+        fprintf(stderr, "%s", "Error - Result must be MxP to hold the product of an MxN sparse and an NxP matrix");
+        return -1;
+    }
+    if(MatricesOverlap(result_matrix, dense)){
+        fprintf(stderr, "%s", "Error - Result of a multiplication cannot be one of its operands");
+        return -1;
+    }
+    STATS_BEGIN();
+    SpmmJob job = {sparse, dense, result_matrix};
+    if(sparse->format == SPARSE_CSR){
+        ParallelForNonzeros(sparse, SpmmRowsTask, &job);
+    }
+    else{
+        size_t slices = (dense->num_cols + 63) / 64;
+        size_t work = sparse->nnz * 64 + 1;
+        ParallelFor(slices, work >= 16384 ? 1 : 16384 / work + 1, SpmmSlicesTask, &job);
+    }
+    STATS_END(MATRIX_STAT_SPARSE_MULTIPLY, 2.0 * sparse->nnz * dense->num_cols);
+    return 0;
+}
+
+Matrix SparseMultiplyDense(SparseMatrix sparse, Matrix dense){
+    if(!sparse || isEmpty(dense))
+        return NULL;
+    Matrix result_matrix = NewMatrix(sparse->num_rows, dense->num_cols);
+    if(result_matrix && SparseMultiplyDenseInto(result_matrix, sparse, dense) != 0)
+        FreeMatrix(&result_matrix);
+    return result_matrix;
+}
+
+
+/*******************************************************
+ *          Sparse Addition
+ *******************************************************/
+typedef struct{
+    SparseMatrix a, b, result;
+    double sign;
+}SparseAddJob;
+
+// Walks the sorted index lists of one major of A and B together. With
+// result NULL it only counts the union; otherwise it fills the merged major.
+static size_t MergeMajor(const SparseAddJob *job, size_t major, SparseMatrix result){
+    const SparseMatrix a = job->a, b = job->b;
+    size_t p = a->offsets[major], p_end = a->offsets[major + 1];
+    size_t q = b->offsets[major], q_end = b->offsets[major + 1];
+    size_t out = result ? result->offsets[major] : 0, count = 0;
+    while(p < p_end || q < q_end){
+        uint32_t index;
+        double value;
+        if(q == q_end || (p < p_end && a->indices[p] < b->indices[q])){
+            index = a->indices[p];
+            value = a->values[p++];
+        }
+        else if(p == p_end || b->indices[q] < a->indices[p]){
+            index = b->indices[q];
+            value = job->sign * b->values[q++];
+        }
+        else{
+            index = a->indices[p];
+            value = a->values[p++] + job->sign * b->values[q++];
+        }
+        if(result){
+            result->indices[out] = index;
+            result->values[out++] = value;
+        }
+        count++;
+    }
+    return count;
+}
+
+static void CountMergeTask(void *context, size_t begin, size_t end){
+    const SparseAddJob *job = (const SparseAddJob*)context;
+    for(size_t major = begin; major < end; major++)
+        job->result->offsets[major + 1] = MergeMajor(job, major, NULL);
+}
+
+static void FillMergeTask(void *context, size_t begin, size_t end){
+    const SparseAddJob *job = (const SparseAddJob*)context;
+    for(size_t major = begin; major < end; major++)
+        MergeMajor(job, major, job->result);
+}
+
+SparseMatrix SparseAdd(SparseMatrix sparse_A, SparseMatrix sparse_B, int subtract_flag){
+    if(!sparse_A || !sparse_B || sparse_A->num_rows != sparse_B->num_rows || sparse_A->num_cols != sparse_B->num_cols){
+        fprintf(stderr, "%s", "Error - Need sparse matrices of the same size to perform matrix addition");
+        return NULL;
+    }
+    // B is brought to A's layout if the formats differ
+    SparseMatrix converted = NULL;
+    if(sparse_B->format != sparse_A->format){
+        converted = SparseConvert(sparse_B, sparse_A->format);
+        if(!converted)
+            return NULL;
+        sparse_B = converted;
+    }
+    SparseMatrix result = NewSparseMatrix(sparse_A->num_rows, sparse_A->num_cols, 0, sparse_A->format);
+    if(!result){
+        FreeSparseMatrix(&converted);
+        return NULL;
+    }
+    SparseAddJob job = {sparse_A, sparse_B, result, subtract_flag == 1 ? -1.0 : 1.0};
+    size_t majors = NUM_MAJOR(sparse_A);
+    size_t per_major = (sparse_A->nnz + sparse_B->nnz) / (majors ? majors : 1) + 1;
+    size_t chunk = per_major >= SPARSE_MIN_NONZEROS ? 1 : SPARSE_MIN_NONZEROS / per_major;
+
+    ParallelFor(majors, chunk, CountMergeTask, &job);
+    for(size_t m = 0; m < majors; m++)
+        result->offsets[m + 1] += result->offsets[m];
+    result->nnz = result->offsets[majors];
+    FreeAligned(result->indices);
+    FreeAligned(result->values);
+    result->indices = (uint32_t*)AllocateAligned((result->nnz ? result->nnz : 1) * sizeof(uint32_t));
+    result->values  = (double*)AllocateAligned((result->nnz ? result->nnz : 1) * sizeof(double));
+    if(!result->indices || !result->values){
+        fprintf(stderr, "%s", "Error - Could not allocate sparse matrix");
+        FreeSparseMatrix(&result);
+        FreeSparseMatrix(&converted);
+        return NULL;
+    }
+    ParallelFor(majors, chunk, FillMergeTask, &job);
+    FreeSparseMatrix(&converted);
+    return result;
+}
@@ -0,0 +1,120 @@
+/****************************
+ * Author: Blake A. Molina
+ * Created on: 10/17/26
+ * License: GPL
+ ****************************/
+
+#include <time.h>
+#include "matrix_internal.h"
+
+static const char *const stat_names[MATRIX_STAT_COUNT] = {
+    "new_matrix", "multiply", "add", "transpose", "rotate", "rref", "solve_system",
+    "determinant", "lu_factor", "lu_solve", "cholesky", "cholesky_solve",
+    "sparse_multiply", "krylov", "mixed_solve", "batch", "file_io", "qr", "tiled",
+    "factor_update", "eigen"
+};
+
+/*******************************************************
+ *          Counters
+ *******************************************************/
+#ifdef SMLC_ENABLE_STATS
+#include <stdatomic.h>
+
+// Each entry point's counters share a cache line, so threads recording
+// different operations do not contend
+typedef struct{
+    _Alignas(MATRIX_ALIGNMENT) atomic_uint_fast64_t calls;
+    atomic_uint_fast64_t total_ns;
+    atomic_uint_fast64_t max_ns;
+    atomic_uint_fast64_t flops;
+}OpCounters;
+
+static OpCounters counters[MATRIX_STAT_COUNT];
+static _Alignas(MATRIX_ALIGNMENT) atomic_uint_fast64_t bytes_allocated;
+static _Alignas(MATRIX_ALIGNMENT) atomic_uint_fast64_t pivot_swaps;
+
+uint64_t StatsClock(void){
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+}
+
+void StatsRecord(int op, uint64_t start, uint64_t flops){
+    uint64_t elapsed = StatsClock() - start;
+    OpCounters *counter = &counters[op];
+    atomic_fetch_add_explicit(&counter->calls, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&counter->total_ns, elapsed, memory_order_relaxed);
+    atomic_fetch_add_explicit(&counter->flops, flops, memory_order_relaxed);
+    uint_fast64_t longest = atomic_load_explicit(&counter->max_ns, memory_order_relaxed);
+    while(elapsed > longest &&
+          !atomic_compare_exchange_weak_explicit(&counter->max_ns, &longest, elapsed,
+                                                 memory_order_relaxed, memory_order_relaxed))
+        ;
+}
+
+void StatsAllocated(uint64_t bytes){
+    atomic_fetch_add_explicit(&bytes_allocated, bytes, memory_order_relaxed);
+}
+
+void StatsPivotSwap(void){
+    atomic_fetch_add_explicit(&pivot_swaps, 1, memory_order_relaxed);
+}
+#endif
+
+
+/*******************************************************
+ *          Snapshot & Reset
+ *******************************************************/
+void GetMatrixStats(MatrixStats *stats){
+    if(!stats)
+        return;
+    memset(stats, 0, sizeof(*stats));
+    for(int op = 0; op < MATRIX_STAT_COUNT; op++)
+        stats->ops[op].name = stat_names[op];
+#ifdef SMLC_ENABLE_STATS
+    stats->enabled = 1;
+    stats->bytes_allocated = atomic_load_explicit(&bytes_allocated, memory_order_relaxed);
+    stats->pivot_swaps = atomic_load_explicit(&pivot_swaps, memory_order_relaxed);
+    for(int op = 0; op < MATRIX_STAT_COUNT; op++){
+        stats->ops[op].calls = atomic_load_explicit(&counters[op].calls, memory_order_relaxed);
+        stats->ops[op].total_ns = atomic_load_explicit(&counters[op].total_ns, memory_order_relaxed);
+        stats->ops[op].max_ns = atomic_load_explicit(&counters[op].max_ns, memory_order_relaxed);
+        stats->ops[op].flops = atomic_load_explicit(&counters[op].flops, memory_order_relaxed);
+    }
+#endif
+}
+
+void ResetMatrixStats(void){
+#ifdef SMLC_ENABLE_STATS
+    atomic_store_explicit(&bytes_allocated, 0, memory_order_relaxed);
+    atomic_store_explicit(&pivot_swaps, 0, memory_order_relaxed);
+    for(int op = 0; op < MATRIX_STAT_COUNT; op++){
+        atomic_store_explicit(&counters[op].calls, 0, memory_order_relaxed);
+        atomic_store_explicit(&counters[op].total_ns, 0, memory_order_relaxed);
+        atomic_store_explicit(&counters[op].max_ns, 0, memory_order_relaxed);
+        atomic_store_explicit(&counters[op].flops, 0, memory_order_relaxed);
+    }
+#endif
+}
+
+
+/*******************************************************
+ *          JSON Dump
+ *******************************************************/
+int WriteMatrixStatsJSON(FILE *stream){
+    if(!stream)
+        return -1;
+    MatrixStats stats;
+    GetMatrixStats(&stats);
+    fprintf(stream, "{\"enabled\": %s, \"bytes_allocated\": %llu, \"pivot_swaps\": %llu, \"operations\": {",
+            stats.enabled ? "true" : "false",
+            (unsigned long long)stats.bytes_allocated, (unsigned long long)stats.pivot_swaps);
+    for(int op = 0; op < MATRIX_STAT_COUNT; op++){
+        const MatrixOpStats *entry = &stats.ops[op];
+        fprintf(stream, "%s\n  \"%s\": {\"calls\": %llu, \"total_seconds\": %.9f, \"max_seconds\": %.9f, \"flops\": %llu}",
+                op ? "," : "", entry->name, (unsigned long long)entry->calls,
+                entry->total_ns * 1e-9, entry->max_ns * 1e-9, (unsigned long long)entry->flops);
+    }
+    fprintf(stream, "%s", "\n}}\n");
+    return ferror(stream) ? -1 : 0;
+}
@@ -0,0 +1,271 @@
+/****************************
+ * Author: Blake A. Molina
+ * Created on: 10/17/26
+ * License: GPL
+ ****************************/
+
+#include <stdatomic.h>
+#include "matrix_internal.h"
+
+// Products whose smallest dimension is at or below this go to DenseGemm
+#define STRASSEN_DEFAULT_CUTOFF 1024
+// Never recurse below this, whatever the cutoff: halves would be too small
+// for the classical kernel to run near peak
+#define STRASSEN_MIN_CUTOFF 64
+
+static atomic_size_t strassen_cutoff = STRASSEN_DEFAULT_CUTOFF;
+
+void SetStrassenCutoff(size_t cutoff){
+    if(cutoff == 0)
+        cutoff = STRASSEN_DEFAULT_CUTOFF;
+    atomic_store(&strassen_cutoff, cutoff < STRASSEN_MIN_CUTOFF ? STRASSEN_MIN_CUTOFF : cutoff);
+}
+
+size_t GetStrassenCutoff(void){
+    return atomic_load(&strassen_cutoff);
+}
+
+// Temporaries are stored with rows rounded to a cache line
+static size_t PaddedWidth(size_t cols){
+    const size_t per_line = MATRIX_ALIGNMENT / sizeof(double);
+    return (cols + per_line - 1) / per_line * per_line;
+}
+
+static int Recurse(size_t m, size_t k, size_t n, size_t cutoff){
+    size_t smallest = m < k ? (m < n ? m : n) : (k < n ? k : n);
+    return smallest > cutoff;
+}
+
+
+/*******************************************************
+ *          Block Arithmetic
+ *******************************************************/
+typedef struct{
+    size_t cols;
+    const double *x;
+    size_t ldx;
+    double beta;
+    const double *y;
+    size_t ldy;
+    double *z;
+    size_t ldz;
+}BlockAddJob;
+
+static void BlockAddTask(void *context, size_t begin, size_t end){
+    const BlockAddJob *job = (const BlockAddJob*)context;
+    for(size_t i = begin; i < end; i++)
+        matrix_kernels->add(job->cols, job->x + i*job->ldx, job->beta, job->y + i*job->ldy, job->z + i*job->ldz);
+}
+
+// z = x + beta * y for rows x cols blocks (z may be x or y)
+static void BlockAdd(size_t rows, size_t cols, const double *x, size_t ldx, double beta,
+                     const double *y, size_t ldy, double *z, size_t ldz){
+    BlockAddJob job = {cols, x, ldx, beta, y, ldy, z, ldz};
+    ParallelFor(rows, cols >= 16384 ? 1 : 16384 / cols + 1, BlockAddTask, &job);
+}
+
+
+/*******************************************************
+ *          Strassen-Winograd Recursion
+ *******************************************************/
+// Doubles of workspace StrassenEven needs for an m x k by k x n product:
+// the X and Y temporaries of this level plus those of the level below
+static size_t WorkspaceSize(size_t m, size_t k, size_t n, size_t cutoff){
+    if(!Recurse(m, k, n, cutoff))
+        return 0;
+    size_t m2 = m / 2, k2 = k / 2, n2 = n / 2;
+    size_t x_width = PaddedWidth(k2 > n2 ? k2 : n2);
+    return m2 * x_width + k2 * PaddedWidth(n2) + WorkspaceSize(m2, k2, n2, cutoff);
+}
+
+static void Strassen(size_t m, size_t k, size_t n, const double *A, size_t lda,
+                     const double *B, size_t ldb, double *C, size_t ldc, double *work, size_t cutoff);
+
+// C = A * B for even m, k and n with Winograd's variant (7 products,
+// 15 additions), in the order of Boyer, Dumas, Pernet and Zhou that needs
+// only two temporaries: X (an A quadrant, or a C quadrant if wider) and Y
+// (a B quadrant). P1..P7 are the seven products, U1..U7 the sums.
+static void StrassenEven(size_t m, size_t k, size_t n, const double *A, size_t lda,
+                         const double *B, size_t ldb, double *C, size_t ldc, double *work, size_t cutoff){
+    size_t m2 = m / 2, k2 = k / 2, n2 = n / 2;
+    const double *A11 = A, *A12 = A + k2, *A21 = A + m2*lda, *A22 = A21 + k2;
+    const double *B11 = B, *B12 = B + n2, *B21 = B + k2*ldb, *B22 = B21 + n2;
+    double *C11 = C, *C12 = C + n2, *C21 = C + m2*ldc, *C22 = C21 + n2;
+    size_t ldx = PaddedWidth(k2 > n2 ? k2 : n2), ldy = PaddedWidth(n2);
+    double *X = work, *Y = X + m2*ldx, *next = Y + k2*ldy;
+
+    BlockAdd(m2, k2, A11, lda, -1.0, A21, lda, X, ldx);            // S3 = A11 - A21
+    BlockAdd(k2, n2, B22, ldb, -1.0, B12, ldb, Y, ldy);            // T3 = B22 - B12
+    Strassen(m2, k2, n2, X, ldx, Y, ldy, C21, ldc, next, cutoff);  // P7 = S3 * T3
+    BlockAdd(m2, k2, A21, lda, 1.0, A22, lda, X, ldx);             // S1 = A21 + A22
+    BlockAdd(k2, n2, B12, ldb, -1.0, B11, ldb, Y, ldy);            // T1 = B12 - B11
+    Strassen(m2, k2, n2, X, ldx, Y, ldy, C22, ldc, next, cutoff);  // P5 = S1 * T1
+    BlockAdd(m2, k2, X, ldx, -1.0, A11, lda, X, ldx);              // S2 = S1 - A11
+    BlockAdd(k2, n2, B22, ldb, -1.0, Y, ldy, Y, ldy);              // T2 = B22 - T1
+    Strassen(m2, k2, n2, X, ldx, Y, ldy, C12, ldc, next, cutoff);  // P6 = S2 * T2
+    BlockAdd(m2, k2, A12, lda, -1.0, X, ldx, X, ldx);              // S4 = A12 - S2
+    Strassen(m2, k2, n2, X, ldx, B22, ldb, C11, ldc, next, cutoff); // P3 = S4 * B22
+    Strassen(m2, k2, n2, A11, lda, B11, ldb, X, ldx, next, cutoff); // P1 = A11 * B11
+    BlockAdd(m2, n2, X, ldx, 1.0, C12, ldc, C12, ldc);             // U2 = P1 + P6
+    BlockAdd(m2, n2, C12, ldc, 1.0, C21, ldc, C21, ldc);           // U3 = U2 + P7
+    BlockAdd(m2, n2, C12, ldc, 1.0, C22, ldc, C12, ldc);           // U4 = U2 + P5
+    BlockAdd(m2, n2, C21, ldc, 1.0, C22, ldc, C22, ldc);           // U7 = U3 + P5 (C22)
+    BlockAdd(m2, n2, C12, ldc, 1.0, C11, ldc, C12, ldc);           // U5 = U4 + P3 (C12)
+    BlockAdd(k2, n2, Y, ldy, -1.0, B21, ldb, Y, ldy);              // T4 = T2 - B21
+    Strassen(m2, k2, n2, A22, lda, Y, ldy, C11, ldc, next, cutoff); // P4 = A22 * T4
+    BlockAdd(m2, n2, C21, ldc, -1.0, C11, ldc, C21, ldc);          // U6 = U3 - P4 (C21)
+    Strassen(m2, k2, n2, A12, lda, B21, ldb, C11, ldc, next, cutoff); // P2 = A12 * B21
+    BlockAdd(m2, n2, X, ldx, 1.0, C11, ldc, C11, ldc);             // U1 = P1 + P2 (C11)
+}
+
+// The last row / column of an odd dimension is peeled off: the even part
+// recurses and the strips are finished by the classical kernel
+static void PeelOdd(size_t m, size_t k, size_t n, const double *A, size_t lda,
+                    const double *B, size_t ldb, double *C, size_t ldc){
+    size_t me = m & ~(size_t)1, ke = k & ~(size_t)1, ne = n & ~(size_t)1;
+    if(ke < k) // C[0:me, 0:ne] += A[0:me, k-1] * B[k-1, 0:ne]
+        DenseGemm(0, 0, me, ne, 1, 1.0, A + ke, lda, B + ke*ldb, ldb, 1.0, C, ldc);
+    if(ne < n) // last column of C
+        DenseGemm(0, 0, m, 1, k, 1.0, A, lda, B + ne, ldb, 0.0, C + ne, ldc);
+    if(me < m) // last row of C, left of the last column
+        DenseGemm(0, 0, 1, ne, k, 1.0, A + me*lda, lda, B, ldb, 0.0, C + me*ldc, ldc);
+}
+
+static void Strassen(size_t m, size_t k, size_t n, const double *A, size_t lda,
+                     const double *B, size_t ldb, double *C, size_t ldc, double *work, size_t cutoff){
+    if(!Recurse(m, k, n, cutoff)){
+        DenseGemm(0, 0, m, n, k, 1.0, A, lda, B, ldb, 0.0, C, ldc);
+        return;
+    }
+    StrassenEven(m & ~(size_t)1, k & ~(size_t)1, n & ~(size_t)1, A, lda, B, ldb, C, ldc, work, cutoff);
+    PeelOdd(m, k, n, A, lda, B, ldb, C, ldc);
+}
+
+
+/*******************************************************
+ *          Parallel Top Level
+ *******************************************************/
+// The seven products of the top level are independent once the S and T
+// sums exist, so each becomes one task running the sequential recursion
+// above (whose own GEMMs and additions then stay on that thread).
+typedef struct{
+    size_t m2, k2, n2, cutoff, work_size;
+    const double *left[7], *right[7];
+    size_t ld_left[7], ld_right[7];
+    double *product[7];
+    size_t ld_product[7];
+    double *work;
+}ProductsJob;
+
+static void ProductsTask(void *context, size_t begin, size_t end){
+    const ProductsJob *job = (const ProductsJob*)context;
+    for(size_t p = begin; p < end; p++)
+        Strassen(job->m2, job->k2, job->n2, job->left[p], job->ld_left[p], job->right[p], job->ld_right[p],
+                 job->product[p], job->ld_product[p], job->work + p*job->work_size, job->cutoff);
+}
+
+// StrassenEven with the seven products run concurrently. Needs all of S1..S4,
+// T1..T4 and three extra products (P1, P2, P4) at once; returns -1 without
+// touching C if that memory is not available.
+static int StrassenParallel(size_t m, size_t k, size_t n, const double *A, size_t lda,
+                            const double *B, size_t ldb, double *C, size_t ldc, size_t cutoff){
+    size_t m2 = m / 2, k2 = k / 2, n2 = n / 2;
+    size_t lds = PaddedWidth(k2), ldt = PaddedWidth(n2), ldp = PaddedWidth(n2);
+    size_t work_size = WorkspaceSize(m2, k2, n2, cutoff);
+    size_t total = 4*m2*lds + 4*k2*ldt + 3*m2*ldp + 7*work_size;
+    double *buffer = (double*)AllocateAligned(total * sizeof(double));
+    if(!buffer)
+        return -1;
+    const double *A11 = A, *A12 = A + k2, *A21 = A + m2*lda, *A22 = A21 + k2;
+    const double *B11 = B, *B12 = B + n2, *B21 = B + k2*ldb, *B22 = B21 + n2;
+    double *C11 = C, *C12 = C + n2, *C21 = C + m2*ldc, *C22 = C21 + n2;
+    double *S1 = buffer, *S2 = S1 + m2*lds, *S3 = S2 + m2*lds, *S4 = S3 + m2*lds;
+    double *T1 = S4 + m2*lds, *T2 = T1 + k2*ldt, *T3 = T2 + k2*ldt, *T4 = T3 + k2*ldt;
+    double *P1 = T4 + k2*ldt, *P2 = P1 + m2*ldp, *P4 = P2 + m2*ldp;
+
+    BlockAdd(m2, k2, A21, lda, 1.0, A22, lda, S1, lds);   // S1 = A21 + A22
+    BlockAdd(m2, k2, S1, lds, -1.0, A11, lda, S2, lds);   // S2 = S1 - A11
+    BlockAdd(m2, k2, A11, lda, -1.0, A21, lda, S3, lds);  // S3 = A11 - A21
+    BlockAdd(m2, k2, A12, lda, -1.0, S2, lds, S4, lds);   // S4 = A12 - S2
+    BlockAdd(k2, n2, B12, ldb, -1.0, B11, ldb, T1, ldt);  // T1 = B12 - B11
+    BlockAdd(k2, n2, B22, ldb, -1.0, T1, ldt, T2, ldt);   // T2 = B22 - T1
+    BlockAdd(k2, n2, B22, ldb, -1.0, B12, ldb, T3, ldt);  // T3 = B22 - B12
+    BlockAdd(k2, n2, T2, ldt, -1.0, B21, ldb, T4, ldt);   // T4 = T2 - B21
+
+    // P3, P5, P6 and P7 land in the C quadrants, as in StrassenEven
+    ProductsJob job = {
+        m2, k2, n2, cutoff, work_size,
+        {A11, A12, S4, A22, S1, S2, S3}, {B11, B21, B22, T4, T1, T2, T3},
+        {lda, lda, lds, lda, lds, lds, lds}, {ldb, ldb, ldb, ldt, ldt, ldt, ldt},
+        {P1, P2, C11, P4, C22, C12, C21}, {ldp, ldp, ldc, ldp, ldc, ldc, ldc},
+        P4 + m2*ldp
+    };
+    ParallelFor(7, 1, ProductsTask, &job);
+
+    BlockAdd(m2, n2, P1, ldp, 1.0, C12, ldc, C12, ldc);    // U2 = P1 + P6
+    BlockAdd(m2, n2, C12, ldc, 1.0, C21, ldc, C21, ldc);   // U3 = U2 + P7
+    BlockAdd(m2, n2, C12, ldc, 1.0, C22, ldc, C12, ldc);   // U4 = U2 + P5
+    BlockAdd(m2, n2, C21, ldc, 1.0, C22, ldc, C22, ldc);   // U7 = U3 + P5 (C22)
+    BlockAdd(m2, n2, C12, ldc, 1.0, C11, ldc, C12, ldc);   // U5 = U4 + P3 (C12)
+    BlockAdd(m2, n2, C21, ldc, -1.0, P4, ldp, C21, ldc);   // U6 = U3 - P4 (C21)
+    BlockAdd(m2, n2, P1, ldp, 1.0, P2, ldp, C11, ldc);     // U1 = P1 + P2 (C11)
+    FreeAligned(buffer);
+    return 0;
+}
+
+
+/*******************************************************
+ *          Public Entry Points
+ *******************************************************/
+int MultiplyMatricesStrassenInto(Matrix result_matrix, Matrix matrix_A, Matrix matrix_B){
+    if(isEmpty(matrix_A) || isEmpty(matrix_B) || isEmpty(result_matrix) ||
+       matrix_A->num_cols != matrix_B->num_rows ||
+       result_matrix->num_rows != matrix_A->num_rows || result_matrix->num_cols != matrix_B->num_cols){
+        fprintf(stderr, "%s", "Error - Result must be MxP to hold the product of an MxN and an NxP matrix");
+        return -1;
+    }
+    if(MatricesOverlap(result_matrix, matrix_A) || MatricesOverlap(result_matrix, matrix_B)){
+        fprintf(stderr, "%s", "Error - Result of a multiplication cannot be one of its operands");
+        return -1;
+    }
+    size_t m = matrix_A->num_rows, k = matrix_A->num_cols, n = matrix_B->num_cols;
+    size_t cutoff = GetStrassenCutoff();
+    const double *A = matrix_A->data, *B = matrix_B->data;
+    double *C = result_matrix->data;
+    size_t lda = matrix_A->ld, ldb = matrix_B->ld, ldc = result_matrix->ld;
+    STATS_BEGIN();
+
+    int done = 0;
+    if(Recurse(m, k, n, cutoff) && GetMatrixThreads() > 1){
+        done = StrassenParallel(m & ~(size_t)1, k & ~(size_t)1, n & ~(size_t)1, A, lda, B, ldb, C, ldc, cutoff) == 0;
+        if(done)
+            PeelOdd(m, k, n, A, lda, B, ldb, C, ldc);
+    }
+    if(!done){
+        // sequential recursion (its GEMMs and additions still use every
+        // thread); the workspace for all levels is allocated up front
+        size_t work_size = WorkspaceSize(m, k, n, cutoff);
+        double *work = work_size ? (double*)AllocateAligned(work_size * sizeof(double)) : NULL;
+        if(work_size && !work){
+            // no room for the temporaries: the classical product needs none
+            DenseGemm(0, 0, m, n, k, 1.0, A, lda, B, ldb, 0.0, C, ldc);
+        }
+        else
+            Strassen(m, k, n, A, lda, B, ldb, C, ldc, work, cutoff);
+        FreeAligned(work);
+    }
+    STATS_END(MATRIX_STAT_MULTIPLY, 2.0 * m * n * k);
+    return 0;
+}
+
+Matrix MultiplyMatricesStrassen(Matrix matrix_A, Matrix matrix_B){
+    if(isEmpty(matrix_A) || isEmpty(matrix_B) || matrix_A->num_cols != matrix_B->num_rows){
+        fprintf(stderr, "%s", "Error - Matrix A's column count must equal matrix B's row count to multiply");
+        return NULL;
+    }
+    Matrix result_matrix = NewMatrix(matrix_A->num_rows, matrix_B->num_cols);
+    if(!result_matrix)
+        return NULL;
+    MultiplyMatricesStrassenInto(result_matrix, matrix_A, matrix_B);
+    return result_matrix;
+}
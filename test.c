@@ -0,0 +1,803 @@
+/****************************
+ * Author: Blake A. Molina
+ * Created on: 10/17/26
+ * License: GPL
+ ****************************/
+
+#include <math.h>
+#include "matrix.h"
+
+// Regression checks run by `make check`; each test returns 0 on success
+static int failures = 0;
+
+#define CHECK(condition) \
+    do{ \
+        if(!(condition)){ \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            failures++; \
+        } \
+    }while(0)
+
+/*******************************************************
+ *          Reference Helpers
+ *******************************************************/
+static unsigned long long test_seed = 12345;
+
+// Fills a matrix with pseudo-random values in [-0.5, 0.5)
+static void FillRandom(Matrix matrix){
+    for(size_t i = 0; i < matrix->num_rows; i++)
+        for(size_t j = 0; j < matrix->num_cols; j++){
+            test_seed = test_seed * 6364136223846793005ULL + 1442695040888963407ULL;
+            MATRIX_AT(matrix, i, j) = (double)(test_seed >> 11) / 9007199254740992.0 - 0.5;
+        }
+}
+
+static Matrix RandomMatrix(size_t num_rows, size_t num_cols){
+    Matrix matrix = NewMatrix(num_rows, num_cols);
+    FillRandom(matrix);
+    return matrix;
+}
+
+// The textbook triple loop
+static Matrix NaiveMultiply(Matrix a, Matrix b){
+    Matrix c = NewMatrix(a->num_rows, b->num_cols);
+    for(size_t i = 0; i < a->num_rows; i++)
+        for(size_t j = 0; j < b->num_cols; j++){
+            double sum = 0.0;
+            for(size_t k = 0; k < a->num_cols; k++)
+                sum += MATRIX_AT(a, i, k) * MATRIX_AT(b, k, j);
+            MATRIX_AT(c, i, j) = sum;
+        }
+    return c;
+}
+
+static double MaxDifference(Matrix a, Matrix b){
+    double worst = 0.0;
+    for(size_t i = 0; i < a->num_rows; i++)
+        for(size_t j = 0; j < a->num_cols; j++){
+            double difference = fabs(MATRIX_AT(a, i, j) - MATRIX_AT(b, i, j));
+            worst = difference > worst ? difference : worst;
+        }
+    return worst;
+}
+
+static Matrix CopyOf(Matrix matrix){
+    Matrix copy = NewMatrix(matrix->num_rows, matrix->num_cols);
+    for(size_t i = 0; i < matrix->num_rows; i++)
+        for(size_t j = 0; j < matrix->num_cols; j++)
+            MATRIX_AT(copy, i, j) = MATRIX_AT(matrix, i, j);
+    return copy;
+}
+
+
+/*******************************************************
+ *          GEMM
+ *******************************************************/
+// Products against the triple loop for shapes around the small-product,
+// register tile and cache block boundaries, into fresh matrices and views
+static void TestMultiplyMatchesTripleLoop(void){
+    const size_t shapes[][3] = {
+        {1, 1, 1}, {2, 3, 4}, {7, 13, 5}, {8, 8, 8}, {31, 33, 17},
+        {64, 64, 64}, {97, 257, 33}, {130, 300, 70}, {200, 513, 150}
+    };
+    for(size_t s = 0; s < sizeof(shapes) / sizeof(shapes[0]); s++){
+        size_t m = shapes[s][0], k = shapes[s][1], n = shapes[s][2];
+        Matrix a = RandomMatrix(m, k), b = RandomMatrix(k, n);
+        Matrix expected = NaiveMultiply(a, b);
+        Matrix product = MultiplyMatrices(a, b);
+        CHECK(product && MaxDifference(product, expected) < 1e-12 * k);
+        // the same product written into a block of a wider matrix
+        Matrix parent = RandomMatrix(m + 2, n + 3);
+        Matrix block = MatrixView(parent, 1, 2, m, n, 1);
+        CHECK(MultiplyMatricesInto(block, a, b) == 0);
+        CHECK(MaxDifference(block, expected) < 1e-12 * k);
+        FreeMatrix(&a);
+        FreeMatrix(&b);
+        FreeMatrix(&expected);
+        FreeMatrix(&product);
+        FreeMatrix(&block);
+        FreeMatrix(&parent);
+    }
+}
+
+// The float engine against the same loop, to float accuracy
+static void TestMultiplyFMatchesTripleLoop(void){
+    const size_t m = 70, k = 300, n = 45;
+    Matrix a = RandomMatrix(m, k), b = RandomMatrix(k, n);
+    Matrix expected = NaiveMultiply(a, b);
+    MatrixF a_f = MatrixToFloat(a), b_f = MatrixToFloat(b);
+    MatrixF product_f = MultiplyMatricesF(a_f, b_f);
+    Matrix product = product_f ? MatrixToDouble(product_f) : NULL;
+    CHECK(product && MaxDifference(product, expected) < 1e-4);
+    FreeMatrix(&a);
+    FreeMatrix(&b);
+    FreeMatrix(&expected);
+    FreeMatrix(&product);
+    FreeMatrixF(&a_f);
+    FreeMatrixF(&b_f);
+    FreeMatrixF(&product_f);
+}
+
+
+/*******************************************************
+ *          Arena Ownership
+ *******************************************************/
+// A heap matrix transposed into a new shape while an arena is active must
+// stay on the heap, so resetting the arena cannot clobber it
+static void TestTransposeKeepsHeapStorage(void){
+    Matrix a = NewMatrix(2, 3);
+    for(size_t i = 0; i < 2; i++)
+        for(size_t j = 0; j < 3; j++)
+            MATRIX_AT(a, i, j) = (double)(i * 3 + j + 1);
+    MatrixArena arena = NewMatrixArena(0);
+    MatrixArena previous = UseMatrixArena(arena);
+    Transpose(a);
+    ResetMatrixArena(arena);
+    Matrix scribble = NewMatrix(3, 2);
+    for(size_t i = 0; i < 3; i++)
+        for(size_t j = 0; j < 2; j++)
+            MATRIX_AT(scribble, i, j) = -99.0;
+    UseMatrixArena(previous);
+    CHECK(a->num_rows == 3 && a->num_cols == 2);
+    CHECK(a->flags & MATRIX_OWNS_DATA);
+    for(size_t i = 0; i < 3; i++)
+        for(size_t j = 0; j < 2; j++)
+            CHECK(MATRIX_AT(a, i, j) == (double)(j * 3 + i + 1));
+    FreeMatrixArena(&arena);
+    FreeMatrix(&a);
+}
+
+// An arena matrix transposed into a new shape stays arena-owned
+static void TestTransposeKeepsArenaStorage(void){
+    MatrixArena arena = NewMatrixArena(0);
+    MatrixArena previous = UseMatrixArena(arena);
+    Matrix a = NewMatrix(2, 3);
+    MATRIX_AT(a, 0, 2) = 5.0;
+    Transpose(a);
+    CHECK(!(a->flags & MATRIX_OWNS_DATA));
+    CHECK(MATRIX_AT(a, 2, 0) == 5.0);
+    UseMatrixArena(previous);
+    FreeMatrixArena(&arena);
+}
+
+// Factorization objects are heap-owned even when made inside an arena scope
+static void TestFactorsOutliveArena(void){
+    Matrix a = NewMatrix(3, 3);
+    for(size_t i = 0; i < 3; i++)
+        MATRIX_AT(a, i, i) = (double)(i + 2);
+    MatrixArena arena = NewMatrixArena(0);
+    MatrixArena previous = UseMatrixArena(arena);
+    LUFactorization lu = LUFactor(a);
+    QRFactorization qr = QRFactor(a, 0.0);
+    ResetMatrixArena(arena);
+    Matrix scribble = NewMatrix(8, 8);
+    for(size_t i = 0; i < 8; i++)
+        for(size_t j = 0; j < 8; j++)
+            MATRIX_AT(scribble, i, j) = -99.0;
+    UseMatrixArena(previous);
+    CHECK(lu && LUDeterminant(lu) == 24.0);
+    Matrix rhs = NewMatrix(3, 1);
+    for(size_t i = 0; i < 3; i++)
+        MATRIX_AT(rhs, i, 0) = (double)(i + 2);
+    Matrix x = qr ? QRSolve(qr, rhs) : NULL;
+    CHECK(x != NULL);
+    for(size_t i = 0; x && i < 3; i++)
+        CHECK(fabs(MATRIX_AT(x, i, 0) - 1.0) < 1e-12);
+    FreeMatrix(&x);
+    FreeMatrix(&rhs);
+    FreeLUFactorization(&lu);
+    FreeQRFactorization(&qr);
+    FreeMatrixArena(&arena);
+    FreeMatrix(&a);
+}
+
+
+/*******************************************************
+ *          Lazy Expressions
+ *******************************************************/
+// R = A + (R + B) * C: the result is a leaf nested inside a product operand
+static void TestExprNestedResultAlias(void){
+    Matrix r = RandomMatrix(4, 4), a = RandomMatrix(4, 4), b = RandomMatrix(4, 4), c = RandomMatrix(4, 4);
+    Matrix sum = CopyOf(r);
+    for(size_t i = 0; i < 4; i++)
+        for(size_t j = 0; j < 4; j++)
+            MATRIX_AT(sum, i, j) += MATRIX_AT(b, i, j);
+    Matrix expected = NaiveMultiply(sum, c);
+    for(size_t i = 0; i < 4; i++)
+        for(size_t j = 0; j < 4; j++)
+            MATRIX_AT(expected, i, j) += MATRIX_AT(a, i, j);
+    MatrixExprGraph graph = NewMatrixExprGraph();
+    MatrixExpr expr = ExprAdd(ExprMatrix(graph, a),
+                              ExprMultiply(ExprAdd(ExprMatrix(graph, r), ExprMatrix(graph, b)), ExprMatrix(graph, c)));
+    CHECK(EvaluateExprInto(r, expr) == 0);
+    CHECK(MaxDifference(r, expected) < 1e-12);
+    FreeMatrixExprGraph(&graph);
+    FreeMatrix(&r);
+    FreeMatrix(&a);
+    FreeMatrix(&b);
+    FreeMatrix(&c);
+    FreeMatrix(&sum);
+    FreeMatrix(&expected);
+}
+
+
+/*******************************************************
+ *          Views & Aliasing
+ *******************************************************/
+// A strided view reads and writes its parent's elements
+static void TestViewIndexing(void){
+    Matrix parent = RandomMatrix(9, 7);
+    Matrix view = MatrixView(parent, 1, 2, 4, 3, 2);
+    CHECK(view && view->num_rows == 4 && view->num_cols == 3);
+    for(size_t i = 0; view && i < 4; i++)
+        for(size_t j = 0; j < 3; j++){
+            CHECK(MATRIX_AT(view, i, j) == MATRIX_AT(parent, 1 + 2 * i, 2 + j));
+            MATRIX_AT(view, i, j) = -1.0;
+            CHECK(MATRIX_AT(parent, 1 + 2 * i, 2 + j) == -1.0);
+        }
+    CHECK(MatrixView(parent, 7, 0, 2, 7, 2) == NULL);
+    FreeMatrix(&view);
+    FreeMatrix(&parent);
+}
+
+// Products refuse a result that overlaps an operand, but take disjoint
+// blocks of one parent; shape changes of a view are refused
+static void TestViewAliasRejection(void){
+    Matrix parent = RandomMatrix(8, 8);
+    Matrix a = MatrixView(parent, 0, 0, 4, 4, 1);
+    Matrix b = MatrixView(parent, 0, 4, 4, 4, 1);
+    Matrix overlapping = MatrixView(parent, 2, 2, 4, 4, 1);
+    Matrix disjoint = MatrixView(parent, 4, 0, 4, 4, 1);
+    Matrix before = CopyOf(parent);
+    CHECK(MultiplyMatricesInto(overlapping, a, b) == -1);
+    CHECK(MultiplyMatricesInto(a, a, b) == -1);
+    CHECK(MultiplyMatricesStrassenInto(overlapping, a, b) == -1);
+    CHECK(MaxDifference(parent, before) == 0.0);
+    Matrix expected = NaiveMultiply(a, b);
+    CHECK(MultiplyMatricesInto(disjoint, a, b) == 0);
+    CHECK(MaxDifference(disjoint, expected) < 1e-14);
+    Matrix wide = MatrixView(parent, 0, 0, 2, 5, 1);
+    Transpose(wide);
+    CHECK(wide->num_rows == 2 && wide->num_cols == 5);
+    FreeMatrix(&a);
+    FreeMatrix(&b);
+    FreeMatrix(&overlapping);
+    FreeMatrix(&disjoint);
+    FreeMatrix(&wide);
+    FreeMatrix(&expected);
+    FreeMatrix(&before);
+    FreeMatrix(&parent);
+}
+
+// A 3x5 and a 5x3 view from one origin share storage without being one
+// square matrix, so transposing one into the other must be refused
+static void TestTransposeIntoRejectsSameOriginViews(void){
+    Matrix parent = RandomMatrix(6, 6);
+    Matrix expected = CopyOf(parent);
+    Matrix wide = MatrixView(parent, 0, 0, 3, 5, 1);
+    Matrix tall = MatrixView(parent, 0, 0, 5, 3, 1);
+    CHECK(TransposeInto(wide, tall) == -1);
+    CHECK(MaxDifference(parent, expected) == 0.0);
+    // a square view onto itself is still transposed in place
+    Matrix square = MatrixView(parent, 1, 1, 4, 4, 1);
+    CHECK(TransposeInto(square, square) == 0);
+    CHECK(MATRIX_AT(parent, 1, 2) == MATRIX_AT(expected, 2, 1));
+    FreeMatrix(&wide);
+    FreeMatrix(&tall);
+    FreeMatrix(&square);
+    FreeMatrix(&parent);
+    FreeMatrix(&expected);
+}
+
+
+/*******************************************************
+ *          Single Precision
+ *******************************************************/
+static void TestMultiplyIntoFRejectsOperandResult(void){
+    MatrixF a = NewMatrixF(600, 600), b = NewMatrixF(600, 600);
+    CHECK(MultiplyMatricesIntoF(a, a, b) == -1);
+    CHECK(MultiplyMatricesIntoF(b, a, b) == -1);
+    FreeMatrixF(&a);
+    FreeMatrixF(&b);
+}
+
+
+/*******************************************************
+ *          LU Factorization
+ *******************************************************/
+// max |A * X - B|
+static double SolveResidual(Matrix a, Matrix x, Matrix b){
+    Matrix product = NaiveMultiply(a, x);
+    double residual = MaxDifference(product, b);
+    FreeMatrix(&product);
+    return residual;
+}
+
+static void TestLUSolveResidual(void){
+    const size_t sizes[] = {1, 2, 5, 9, 64, 150, 301};
+    for(size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++){
+        size_t n = sizes[s];
+        Matrix a = RandomMatrix(n, n), b = RandomMatrix(n, 3);
+        for(size_t i = 0; i < n; i++)
+            MATRIX_AT(a, i, i) += 2.0;
+        LUFactorization lu = LUFactor(a);
+        Matrix x = lu ? LUSolve(lu, b) : NULL;
+        CHECK(x && SolveResidual(a, x, b) < 1e-11 * n);
+        // the O(n) determinant of the factors agrees with Determinant()
+        double determinant = Determinant(a);
+        CHECK(lu && fabs(LUDeterminant(lu) - determinant) <= 1e-10 * fabs(determinant));
+        FreeLUFactorization(&lu);
+        FreeMatrix(&x);
+        FreeMatrix(&a);
+        FreeMatrix(&b);
+    }
+}
+
+// A singular matrix factors, but solving with it is refused
+static void TestLUSingular(void){
+    Matrix a = RandomMatrix(6, 6), b = RandomMatrix(6, 1);
+    for(size_t i = 0; i < 6; i++)
+        MATRIX_AT(a, 4, i) = MATRIX_AT(a, 1, i);
+    LUFactorization lu = LUFactor(a);
+    CHECK(lu && LUDeterminant(lu) == 0.0);
+    CHECK(lu && LUSolveInPlace(lu, b) != 0);
+    FreeLUFactorization(&lu);
+    FreeMatrix(&a);
+    FreeMatrix(&b);
+}
+
+
+/*******************************************************
+ *          Cholesky
+ *******************************************************/
+// M * M^T + N * I: symmetric and safely positive definite
+static Matrix RandomSPD(size_t n){
+    Matrix m = RandomMatrix(n, n);
+    Matrix spd = NewMatrix(n, n);
+    for(size_t i = 0; i < n; i++)
+        for(size_t j = 0; j < n; j++){
+            double sum = i == j ? (double)n : 0.0;
+            for(size_t k = 0; k < n; k++)
+                sum += MATRIX_AT(m, i, k) * MATRIX_AT(m, j, k);
+            MATRIX_AT(spd, i, j) = sum;
+        }
+    FreeMatrix(&m);
+    return spd;
+}
+
+// L * L^T against A, zero upper triangle, and both solve paths by residual
+static void TestCholeskyFactorAndSolve(void){
+    const size_t sizes[] = {1, 3, 8, 65, 200};
+    for(size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++){
+        size_t n = sizes[s];
+        Matrix a = RandomSPD(n), b = RandomMatrix(n, 2);
+        Matrix factor = Cholesky(a);
+        CHECK(factor != NULL);
+        if(!factor){
+            FreeMatrix(&a);
+            FreeMatrix(&b);
+            continue;
+        }
+        double worst = 0.0;
+        for(size_t i = 0; i < n; i++)
+            for(size_t j = 0; j < n; j++){
+                double sum = 0.0;
+                for(size_t k = 0; k < n; k++)
+                    sum += MATRIX_AT(factor, i, k) * MATRIX_AT(factor, j, k);
+                worst = fabs(sum - MATRIX_AT(a, i, j)) > worst ? fabs(sum - MATRIX_AT(a, i, j)) : worst;
+                if(j > i)
+                    CHECK(MATRIX_AT(factor, i, j) == 0.0);
+            }
+        CHECK(worst < 1e-12 * n * n);
+        Matrix x = CholeskySolve(factor, b);
+        CHECK(x && SolveResidual(a, x, b) < 1e-11 * n);
+        double *packed = (double*)malloc(CHOLESKY_PACKED_SIZE(n) * sizeof(double));
+        Matrix y = CopyOf(b);
+        CHECK(CholeskyPacked(a, packed) == 0 && CholeskySolvePacked(packed, y) == 0);
+        CHECK(SolveResidual(a, y, b) < 1e-11 * n);
+        free(packed);
+        FreeMatrix(&x);
+        FreeMatrix(&y);
+        FreeMatrix(&factor);
+        FreeMatrix(&a);
+        FreeMatrix(&b);
+    }
+}
+
+// An indefinite matrix reports its first bad pivot
+static void TestCholeskyRejectsIndefinite(void){
+    Matrix a = RandomSPD(5);
+    MATRIX_AT(a, 3, 3) = -1.0;
+    CHECK(CholeskyInPlace(a) == 4);
+    FreeMatrix(&a);
+}
+
+
+/*******************************************************
+ *          Row Kernels
+ *******************************************************/
+// Sums and differences over widths that leave every possible vector tail,
+// with the result one of the operands
+static void TestAddMatchesElementwise(void){
+    for(size_t cols = 1; cols <= 37; cols += 3){
+        Matrix a = RandomMatrix(5, cols), b = RandomMatrix(5, cols);
+        Matrix sum = AddMatrices(a, b, 0);
+        CHECK(sum != NULL);
+        for(size_t i = 0; sum && i < 5; i++)
+            for(size_t j = 0; j < cols; j++)
+                CHECK(MATRIX_AT(sum, i, j) == MATRIX_AT(a, i, j) + MATRIX_AT(b, i, j));
+        Matrix expected = CopyOf(a);
+        CHECK(AddMatricesInto(a, a, b, 1) == 0);
+        for(size_t i = 0; i < 5; i++)
+            for(size_t j = 0; j < cols; j++)
+                CHECK(MATRIX_AT(a, i, j) == MATRIX_AT(expected, i, j) - MATRIX_AT(b, i, j));
+        FreeMatrix(&a);
+        FreeMatrix(&b);
+        FreeMatrix(&sum);
+        FreeMatrix(&expected);
+    }
+}
+
+
+/*******************************************************
+ *          Transpose & Rotation
+ *******************************************************/
+// Rectangular and square (in place) transposes across the tile edges
+static void TestTransposeMatchesIndexSwap(void){
+    const size_t shapes[][2] = {{1, 1}, {1, 9}, {3, 3}, {7, 7}, {33, 17}, {64, 64}, {130, 45}, {257, 257}};
+    for(size_t s = 0; s < sizeof(shapes) / sizeof(shapes[0]); s++){
+        size_t m = shapes[s][0], n = shapes[s][1];
+        Matrix a = RandomMatrix(m, n);
+        Matrix original = CopyOf(a);
+        Matrix into = NewMatrix(n, m);
+        CHECK(TransposeInto(a, into) == 0);
+        Transpose(a);
+        CHECK(a->num_rows == n && a->num_cols == m);
+        for(size_t i = 0; i < n; i++)
+            for(size_t j = 0; j < m; j++){
+                CHECK(MATRIX_AT(a, i, j) == MATRIX_AT(original, j, i));
+                CHECK(MATRIX_AT(into, i, j) == MATRIX_AT(original, j, i));
+            }
+        FreeMatrix(&a);
+        FreeMatrix(&original);
+        FreeMatrix(&into);
+    }
+}
+
+// Quarter turns both ways, the half turn and the flips by index arithmetic
+static void TestRotationsMatchIndexMaps(void){
+    const size_t sizes[] = {1, 2, 5, 64, 71};
+    for(size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++){
+        size_t n = sizes[s];
+        Matrix original = RandomMatrix(n, n);
+        Matrix a = CopyOf(original);
+        RotateMatrixClockwise(a);
+        for(size_t i = 0; i < n; i++)
+            for(size_t j = 0; j < n; j++)
+                CHECK(MATRIX_AT(a, i, j) == MATRIX_AT(original, n - 1 - j, i));
+        RotateMatrixCounterClockwise(a);
+        CHECK(MaxDifference(a, original) == 0.0);
+        FreeMatrix(&a);
+        FreeMatrix(&original);
+    }
+    Matrix original = RandomMatrix(6, 11);
+    Matrix half = CopyOf(original), horizontal = CopyOf(original), vertical = CopyOf(original);
+    Rotate180(half);
+    FlipHorizontal(horizontal);
+    FlipVertical(vertical);
+    for(size_t i = 0; i < 6; i++)
+        for(size_t j = 0; j < 11; j++){
+            CHECK(MATRIX_AT(half, i, j) == MATRIX_AT(original, 5 - i, 10 - j));
+            CHECK(MATRIX_AT(horizontal, i, j) == MATRIX_AT(original, i, 10 - j));
+            CHECK(MATRIX_AT(vertical, i, j) == MATRIX_AT(original, 5 - i, j));
+        }
+    FreeMatrix(&original);
+    FreeMatrix(&half);
+    FreeMatrix(&horizontal);
+    FreeMatrix(&vertical);
+}
+
+
+/*******************************************************
+ *          Sparse Matrices
+ *******************************************************/
+// A random matrix with most entries zeroed
+static Matrix RandomSparseDense(size_t num_rows, size_t num_cols){
+    Matrix dense = RandomMatrix(num_rows, num_cols);
+    for(size_t i = 0; i < num_rows; i++)
+        for(size_t j = 0; j < num_cols; j++)
+            if(fabs(MATRIX_AT(dense, i, j)) < 0.4)
+                MATRIX_AT(dense, i, j) = 0.0;
+    return dense;
+}
+
+// Conversions, products with vectors (both ways) and dense matrices, and
+// sums, in both formats against the dense arithmetic
+static void TestSparseMatchesDense(void){
+    const int formats[] = {SPARSE_CSR, SPARSE_CSC};
+    Matrix dense = RandomSparseDense(37, 23), other = RandomSparseDense(37, 23);
+    Matrix right = RandomMatrix(23, 5);
+    Matrix x = RandomMatrix(1, 37);
+    Matrix expected = NaiveMultiply(dense, right);
+    for(size_t f = 0; f < 2; f++){
+        SparseMatrix sparse = SparseFromDense(dense, 0.0, formats[f]);
+        SparseMatrix sparse_other = SparseFromDense(other, 0.0, formats[f]);
+        Matrix back = SparseToDense(sparse);
+        CHECK(back && MaxDifference(back, dense) == 0.0);
+        double y[37], y_t[23];
+        CHECK(SparseMultiplyVector(sparse, 0, x->data, y) == 0);
+        CHECK(SparseMultiplyVector(sparse, 1, x->data, y_t) == 0);
+        for(size_t i = 0; i < 37; i++){
+            double sum = 0.0;
+            for(size_t j = 0; j < 23; j++)
+                sum += MATRIX_AT(dense, i, j) * x->data[j];
+            CHECK(fabs(y[i] - sum) < 1e-13);
+        }
+        for(size_t j = 0; j < 23; j++){
+            double sum = 0.0;
+            for(size_t i = 0; i < 37; i++)
+                sum += MATRIX_AT(dense, i, j) * x->data[i];
+            CHECK(fabs(y_t[j] - sum) < 1e-13);
+        }
+        Matrix product = SparseMultiplyDense(sparse, right);
+        CHECK(product && MaxDifference(product, expected) < 1e-13);
+        SparseMatrix difference = SparseAdd(sparse, sparse_other, 1);
+        Matrix difference_dense = difference ? SparseToDense(difference) : NULL;
+        CHECK(difference_dense != NULL);
+        for(size_t i = 0; difference_dense && i < 37; i++)
+            for(size_t j = 0; j < 23; j++)
+                CHECK(MATRIX_AT(difference_dense, i, j) == MATRIX_AT(dense, i, j) - MATRIX_AT(other, i, j));
+        FreeSparseMatrix(&sparse);
+        FreeSparseMatrix(&sparse_other);
+        FreeSparseMatrix(&difference);
+        FreeMatrix(&back);
+        FreeMatrix(&product);
+        FreeMatrix(&difference_dense);
+    }
+    FreeMatrix(&dense);
+    FreeMatrix(&other);
+    FreeMatrix(&right);
+    FreeMatrix(&x);
+    FreeMatrix(&expected);
+}
+
+// Repeated triplets are summed; out-of-range ones are refused
+static void TestSparseTripletsSumDuplicates(void){
+    const size_t rows[] = {2, 0, 2, 1, 2}, cols[] = {1, 0, 1, 2, 0};
+    const double values[] = {1.0, 2.0, 3.0, 4.0, 5.0};
+    SparseMatrix sparse = SparseFromTriplets(3, 3, 5, rows, cols, values, SPARSE_CSR);
+    Matrix dense = sparse ? SparseToDense(sparse) : NULL;
+    CHECK(dense && MATRIX_AT(dense, 2, 1) == 4.0 && MATRIX_AT(dense, 0, 0) == 2.0 &&
+          MATRIX_AT(dense, 1, 2) == 4.0 && MATRIX_AT(dense, 2, 0) == 5.0 && MATRIX_AT(dense, 1, 1) == 0.0);
+    const size_t bad_rows[] = {3};
+    CHECK(SparseFromTriplets(3, 3, 1, bad_rows, cols, values, SPARSE_CSC) == NULL);
+    FreeSparseMatrix(&sparse);
+    FreeMatrix(&dense);
+}
+
+
+/*******************************************************
+ *          Krylov Solvers
+ *******************************************************/
+// ||b - A x|| / ||b|| recomputed from the operator
+static double RelativeResidual(const LinearOperator *op, const double *b, const double *x){
+    size_t n = op->size;
+    double *ax = (double*)malloc(n * sizeof(double));
+    op->apply(op->context, x, ax);
+    double residual = 0.0, norm = 0.0;
+    for(size_t i = 0; i < n; i++){
+        residual += (b[i] - ax[i]) * (b[i] - ax[i]);
+        norm += b[i] * b[i];
+    }
+    free(ax);
+    return sqrt(residual / norm);
+}
+
+// 1D Laplacian plus a shift, applied without forming it
+static void ShiftedLaplacian(void *context, const double *x, double *y){
+    size_t n = *(const size_t*)context;
+    for(size_t i = 0; i < n; i++)
+        y[i] = 2.5 * x[i] - (i > 0 ? x[i - 1] : 0.0) - (i + 1 < n ? x[i + 1] : 0.0);
+}
+
+// CG on a sparse SPD system (plain, Jacobi, IC(0)) and a matrix-free one;
+// BiCGSTAB and GMRES on a dense nonsymmetric system (plain, ILU(0))
+static void TestKrylovSolversConverge(void){
+    size_t n = 200;
+    size_t rows[3 * 200], cols[3 * 200], count = 0;
+    double values[3 * 200];
+    for(size_t i = 0; i < n; i++){
+        rows[count] = i, cols[count] = i, values[count++] = 2.5;
+        if(i > 0)
+            rows[count] = i, cols[count] = i - 1, values[count++] = -1.0;
+        if(i + 1 < n)
+            rows[count] = i, cols[count] = i + 1, values[count++] = -1.0;
+    }
+    SparseMatrix laplacian = SparseFromTriplets(n, n, count, rows, cols, values, SPARSE_CSR);
+    LinearOperator sparse_op = SparseOperator(laplacian);
+    LinearOperator free_op = MatrixFreeOperator(n, ShiftedLaplacian, &n);
+    Matrix b = RandomMatrix(1, n), x = NewMatrix(1, n);
+    SolverOptions options = {1e-10, 0, 0, NULL, NULL};
+    SolverReport report;
+    Preconditioner preconditioners[3] = {NULL, NewJacobiPreconditioner(&sparse_op),
+                                         NewIncompleteCholeskyPreconditioner(&sparse_op)};
+    for(size_t p = 0; p < 3; p++){
+        memset(x->data, 0, n * sizeof(double));
+        CHECK(SolveCG(&sparse_op, preconditioners[p], b->data, x->data, &options, &report) == 0);
+        CHECK(report.converged && RelativeResidual(&sparse_op, b->data, x->data) < 1e-9);
+        FreePreconditioner(&preconditioners[p]);
+    }
+    memset(x->data, 0, n * sizeof(double));
+    CHECK(SolveCG(&free_op, NULL, b->data, x->data, &options, &report) == 0);
+    CHECK(RelativeResidual(&free_op, b->data, x->data) < 1e-9);
+
+    Matrix a = RandomMatrix(n, n);
+    for(size_t i = 0; i < n; i++)
+        MATRIX_AT(a, i, i) += 0.6 * n;
+    LinearOperator dense_op = DenseOperator(a);
+    Preconditioner ilu = NewILU0Preconditioner(&dense_op);
+    for(size_t p = 0; p < 2; p++){
+        Preconditioner preconditioner = p ? ilu : NULL;
+        memset(x->data, 0, n * sizeof(double));
+        CHECK(SolveBiCGSTAB(&dense_op, preconditioner, b->data, x->data, &options, &report) == 0);
+        CHECK(RelativeResidual(&dense_op, b->data, x->data) < 1e-9);
+        memset(x->data, 0, n * sizeof(double));
+        CHECK(SolveGMRES(&dense_op, preconditioner, b->data, x->data, &options, &report) == 0);
+        CHECK(RelativeResidual(&dense_op, b->data, x->data) < 1e-9);
+    }
+    FreePreconditioner(&ilu);
+    FreeSparseMatrix(&laplacian);
+    FreeMatrix(&a);
+    FreeMatrix(&b);
+    FreeMatrix(&x);
+}
+
+
+/*******************************************************
+ *          QR Factorization
+ *******************************************************/
+// Least squares against the normal equations: A^T (A x - b) = 0, and
+// exact recovery when the system is consistent
+static void TestLeastSquaresNormalEquations(void){
+    Matrix a = RandomMatrix(90, 40), b = RandomMatrix(90, 3);
+    Matrix x = LeastSquares(a, b);
+    CHECK(x && x->num_rows == 40 && x->num_cols == 3);
+    Matrix ax = NaiveMultiply(a, x);
+    for(size_t i = 0; i < ax->num_rows; i++)
+        for(size_t j = 0; j < ax->num_cols; j++)
+            MATRIX_AT(ax, i, j) -= MATRIX_AT(b, i, j);
+    Matrix at = NewMatrix(40, 90);
+    TransposeInto(a, at);
+    Matrix gradient = NaiveMultiply(at, ax);
+    Matrix zero = NewMatrix(40, 3);
+    CHECK(MaxDifference(gradient, zero) < 1e-10);
+
+    Matrix exact = RandomMatrix(40, 2);
+    Matrix consistent = NaiveMultiply(a, exact);
+    Matrix recovered = LeastSquares(a, consistent);
+    CHECK(recovered && MaxDifference(recovered, exact) < 1e-10);
+    Matrix *matrices[] = {&a, &b, &x, &ax, &at, &gradient, &zero, &exact, &consistent, &recovered};
+    for(size_t i = 0; i < sizeof(matrices) / sizeof(*matrices); i++)
+        FreeMatrix(matrices[i]);
+}
+
+// A product of 60x7 and 7x30 factors has rank 7, whatever its shape
+static void TestMatrixRankOfLowRankProduct(void){
+    Matrix left = RandomMatrix(60, 7), right = RandomMatrix(7, 30);
+    Matrix product = NaiveMultiply(left, right);
+    CHECK(MatrixRank(product, 0) == 7);
+    Matrix full = RandomMatrix(30, 60);
+    CHECK(MatrixRank(full, 0) == 30);
+    FreeMatrix(&left);
+    FreeMatrix(&right);
+    FreeMatrix(&product);
+    FreeMatrix(&full);
+}
+
+
+/*******************************************************
+ *          Eigenvalues
+ *******************************************************/
+// max |A v_j - lambda_j v_j| and max |v_i . v_j - delta_ij| over columns
+static void EigenResiduals(Matrix a, const double *eigenvalues, Matrix vectors,
+                           double *residual, double *orthogonality){
+    Matrix av = NaiveMultiply(a, vectors);
+    *residual = *orthogonality = 0.0;
+    for(size_t j = 0; j < vectors->num_cols; j++){
+        for(size_t i = 0; i < vectors->num_rows; i++){
+            double difference = fabs(MATRIX_AT(av, i, j) - eigenvalues[j] * MATRIX_AT(vectors, i, j));
+            *residual = difference > *residual ? difference : *residual;
+        }
+        for(size_t l = 0; l < vectors->num_cols; l++){
+            double dot = 0.0;
+            for(size_t i = 0; i < vectors->num_rows; i++)
+                dot += MATRIX_AT(vectors, i, j) * MATRIX_AT(vectors, i, l);
+            dot = fabs(dot - (j == l ? 1.0 : 0.0));
+            *orthogonality = dot > *orthogonality ? dot : *orthogonality;
+        }
+    }
+    FreeMatrix(&av);
+}
+
+// The full decomposition by its residual and orthogonality, then Lanczos
+// against its largest eigenvalues
+static void TestEigenpairsResidual(void){
+    size_t n = 120, k = 4;
+    Matrix a = RandomSPD(n), vectors = NewMatrix(n, n);
+    double eigenvalues[120], residual, orthogonality;
+    CHECK(SymmetricEigen(a, eigenvalues, vectors) == 0);
+    EigenResiduals(a, eigenvalues, vectors, &residual, &orthogonality);
+    CHECK(residual < 1e-9 * eigenvalues[n - 1] && orthogonality < 1e-10);
+    for(size_t i = 1; i < n; i++)
+        CHECK(eigenvalues[i - 1] <= eigenvalues[i]);
+
+    LinearOperator op = DenseOperator(a);
+    Matrix dominant = NewMatrix(n, k);
+    double largest[4];
+    SolverOptions options = {1e-10, 0, 0, NULL, NULL};
+    CHECK(DominantEigenpairs(&op, k, largest, dominant, &options, NULL) == 0);
+    for(size_t j = 0; j < k; j++)
+        CHECK(fabs(largest[j] - eigenvalues[n - 1 - j]) < 1e-8 * eigenvalues[n - 1]);
+    EigenResiduals(a, largest, dominant, &residual, &orthogonality);
+    CHECK(residual < 1e-8 * largest[0] && orthogonality < 1e-10);
+    FreeMatrix(&a);
+    FreeMatrix(&vectors);
+    FreeMatrix(&dominant);
+}
+
+
+/*******************************************************
+ *          Strassen
+ *******************************************************/
+// The cutoff reads back clamped, and odd shapes recursing two levels
+// below it still match the triple loop
+static void TestStrassenCutoffAndProduct(void){
+    size_t previous = GetStrassenCutoff();
+    SetStrassenCutoff(1);
+    CHECK(GetStrassenCutoff() == 64);
+    SetStrassenCutoff(0);
+    CHECK(GetStrassenCutoff() == 1024);
+    SetStrassenCutoff(64);
+    Matrix a = RandomMatrix(301, 263), b = RandomMatrix(263, 277);
+    Matrix expected = NaiveMultiply(a, b), c = MultiplyMatricesStrassen(a, b);
+    CHECK(c && MaxDifference(c, expected) < 1e-11);
+    SetStrassenCutoff(previous);
+    FreeMatrix(&a);
+    FreeMatrix(&b);
+    FreeMatrix(&expected);
+    FreeMatrix(&c);
+}
+
+
+int main(void){
+    TestMultiplyMatchesTripleLoop();
+    TestMultiplyFMatchesTripleLoop();
+    TestTransposeKeepsHeapStorage();
+    TestTransposeKeepsArenaStorage();
+    TestFactorsOutliveArena();
+    TestExprNestedResultAlias();
+    TestViewIndexing();
+    TestViewAliasRejection();
+    TestTransposeIntoRejectsSameOriginViews();
+    TestMultiplyIntoFRejectsOperandResult();
+    TestLUSolveResidual();
+    TestLUSingular();
+    TestCholeskyFactorAndSolve();
+    TestCholeskyRejectsIndefinite();
+    TestAddMatchesElementwise();
+    TestTransposeMatchesIndexSwap();
+    TestRotationsMatchIndexMaps();
+    TestSparseMatchesDense();
+    TestSparseTripletsSumDuplicates();
+    TestKrylovSolversConverge();
+    TestLeastSquaresNormalEquations();
+    TestMatrixRankOfLowRankProduct();
+    TestEigenpairsResidual();
+    TestStrassenCutoffAndProduct();
+    if(failures){
+        fprintf(stderr, "%d check(s) failed with the %s kernels\n", failures, MatrixKernelName());
+        return 1;
+    }
+    printf("All checks passed with the %s kernels\n", MatrixKernelName());
+    return 0;
+}
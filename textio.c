@@ -0,0 +1,325 @@
+/****************************
+ * Author: Blake A. Molina
+ * Created on: 10/17/26
+ * License: GPL
+ ****************************/
+
+#include "matrix_internal.h"
+
+// Bytes read or formatted before each trip to the stream
+#define TEXT_CHUNK (1u << 20)
+// Longest formatted value: sign, 17 significant digits, point, exponent
+#define MAX_NUMBER_LENGTH 40
+
+/*******************************************************
+ *          Number Parsing
+ *******************************************************/
+// Exactly representable powers of ten (10^22 is the largest)
+static const double exact_powers[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+static int IsSeparator(char c){
+    return c == ' ' || c == '\t' || c == ',' || c == ';' || c == '\r';
+}
+
+// Parses the number at text, which ends before end. Numbers with at most 19
+// significant digits whose mantissa and power of ten are both exact in a
+// double are converted with one correctly rounded multiply or divide; the
+// rest (long mantissas, large exponents, inf, nan) go through strtod.
+// Returns the character after the number, or NULL if there is none.
+static const char *ParseNumber(const char *text, const char *end, double *value){
+    const char *at = text;
+    int negative = 0;
+    if(at < end && (*at == '-' || *at == '+'))
+        negative = *at++ == '-';
+    uint64_t mantissa = 0;
+    int digits = 0, exponent = 0, seen_digit = 0;
+    for(; at < end && *at >= '0' && *at <= '9'; at++, seen_digit = 1){
+        if(digits < 19){
+            mantissa = mantissa * 10 + (uint64_t)(*at - '0');
+            digits += mantissa != 0;
+        }
+        else
+            exponent++;
+    }
+    if(at < end && *at == '.'){
+        for(at++; at < end && *at >= '0' && *at <= '9'; at++, seen_digit = 1){
+            if(digits < 19){
+                mantissa = mantissa * 10 + (uint64_t)(*at - '0');
+                digits += mantissa != 0;
+                exponent--;
+            }
+        }
+    }
+    int fast = seen_digit && digits < 19;
+    if(seen_digit && at < end && (*at == 'e' || *at == 'E')){
+        const char *mark = at++;
+        int exponent_negative = 0, exponent_value = 0, exponent_digit = 0;
+        if(at < end && (*at == '-' || *at == '+'))
+            exponent_negative = *at++ == '-';
+        for(; at < end && *at >= '0' && *at <= '9'; at++, exponent_digit = 1)
+            if(exponent_value < 100000)
+                exponent_value = exponent_value * 10 + (*at - '0');
+        if(exponent_digit)
+            exponent += exponent_negative ? -exponent_value : exponent_value;
+        else
+            at = mark; // "1e" is the number 1 followed by junk
+    }
+    if(fast && mantissa <= (1ull << 53) && exponent >= -22 && exponent <= 22){
+        double result = (double)mantissa;
+        result = exponent < 0 ? result / exact_powers[-exponent] : result * exact_powers[exponent];
+        *value = negative ? -result : result;
+        return at;
+    }
+
+    // slow path on a terminated copy of the token
+    char token[512];
+    size_t length = 0;
+    while(text + length < end && !IsSeparator(text[length]) && text[length] != '\n' && length < sizeof(token) - 1){
+        token[length] = text[length];
+        length++;
+    }
+    token[length] = '\0';
+    char *stop;
+    *value = strtod(token, &stop);
+    return stop == token ? NULL : text + (stop - token);
+}
+
+
+/*******************************************************
+ *          Reading
+ *******************************************************/
+typedef struct{
+    double *values;
+    size_t count, capacity;
+    size_t num_rows, num_cols;
+    size_t line;         // current line number, for error messages
+    int header_checked;  // the first non-empty line has been seen
+}TextReader;
+
+static int PushValue(TextReader *reader, double value){
+    if(reader->count == reader->capacity){
+        size_t capacity = reader->capacity ? reader->capacity * 2 : 4096;
+        double *grown = (double*)realloc(reader->values, capacity * sizeof(double));
+        if(!grown)
+            return -1;
+        reader->values = grown;
+        reader->capacity = capacity;
+    }
+    reader->values[reader->count++] = value;
+    return 0;
+}
+
+// Parses one line (without its newline); returns -1 on a malformed line
+static int ParseLine(TextReader *reader, const char *at, const char *end){
+    reader->line++;
+    while(at < end && IsSeparator(*at))
+        at++;
+    if(at == end || *at == '#')
+        return 0; // blank line or comment
+    size_t start = reader->count, fields = 0;
+    while(at < end){
+        double value;
+        const char *next = ParseNumber(at, end, &value);
+        if(!next || (next < end && !IsSeparator(*next))){
+            if(!reader->header_checked){
+                // a first line that is not numeric is a column header
+                reader->header_checked = 1;
+                reader->count = start;
+                return 0;
+            }
+            fprintf(stderr, "Error - Line %zu: not a number", reader->line);
+            return -1;
+        }
+        if(PushValue(reader, value) != 0){
+            fprintf(stderr, "%s", "Error - Could not allocate memory while reading matrix");
+            return -1;
+        }
+        fields++;
+        for(at = next; at < end && IsSeparator(*at); at++)
+            ;
+    }
+    reader->header_checked = 1;
+    if(reader->num_rows == 0)
+        reader->num_cols = fields;
+    else if(fields != reader->num_cols){
+        fprintf(stderr, "Error - Line %zu: %zu values, expected %zu", reader->line, fields, reader->num_cols);
+        return -1;
+    }
+    reader->num_rows++;
+    return 0;
+}
+
+Matrix ReadMatrixText(FILE *stream){
+    if(!stream)
+        return NULL;
+    STATS_BEGIN();
+    TextReader reader = {NULL, 0, 0, 0, 0, 0, 0};
+    size_t capacity = TEXT_CHUNK, held = 0;
+    char *buffer = (char*)malloc(capacity);
+    int status = buffer ? 0 : -1;
+    int at_end = 0;
+    while(status == 0 && !at_end){
+        // top the buffer up, then parse every complete line in it
+        if(held == capacity){
+            // a line longer than the buffer: grow it
+            char *grown = (char*)realloc(buffer, capacity * 2);
+            if(!grown){
+                status = -1;
+                break;
+            }
+            buffer = grown;
+            capacity *= 2;
+        }
+        size_t got = fread(buffer + held, 1, capacity - held, stream);
+        held += got;
+        at_end = got == 0;
+        const char *line = buffer, *end = buffer + held;
+        for(;;){
+            const char *newline = (const char*)memchr(line, '\n', (size_t)(end - line));
+            if(!newline){
+                if(at_end && line < end)  // last line without a newline
+                    status = ParseLine(&reader, line, end);
+                if(at_end)
+                    line = end;
+                break;
+            }
+            if((status = ParseLine(&reader, line, newline)) != 0)
+                break;
+            line = newline + 1;
+        }
+        held = (size_t)(end - line);
+        memmove(buffer, line, held);
+    }
+    if(status == 0 && ferror(stream)){
+        fprintf(stderr, "%s", "Error - Could not read matrix text");
+        status = -1;
+    }
+    free(buffer);
+
+    Matrix matrix = NULL;
+    if(status == 0 && reader.num_rows > 0 && reader.num_cols > 0){
+        matrix = NewMatrix(reader.num_rows, reader.num_cols);
+        if(matrix)
+            for(size_t i = 0; i < reader.num_rows; i++)
+                memcpy(MATRIX_ROW(matrix, i), reader.values + i * reader.num_cols, reader.num_cols * sizeof(double));
+    }
+    else if(status == 0)
+        fprintf(stderr, "%s", "Error - No matrix values found");
+    free(reader.values);
+    STATS_END(MATRIX_STAT_FILE_IO, 0);
+    return matrix;
+}
+
+Matrix LoadMatrixText(const char *path){
+    FILE *stream = path ? fopen(path, "r") : NULL;
+    if(!stream){
+        fprintf(stderr, "Error - Could not open %s", path ? path : "(null)");
+        return NULL;
+    }
+    Matrix matrix = ReadMatrixText(stream);
+    fclose(stream);
+    return matrix;
+}
+
+
+/*******************************************************
+ *          Writing
+ *******************************************************/
+// Formats value with precision digits after the point, exactly as "%.*f".
+// Values whose scaled magnitude stays below 2^52 are formatted by hand; the
+// rest (and precision < 0: exact "%.17g") go through snprintf.
+static size_t FormatNumber(char *out, double value, int precision){
+    if(precision >= 0 && precision <= 15 && value == value){
+        // |value| * 10^p is product + error exactly (fma recovers the
+        // rounding error), so it is rounded half-to-even as printf would
+        double product = fabs(value) * exact_powers[precision];
+        if(product < 4503599627370496.0){
+            double error = fma(fabs(value), exact_powers[precision], -product);
+            double whole = floor(product);
+            double past_half = (product - whole - 0.5) + error;
+            if(past_half > 0.0 || (past_half == 0.0 && fmod(whole, 2.0) != 0.0))
+                whole += 1.0;
+            uint64_t integer = (uint64_t)whole;
+            char digits[24];
+            size_t count = 0;
+            do{
+                digits[count++] = (char)('0' + integer % 10);
+                integer /= 10;
+            }while(integer > 0 || count <= (size_t)precision);
+            size_t length = 0;
+            if(signbit(value))
+                out[length++] = '-';
+            while(count > (size_t)precision)
+                out[length++] = digits[--count];
+            if(precision > 0){
+                out[length++] = '.';
+                while(count > 0)
+                    out[length++] = digits[--count];
+            }
+            return length;
+        }
+    }
+    int length = precision >= 0 ? snprintf(out, MAX_NUMBER_LENGTH, "%.*f", precision, value)
+                                : snprintf(out, MAX_NUMBER_LENGTH, "%.17g", value);
+    if(length < 0)
+        return 0;
+    return (size_t)length < MAX_NUMBER_LENGTH ? (size_t)length : MAX_NUMBER_LENGTH - 1;
+}
+
+int FormatMatrixText(Matrix matrix, FILE *stream, int precision, char delimiter, int trailing_delimiter){
+    if(isEmpty(matrix) || !stream)
+        return -1;
+    // %f of a huge value can be hundreds of characters; those use %.17g
+    if(precision > 15)
+        precision = -1;
+    char *buffer = (char*)malloc(TEXT_CHUNK + MAX_NUMBER_LENGTH + 2);
+    if(!buffer)
+        return -1;
+    size_t used = 0;
+    int status = 0;
+    for(size_t i = 0; i < matrix->num_rows && status == 0; i++){
+        const double *row = MATRIX_ROW(matrix, i);
+        for(size_t j = 0; j < matrix->num_cols; j++){
+            double value = row[j];
+            used += fabs(value) < 1e22 ? FormatNumber(buffer + used, value, precision)
+                                       : FormatNumber(buffer + used, value, -1);
+            if(j + 1 < matrix->num_cols || trailing_delimiter)
+                buffer[used++] = delimiter;
+            if(used >= TEXT_CHUNK){
+                status = fwrite(buffer, 1, used, stream) == used ? 0 : -1;
+                used = 0;
+            }
+        }
+        buffer[used++] = '\n';
+    }
+    if(status == 0 && used > 0 && fwrite(buffer, 1, used, stream) != used)
+        status = -1;
+    free(buffer);
+    if(status != 0)
+        fprintf(stderr, "%s", "Error - Could not write matrix text");
+    return status;
+}
+
+int WriteMatrixText(Matrix matrix, FILE *stream, int precision, char delimiter){
+    STATS_BEGIN();
+    int status = FormatMatrixText(matrix, stream, precision, delimiter, 0);
+    STATS_END(MATRIX_STAT_FILE_IO, 0);
+    return status;
+}
+
+int SaveMatrixText(Matrix matrix, const char *path, int precision, char delimiter){
+    if(isEmpty(matrix))
+        return -1;
+    FILE *stream = path ? fopen(path, "w") : NULL;
+    if(!stream){
+        fprintf(stderr, "Error - Could not open %s for writing", path ? path : "(null)");
+        return -1;
+    }
+    int status = WriteMatrixText(matrix, stream, precision, delimiter);
+    if(fclose(stream) != 0)
+        status = -1;
+    return status;
+}
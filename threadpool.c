@@ -0,0 +1,156 @@
+/****************************
+ * Author: Blake A. Molina
+ * Created on: 10/17/26
+ * License: GPL
+ ****************************/
+
+#define _POSIX_C_SOURCE 200809L  // sysconf
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <unistd.h>
+#include "matrix_internal.h"
+
+/*******************************************************
+ *          Pool State
+ *******************************************************/
+// Workers are created on first use and then live for the rest of the
+// program, sleeping on work_ready between jobs. Only one job runs at a
+// time; the submitting thread works on it alongside the pool.
+static pthread_mutex_t submit_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t pool_lock   = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  work_ready  = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t  work_done   = PTHREAD_COND_INITIALIZER;
+
+static size_t num_workers = 0;        // threads in the pool (excluding callers)
+static size_t active_workers = 0;     // workers still busy with the current job
+static unsigned long generation = 0;  // bumped once per job to wake the workers
+
+static struct{
+    ParallelTask task;
+    void *context;
+    size_t count;
+    size_t parts;
+    atomic_size_t next_part;
+}job;
+
+static atomic_size_t requested_threads = 0;  // 0 until configured
+static _Thread_local int inside_parallel = 0;
+
+// Executes parts of the current job until none are left
+static void RunParts(void){
+    inside_parallel = 1;
+    for(;;){
+        size_t part = atomic_fetch_add(&job.next_part, 1);
+        if(part >= job.parts)
+            break;
+        size_t begin = job.count * part / job.parts;
+        size_t end   = job.count * (part + 1) / job.parts;
+        job.task(job.context, begin, end);
+    }
+    inside_parallel = 0;
+}
+
+// start_generation is the job generation current when the worker was
+// created; any later generation is a job it must take part in.
+static void *WorkerMain(void *start_generation){
+    unsigned long seen = (unsigned long)(uintptr_t)start_generation;
+    pthread_mutex_lock(&pool_lock);
+    for(;;){
+        while(generation == seen)
+            pthread_cond_wait(&work_ready, &pool_lock);
+        seen = generation;
+        pthread_mutex_unlock(&pool_lock);
+
+        RunParts();
+
+        pthread_mutex_lock(&pool_lock);
+        if(--active_workers == 0)
+            pthread_cond_signal(&work_done);
+    }
+    return NULL;
+}
+
+// Grows the pool to wanted workers; called with submit_lock held
+static void EnsureWorkers(size_t wanted){
+    while(num_workers < wanted){
+        pthread_t thread;
+        if(pthread_create(&thread, NULL, WorkerMain, (void*)(uintptr_t)generation) != 0)
+            break; // run with what we have
+        pthread_detach(thread);
+        num_workers++;
+    }
+}
+
+
+/*******************************************************
+ *          Thread Count
+ *******************************************************/
+void SetMatrixThreads(size_t num_threads){
+    if(num_threads == 0){
+        long online = sysconf(_SC_NPROCESSORS_ONLN);
+        num_threads = online > 0 ? (size_t)online : 1;
+    }
+    atomic_store(&requested_threads, num_threads);
+}
+
+size_t GetMatrixThreads(void){
+    size_t threads = atomic_load(&requested_threads);
+    if(threads == 0){
+        // first use: SMLC_NUM_THREADS overrides the number of online cores
+        const char *env = getenv("SMLC_NUM_THREADS");
+        long from_env = env ? strtol(env, NULL, 10) : 0;
+        SetMatrixThreads(from_env > 0 ? (size_t)from_env : 0);
+        threads = atomic_load(&requested_threads);
+    }
+    return threads;
+}
+
+
+/*******************************************************
+ *          Parallel Loops
+ *******************************************************/
+void ParallelFor(size_t count, size_t min_chunk, ParallelTask task, void *context){
+    if(count == 0)
+        return;
+    if(min_chunk == 0)
+        min_chunk = 1;
+    size_t threads = GetMatrixThreads();
+    size_t parts = count / min_chunk;
+    if(parts > threads)
+        parts = threads;
+
+    // Small inputs, nested calls from inside a job, and jobs submitted while
+    // another is running all execute serially on the calling thread.
+    if(parts <= 1 || inside_parallel || pthread_mutex_trylock(&submit_lock) != 0){
+        task(context, 0, count);
+        return;
+    }
+
+    EnsureWorkers(threads - 1);
+    if(num_workers == 0){
+        pthread_mutex_unlock(&submit_lock);
+        task(context, 0, count);
+        return;
+    }
+
+    pthread_mutex_lock(&pool_lock);
+    job.task = task;
+    job.context = context;
+    job.count = count;
+    job.parts = parts;
+    atomic_store(&job.next_part, 0);
+    active_workers = num_workers;
+    generation++;
+    pthread_cond_broadcast(&work_ready);
+    pthread_mutex_unlock(&pool_lock);
+
+    RunParts();
+
+    pthread_mutex_lock(&pool_lock);
+    while(active_workers != 0)
+        pthread_cond_wait(&work_done, &pool_lock);
+    pthread_mutex_unlock(&pool_lock);
+    pthread_mutex_unlock(&submit_lock);
+}
@@ -0,0 +1,612 @@
+/****************************
+ * Author: Blake A. Molina
+ * Created on: 10/17/26
+ * License: GPL
+ ****************************/
+
+#include <aio.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "matrix_internal.h"
+
+#define TILED_FILE_MAGIC "SMLCTIL"   // 7 characters + terminator
+#define TILED_FILE_VERSION 1
+#define TILED_FILE_BYTE_ORDER 0x01020304u
+#define TILED_DTYPE_FLOAT64 1
+
+#define TILED_DEFAULT_TILE   1024          // tile edge when none is given (8 MiB tiles)
+#define TILED_DEFAULT_BUDGET (256u << 20)  // bytes of tiles when no budget is given
+#define TILED_MAX_LOOKAHEAD  8             // reads kept in flight beyond the tiles in use
+
+/*******************************************************
+ *          File Header
+ *******************************************************/
+// Fixed 64-byte header followed by every tile, row of tiles by row of
+// tiles. Each tile is stored whole as tile_size rows of tile_ld values (the
+// layout of a NewMatrix(tile_size, tile_size)), so it is read straight into
+// a tile buffer; the parts of edge tiles outside the matrix stay zero.
+typedef struct{
+    char magic[8];
+    uint32_t version;
+    uint32_t dtype;
+    uint64_t num_rows;
+    uint64_t num_cols;
+    uint64_t tile_size;    // tiles are tile_size x tile_size
+    uint64_t tile_ld;      // values per stored tile row (a multiple of 8)
+    uint64_t data_offset;  // bytes from the start of the file to the first tile
+    uint32_t byte_order;
+    uint32_t reserved;
+}TiledFileHeader;
+
+_Static_assert(sizeof(TiledFileHeader) == 64, "tiled file header must stay 64 bytes");
+
+static size_t TileRows(TiledMatrix tiled, size_t tile_row){
+    size_t first = tile_row * tiled->tile_size;
+    return tiled->num_rows - first < tiled->tile_size ? tiled->num_rows - first : tiled->tile_size;
+}
+
+static size_t TileCols(TiledMatrix tiled, size_t tile_col){
+    size_t first = tile_col * tiled->tile_size;
+    return tiled->num_cols - first < tiled->tile_size ? tiled->num_cols - first : tiled->tile_size;
+}
+
+static off_t TileOffset(TiledMatrix tiled, size_t tile_row, size_t tile_col){
+    return (off_t)(tiled->data_offset + (tile_row * tiled->tile_cols + tile_col) * tiled->tile_bytes);
+}
+
+// pread / pwrite of exactly size bytes, resuming after partial transfers
+static int ReadFull(int fd, void *buffer, size_t size, off_t offset){
+    char *at = (char*)buffer;
+    while(size > 0){
+        ssize_t got = pread(fd, at, size, offset);
+        if(got < 0 && errno == EINTR)
+            continue;
+        if(got <= 0)
+            return -1;
+        at += got;
+        offset += got;
+        size -= (size_t)got;
+    }
+    return 0;
+}
+
+static int WriteFull(int fd, const void *buffer, size_t size, off_t offset){
+    const char *at = (const char*)buffer;
+    while(size > 0){
+        ssize_t written = pwrite(fd, at, size, offset);
+        if(written < 0 && errno == EINTR)
+            continue;
+        if(written <= 0)
+            return -1;
+        at += written;
+        offset += written;
+        size -= (size_t)written;
+    }
+    return 0;
+}
+
+static int ReadTile(TiledMatrix tiled, size_t tile_row, size_t tile_col, double *tile){
+    if(ReadFull(tiled->fd, tile, tiled->tile_bytes, TileOffset(tiled, tile_row, tile_col)) != 0){
+        fprintf(stderr, "%s", "Error - Could not read a matrix tile");
+        return -1;
+    }
+    return 0;
+}
+
+static int WriteTile(TiledMatrix tiled, size_t tile_row, size_t tile_col, const double *tile){
+    if(WriteFull(tiled->fd, tile, tiled->tile_bytes, TileOffset(tiled, tile_row, tile_col)) != 0){
+        fprintf(stderr, "%s", "Error - Could not write a matrix tile");
+        return -1;
+    }
+    return 0;
+}
+
+
+/*******************************************************
+ *          Creating & Opening
+ *******************************************************/
+static TiledMatrix NewTiledStruct(int fd, size_t num_rows, size_t num_cols, size_t tile_size, size_t tile_ld,
+                                  size_t data_offset){
+    TiledMatrix tiled = (TiledMatrix)malloc(sizeof(tiled_struct));
+    if(!tiled){
+        fprintf(stderr, "%s", "Error - Could not allocate tiled matrix");
+        return NULL;
+    }
+    tiled->fd = fd;
+    tiled->num_rows = num_rows;
+    tiled->num_cols = num_cols;
+    tiled->tile_size = tile_size;
+    tiled->tile_ld = tile_ld;
+    tiled->tile_rows = (num_rows + tile_size - 1) / tile_size;
+    tiled->tile_cols = (num_cols + tile_size - 1) / tile_size;
+    tiled->tile_bytes = tile_size * tile_ld * sizeof(double);
+    tiled->data_offset = data_offset;
+    return tiled;
+}
+
+TiledMatrix NewTiledMatrix(const char *path, size_t num_rows, size_t num_cols, size_t tile_size){
+    if(!path || num_rows == 0 || num_cols == 0){
+        fprintf(stderr, "%s", "Error - Need a path and a non-empty shape to create a tiled matrix");
+        return NULL;
+    }
+    if(tile_size == 0)
+        tile_size = TILED_DEFAULT_TILE;
+    const size_t per_line = MATRIX_ALIGNMENT / sizeof(double);
+    size_t tile_ld = (tile_size + per_line - 1) / per_line * per_line;
+    int fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if(fd < 0){
+        fprintf(stderr, "Error - Could not create %s", path);
+        return NULL;
+    }
+    TiledMatrix tiled = NewTiledStruct(fd, num_rows, num_cols, tile_size, tile_ld, sizeof(TiledFileHeader));
+    if(!tiled){
+        close(fd);
+        return NULL;
+    }
+    TiledFileHeader header = {TILED_FILE_MAGIC, TILED_FILE_VERSION, TILED_DTYPE_FLOAT64, num_rows, num_cols,
+                              tile_size, tile_ld, sizeof(TiledFileHeader), TILED_FILE_BYTE_ORDER, 0};
+    // the tiles start as a hole in the file: zeros that take no disk space
+    off_t size = TileOffset(tiled, tiled->tile_rows, 0);
+    if(WriteFull(fd, &header, sizeof(header), 0) != 0 || ftruncate(fd, size) != 0){
+        fprintf(stderr, "Error - Could not size %s", path);
+        CloseTiledMatrix(&tiled);
+        return NULL;
+    }
+    return tiled;
+}
+
+TiledMatrix OpenTiledMatrix(const char *path){
+    int fd = path ? open(path, O_RDWR) : -1;
+    if(fd < 0){
+        fprintf(stderr, "Error - Could not open %s", path ? path : "(null)");
+        return NULL;
+    }
+    TiledFileHeader header;
+    struct stat info;
+    if(fstat(fd, &info) != 0 || ReadFull(fd, &header, sizeof(header), 0) != 0 ||
+       memcmp(header.magic, TILED_FILE_MAGIC, sizeof(header.magic)) != 0){
+        fprintf(stderr, "Error - %s is not a tiled matrix file", path);
+        close(fd);
+        return NULL;
+    }
+    if(header.byte_order != TILED_FILE_BYTE_ORDER || header.version != TILED_FILE_VERSION ||
+       header.dtype != TILED_DTYPE_FLOAT64 || header.num_rows == 0 || header.num_cols == 0 ||
+       header.tile_size == 0 || header.tile_ld < header.tile_size || (header.tile_ld * sizeof(double)) % MATRIX_ALIGNMENT != 0 ||
+       header.data_offset % MATRIX_ALIGNMENT != 0){
+        fprintf(stderr, "Error - %s has an inconsistent header or another byte order", path);
+        close(fd);
+        return NULL;
+    }
+    TiledMatrix tiled = NewTiledStruct(fd, header.num_rows, header.num_cols, header.tile_size, header.tile_ld,
+                                       header.data_offset);
+    if(tiled && TileOffset(tiled, tiled->tile_rows, 0) > info.st_size){
+        fprintf(stderr, "Error - %s is truncated", path);
+        CloseTiledMatrix(&tiled);
+    }
+    else if(!tiled)
+        close(fd);
+    return tiled;
+}
+
+void CloseTiledMatrix(TiledMatrix *tiled){
+    if(tiled && *tiled){
+        close((*tiled)->fd);
+        free(*tiled);
+        *tiled = NULL;
+    }
+}
+
+
+/*******************************************************
+ *          Block Transfer
+ *******************************************************/
+// Copies between a tiled matrix and an in-memory block at (row, col),
+// touching each tile the block covers once. Tiles the block covers only in
+// part are read before they are written.
+static int TransferBlock(TiledMatrix tiled, size_t row, size_t col, Matrix block, int to_file){
+    if(!tiled || isEmpty(block) || row >= tiled->num_rows || col >= tiled->num_cols ||
+       block->num_rows > tiled->num_rows - row || block->num_cols > tiled->num_cols - col){
+        fprintf(stderr, "%s", "Error - Block must lie inside the tiled matrix");
+        return -1;
+    }
+    double *tile = (double*)AllocateAligned(tiled->tile_bytes);
+    if(!tile){
+        fprintf(stderr, "%s", "Error - Could not allocate a tile buffer");
+        return -1;
+    }
+    STATS_BEGIN();
+    size_t t = tiled->tile_size;
+    int status = 0;
+    size_t last_row = row + block->num_rows, last_col = col + block->num_cols;
+    for(size_t ti = row / t; ti * t < last_row && status == 0; ti++){
+        for(size_t tj = col / t; tj * t < last_col && status == 0; tj++){
+            // part of the tile inside the block, in matrix coordinates
+            size_t r0 = ti * t > row ? ti * t : row, r1 = ti * t + t < last_row ? ti * t + t : last_row;
+            size_t c0 = tj * t > col ? tj * t : col, c1 = tj * t + t < last_col ? tj * t + t : last_col;
+            int whole = r0 == ti * t && c0 == tj * t && r1 - r0 == TileRows(tiled, ti) && c1 - c0 == TileCols(tiled, tj);
+            if(to_file && whole)
+                memset(tile, 0, tiled->tile_bytes);
+            else
+                status = ReadTile(tiled, ti, tj, tile);
+            for(size_t i = r0; i < r1 && status == 0; i++){
+                double *tile_row = tile + (i - ti * t) * tiled->tile_ld + (c0 - tj * t);
+                double *block_row = MATRIX_ROW(block, i - row) + (c0 - col);
+                if(to_file)
+                    memcpy(tile_row, block_row, (c1 - c0) * sizeof(double));
+                else
+                    memcpy(block_row, tile_row, (c1 - c0) * sizeof(double));
+            }
+            if(to_file && status == 0)
+                status = WriteTile(tiled, ti, tj, tile);
+        }
+    }
+    FreeAligned(tile);
+    STATS_END(MATRIX_STAT_TILED, 0);
+    return status == 0 ? 0 : -1;
+}
+
+int WriteTiledBlock(TiledMatrix tiled, size_t row, size_t col, Matrix block){
+    return TransferBlock(tiled, row, col, block, 1);
+}
+
+int ReadTiledBlock(TiledMatrix tiled, size_t row, size_t col, Matrix block){
+    return TransferBlock(tiled, row, col, block, 0);
+}
+
+
+/*******************************************************
+ *          Asynchronous Tile Streams
+ *******************************************************/
+// A stream reads a fixed sequence of tiles (given by a schedule function)
+// into a ring of buffers. Handing out tile s makes tiles s-hold+1..s
+// available to the caller and starts the reads of the tiles after s, as far
+// as the free buffers allow, so the disk works ahead of the computation.
+typedef struct{
+    TiledMatrix tiled;
+    size_t tile_row, tile_col;
+}TileRef;
+
+typedef TileRef (*TileSchedule)(const void *context, size_t step);
+
+typedef struct{
+    TileSchedule schedule;
+    const void *context;
+    size_t count;            // tiles in the schedule
+    size_t slots, hold;      // ring buffers, and how many of them the caller holds
+    double **buffers;
+    struct aiocb *requests;  // one per buffer; aio_fildes < 0 when none is pending
+    size_t issued, taken;    // steps read (or being read) / handed out
+    int status;
+}TileStream;
+
+static void IssueRead(TileStream *stream){
+    size_t step = stream->issued++, slot = step % stream->slots;
+    TileRef ref = stream->schedule(stream->context, step);
+    struct aiocb *request = &stream->requests[slot];
+    memset(request, 0, sizeof(*request));
+    request->aio_fildes = ref.tiled->fd;
+    request->aio_offset = TileOffset(ref.tiled, ref.tile_row, ref.tile_col);
+    request->aio_buf = stream->buffers[slot];
+    request->aio_nbytes = ref.tiled->tile_bytes;
+    request->aio_sigevent.sigev_notify = SIGEV_NONE;
+    if(aio_read(request) != 0){
+        // asynchronous I/O refused (e.g. out of resources): read it now
+        request->aio_fildes = -1;
+        if(ReadTile(ref.tiled, ref.tile_row, ref.tile_col, stream->buffers[slot]) != 0)
+            stream->status = -1;
+    }
+}
+
+// Waits for the read in a slot; a short read is finished synchronously
+static void CompleteRead(TileStream *stream, size_t slot){
+    struct aiocb *request = &stream->requests[slot];
+    if(request->aio_fildes < 0)
+        return;
+    const struct aiocb *list[1] = {request};
+    while(aio_error(request) == EINPROGRESS)
+        aio_suspend(list, 1, NULL);
+    ssize_t got = aio_return(request);
+    size_t done = got > 0 ? (size_t)got : 0;
+    if(done < request->aio_nbytes &&
+       ReadFull(request->aio_fildes, (char*)stream->buffers[slot] + done, request->aio_nbytes - done,
+                request->aio_offset + (off_t)done) != 0){
+        fprintf(stderr, "%s", "Error - Could not read a matrix tile");
+        stream->status = -1;
+    }
+    request->aio_fildes = -1;
+}
+
+static void OpenStream(TileStream *stream, TileSchedule schedule, const void *context, size_t count,
+                       size_t hold, double **buffers, struct aiocb *requests, size_t slots){
+    *stream = (TileStream){schedule, context, count, slots, hold, buffers, requests, 0, 0, 0};
+    for(size_t slot = 0; slot < slots; slot++)
+        requests[slot].aio_fildes = -1;
+}
+
+static const double *NextTile(TileStream *stream){
+    size_t step = stream->taken++;
+    size_t ahead = step + 1 + stream->slots - stream->hold;
+    size_t limit = ahead < stream->count ? ahead : stream->count;
+    while(stream->issued < limit)
+        IssueRead(stream);
+    CompleteRead(stream, step % stream->slots);
+    return stream->buffers[step % stream->slots];
+}
+
+// Waits out every read still in flight (the buffers may then be reused)
+static int CloseStream(TileStream *stream){
+    for(size_t step = stream->taken; step < stream->issued; step++)
+        CompleteRead(stream, step % stream->slots);
+    return stream->status;
+}
+
+// The tile buffers of one operation: accumulators plus a stream ring sized
+// from the memory budget
+typedef struct{
+    double *memory;
+    double **buffers;
+    struct aiocb *requests;
+    size_t slots;
+}TileBuffers;
+
+static int AllocateTileBuffers(TileBuffers *tiles, size_t tile_bytes, size_t memory_budget, size_t fixed, size_t hold){
+    if(memory_budget == 0)
+        memory_budget = TILED_DEFAULT_BUDGET;
+    size_t fit = memory_budget / tile_bytes;
+    if(fit < fixed + hold + 1){
+        fprintf(stderr, "Error - Memory budget must hold at least %zu tiles of %zu bytes", fixed + hold + 1, tile_bytes);
+        return -1;
+    }
+    size_t slots = fit - fixed < hold + TILED_MAX_LOOKAHEAD ? fit - fixed : hold + TILED_MAX_LOOKAHEAD;
+    tiles->slots = slots;
+    tiles->memory = (double*)AllocateAligned((fixed + slots) * tile_bytes);
+    tiles->buffers = (double**)malloc((fixed + slots) * sizeof(double*));
+    tiles->requests = (struct aiocb*)calloc(slots, sizeof(struct aiocb));
+    if(!tiles->memory || !tiles->buffers || !tiles->requests){
+        fprintf(stderr, "%s", "Error - Could not allocate tile buffers");
+        FreeAligned(tiles->memory);
+        free(tiles->buffers);
+        free(tiles->requests);
+        return -1;
+    }
+    // buffers[0..fixed) are the accumulators, the rest the stream ring
+    for(size_t b = 0; b < fixed + slots; b++)
+        tiles->buffers[b] = tiles->memory + b * (tile_bytes / sizeof(double));
+    return 0;
+}
+
+static void FreeTileBuffers(TileBuffers *tiles){
+    FreeAligned(tiles->memory);
+    free(tiles->buffers);
+    free(tiles->requests);
+}
+
+// Whether two open tiled matrices are the same file
+static int SameFile(TiledMatrix a, TiledMatrix b){
+    struct stat a_info, b_info;
+    if(a == b)
+        return 1;
+    return fstat(a->fd, &a_info) == 0 && fstat(b->fd, &b_info) == 0 &&
+           a_info.st_dev == b_info.st_dev && a_info.st_ino == b_info.st_ino;
+}
+
+
+/*******************************************************
+ *          Tiled Addition
+ *******************************************************/
+typedef struct{
+    TiledMatrix matrix_A, matrix_B;
+}AddSchedule;
+
+// A(i,j), B(i,j) for every tile in row-major order
+static TileRef AddStep(const void *context, size_t step){
+    const AddSchedule *add = (const AddSchedule*)context;
+    size_t tile = step / 2;
+    TiledMatrix tiled = step % 2 ? add->matrix_B : add->matrix_A;
+    return (TileRef){tiled, tile / tiled->tile_cols, tile % tiled->tile_cols};
+}
+
+int TiledAdd(TiledMatrix result_matrix, TiledMatrix matrix_A, TiledMatrix matrix_B, int subtract_flag,
+             size_t memory_budget){
+    if(!result_matrix || !matrix_A || !matrix_B ||
+       matrix_A->num_rows != matrix_B->num_rows || matrix_A->num_cols != matrix_B->num_cols ||
+       result_matrix->num_rows != matrix_A->num_rows || result_matrix->num_cols != matrix_A->num_cols ||
+       matrix_A->tile_size != matrix_B->tile_size || result_matrix->tile_size != matrix_A->tile_size){
+        fprintf(stderr, "%s", "Error - Tiled matrices must have the same shape and tile size to add or subtract");
+        return -1;
+    }
+    TileBuffers tiles;
+    if(AllocateTileBuffers(&tiles, matrix_A->tile_bytes, memory_budget, 1, 2) != 0)
+        return -1;
+    STATS_BEGIN();
+    // each tile is read before it is written, so the result may be an operand
+    AddSchedule add = {matrix_A, matrix_B};
+    size_t count = matrix_A->tile_rows * matrix_A->tile_cols;
+    size_t values = matrix_A->tile_bytes / sizeof(double);
+    double *sum = tiles.buffers[0];
+    TileStream stream;
+    OpenStream(&stream, AddStep, &add, 2 * count, 2, tiles.buffers + 1, tiles.requests, tiles.slots);
+    int status = 0;
+    for(size_t tile = 0; tile < count && status == 0; tile++){
+        const double *a = NextTile(&stream);
+        const double *b = NextTile(&stream);
+        if((status = stream.status) != 0)
+            break;
+        matrix_kernels->add(values, a, subtract_flag ? -1.0 : 1.0, b, sum);
+        status = WriteTile(result_matrix, tile / matrix_A->tile_cols, tile % matrix_A->tile_cols, sum);
+    }
+    if(CloseStream(&stream) != 0)
+        status = -1;
+    FreeTileBuffers(&tiles);
+    STATS_END(MATRIX_STAT_TILED, (double)matrix_A->num_rows * matrix_A->num_cols);
+    return status;
+}
+
+
+/*******************************************************
+ *          Tiled Multiplication
+ *******************************************************/
+typedef struct{
+    TiledMatrix matrix_A, matrix_B;
+    size_t inner;  // tiles along the shared dimension
+    size_t cols;   // tile columns of the result
+}MultiplySchedule;
+
+// For each result tile (i,j) in row-major order: A(i,k), B(k,j) for every k
+static TileRef MultiplyStep(const void *context, size_t step){
+    const MultiplySchedule *multiply = (const MultiplySchedule*)context;
+    size_t per_tile = 2 * multiply->inner;
+    size_t tile = step / per_tile, k = step % per_tile / 2;
+    size_t i = tile / multiply->cols, j = tile % multiply->cols;
+    if(step % 2 == 0)
+        return (TileRef){multiply->matrix_A, i, k};
+    return (TileRef){multiply->matrix_B, k, j};
+}
+
+int TiledMultiply(TiledMatrix result_matrix, TiledMatrix matrix_A, TiledMatrix matrix_B, size_t memory_budget){
+    if(!result_matrix || !matrix_A || !matrix_B || matrix_A->num_cols != matrix_B->num_rows ||
+       result_matrix->num_rows != matrix_A->num_rows || result_matrix->num_cols != matrix_B->num_cols ||
+       matrix_A->tile_size != matrix_B->tile_size || result_matrix->tile_size != matrix_A->tile_size){
+        fprintf(stderr, "%s", "Error - Result must be MxP to hold the product of an MxN and an NxP tiled matrix (all of one tile size)");
+        return -1;
+    }
+    if(SameFile(result_matrix, matrix_A) || SameFile(result_matrix, matrix_B)){
+        fprintf(stderr, "%s", "Error - Result of a multiplication cannot be one of its operands");
+        return -1;
+    }
+    TileBuffers tiles;
+    if(AllocateTileBuffers(&tiles, matrix_A->tile_bytes, memory_budget, 1, 2) != 0)
+        return -1;
+    STATS_BEGIN();
+    MultiplySchedule multiply = {matrix_A, matrix_B, matrix_A->tile_cols, result_matrix->tile_cols};
+    size_t count = result_matrix->tile_rows * result_matrix->tile_cols, ld = matrix_A->tile_ld;
+    double *product = tiles.buffers[0];
+    memset(product, 0, matrix_A->tile_bytes); // padding outside the edge tiles stays zero
+    TileStream stream;
+    OpenStream(&stream, MultiplyStep, &multiply, count * 2 * multiply.inner, 2, tiles.buffers + 1,
+               tiles.requests, tiles.slots);
+    int status = 0;
+    for(size_t tile = 0; tile < count && status == 0; tile++){
+        size_t i = tile / multiply.cols, j = tile % multiply.cols;
+        size_t rows = TileRows(result_matrix, i), cols = TileCols(result_matrix, j);
+        for(size_t k = 0; k < multiply.inner; k++){
+            const double *a = NextTile(&stream);
+            const double *b = NextTile(&stream);
+            if((status = stream.status) != 0)
+                break;
+            // the disk reads the next tiles while this runs
+            DenseGemm(0, 0, rows, cols, TileCols(matrix_A, k), 1.0, a, ld, b, ld,
+                      k == 0 ? 0.0 : 1.0, product, ld);
+        }
+        if(status == 0)
+            status = WriteTile(result_matrix, i, j, product);
+    }
+    if(CloseStream(&stream) != 0)
+        status = -1;
+    FreeTileBuffers(&tiles);
+    STATS_END(MATRIX_STAT_TILED, 2.0 * matrix_A->num_rows * matrix_B->num_cols * matrix_A->num_cols);
+    return status;
+}
+
+
+/*******************************************************
+ *          Tiled Cholesky Factorization
+ *******************************************************/
+// Left-looking, one column of tiles at a time: tile (i,j) below the
+// diagonal becomes L(i,j) = (A(i,j) - sum_k<j L(i,k) L(j,k)^T) L(j,j)^-T,
+// and the diagonal tile is factored in memory. Every tile a column reads
+// besides its own comes from columns already finished.
+typedef struct{
+    TiledMatrix tiled;
+    size_t column;
+}CholeskySchedule;
+
+// A(j,j), L(j,k) for k < j; then for each i > j: A(i,j), L(i,k), L(j,k) for k < j
+static TileRef CholeskyStep(const void *context, size_t step){
+    const CholeskySchedule *cholesky = (const CholeskySchedule*)context;
+    size_t j = cholesky->column;
+    if(step < j + 1)
+        return (TileRef){cholesky->tiled, j, step == 0 ? j : step - 1};
+    step -= j + 1;
+    size_t per_tile = 2 * j + 1, i = j + 1 + step / per_tile, r = step % per_tile;
+    if(r == 0)
+        return (TileRef){cholesky->tiled, i, j};
+    return (TileRef){cholesky->tiled, (r - 1) % 2 ? j : i, (r - 1) / 2};
+}
+
+typedef struct{
+    double *tile;
+    const double *diagonal;
+    size_t ld, width;
+}TileSolveJob;
+
+// tile rows [begin, end) times L^-T for the factored diagonal tile L
+static void TileSolveTask(void *context, size_t begin, size_t end){
+    const TileSolveJob *job = (const TileSolveJob*)context;
+    for(size_t r = begin; r < end; r++){
+        double *row = job->tile + r * job->ld;
+        for(size_t c = 0; c < job->width; c++){
+            const double *l_row = job->diagonal + c * job->ld;
+            row[c] = (row[c] - matrix_kernels->dot(c, row, l_row)) / l_row[c];
+        }
+    }
+}
+
+int TiledCholesky(TiledMatrix tiled, size_t memory_budget){
+    if(!tiled || tiled->num_rows != tiled->num_cols){
+        fprintf(stderr, "%s", "Error - Need an NxN tiled matrix to compute a Cholesky factorization");
+        return -1;
+    }
+    TileBuffers tiles;
+    if(AllocateTileBuffers(&tiles, tiled->tile_bytes, memory_budget, 2, 2) != 0)
+        return -1;
+    STATS_BEGIN();
+    size_t nt = tiled->tile_rows, ld = tiled->tile_ld, t = tiled->tile_size;
+    double *work = tiles.buffers[0], *diagonal = tiles.buffers[1];
+    int status = 0;
+    for(size_t j = 0; j < nt && status == 0; j++){
+        CholeskySchedule cholesky = {tiled, j};
+        size_t count = (j + 1) + (nt - j - 1) * (2 * j + 1);
+        size_t width = TileRows(tiled, j);
+        TileStream stream;
+        OpenStream(&stream, CholeskyStep, &cholesky, count, 2, tiles.buffers + 2, tiles.requests, tiles.slots);
+        for(size_t i = j; i < nt && status == 0; i++){
+            size_t rows = TileRows(tiled, i);
+            memcpy(work, NextTile(&stream), tiled->tile_bytes);
+            for(size_t k = 0; k < j && status == 0; k++){
+                const double *l_ik = NextTile(&stream);
+                const double *l_jk = i == j ? l_ik : NextTile(&stream);
+                if((status = stream.status) != 0)
+                    break;
+                DenseGemm(0, 1, rows, width, TileCols(tiled, k), -1.0, l_ik, ld, l_jk, ld, 1.0, work, ld);
+            }
+            if(status != 0 || (status = stream.status) != 0)
+                break;
+            if(i == j){
+                size_t failed = CholeskyDense(width, work, ld);
+                if(failed){
+                    status = (int)(j * t + failed);
+                    break;
+                }
+                memcpy(diagonal, work, tiled->tile_bytes);
+            }
+            else{
+                TileSolveJob job = {work, diagonal, ld, width};
+                ParallelFor(rows, 64, TileSolveTask, &job);
+            }
+            status = WriteTile(tiled, i, j, work);
+        }
+        if(CloseStream(&stream) != 0 && status == 0)
+            status = -1;
+    }
+    // L is lower triangular: clear the tiles above the diagonal
+    memset(work, 0, tiled->tile_bytes);
+    for(size_t i = 0; i < nt && status == 0; i++)
+        for(size_t j = i + 1; j < nt && status == 0; j++)
+            status = WriteTile(tiled, i, j, work);
+    FreeTileBuffers(&tiles);
+    STATS_END(MATRIX_STAT_TILED, (double)tiled->num_rows * tiled->num_rows * tiled->num_rows / 3);
+    return status;
+}
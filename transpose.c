@@ -0,0 +1,344 @@
+/****************************
+ * Author: Blake A. Molina
+ * Created on: 10/17/26
+ * License: GPL
+ ****************************/
+
+#include "matrix_internal.h"
+
+// Edge of the cache block walked tile by tile; a block of source and one of
+// destination (2 * 64 * 64 doubles) fit comfortably in L2
+#define TRANSPOSE_BLOCK 64
+
+
+/*******************************************************
+ *          Block Kernels
+ *******************************************************/
+// dst (cols x rows) = src (rows x cols)^T for one cache block, using the
+// SIMD tile kernel on full tiles and plain loops on the ragged edges
+static void TransposeBlock(size_t rows, size_t cols, const double *src, size_t lds,
+                           double *dst, size_t ldd){
+    size_t full_rows = rows - rows % TRANSPOSE_TILE;
+    size_t full_cols = cols - cols % TRANSPOSE_TILE;
+    for(size_t i = 0; i < full_rows; i += TRANSPOSE_TILE)
+        for(size_t j = 0; j < full_cols; j += TRANSPOSE_TILE)
+            matrix_kernels->transpose_tile(src + i*lds + j, lds, dst + j*ldd + i, ldd);
+    for(size_t i = 0; i < rows; i++){
+        size_t j = i < full_rows ? full_cols : 0;
+        for(; j < cols; j++)
+            dst[j*ldd + i] = src[i*lds + j];
+    }
+}
+
+// Exchanges the size x size blocks X and Y while transposing both: X = Y^T, Y = X^T
+static void SwapTransposeBlock(size_t size, double *x, double *y, size_t ld){
+    _Alignas(MATRIX_ALIGNMENT) double scratch[TRANSPOSE_BLOCK * TRANSPOSE_BLOCK];
+    TransposeBlock(size, size, x, ld, scratch, TRANSPOSE_BLOCK);
+    TransposeBlock(size, size, y, ld, x, ld);
+    for(size_t i = 0; i < size; i++)
+        memcpy(y + i*ld, scratch + i*TRANSPOSE_BLOCK, size * sizeof(double));
+}
+
+// Transposes the size x size diagonal block at a in place
+static void TransposeDiagonalBlock(size_t size, double *a, size_t ld){
+    _Alignas(MATRIX_ALIGNMENT) double scratch[TRANSPOSE_BLOCK * TRANSPOSE_BLOCK];
+    TransposeBlock(size, size, a, ld, scratch, TRANSPOSE_BLOCK);
+    for(size_t i = 0; i < size; i++)
+        memcpy(a + i*ld, scratch + i*TRANSPOSE_BLOCK, size * sizeof(double));
+}
+
+
+/*******************************************************
+ *          Out-of-place Transpose
+ *******************************************************/
+typedef struct{
+    size_t rows, cols;
+    const double *src;
+    size_t lds;
+    double *dst;
+    size_t ldd;
+}TransposeJob;
+
+// Block rows [begin, end) of the source; each writes its own block columns of dst
+static void TransposeBlockRowsTask(void *context, size_t begin, size_t end){
+    const TransposeJob *job = (const TransposeJob*)context;
+    for(size_t block = begin; block < end; block++){
+        size_t i = block * TRANSPOSE_BLOCK;
+        size_t rows = job->rows - i < TRANSPOSE_BLOCK ? job->rows - i : TRANSPOSE_BLOCK;
+        for(size_t j = 0; j < job->cols; j += TRANSPOSE_BLOCK){
+            size_t cols = job->cols - j < TRANSPOSE_BLOCK ? job->cols - j : TRANSPOSE_BLOCK;
+            TransposeBlock(rows, cols, job->src + i*job->lds + j, job->lds,
+                           job->dst + j*job->ldd + i, job->ldd);
+        }
+    }
+}
+
+void TransposeDense(size_t rows, size_t cols, const double *src, size_t lds, double *dst, size_t ldd){
+    TransposeJob job = {rows, cols, src, lds, dst, ldd};
+    size_t block_rows = (rows + TRANSPOSE_BLOCK - 1) / TRANSPOSE_BLOCK;
+    size_t min_blocks = cols * TRANSPOSE_BLOCK >= 65536 ? 1 : 65536 / (cols * TRANSPOSE_BLOCK) + 1;
+    ParallelFor(block_rows, min_blocks, TransposeBlockRowsTask, &job);
+}
+
+
+/*******************************************************
+ *          In-place Square Transpose
+ *******************************************************/
+typedef struct{
+    size_t n, blocks;
+    double *a;
+    size_t ld;
+}SquareTransposeJob;
+
+// Block row b: transpose the diagonal block, then swap-transpose every block
+// right of it with its mirror below the diagonal
+static void TransposeBlockRow(const SquareTransposeJob *job, size_t b){
+    size_t i = b * TRANSPOSE_BLOCK;
+    size_t size = job->n - i < TRANSPOSE_BLOCK ? job->n - i : TRANSPOSE_BLOCK;
+    TransposeDiagonalBlock(size, job->a + i*job->ld + i, job->ld);
+    for(size_t j = i + TRANSPOSE_BLOCK; j < job->n; j += TRANSPOSE_BLOCK){
+        size_t cols = job->n - j < TRANSPOSE_BLOCK ? job->n - j : TRANSPOSE_BLOCK;
+        if(cols == size){
+            SwapTransposeBlock(size, job->a + i*job->ld + j, job->a + j*job->ld + i, job->ld);
+        }
+        else{
+            // ragged last block column: plain element swaps
+            for(size_t r = 0; r < size; r++)
+                for(size_t c = 0; c < cols; c++)
+                    SwapValues(job->a + (i + r)*job->ld + j + c, job->a + (j + c)*job->ld + i + r);
+        }
+    }
+}
+
+// Task t owns block rows t and blocks-1-t, so every share does about the same work
+static void TransposeSquareTask(void *context, size_t begin, size_t end){
+    const SquareTransposeJob *job = (const SquareTransposeJob*)context;
+    for(size_t t = begin; t < end; t++){
+        TransposeBlockRow(job, t);
+        if(job->blocks - 1 - t != t)
+            TransposeBlockRow(job, job->blocks - 1 - t);
+    }
+}
+
+void TransposeSquareDense(size_t n, double *a, size_t ld){
+    size_t blocks = (n + TRANSPOSE_BLOCK - 1) / TRANSPOSE_BLOCK;
+    SquareTransposeJob job = {n, blocks, a, ld};
+    size_t min_pairs = n >= 1024 ? 1 : 1024 / (n ? n : 1) + 1;
+    ParallelFor((blocks + 1) / 2, min_pairs, TransposeSquareTask, &job);
+}
+
+
+/*******************************************************
+ *          Public Entry Points
+ *******************************************************/
+void Transpose(Matrix matrix){
+    if(isEmpty(matrix))
+        return;
+    STATS_BEGIN();
+    if(isSquare(matrix)){
+        if(SmallTransposeDense(matrix->num_rows, matrix->data, matrix->ld, matrix->data, matrix->ld) != 0)
+            TransposeSquareDense(matrix->num_rows, matrix->data, matrix->ld);
+        STATS_END(MATRIX_STAT_TRANSPOSE, 0);
+        return;
+    }
+    // A rectangular matrix changes shape, so it is transposed into fresh
+    // storage which then replaces the old buffer
+    if(matrix->flags & MATRIX_VIEW){
+        fprintf(stderr, "%s", "Error - Cannot change the shape of a view (use TransposeInto)");
+        return;
+    }
+    // the new storage must live as long as the old: heap storage for a
+    // matrix that owns (or maps) its values, the active arena otherwise
+    int heap = (matrix->flags & (MATRIX_OWNS_DATA | MATRIX_MAPPED)) != 0;
+    MatrixArena previous = UseMatrixArena(heap ? NULL : ActiveArena());
+    Matrix transposed = NewMatrix(matrix->num_cols, matrix->num_rows);
+    UseMatrixArena(previous);
+    if(!transposed){
+        fprintf(stderr, "%s", "Error - Could not allocate memory to transpose matrix");
+        return;
+    }
+    TransposeDense(matrix->num_rows, matrix->num_cols, matrix->data, matrix->ld,
+                   transposed->data, transposed->ld);
+    // swap the storage; each struct keeps the bits describing the struct
+    // itself (a mapped matrix's struct also holds its mapping)
+    const unsigned struct_bits = MATRIX_OWNS_STRUCT | MATRIX_MAPPED;
+    matrix_struct old = *matrix;
+    unsigned matrix_struct_bits = matrix->flags & struct_bits;
+    unsigned transposed_struct_bits = transposed->flags & struct_bits;
+    *matrix = *transposed;
+    *transposed = old;
+    matrix->flags = (matrix->flags & ~struct_bits) | matrix_struct_bits;
+    transposed->flags = (transposed->flags & ~struct_bits) | transposed_struct_bits;
+    FreeMatrix(&transposed);
+    STATS_END(MATRIX_STAT_TRANSPOSE, 0);
+}
+
+int TransposeInto(Matrix src, Matrix dst){
+    if(isEmpty(src) || isEmpty(dst) || src->num_rows != dst->num_cols || src->num_cols != dst->num_rows){
+        fprintf(stderr, "%s", "Error - Destination must be NxM to hold the transpose of an MxN matrix");
+        return -1;
+    }
+    STATS_BEGIN();
+    if(src->num_rows == src->num_cols && src->data == dst->data && src->ld == dst->ld){
+        // a square matrix onto its own storage, done in place
+        if(SmallTransposeDense(src->num_rows, src->data, src->ld, dst->data, dst->ld) != 0)
+            TransposeSquareDense(src->num_rows, src->data, src->ld);
+        STATS_END(MATRIX_STAT_TRANSPOSE, 0);
+        return 0;
+    }
+    if(MatricesOverlap(src, dst)){
+        fprintf(stderr, "%s", "Error - Destination of a transpose cannot partly overlap its source");
+        return -1;
+    }
+    if(src->num_rows != src->num_cols ||
+       SmallTransposeDense(src->num_rows, src->data, src->ld, dst->data, dst->ld) != 0)
+        TransposeDense(src->num_rows, src->num_cols, src->data, src->ld, dst->data, dst->ld);
+    STATS_END(MATRIX_STAT_TRANSPOSE, 0);
+    return 0;
+}
+
+
+/*******************************************************
+ *          Rotation & Flips
+ *******************************************************/
+// Edge of the (i, j) tile walked per step of a rotation; each of the four
+// 32x32 regions a tile touches stays cache-resident while it is cycled
+#define ROTATE_TILE 32
+
+typedef struct{
+    size_t n;
+    double *a;
+    size_t ld;
+    int clockwise;
+}RotateJob;
+
+// Tile rows [begin, end) of the i < n/2, j < (n+1)/2 quadrant. Every element
+// of the quadrant starts one four-way cycle
+//   (i, j) -> (j, n-1-i) -> (n-1-i, n-1-j) -> (n-1-j, i)
+// so each value is read and written exactly once.
+static void RotateTilesTask(void *context, size_t begin, size_t end){
+    const RotateJob *job = (const RotateJob*)context;
+    const size_t n = job->n, ld = job->ld, last = job->n - 1;
+    const size_t half_rows = n / 2, half_cols = (n + 1) / 2;
+    double *a = job->a;
+    for(size_t tile = begin; tile < end; tile++){
+        size_t i0 = tile * ROTATE_TILE;
+        size_t i1 = half_rows - i0 < ROTATE_TILE ? half_rows : i0 + ROTATE_TILE;
+        for(size_t j0 = 0; j0 < half_cols; j0 += ROTATE_TILE){
+            size_t j1 = half_cols - j0 < ROTATE_TILE ? half_cols : j0 + ROTATE_TILE;
+            for(size_t i = i0; i < i1; i++){
+                double *p0 = a + i*ld, *p2 = a + (last - i)*ld;
+                for(size_t j = j0; j < j1; j++){
+                    double *p1 = a + j*ld + last - i;
+                    double *p3 = a + (last - j)*ld + i;
+                    double temp = p0[j];
+                    if(job->clockwise){
+                        p0[j] = *p3;
+                        *p3 = p2[last - j];
+                        p2[last - j] = *p1;
+                        *p1 = temp;
+                    }
+                    else{
+                        p0[j] = *p1;
+                        *p1 = p2[last - j];
+                        p2[last - j] = *p3;
+                        *p3 = temp;
+                    }
+                }
+            }
+        }
+    }
+}
+
+static void RotateSquareDense(size_t n, double *a, size_t ld, int clockwise){
+    RotateJob job = {n, a, ld, clockwise};
+    size_t tiles = (n / 2 + ROTATE_TILE - 1) / ROTATE_TILE;
+    size_t min_tiles = n * ROTATE_TILE >= 16384 ? 1 : 16384 / (n * ROTATE_TILE) + 1;
+    ParallelFor(tiles, min_tiles, RotateTilesTask, &job);
+}
+
+typedef struct{
+    Matrix matrix;
+    int reverse; // 1: also reverse each row (180 degrees), 0: plain row swap
+}MirrorRowsJob;
+
+// Row pairs (r, m-1-r) for r in [begin, end); the middle row of an odd
+// height is reversed in place when reverse is set
+static void MirrorRowsTask(void *context, size_t begin, size_t end){
+    const MirrorRowsJob *job = (const MirrorRowsJob*)context;
+    const size_t rows = job->matrix->num_rows, cols = job->matrix->num_cols;
+    for(size_t r = begin; r < end; r++){
+        double *top = MATRIX_ROW(job->matrix, r);
+        double *bottom = MATRIX_ROW(job->matrix, rows - 1 - r);
+        if(top == bottom){
+            if(job->reverse)
+                matrix_kernels->swap_reversed(cols / 2, top, top + cols - cols / 2);
+        }
+        else if(job->reverse)
+            matrix_kernels->swap_reversed(cols, top, bottom);
+        else
+            matrix_kernels->swap(cols, top, bottom);
+    }
+}
+
+// Rows [begin, end) reversed in place
+static void ReverseRowsTask(void *context, size_t begin, size_t end){
+    Matrix matrix = (Matrix)context;
+    const size_t cols = matrix->num_cols, half = cols / 2;
+    for(size_t r = begin; r < end; r++){
+        double *row = MATRIX_ROW(matrix, r);
+        matrix_kernels->swap_reversed(half, row, row + cols - half);
+    }
+}
+
+static size_t MirrorChunk(size_t num_cols){
+    return num_cols >= 16384 ? 1 : 16384 / num_cols + 1;
+}
+
+void RotateMatrixClockwise(Matrix matrix){
+    // make sure matrix exists and is square
+    if(isEmpty(matrix) || !isSquare(matrix))
+        fprintf(stderr, "%s", "Error - Need an Nxn matrix to rotate");
+    else{
+        STATS_BEGIN();
+        RotateSquareDense(matrix->num_rows, matrix->data, matrix->ld, 1);
+        STATS_END(MATRIX_STAT_ROTATE, 0);
+    }
+}
+
+void RotateMatrixCounterClockwise(Matrix matrix){
+    // make sure matrix exists and is square
+    if(isEmpty(matrix) || !isSquare(matrix))
+        fprintf(stderr, "%s", "Error - Need an Nxn matrix to rotate");
+    else{
+        STATS_BEGIN();
+        RotateSquareDense(matrix->num_rows, matrix->data, matrix->ld, 0);
+        STATS_END(MATRIX_STAT_ROTATE, 0);
+    }
+}
+
+void Rotate180(Matrix matrix){
+    if(isEmpty(matrix))
+        return;
+    STATS_BEGIN();
+    MirrorRowsJob job = {matrix, 1};
+    ParallelFor((matrix->num_rows + 1) / 2, MirrorChunk(matrix->num_cols), MirrorRowsTask, &job);
+    STATS_END(MATRIX_STAT_ROTATE, 0);
+}
+
+void FlipHorizontal(Matrix matrix){
+    if(isEmpty(matrix) || matrix->num_cols < 2)
+        return;
+    STATS_BEGIN();
+    ParallelFor(matrix->num_rows, MirrorChunk(matrix->num_cols), ReverseRowsTask, matrix);
+    STATS_END(MATRIX_STAT_ROTATE, 0);
+}
+
+void FlipVertical(Matrix matrix){
+    if(isEmpty(matrix))
+        return;
+    STATS_BEGIN();
+    MirrorRowsJob job = {matrix, 0};
+    ParallelFor(matrix->num_rows / 2, MirrorChunk(matrix->num_cols), MirrorRowsTask, &job);
+    STATS_END(MATRIX_STAT_ROTATE, 0);
+}
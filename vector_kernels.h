@@ -0,0 +1,145 @@
+/****************************
+ * Author: Blake A. Molina
+ * Created on: 10/17/26
+ * License: GPL
+ ****************************/
+
+/*************************************************************************
+ * Element-type generic row and GEMM kernels, included by simd.c once per
+ * element type and instruction set.
+ *
+ *  Before each inclusion simd.c defines REAL (the element type), LANES
+ *  (REALs per native vector, 1 for the portable set), KERNEL_ISA (the
+ *  set's name), KERNEL_TABLE (the table type) and the register tile
+ *  KERNEL_MR x KERNEL_NR of its gemm_micro, and selects the target with
+ *  #pragma GCC target. Vec is a GCC vector of LANES REALs, so each Vec
+ *  operation below is one SSE2, AVX2 or AVX-512 instruction. The
+ *  inclusion defines the table KERNEL_TABLE##_##KERNEL_ISA, named after
+ *  the set (e.g. MatrixKernelsF_avx2 with name "avx2").
+ *
+ *  The float32 kernels are generated this way; the double ones in simd.c
+ *  are hand-written intrinsics that predate this template.
+ *
+ *  There is deliberately no include guard.
+ ************************************************************************/
+
+#define KERNEL_CONCAT_(a, b, c)   a##b##c
+#define KERNEL_CONCAT(a, b, c)    KERNEL_CONCAT_(a, b, c)
+#define KERNEL_NAME(name)         KERNEL_CONCAT(name, KERNEL_TABLE, KERNEL_ISA)
+#define KERNEL_STRING_(isa)       #isa
+#define KERNEL_STRING(isa)        KERNEL_STRING_(isa)
+
+#define Vec KERNEL_NAME(Vec)
+#define NR_VECS (KERNEL_NR / LANES)
+
+// Unaligned access: the vector is only as aligned as its elements
+typedef REAL Vec __attribute__((vector_size(LANES * sizeof(REAL)), aligned(sizeof(REAL))));
+
+#define LOAD(p)      (*(const Vec*)(p))
+#define STORE(p, v)  (*(Vec*)(p) = (v))
+
+static void KERNEL_NAME(Axpy)(size_t n, REAL alpha, const REAL *restrict x, REAL *restrict y){
+    size_t i = 0;
+    for(; i + LANES <= n; i += LANES)
+        STORE(y + i, LOAD(y + i) + alpha * LOAD(x + i));
+    for(; i < n; i++)
+        y[i] += alpha * x[i];
+}
+
+static void KERNEL_NAME(Scale)(size_t n, REAL alpha, REAL *x){
+    size_t i = 0;
+    for(; i + LANES <= n; i += LANES)
+        STORE(x + i, alpha * LOAD(x + i));
+    for(; i < n; i++)
+        x[i] *= alpha;
+}
+
+static void KERNEL_NAME(Swap)(size_t n, REAL *restrict x, REAL *restrict y){
+    size_t i = 0;
+    for(; i + LANES <= n; i += LANES){
+        Vec temp = LOAD(x + i);
+        STORE(x + i, LOAD(y + i));
+        STORE(y + i, temp);
+    }
+    for(; i < n; i++){
+        REAL temp = x[i];
+        x[i] = y[i];
+        y[i] = temp;
+    }
+}
+
+static void KERNEL_NAME(Add)(size_t n, const REAL *x, REAL beta, const REAL *y, REAL *z){
+    size_t i = 0;
+    for(; i + LANES <= n; i += LANES)
+        STORE(z + i, LOAD(x + i) + beta * LOAD(y + i));
+    for(; i < n; i++)
+        z[i] = x[i] + beta * y[i];
+}
+
+static REAL KERNEL_NAME(Dot)(size_t n, const REAL *x, const REAL *y){
+    // two vector accumulators break the dependency chain
+    Vec s0 = {0}, s1 = {0};
+    size_t i = 0;
+    for(; i + 2*LANES <= n; i += 2*LANES){
+        s0 += LOAD(x + i) * LOAD(y + i);
+        s1 += LOAD(x + i + LANES) * LOAD(y + i + LANES);
+    }
+    for(; i + LANES <= n; i += LANES)
+        s0 += LOAD(x + i) * LOAD(y + i);
+    s0 += s1;
+    REAL sum = 0;
+    for(size_t l = 0; l < LANES; l++)
+        sum += s0[l];
+    for(; i < n; i++)
+        sum += x[i] * y[i];
+    return sum;
+}
+
+// KERNEL_MR x KERNEL_NR tile held in KERNEL_MR * NR_VECS vector accumulators:
+// per k step, NR_VECS loads of B and one broadcast of each A value
+static void KERNEL_NAME(GemmMicro)(size_t kc, const REAL *restrict a, const REAL *restrict b,
+                                   REAL *restrict tile){
+    Vec acc[KERNEL_MR][NR_VECS];
+    #pragma GCC unroll 16
+    for(int i = 0; i < KERNEL_MR; i++)
+        #pragma GCC unroll 16
+        for(int v = 0; v < NR_VECS; v++)
+            acc[i][v] = (Vec){0};
+    for(size_t p = 0; p < kc; p++){
+        Vec b_vecs[NR_VECS];
+        #pragma GCC unroll 16
+        for(int v = 0; v < NR_VECS; v++)
+            b_vecs[v] = LOAD(b + v*LANES);
+        #pragma GCC unroll 16
+        for(int i = 0; i < KERNEL_MR; i++){
+            const REAL a_value = a[i];
+            #pragma GCC unroll 16
+            for(int v = 0; v < NR_VECS; v++)
+                acc[i][v] += a_value * b_vecs[v];
+        }
+        a += KERNEL_MR;
+        b += KERNEL_NR;
+    }
+    #pragma GCC unroll 16
+    for(int i = 0; i < KERNEL_MR; i++)
+        #pragma GCC unroll 16
+        for(int v = 0; v < NR_VECS; v++)
+            STORE(tile + i*KERNEL_NR + v*LANES, acc[i][v]);
+}
+
+static const KERNEL_TABLE KERNEL_CONCAT(KERNEL_TABLE, _, KERNEL_ISA) = {
+    KERNEL_STRING(KERNEL_ISA), KERNEL_NAME(Axpy), KERNEL_NAME(Scale), KERNEL_NAME(Swap),
+    KERNEL_NAME(Add), KERNEL_NAME(Dot), KERNEL_NAME(GemmMicro)
+};
+
+#undef Vec
+#undef NR_VECS
+#undef LOAD
+#undef STORE
+#undef KERNEL_NAME
+#undef KERNEL_STRING
+#undef KERNEL_STRING_
+#undef KERNEL_CONCAT
+#undef KERNEL_CONCAT_
+#undef KERNEL_ISA
+#undef LANES